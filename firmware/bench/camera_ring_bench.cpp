@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <iostream>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/spsc_ring.hpp"
+
+// Compares the frame hand-off used by CameraStreamer (lock-free SPSC ring with
+// an event count) against the previous mutex + deque + condition_variable
+// queue. A synthetic frame source stands in for the camera driver: a pool of
+// preallocated frame buffers handed out round-robin, stamped with their
+// capture time. Both queues drop the oldest frame when full, like the streamer.
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+constexpr std::size_t kQueueCapacity = 3;
+constexpr std::size_t kPoolSize = 64;
+constexpr std::size_t kFrameBytes = 24 * 1024;
+
+class SyntheticSource {
+  public:
+    SyntheticSource() : buffers_(kPoolSize, std::vector<std::uint8_t>(kFrameBytes)) {
+        for (std::size_t i = 0; i < kPoolSize; ++i) {
+            std::fill(buffers_[i].begin(), buffers_[i].end(), static_cast<std::uint8_t>(i));
+            frames_[i].buf = buffers_[i].data();
+            frames_[i].len = kFrameBytes;
+            frames_[i].width = 320;
+            frames_[i].height = 240;
+        }
+    }
+
+    camera_fb_t *capture() {
+        const std::size_t slot = next_++ % kPoolSize;
+        stamps_[slot].store(Clock::now().time_since_epoch().count(), std::memory_order_relaxed);
+        return &frames_[slot];
+    }
+
+    [[nodiscard]] Clock::duration age(const camera_fb_t *frame) const {
+        const auto slot = static_cast<std::size_t>(frame - frames_.data());
+        return Clock::now() - Clock::time_point{Clock::duration{stamps_[slot].load(std::memory_order_relaxed)}};
+    }
+
+  private:
+    std::vector<std::vector<std::uint8_t>> buffers_;
+    std::array<camera_fb_t, kPoolSize> frames_{};
+    std::array<std::atomic<Clock::rep>, kPoolSize> stamps_{};
+    std::size_t next_{0};
+};
+
+class RingQueue {
+  public:
+    static constexpr const char *kName = "spsc ring + event count";
+
+    // Returns true if a frame had to be dropped.
+    bool push(camera_fb_t *frame) {
+        bool dropped = false;
+        camera_fb_t *evicted = nullptr;
+        while (!ring_.tryPush(frame)) {
+            dropped = ring_.tryPop(evicted) || dropped;
+        }
+        event_.notifyAll();
+        return dropped;
+    }
+
+    std::optional<camera_fb_t *> pop(std::chrono::milliseconds timeout) {
+        camera_fb_t *frame = nullptr;
+        if (ring_.tryPop(frame)) {
+            return frame;
+        }
+        const auto deadline = Clock::now() + timeout;
+        while (true) {
+            const auto key = event_.prepareWait();
+            if (ring_.tryPop(frame)) {
+                event_.cancelWait();
+                return frame;
+            }
+            if (!event_.wait(key, deadline)) {
+                return ring_.tryPop(frame) ? std::optional<camera_fb_t *>{frame} : std::nullopt;
+            }
+        }
+    }
+
+    void close() { event_.notifyAll(); }
+
+  private:
+    minitrain::SpscRing<camera_fb_t *> ring_{kQueueCapacity};
+    minitrain::EventCount event_;
+};
+
+class MutexQueue {
+  public:
+    static constexpr const char *kName = "mutex + deque + condvar";
+
+    bool push(camera_fb_t *frame) {
+        bool dropped = false;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            if (stopRequested_) {
+                return false;
+            }
+            if (queue_.size() >= kQueueCapacity) {
+                queue_.pop_front();
+                dropped = true;
+            }
+            queue_.push_back(frame);
+        }
+        available_.notify_one();
+        return dropped;
+    }
+
+    std::optional<camera_fb_t *> pop(std::chrono::milliseconds timeout) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (!available_.wait_for(lock, timeout, [this] { return !queue_.empty() || stopRequested_; }) ||
+            queue_.empty()) {
+            return std::nullopt;
+        }
+        auto *frame = queue_.front();
+        queue_.pop_front();
+        return frame;
+    }
+
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopRequested_ = true;
+        }
+        available_.notify_all();
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable available_;
+    std::deque<camera_fb_t *> queue_;
+    bool stopRequested_{false};
+};
+
+struct Result {
+    std::size_t produced{0};
+    std::size_t delivered{0};
+    std::size_t dropped{0};
+    Clock::duration elapsed{};
+    // Keeps the consumer's reads of the frame data observable.
+    std::uint64_t checksum{0};
+    std::vector<Clock::duration> latencies;
+};
+
+// Producer paced at `period` (zero: as fast as possible) for `frames` frames.
+template <typename Queue> Result run(std::size_t frames, std::chrono::microseconds period) {
+    Queue queue;
+    SyntheticSource source;
+    Result result{};
+    result.latencies.reserve(frames);
+    std::atomic<bool> done{false};
+    std::uint64_t checksum = 0;
+
+    const auto start = Clock::now();
+    std::thread consumer([&] {
+        while (true) {
+            const auto frame = queue.pop(std::chrono::milliseconds{5});
+            if (!frame) {
+                if (done.load(std::memory_order_acquire)) {
+                    break;
+                }
+                continue;
+            }
+            result.latencies.push_back(source.age(*frame));
+            checksum += (*frame)->buf[(*frame)->len - 1];
+            ++result.delivered;
+        }
+    });
+
+    auto next = Clock::now();
+    for (std::size_t i = 0; i < frames; ++i) {
+        if (period.count() > 0) {
+            next += period;
+            while (Clock::now() < next) {
+            }
+        }
+        result.dropped += queue.push(source.capture()) ? 1U : 0U;
+        ++result.produced;
+    }
+    done.store(true, std::memory_order_release);
+    queue.close();
+    consumer.join();
+    result.elapsed = Clock::now() - start;
+    result.checksum = checksum;
+    return result;
+}
+
+double micros(Clock::duration duration) {
+    return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count()) / 1000.0;
+}
+
+void report(const char *name, const char *mode, Result result) {
+    std::sort(result.latencies.begin(), result.latencies.end());
+    const auto percentile = [&](double p) {
+        if (result.latencies.empty()) {
+            return 0.0;
+        }
+        const auto index = static_cast<std::size_t>(p * static_cast<double>(result.latencies.size() - 1));
+        return micros(result.latencies[index]);
+    };
+    const double seconds = micros(result.elapsed) / 1e6;
+    std::cout << mode << " | " << name << ": " << static_cast<double>(result.delivered) / seconds
+              << " frames/s delivered, " << result.dropped << "/" << result.produced << " dropped, latency p50 "
+              << percentile(0.50) << " us, p99 " << percentile(0.99) << " us, max " << percentile(1.0) << " us"
+              << '\n';
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const std::size_t frames = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 1'000'000U;
+
+    // Unpaced producer: hand-off throughput and contention.
+    report(RingQueue::kName, "throughput", run<RingQueue>(frames, std::chrono::microseconds{0}));
+    report(MutexQueue::kName, "throughput", run<MutexQueue>(frames, std::chrono::microseconds{0}));
+
+    // 1 kHz producer: wake-up latency of a consumer that mostly sleeps.
+    const std::size_t pacedFrames = std::max<std::size_t>(frames / 200U, 1000U);
+    report(RingQueue::kName, "1 kHz    ", run<RingQueue>(pacedFrames, std::chrono::microseconds{1000}));
+    report(MutexQueue::kName, "1 kHz    ", run<MutexQueue>(pacedFrames, std::chrono::microseconds{1000}));
+    return 0;
+}
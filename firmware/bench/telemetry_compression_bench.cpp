@@ -0,0 +1,157 @@
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "minitrain/command_channel.hpp"
+#include "minitrain/telemetry_compression.hpp"
+
+// Compares the Gorilla-style telemetry blocks against the size of the samples
+// on the wire. Pass a capture made of concatenated telemetry frames as sent by
+// CommandChannel::publishTelemetry() (the format of fixtures/telemetry); without
+// one, a synthetic 50 Hz trace with sensor-like quantisation is used.
+
+namespace {
+
+using minitrain::TelemetrySample;
+using minitrain::TimedTelemetrySample;
+
+constexpr std::size_t kTelemetryPayloadSize = 6 * sizeof(float) + sizeof(std::uint32_t) + 8;
+
+float readFloat(const std::uint8_t *in) {
+    std::uint32_t bits = static_cast<std::uint32_t>(in[0]) | (static_cast<std::uint32_t>(in[1]) << 8U) |
+                         (static_cast<std::uint32_t>(in[2]) << 16U) | (static_cast<std::uint32_t>(in[3]) << 24U);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+std::vector<TimedTelemetrySample> loadCapture(const char *path) {
+    std::ifstream file(path, std::ios::binary);
+    const std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    const std::size_t frameSize = minitrain::kCommandFrameHeaderSize + kTelemetryPayloadSize;
+    std::vector<TimedTelemetrySample> trace;
+    for (std::size_t offset = 0; offset + frameSize <= bytes.size(); offset += frameSize) {
+        const auto frame = minitrain::CommandChannel::decodeFrame(
+            std::vector<std::uint8_t>(bytes.begin() + static_cast<std::ptrdiff_t>(offset),
+                                      bytes.begin() + static_cast<std::ptrdiff_t>(offset + frameSize)));
+        if (frame.payload.size() != kTelemetryPayloadSize) {
+            throw std::invalid_argument("Capture does not contain telemetry frames");
+        }
+        TimedTelemetrySample entry{};
+        entry.timestampMillis = frame.header.timestampMicros / 1000U;
+        auto &sample = entry.sample;
+        const auto *payload = frame.payload.data();
+        sample.speedMetersPerSecond = readFloat(payload);
+        sample.motorCurrentAmps = readFloat(payload + 4);
+        sample.batteryVoltage = readFloat(payload + 8);
+        sample.temperatureCelsius = readFloat(payload + 12);
+        sample.appliedSpeedMetersPerSecond = readFloat(payload + 16);
+        sample.failSafeProgress = readFloat(payload + 20);
+        sample.sequence = frame.header.sequence;
+        sample.commandTimestamp = frame.header.timestampMicros;
+        sample.sessionId = frame.header.sessionId;
+        sample.lightsOverrideMask = static_cast<std::uint8_t>(frame.header.lightsOverride & 0x7FU);
+        sample.appliedDirection = frame.header.direction;
+        trace.push_back(entry);
+    }
+    return trace;
+}
+
+std::vector<TimedTelemetrySample> syntheticTrace(std::size_t samples) {
+    std::mt19937 rng{42U};
+    std::normal_distribution<float> noise{0.0F, 1.0F};
+    std::vector<TimedTelemetrySample> trace(samples);
+    float speed = 0.0F;
+    for (std::size_t i = 0; i < samples; ++i) {
+        auto &entry = trace[i];
+        entry.timestampMillis = 1'700'000'000'000ULL + i * 20U + (i % 53U == 0U ? 1U : 0U);
+        const float target = (i / 3000U) % 2U == 0U ? 1.2F : 0.4F;
+        speed += (target - speed) * 0.01F;
+        auto &sample = entry.sample;
+        // Quantised like the hardware reports them: encoder mm/s, 4 mA ADC
+        // steps, 10 mV battery steps and a 0.25 degree temperature sensor.
+        sample.speedMetersPerSecond = std::round(speed * 1000.0F + noise(rng) * 2.0F) / 1000.0F;
+        sample.appliedSpeedMetersPerSecond = std::round(speed * 1000.0F) / 1000.0F;
+        sample.motorCurrentAmps = std::round((0.3F + speed * 0.4F) * 250.0F + noise(rng) * 0.5F) / 250.0F;
+        sample.batteryVoltage = std::round((12.4F - static_cast<float>(i) * 1.0e-5F) * 100.0F) / 100.0F;
+        sample.temperatureCelsius = std::round((28.0F + static_cast<float>(i) * 2.0e-4F) * 4.0F) / 4.0F;
+        sample.sequence = static_cast<std::uint32_t>(i + 1U);
+        sample.commandTimestamp = 1'700'000'000'000'000ULL + i * 20'000U;
+        sample.appliedDirection = minitrain::Direction::Forward;
+        sample.activeCab = minitrain::ActiveCab::Front;
+        sample.lightsState = minitrain::LightsState::FrontWhiteRearRed;
+    }
+    return trace;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::vector<TimedTelemetrySample> trace;
+    const char *source = "synthetic 50 Hz trace";
+    if (argc > 1) {
+        try {
+            trace = loadCapture(argv[1]);
+            source = argv[1];
+        } catch (const std::exception &ex) {
+            std::cerr << "WARN: " << argv[1] << " unusable (" << ex.what() << "), using synthetic trace" << '\n';
+        }
+    }
+    if (trace.empty()) {
+        trace = syntheticTrace(180'000); // one hour at 50 Hz
+    }
+
+    constexpr std::size_t kBlockSamples = 3000; // one minute per block
+    std::vector<std::vector<std::uint8_t>> blocks;
+    minitrain::TelemetryCompressor compressor;
+    const auto encodeStart = std::chrono::steady_clock::now();
+    for (const auto &entry : trace) {
+        compressor.append(entry.sample, entry.timestampMillis);
+        if (compressor.sampleCount() == kBlockSamples) {
+            blocks.push_back(compressor.finish());
+        }
+    }
+    if (compressor.sampleCount() > 0) {
+        blocks.push_back(compressor.finish());
+    }
+    const auto encodeTime = std::chrono::steady_clock::now() - encodeStart;
+
+    std::size_t decodedSamples = 0;
+    const auto decodeStart = std::chrono::steady_clock::now();
+    for (const auto &block : blocks) {
+        minitrain::TelemetryDecompressor decompressor{block};
+        while (decompressor.next()) {
+            ++decodedSamples;
+        }
+    }
+    const auto decodeTime = std::chrono::steady_clock::now() - decodeStart;
+
+    std::size_t compressed = 0;
+    for (const auto &block : blocks) {
+        compressed += block.size();
+    }
+    const double samples = static_cast<double>(trace.size());
+    const double wireBytes = samples * static_cast<double>(minitrain::kCommandFrameHeaderSize + kTelemetryPayloadSize);
+    const double payloadBytes = samples * static_cast<double>(kTelemetryPayloadSize + sizeof(std::uint64_t));
+    const auto nanos = [](auto duration) {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(duration).count());
+    };
+
+    std::cout << "source: " << source << ", " << trace.size() << " samples in " << blocks.size() << " blocks" << '\n';
+    std::cout << "compressed: " << compressed << " bytes, " << static_cast<double>(compressed) * 8.0 / samples
+              << " bits/sample" << '\n';
+    std::cout << "ratio vs wire frames (" << minitrain::kCommandFrameHeaderSize + kTelemetryPayloadSize
+              << " B/sample): " << wireBytes / static_cast<double>(compressed) << "x" << '\n';
+    std::cout << "ratio vs payload + timestamp (" << kTelemetryPayloadSize + sizeof(std::uint64_t)
+              << " B/sample): " << payloadBytes / static_cast<double>(compressed) << "x" << '\n';
+    std::cout << "encode: " << nanos(encodeTime) / samples << " ns/sample, decode: "
+              << nanos(decodeTime) / static_cast<double>(decodedSamples) << " ns/sample" << '\n';
+    return decodedSamples == trace.size() ? 0 : 1;
+}
@@ -0,0 +1,73 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "minitrain/yuv_kernels.hpp"
+
+// Throughput of the YUV422 -> luma kernels in megapixels of camera input per
+// second, for every kernel set available on this machine, at the frame sizes
+// the camera streams (QVGA and VGA).
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+struct FrameSize {
+    const char *name;
+    std::size_t width;
+    std::size_t height;
+};
+
+double megapixelsPerSecond(const std::vector<std::uint8_t> &frame, const FrameSize &size, std::size_t factor,
+                           minitrain::LumaReduction reduction, minitrain::SimdIsa isa, std::size_t iterations,
+                           std::vector<std::uint8_t> &output) {
+    output.resize(minitrain::lumaOutputSize(size.width, size.height, factor));
+    // Warm caches and the AVX2 detection before timing.
+    (void)minitrain::yuv422ToLuma(frame.data(), size.width, size.height, factor, reduction, output.data(), isa);
+    const auto start = Clock::now();
+    for (std::size_t i = 0; i < iterations; ++i) {
+        (void)minitrain::yuv422ToLuma(frame.data(), size.width, size.height, factor, reduction, output.data(), isa);
+    }
+    const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    const double pixels = static_cast<double>(size.width * size.height * iterations);
+    return seconds > 0.0 ? pixels / seconds / 1e6 : 0.0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const std::size_t iterations = argc > 1 ? static_cast<std::size_t>(std::stoul(argv[1])) : 2000U;
+    const FrameSize sizes[] = {{"QVGA", 320, 240}, {"VGA ", 640, 480}};
+    std::mt19937 rng(7);
+    std::uniform_int_distribution<int> byte(0, 255);
+    std::vector<std::uint8_t> output;
+
+    for (const auto &size : sizes) {
+        std::vector<std::uint8_t> frame(size.width * size.height * 2U);
+        std::generate(frame.begin(), frame.end(), [&] { return static_cast<std::uint8_t>(byte(rng)); });
+        for (const std::size_t factor : {1U, 2U, 4U}) {
+            for (const auto reduction : {minitrain::LumaReduction::Average, minitrain::LumaReduction::Subsample}) {
+                if (factor == 1 && reduction == minitrain::LumaReduction::Subsample) {
+                    continue;
+                }
+                const double scalar = megapixelsPerSecond(frame, size, factor, reduction, minitrain::SimdIsa::Scalar,
+                                                          iterations, output);
+                for (const auto isa : minitrain::availableYuvKernels()) {
+                    const double rate = isa == minitrain::SimdIsa::Scalar
+                                            ? scalar
+                                            : megapixelsPerSecond(frame, size, factor, reduction, isa, iterations,
+                                                                  output);
+                    std::cout << size.name << " 1/" << factor << ' '
+                              << (reduction == minitrain::LumaReduction::Average ? "average  " : "subsample")
+                              << " | " << minitrain::toString(isa) << ": " << rate << " MP/s ("
+                              << (scalar > 0.0 ? rate / scalar : 0.0) << "x scalar)" << '\n';
+                }
+            }
+        }
+    }
+    return 0;
+}
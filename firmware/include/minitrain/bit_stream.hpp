@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+namespace minitrain {
+
+// MSB-first bit packer used by the compressed telemetry encodings.
+class BitWriter {
+  public:
+    void write(std::uint64_t value, unsigned bits) {
+        while (bits > 0) {
+            const unsigned used = static_cast<unsigned>(bitCount_ % 8U);
+            if (used == 0) {
+                bytes_.push_back(0U);
+            }
+            const unsigned room = 8U - used;
+            const unsigned take = bits < room ? bits : room;
+            const auto chunk = static_cast<std::uint8_t>((value >> (bits - take)) & ((1U << take) - 1U));
+            bytes_.back() = static_cast<std::uint8_t>(bytes_.back() | (chunk << (room - take)));
+            bits -= take;
+            bitCount_ += take;
+        }
+    }
+
+    void writeBit(bool bit) { write(bit ? 1U : 0U, 1); }
+
+    void reserve(std::size_t bytes) { bytes_.reserve(bytes); }
+
+    void clear() {
+        bytes_.clear();
+        bitCount_ = 0;
+    }
+
+    [[nodiscard]] std::size_t bitCount() const { return bitCount_; }
+    [[nodiscard]] const std::vector<std::uint8_t> &bytes() const { return bytes_; }
+
+  private:
+    std::vector<std::uint8_t> bytes_;
+    std::size_t bitCount_{0};
+};
+
+class BitReader {
+  public:
+    BitReader(const std::uint8_t *data, std::size_t size) : data_{data}, size_{size} {}
+
+    std::uint64_t read(unsigned bits) {
+        if (bits > remaining()) {
+            throw std::invalid_argument("Truncated bit stream");
+        }
+        std::uint64_t value = 0;
+        while (bits > 0) {
+            const unsigned used = static_cast<unsigned>(position_ % 8U);
+            const unsigned room = 8U - used;
+            const unsigned take = bits < room ? bits : room;
+            const auto byte = data_[position_ / 8U];
+            const auto chunk = static_cast<std::uint64_t>((byte >> (room - take)) & ((1U << take) - 1U));
+            value = (value << take) | chunk;
+            bits -= take;
+            position_ += take;
+        }
+        return value;
+    }
+
+    bool readBit() { return read(1) != 0U; }
+
+    [[nodiscard]] std::size_t remaining() const { return size_ * 8U - position_; }
+
+  private:
+    const std::uint8_t *data_;
+    std::size_t size_;
+    std::size_t position_{0};
+};
+
+} // namespace minitrain
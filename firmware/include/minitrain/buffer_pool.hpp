@@ -0,0 +1,94 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace minitrain {
+
+struct BufferPoolClass {
+    std::size_t blockBytes{0};
+    // Below 65535; larger classes are ignored.
+    std::size_t blockCount{0};
+};
+
+struct BufferPoolStats {
+    std::size_t blockBytes{0};
+    std::size_t capacity{0};
+    std::size_t inUse{0};
+    // Most blocks ever in use at once.
+    std::size_t highWater{0};
+    std::uint64_t acquired{0};
+    // Requests this class should have served but found empty.
+    std::uint64_t exhausted{0};
+};
+
+// Fixed set of size classes, each a single slab carved into equal blocks at
+// construction; nothing is allocated afterwards. allocate() and release()
+// are lock-free (a tagged Treiber stack per class) and may be called from
+// any thread, so per-frame bookkeeping on the video path never touches the
+// general heap after startup.
+class BufferPool {
+  public:
+    explicit BufferPool(std::vector<BufferPoolClass> classes);
+    ~BufferPool();
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    // A block from the smallest class that fits and still has one free, or
+    // nullptr. Blocks are aligned for any scalar type.
+    [[nodiscard]] void *allocate(std::size_t bytes);
+    // block must have come from allocate() on this pool.
+    void release(void *block);
+    [[nodiscard]] bool owns(const void *block) const;
+
+    // One entry per class, smallest blocks first.
+    [[nodiscard]] std::vector<BufferPoolStats> stats() const;
+    [[nodiscard]] std::size_t inUse() const;
+
+  private:
+    struct SizeClass;
+
+    std::vector<std::unique_ptr<SizeClass>> classes_;
+};
+
+// Standard allocator over a BufferPool, e.g. for std::allocate_shared. Falls
+// back to the heap when the pool is exhausted (counted in its stats) or
+// absent. The allocator keeps the pool alive, so objects may outlive the
+// component that created the pool.
+template <typename T> class PoolAllocator {
+    static_assert(alignof(T) <= alignof(std::max_align_t), "PoolAllocator does not support over-aligned types");
+
+  public:
+    using value_type = T;
+
+    explicit PoolAllocator(std::shared_ptr<BufferPool> pool) noexcept : pool_(std::move(pool)) {}
+    template <typename U> PoolAllocator(const PoolAllocator<U> &other) noexcept : pool_(other.pool_) {}
+
+    T *allocate(std::size_t count) {
+        void *memory = pool_ ? pool_->allocate(count * sizeof(T)) : nullptr;
+        return static_cast<T *>(memory != nullptr ? memory : ::operator new(count * sizeof(T)));
+    }
+
+    void deallocate(T *memory, std::size_t) noexcept {
+        if (pool_ && pool_->owns(memory)) {
+            pool_->release(memory);
+        } else {
+            ::operator delete(memory);
+        }
+    }
+
+    template <typename U> bool operator==(const PoolAllocator<U> &other) const noexcept { return pool_ == other.pool_; }
+    template <typename U> bool operator!=(const PoolAllocator<U> &other) const noexcept { return pool_ != other.pool_; }
+
+  private:
+    std::shared_ptr<BufferPool> pool_;
+
+    template <typename U> friend class PoolAllocator;
+};
+
+} // namespace minitrain
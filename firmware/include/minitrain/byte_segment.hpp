@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minitrain {
+
+// Non-owning view of bytes that are sent as part of a larger message. A list
+// of segments is transmitted back to back, so headers and payloads stored in
+// different buffers go out as one message without being copied together.
+struct ByteSegment {
+    const std::uint8_t *data{nullptr};
+    std::size_t size{0};
+};
+
+} // namespace minitrain
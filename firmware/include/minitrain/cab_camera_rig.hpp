@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/train_state.hpp"
+
+namespace minitrain {
+
+struct CabCameraConfig {
+    // Capture interval of the camera facing the active cab.
+    std::chrono::milliseconds activeInterval{std::chrono::milliseconds{33}};
+    // The other camera keeps capturing this slowly so its sensor, exposure
+    // and white balance stay settled for an immediate switch.
+    std::chrono::milliseconds standbyInterval{std::chrono::milliseconds{1000}};
+    // Frames queued per camera for the consumer.
+    std::size_t queueDepth{1};
+};
+
+struct CabCameraStats {
+    ActiveCab streamingCab{ActiveCab::None};
+    std::uint64_t switchovers{0};
+    // From setActiveCab() to the first frame of the new cab handed out.
+    std::chrono::microseconds lastSwitchLatency{0};
+    // Frames captured before a switch and discarded after it.
+    std::uint64_t staleFrames{0};
+};
+
+// Streams the front or rear camera depending on the active cab. Both
+// streamers keep running: the one facing the active cab at the full rate,
+// the other at a warm standby rate whose frames are never sent. A cab change
+// only swaps the two intervals and the queue the consumer reads, so the
+// first frame of the new cab is captured straight away and only one camera
+// costs bandwidth. Boards with a single sensor pass no rear streamer; the
+// front camera then serves both cabs.
+class CabCameraRig {
+  public:
+    explicit CabCameraRig(CabCameraConfig config = {});
+    ~CabCameraRig();
+
+    CabCameraRig(const CabCameraRig &) = delete;
+    CabCameraRig &operator=(const CabCameraRig &) = delete;
+
+    // The streamers must be initialized and outlive the rig; they are started
+    // if needed and stopped by stop() (initialize them again to restart).
+    // The front camera is active until setActiveCab() says otherwise. Call
+    // both from the consumer thread.
+    bool start(CameraStreamer *front, CameraStreamer *rear = nullptr);
+    void stop();
+    [[nodiscard]] bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Any thread. ActiveCab::None (train stopped) keeps the current camera.
+    void setActiveCab(ActiveCab cab);
+    // New full-rate interval, e.g. from VideoQualityController.
+    void setActiveInterval(std::chrono::milliseconds interval);
+    // Applied to both cameras so a switch needs no sensor reconfiguration.
+    bool setVideoQuality(framesize_t frameSize, int jpegQuality);
+
+    // Single consumer. Only frames of the active cab captured after the last
+    // switch are returned.
+    [[nodiscard]] std::optional<SharedFrame> tryAcquireFrame(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] ActiveCab streamingCab() const;
+    [[nodiscard]] CameraStreamer *streamer(ActiveCab cab) const;
+    [[nodiscard]] CabCameraStats stats() const;
+
+  private:
+    static constexpr std::size_t kFront = 0;
+    static constexpr std::size_t kRear = 1;
+
+    CabCameraConfig config_;
+    std::array<CameraStreamer *, 2> cameras_{};
+    std::array<std::shared_ptr<FrameSubscription>, 2> subscriptions_{};
+    std::atomic<bool> running_{false};
+
+    // Serialises switches and interval changes.
+    mutable std::mutex mutex_;
+    std::atomic<std::size_t> active_{kFront};
+    std::atomic<std::int64_t> switchedAtMicros_{0};
+    std::atomic<bool> awaitingFirstFrame_{false};
+    std::atomic<std::uint64_t> switchovers_{0};
+    std::atomic<std::int64_t> switchLatencyMicros_{0};
+    std::atomic<std::uint64_t> staleFrames_{0};
+};
+
+} // namespace minitrain
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "minitrain/esp_target_check.hpp"
+
+#ifdef ESP_PLATFORM
+#include "esp_camera.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#else
+using esp_err_t = int;
+constexpr esp_err_t ESP_OK = 0;
+
+using pixformat_t = int;
+using framesize_t = int;
+constexpr pixformat_t PIXFORMAT_JPEG = 0;
+constexpr pixformat_t PIXFORMAT_YUV422 = 1;
+constexpr framesize_t FRAMESIZE_VGA = 0;
+constexpr framesize_t FRAMESIZE_QVGA = 1;
+constexpr framesize_t FRAMESIZE_QQVGA = 2;
+
+struct camera_config_t {
+    int ledc_channel{0};
+    int ledc_timer{0};
+    int pin_pwdn{0};
+    int pin_reset{0};
+    int pin_xclk{0};
+    int pin_sccb_sda{0};
+    int pin_sccb_scl{0};
+    int pin_d7{0};
+    int pin_d6{0};
+    int pin_d5{0};
+    int pin_d4{0};
+    int pin_d3{0};
+    int pin_d2{0};
+    int pin_d1{0};
+    int pin_d0{0};
+    int pin_vsync{0};
+    int pin_href{0};
+    int pin_pclk{0};
+    int xclk_freq_hz{0};
+    pixformat_t pixel_format{PIXFORMAT_JPEG};
+    framesize_t frame_size{FRAMESIZE_VGA};
+    int jpeg_quality{10};
+    int fb_count{2};
+    int grab_mode{0};
+    int fb_location{0};
+    bool dual_fb{false};
+    int sccb_i2c_port{0};
+    int clock_speed{0};
+};
+
+struct camera_fb_t {
+    std::uint8_t *buf{nullptr};
+    std::size_t len{0};
+    std::size_t width{0};
+    std::size_t height{0};
+    pixformat_t format{PIXFORMAT_JPEG};
+};
+
+inline esp_err_t esp_camera_init(const camera_config_t *) { return ESP_OK; }
+inline void esp_camera_deinit() {}
+inline camera_fb_t *esp_camera_fb_get() { return nullptr; }
+inline void esp_camera_fb_return(camera_fb_t *) {}
+inline const char *esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+
+constexpr int CAMERA_GRAB_WHEN_EMPTY = 0;
+constexpr int CAMERA_GRAB_LATEST = 1;
+constexpr int CAMERA_FB_IN_PSRAM = 0;
+constexpr int LEDC_TIMER_0 = 0;
+constexpr int LEDC_CHANNEL_0 = 0;
+#endif
+
+namespace minitrain {
+
+// Produces camera frame buffers for CameraStreamer. acquire() is called from
+// the capture thread and may block until a frame is due; release() hands a
+// buffer back and may be called from any thread.
+class FrameSource {
+  public:
+    virtual ~FrameSource() = default;
+
+    // Returns nullptr when no frame could be captured.
+    virtual camera_fb_t *acquire() = 0;
+    virtual void release(camera_fb_t *frame) = 0;
+    // Retunes the sensor while streaming. Returns false if the source cannot.
+    virtual bool applySettings(framesize_t frameSize, int jpegQuality) {
+        (void)frameSize;
+        (void)jpegQuality;
+        return false;
+    }
+};
+
+// The esp32-camera driver. On host builds the driver stubs never produce a
+// frame; use SyntheticFrameSource there.
+class EspCameraFrameSource final : public FrameSource {
+  public:
+    camera_fb_t *acquire() override { return esp_camera_fb_get(); }
+    void release(camera_fb_t *frame) override { esp_camera_fb_return(frame); }
+    bool applySettings(framesize_t frameSize, int jpegQuality) override {
+#ifdef ESP_PLATFORM
+        sensor_t *sensor = esp_camera_sensor_get();
+        return sensor != nullptr && sensor->set_framesize(sensor, frameSize) == 0 &&
+               sensor->set_quality(sensor, jpegQuality) == 0;
+#else
+        return FrameSource::applySettings(frameSize, jpegQuality);
+#endif
+    }
+};
+
+} // namespace minitrain
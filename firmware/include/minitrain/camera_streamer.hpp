@@ -1,112 +1,281 @@
 #pragma once
 
+#include <array>
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <cstddef>
 #include <cstdint>
-#include <deque>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <string>
 #include <thread>
+#include <vector>
 
-#include "minitrain/esp_target_check.hpp"
-
-#ifdef ESP_PLATFORM
-#include "esp_camera.h"
-#include "esp_err.h"
-#include "esp_timer.h"
-#else
-using esp_err_t = int;
-constexpr esp_err_t ESP_OK = 0;
-
-using pixformat_t = int;
-using framesize_t = int;
-constexpr pixformat_t PIXFORMAT_JPEG = 0;
-constexpr pixformat_t PIXFORMAT_YUV422 = 1;
-constexpr framesize_t FRAMESIZE_VGA = 0;
-constexpr framesize_t FRAMESIZE_QVGA = 1;
-
-struct camera_config_t {
-    int ledc_channel{0};
-    int ledc_timer{0};
-    int pin_pwdn{0};
-    int pin_reset{0};
-    int pin_xclk{0};
-    int pin_sccb_sda{0};
-    int pin_sccb_scl{0};
-    int pin_d7{0};
-    int pin_d6{0};
-    int pin_d5{0};
-    int pin_d4{0};
-    int pin_d3{0};
-    int pin_d2{0};
-    int pin_d1{0};
-    int pin_d0{0};
-    int pin_vsync{0};
-    int pin_href{0};
-    int pin_pclk{0};
-    int xclk_freq_hz{0};
-    pixformat_t pixel_format{PIXFORMAT_JPEG};
-    framesize_t frame_size{FRAMESIZE_VGA};
-    int jpeg_quality{10};
-    int fb_count{2};
-    int grab_mode{0};
-    int fb_location{0};
-    bool dual_fb{false};
-    int sccb_i2c_port{0};
-    int clock_speed{0};
+#include "minitrain/buffer_pool.hpp"
+#include "minitrain/camera_driver.hpp"
+#include "minitrain/frame_fingerprint.hpp"
+#include "minitrain/jpeg_validator.hpp"
+#include "minitrain/spsc_ring.hpp"
+#include "minitrain/yuv_kernels.hpp"
+
+namespace minitrain {
+
+class FrameFanout;
+class FrameSubscription;
+
+// Block size of the pool CameraStreamer sizes from fb_count: it holds the
+// fanout bookkeeping of a frame or a video message wrapping one.
+constexpr std::size_t kFrameMetadataBytes = 192;
+
+// Reference-counted handle to a driver frame buffer. Copies share the buffer;
+// it goes back to the driver when the last handle is released, so the same
+// frame can be streamed, recorded and analysed without copying it.
+class SharedFrame {
+  public:
+    SharedFrame() = default;
+    SharedFrame(const SharedFrame &other) noexcept;
+    SharedFrame &operator=(const SharedFrame &other) noexcept;
+    SharedFrame(SharedFrame &&other) noexcept;
+    SharedFrame &operator=(SharedFrame &&other) noexcept;
+    ~SharedFrame();
+
+    [[nodiscard]] const std::uint8_t *data() const;
+    [[nodiscard]] std::size_t size() const;
+    [[nodiscard]] camera_fb_t *raw() const { return block_ ? block_->frame : nullptr; }
+    [[nodiscard]] std::uint32_t useCount() const;
+    // Monotonic (steady_clock) time the frame left the driver.
+    [[nodiscard]] std::chrono::steady_clock::time_point captureTime() const;
+    // Consecutive per publisher, so a gap tells a consumer how many frames
+    // it missed.
+    [[nodiscard]] std::uint64_t sequence() const;
+    // Computed once on the capture thread; invalid for frames published
+    // without one.
+    [[nodiscard]] const FrameFingerprint &fingerprint() const;
+    // Set when the streamer validates JPEGs in JpegValidation::Flag mode.
+    [[nodiscard]] JpegDefect jpegDefect() const;
+
+  private:
+    struct Block {
+        camera_fb_t *frame{nullptr};
+        FrameFanout *owner{nullptr};
+        std::chrono::steady_clock::time_point captured{};
+        std::uint64_t sequence{0};
+        FrameFingerprint fingerprint{};
+        JpegDefect defect{JpegDefect::None};
+        // Pool the block was carved from; nullptr for heap blocks.
+        BufferPool *pool{nullptr};
+        std::atomic<std::uint32_t> references{1};
+    };
+
+    // Adopts one reference already counted in the block.
+    explicit SharedFrame(Block *block) : block_(block) {}
+    static void retain(Block *block);
+    static void release(Block *block);
+    void reset();
+
+    Block *block_{nullptr};
+
+    friend class FrameFanout;
+    friend class FrameSubscription;
 };
 
-struct camera_fb_t {
-    std::uint8_t *buf{nullptr};
-    std::size_t len{0};
-    std::size_t width{0};
-    std::size_t height{0};
-    pixformat_t format{PIXFORMAT_JPEG};
+enum class FrameDropPolicy : std::uint8_t {
+    // Keep the freshest frames: evict the oldest queued frame (live view).
+    DropOldest = 0,
+    // Keep what is queued and skip new frames until there is room (recorders
+    // that prefer contiguous runs).
+    DropNewest = 1,
+    // A single slot that always holds the newest frame; depth is ignored.
+    LatestOnly = 2,
 };
 
-inline esp_err_t esp_camera_init(const camera_config_t *) { return ESP_OK; }
-inline void esp_camera_deinit() {}
-inline camera_fb_t *esp_camera_fb_get() { return nullptr; }
-inline void esp_camera_fb_return(camera_fb_t *) {}
-inline const char *esp_err_to_name(esp_err_t err) { return err == ESP_OK ? "ESP_OK" : "ESP_FAIL"; }
+struct FrameSubscriptionStats {
+    std::uint64_t deliveredFrames{0};
+    std::uint64_t droppedFrames{0};
+    std::size_t pending{0};
+    double deliveredFps{0.0};
+    // Capture to acquire, smoothed and worst case.
+    std::chrono::microseconds averageLatency{0};
+    std::chrono::microseconds maxLatency{0};
+};
 
-constexpr int CAMERA_GRAB_WHEN_EMPTY = 0;
-constexpr int CAMERA_GRAB_LATEST = 1;
-constexpr int CAMERA_FB_IN_PSRAM = 0;
-constexpr int LEDC_TIMER_0 = 0;
-constexpr int LEDC_CHANNEL_0 = 0;
-#endif
+// Bounded per-consumer frame queue fed by a FrameFanout. The publisher never
+// waits for a subscriber; each one applies its own drop policy, so a slow
+// consumer only loses its own frames.
+class FrameSubscription {
+  public:
+    FrameSubscription(std::size_t depth, FrameDropPolicy policy);
+    ~FrameSubscription();
 
-namespace minitrain {
+    FrameSubscription(const FrameSubscription &) = delete;
+    FrameSubscription &operator=(const FrameSubscription &) = delete;
 
-class CameraStreamer {
+    // Single consumer. Returns std::nullopt on timeout or when the queue is
+    // flushed while waiting (e.g. the stream stopped).
+    [[nodiscard]] std::optional<SharedFrame> tryAcquire(std::chrono::milliseconds timeout);
+
+    [[nodiscard]] FrameDropPolicy policy() const { return policy_; }
+    [[nodiscard]] std::size_t depth() const { return queue_.capacity(); }
+    [[nodiscard]] std::size_t pending() const { return queue_.size(); }
+    [[nodiscard]] std::uint64_t droppedFrames() const { return dropped_.load(std::memory_order_relaxed); }
+    // Lock-free snapshot; safe from any thread.
+    [[nodiscard]] FrameSubscriptionStats stats() const;
+
+    // Releases queued frames and wakes a waiting consumer.
+    void flush();
+
+  private:
+    void offer(SharedFrame::Block *block);
+    SharedFrame deliver(SharedFrame::Block *block);
+
+    FrameDropPolicy policy_;
+    SpscRing<SharedFrame::Block *> queue_;
+    EventCount available_;
+    std::atomic<std::uint64_t> dropped_{0};
+    // Written by the consumer only.
+    std::atomic<std::uint64_t> delivered_{0};
+    std::atomic<std::int64_t> lastDeliveryMicros_{0};
+    std::atomic<std::int64_t> deliveryIntervalMicros_{0};
+    std::atomic<std::int64_t> latencyMicros_{0};
+    std::atomic<std::int64_t> maxLatencyMicros_{0};
+
+    friend class FrameFanout;
+};
+
+// Hands every published frame to all subscriptions and returns the buffer
+// through the releaser once no subscription or handle references it. Publish
+// from a single thread; subscribing may happen from any thread. The fanout
+// must outlive the frames it publishes.
+class FrameFanout {
   public:
-    class Frame {
-      public:
-        Frame();
-        Frame(const Frame &) = delete;
-        Frame &operator=(const Frame &) = delete;
-        Frame(Frame &&other) noexcept;
-        Frame &operator=(Frame &&other) noexcept;
-        ~Frame();
-
-        [[nodiscard]] const std::uint8_t *data() const;
-        [[nodiscard]] std::size_t size() const;
-        [[nodiscard]] camera_fb_t *raw() const { return frame_; }
-
-      private:
-        Frame(camera_fb_t *frame, CameraStreamer *owner);
-        void release();
-
-        camera_fb_t *frame_{nullptr};
-        CameraStreamer *owner_{nullptr};
-
-        friend class CameraStreamer;
-    };
+    using Releaser = std::function<void(camera_fb_t *)>;
+
+    static constexpr std::size_t kMaxSubscribers = 8;
+
+    explicit FrameFanout(Releaser releaser);
+    ~FrameFanout();
+
+    FrameFanout(const FrameFanout &) = delete;
+    FrameFanout &operator=(const FrameFanout &) = delete;
 
+    // nullptr once kMaxSubscribers subscriptions exist.
+    [[nodiscard]] std::shared_ptr<FrameSubscription> subscribe(std::size_t depth, FrameDropPolicy policy);
+    // Returns after any publish() still offering to the subscription is done.
+    void unsubscribe(const std::shared_ptr<FrameSubscription> &subscription);
+    [[nodiscard]] std::size_t subscriberCount() const;
+    // Frames dropped by all current subscriptions.
+    [[nodiscard]] std::uint64_t droppedFrames() const;
+    // Published frames not yet handed back to the releaser.
+    [[nodiscard]] std::size_t heldFrames() const { return held_.load(std::memory_order_relaxed); }
+
+    void publish(camera_fb_t *frame,
+                 std::chrono::steady_clock::time_point captured = std::chrono::steady_clock::now(),
+                 const FrameFingerprint &fingerprint = {},
+                 JpegDefect defect = JpegDefect::None);
+    // Drops every queued frame and wakes waiting consumers.
+    void flush();
+    // Sequence the next published frame will carry; publisher thread only.
+    [[nodiscard]] std::uint64_t nextSequence() const { return nextSequence_; }
+    // Frame bookkeeping comes from this pool, or the heap once it is
+    // exhausted. Set while nothing is published; the pool must outlive the
+    // frames allocated from it.
+    void setBufferPool(std::shared_ptr<BufferPool> pool) { pool_ = std::move(pool); }
+
+  private:
+    // Calls fn(FrameSubscription &) for every subscription, lock-free.
+    template <typename Fn> void forEachSubscriber(Fn &&fn) const;
+    void returnFrame(camera_fb_t *frame) const;
+
+    Releaser releaser_;
+    // Publisher thread only.
+    std::uint64_t nextSequence_{0};
+    std::shared_ptr<BufferPool> pool_;
+    std::atomic<std::size_t> held_{0};
+    // Readers walk the slots with plain atomic loads and count themselves in
+    // readers_. unsubscribe() empties a slot, then waits for readers_ to
+    // drain before it drops the reference, so no walk can still see it.
+    // std::atomic_load on a shared_ptr would take a lock from libstdc++'s
+    // mutex pool on every publish instead.
+    std::array<std::atomic<FrameSubscription *>, kMaxSubscribers> slots_{};
+    mutable std::atomic<std::uint32_t> readers_{0};
+    // Keeps the slotted subscriptions alive; guarded by subscribersMutex_.
+    std::vector<std::shared_ptr<FrameSubscription>> owned_;
+    std::mutex subscribersMutex_;
+
+    friend class SharedFrame;
+};
+
+enum class CameraBackpressure : std::uint8_t {
+    // The default consumer only ever sees the newest frame.
+    LatestOnly = 0,
+    DropOldest = 1,
+    DropNewest = 2,
+    // DropOldest, and the capture interval stretches while any subscriber is
+    // dropping frames and shrinks back once they keep up again.
+    AdaptiveInterval = 3,
+};
+
+struct CameraBackpressureConfig {
+    CameraBackpressure policy{CameraBackpressure::DropOldest};
+    std::chrono::milliseconds maxCaptureInterval{std::chrono::milliseconds{250}};
+};
+
+enum class JpegValidation : std::uint8_t {
+    Off = 0,
+    // Publish corrupt frames marked with SharedFrame::jpegDefect().
+    Flag = 1,
+    // Hand corrupt frames straight back to the driver.
+    Drop = 2,
+};
+
+struct CameraStreamStats {
+    double captureFps{0.0};
+    double deliveredFps{0.0};
+    std::uint64_t capturedFrames{0};
+    std::uint64_t deliveredFrames{0};
+    // Drops across the default queue and every subscription.
+    std::uint64_t droppedFrames{0};
+    // Frames waiting in the default queue.
+    std::size_t queueDepth{0};
+    // Frames out of the driver: queued, held by consumers or being sent.
+    // Capture stalls once this reaches fb_count.
+    std::size_t heldFrames{0};
+    std::chrono::microseconds captureInterval{0};
+    // Pacing ticks skipped because a capture overran its slot.
+    std::uint64_t missedTicks{0};
+    std::chrono::microseconds averageLatency{0};
+    std::chrono::microseconds maxLatency{0};
+    // Luma stage: frames converted, and frames skipped because every luma
+    // buffer was still held by a reader.
+    std::uint64_t lumaFrames{0};
+    std::uint64_t lumaSkipped{0};
+    // JPEG frames that failed validation, dropped or flagged, and the defect
+    // of the most recent one.
+    std::uint64_t corruptFrames{0};
+    JpegDefect lastJpegDefect{JpegDefect::None};
+    // Streamer buffer pool, summed over its size classes; exhaustion means
+    // allocations fell back to the heap.
+    std::size_t poolBlocksInUse{0};
+    std::size_t poolHighWater{0};
+    std::uint64_t poolExhausted{0};
+};
+
+// Downscaled grayscale copy of a YUV422 frame, for the low-bitrate navigation
+// view and motion detection. Buffers are recycled once no reader holds them.
+struct LumaFrame {
+    std::size_t width{0};
+    std::size_t height{0};
+    // Sequence and capture time of the source frame.
+    std::uint64_t sequence{0};
+    std::chrono::steady_clock::time_point captureTime{};
+    std::vector<std::uint8_t> pixels;
+};
+
+class CameraStreamer {
+  public:
+    using Frame = SharedFrame;
     using ErrorHandler = std::function<void(const std::string &)>;
 
     CameraStreamer();
@@ -117,41 +286,136 @@ class CameraStreamer {
     CameraStreamer(CameraStreamer &&) = delete;
     CameraStreamer &operator=(CameraStreamer &&) = delete;
 
+    // Overflowing queues never stop the stream: frames are dropped according
+    // to the backpressure policy. maxConsecutiveFailures only counts failed
+    // captures from the driver.
     bool initialize(const camera_config_t &config,
                     std::chrono::milliseconds captureInterval = std::chrono::milliseconds{0},
                     std::size_t maxBufferedFrames = 2,
                     std::size_t maxConsecutiveFailures = 5,
-                    ErrorHandler errorHandler = nullptr);
+                    ErrorHandler errorHandler = nullptr,
+                    CameraBackpressureConfig backpressure = {});
+
+    // Replaces the camera driver, e.g. with a SyntheticFrameSource on hosts.
+    // Stops the stream; call initialize() again afterwards. Frames from the
+    // previous source must have been released. nullptr restores the driver.
+    void setFrameSource(std::shared_ptr<FrameSource> source);
+
+    // Runtime retuning, e.g. from VideoQualityController. setVideoQuality
+    // returns false if the source cannot change settings while streaming.
+    bool setVideoQuality(framesize_t frameSize, int jpegQuality);
+    // New base interval; with AdaptiveInterval it is also the floor the
+    // adaptation recovers to, and any backoff above the floor is kept
+    // rather than reset. A capture waiting for its tick is woken and
+    // the schedule restarts from now, so shortening a long interval (e.g. a
+    // standby camera becoming active) takes effect at once.
+    void setCaptureInterval(std::chrono::milliseconds interval);
+    // Converts every YUV422 frame into a grayscale image downscaled by
+    // factor (1, 2 or 4) on the capture thread; 0 turns the stage off.
+    // Returns false for other factors. May be changed while streaming.
+    bool setLumaStage(std::size_t factor, LumaReduction reduction = LumaReduction::Average);
+    // Structural check of every JPEG frame on the capture thread (see
+    // validateJpeg); Drop by default, so a frame torn by a DMA overrun or a
+    // sensor glitch never reaches the uplink. May be changed while streaming.
+    void setJpegValidation(JpegValidation mode) { jpegValidation_.store(mode, std::memory_order_relaxed); }
 
     bool start();
     void stop();
 
     [[nodiscard]] bool isInitialized() const { return initialized_; }
-    [[nodiscard]] bool isRunning() const { return running_; }
+    [[nodiscard]] bool isRunning() const { return running_.load(std::memory_order_acquire); }
 
+    // Default consumer: a queue of maxBufferedFrames using the backpressure
+    // policy, created on first use. Called from a single consumer thread;
+    // never blocks the capture thread.
     [[nodiscard]] std::optional<Frame> tryAcquireFrame(std::chrono::milliseconds timeout);
 
+    // Additional consumers with their own queue depth and drop policy;
+    // nullptr once FrameFanout::kMaxSubscribers exist, the default one included.
+    [[nodiscard]] std::shared_ptr<FrameSubscription> subscribe(std::size_t depth,
+                                                               FrameDropPolicy policy = FrameDropPolicy::DropOldest);
+    void unsubscribe(const std::shared_ptr<FrameSubscription> &subscription);
+
+    // Newest output of the luma stage, or nullptr if it has not produced one
+    // since start(). Safe from any thread.
+    [[nodiscard]] std::shared_ptr<const LumaFrame> latestLumaFrame() const;
+
+    // Lock-free snapshot; safe from any thread while streaming.
+    [[nodiscard]] CameraStreamStats stats() const;
+
+    // Fixed pool sized from fb_count in initialize() for per-frame
+    // bookkeeping; pass it to makeVideoMessage() so the send path allocates
+    // from it too. nullptr before the first initialize().
+    [[nodiscard]] std::shared_ptr<BufferPool> bufferPool() const { return pool_; }
+
     static camera_config_t createDefaultConfig();
 
   private:
     void captureLoop();
     void returnFrame(camera_fb_t *frame);
+    void adaptCaptureInterval(std::uint64_t droppedFrames);
+    void runLumaStage(const camera_fb_t &frame, std::chrono::steady_clock::time_point captured);
+    // Returns once no stats() call can still see what statsPool_ and
+    // defaultQueue_ pointed to before the caller cleared them.
+    void waitForStatsReaders() const;
 
     camera_config_t config_{};
     std::chrono::milliseconds captureInterval_{0};
     std::size_t maxBufferedFrames_{2};
     std::size_t maxConsecutiveFailures_{5};
     ErrorHandler errorHandler_{};
+    CameraBackpressureConfig backpressure_{};
 
+    std::shared_ptr<FrameSource> source_;
+    std::shared_ptr<BufferPool> pool_;
+    bool customSource_{false};
     bool initialized_{false};
-    bool running_{false};
-    bool stopRequested_{false};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> stopRequested_{false};
 
     std::thread captureThread_;
-    std::mutex mutex_;
-    std::condition_variable frameAvailable_;
-    std::deque<camera_fb_t *> frameQueue_;
+    FrameFanout fanout_;
+    // Owned by the consumer thread calling tryAcquireFrame().
+    std::shared_ptr<FrameSubscription> defaultSubscription_;
+    // stats() may run on any thread: it reads the pool and the default
+    // subscription through these pointers and counts itself in
+    // statsReaders_, as FrameFanout's slot walks do. initialize() clears a
+    // pointer and waits for the readers before dropping what it pointed to.
+    std::atomic<BufferPool *> statsPool_{nullptr};
+    std::atomic<FrameSubscription *> defaultQueue_{nullptr};
+    mutable std::atomic<std::uint32_t> statsReaders_{0};
+
+    // Updated with CAS by the capture thread's adaptation and by
+    // setCaptureInterval(), which owns the floor.
+    std::atomic<std::int64_t> captureIntervalMicros_{0};
+    std::atomic<std::int64_t> minCaptureIntervalMicros_{0};
+    // Written by the capture thread only.
+    std::atomic<std::uint64_t> captured_{0};
+    std::atomic<std::int64_t> captureSpacingMicros_{0};
+    std::atomic<std::uint64_t> missedTicks_{0};
+    // Wakes the capture thread between ticks for a new interval or stop().
+    EventCount pacing_;
+    std::atomic<bool> retimed_{false};
+    std::uint64_t lastDropped_{0};
+    std::size_t calmFrames_{0};
+
+    std::atomic<std::size_t> lumaFactor_{0};
+    std::atomic<LumaReduction> lumaReduction_{LumaReduction::Average};
+    // The published luma frame, one a reader may still hold and one to
+    // convert into.
+    static constexpr std::size_t kLumaBuffers = 3;
+    // Entries are created by the capture thread and never reassigned, so
+    // readers may copy one once latestLuma_ names it. A buffer is rewritten
+    // only when it is not the latest and the pool holds its last reference.
+    std::array<std::shared_ptr<LumaFrame>, kLumaBuffers> lumaPool_{};
+    // Index + 1 of the published buffer, 0 for none.
+    std::atomic<std::size_t> latestLuma_{0};
+    std::atomic<std::uint64_t> lumaFrames_{0};
+    std::atomic<std::uint64_t> lumaSkipped_{0};
+
+    std::atomic<JpegValidation> jpegValidation_{JpegValidation::Drop};
+    std::atomic<std::uint64_t> corruptFrames_{0};
+    std::atomic<JpegDefect> lastJpegDefect_{JpegDefect::None};
 };
 
 } // namespace minitrain
-
@@ -69,7 +69,11 @@ class CommandChannel {
     void poll();
 
     static std::vector<std::uint8_t> encodeFrame(const CommandFrame &frame);
+    // Writes the kCommandFrameHeaderSize header bytes for a payload of payloadSize bytes.
+    static void encodeHeader(const CommandFrameHeader &header, std::size_t payloadSize, std::uint8_t *out);
     static CommandFrame decodeFrame(const std::vector<std::uint8_t> &buffer);
+    // Decodes straight from a receive buffer; the payload is copied out.
+    static CommandFrame decodeFrame(const std::uint8_t *data, std::size_t size);
 
   private:
     Config config_;
@@ -1,8 +1,10 @@
 #pragma once
 
+#include <array>
 #include <chrono>
 #include <cstdint>
 #include <functional>
+#include <mutex>
 #include <optional>
 #include <string>
 #include <vector>
@@ -12,6 +14,7 @@
 
 namespace minitrain {
 
+class FlightRecorder;
 class TrainController;
 
 struct CommandResult {
@@ -19,23 +22,39 @@ struct CommandResult {
     std::string message;
 };
 
+struct AppliedCommand {
+    std::array<std::uint8_t, 16> sessionId{};
+    std::uint32_t sequence{0};
+};
+
 class CommandProcessor {
   public:
     using LegacyParser = std::function<CommandResult(const std::string &)>;
+    using SystemClock = std::function<std::chrono::system_clock::time_point()>;
 
-    CommandProcessor(TrainController &controller, std::optional<LegacyParser> legacyParser = std::nullopt);
+    CommandProcessor(TrainController &controller, std::optional<LegacyParser> legacyParser = std::nullopt,
+                     SystemClock systemClock = {});
 
     CommandResult processFrame(const CommandFrame &frame, std::chrono::steady_clock::time_point arrival);
 
     [[nodiscard]] bool lowFrequencyFallbackActive() const;
+    // Last command frame that reached the controller. Safe to call from other
+    // threads, e.g. to tag outgoing video with the command it reflects.
+    [[nodiscard]] std::optional<AppliedCommand> lastAppliedCommand() const;
+    // Logs every incoming frame with its arrival time; pass nullptr to detach.
+    void attachFlightRecorder(FlightRecorder *recorder) { recorder_ = recorder; }
 
   private:
     CommandResult handleLegacyPayload(const std::vector<std::uint8_t> &payload);
 
     TrainController &controller_;
     std::optional<LegacyParser> legacyParser_;
+    SystemClock systemClock_;
     std::optional<std::chrono::steady_clock::time_point> lastArrival_;
     bool lowFrequencyFallback_{false};
+    FlightRecorder *recorder_{nullptr};
+    std::optional<AppliedCommand> lastApplied_;
+    mutable std::mutex lastAppliedMutex_;
 };
 
 } // namespace minitrain
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "minitrain/flight_recorder.hpp"
+
+namespace minitrain {
+
+constexpr std::uint8_t kEventFailSafe = 0x01U;
+constexpr std::uint8_t kEventPilotRelease = 0x02U;
+constexpr std::uint8_t kEventEmergencyStop = 0x04U;
+constexpr std::uint8_t kEventLightsOverride = 0x08U;
+constexpr std::uint8_t kEventAll = 0x0FU;
+
+[[nodiscard]] std::uint8_t trainEventsOf(const StateTransitionRecord &transition);
+
+struct EventRange {
+    std::array<std::uint8_t, 16> sessionId{};
+    std::uint64_t startMillis{0};
+    std::uint64_t endMillis{0};
+    // Requested events that were active somewhere in the range.
+    std::uint8_t events{0};
+};
+
+// Sparse index over recorded controller state keyed by (sessionId, time).
+// Each session keeps an all-time event bitmap, one bitmap per granule in
+// which any event was active (quiet granules cost nothing) and the exact
+// transition points. Queries skip sessions and granules by bitmap and only
+// walk the transitions of candidate granules. Timestamps are milliseconds on
+// the recorder timeline (steady clock). Attach it to a FlightRecorder to keep
+// it up to date while recording.
+class TelemetryEventIndex {
+  public:
+    using SessionId = std::array<std::uint8_t, 16>;
+
+    explicit TelemetryEventIndex(std::chrono::milliseconds granule = std::chrono::milliseconds{1000});
+
+    // Extends the coverage of a session and records a transition when the
+    // active event mask changes. Timestamps must not go backwards per session.
+    void observe(const SessionId &sessionId, std::uint64_t timestampMillis, std::uint8_t activeEvents);
+    // Incremental maintenance from flight recorder records: session ids come
+    // from command frames and telemetry, event masks from state transitions.
+    void observe(const FlightRecord &record);
+
+    [[nodiscard]] std::vector<EventRange> query(std::uint8_t events, std::uint64_t fromMillis, std::uint64_t toMillis,
+                                                const std::optional<SessionId> &sessionId = std::nullopt) const;
+
+    [[nodiscard]] std::size_t sessionCount() const;
+    [[nodiscard]] std::size_t granuleCount() const;
+    [[nodiscard]] std::size_t transitionCount() const;
+    [[nodiscard]] std::chrono::milliseconds granule() const { return std::chrono::milliseconds{granuleMillis_}; }
+
+    [[nodiscard]] std::vector<std::uint8_t> encode() const;
+    // Throws std::invalid_argument on malformed input.
+    static TelemetryEventIndex decode(const std::vector<std::uint8_t> &buffer);
+    static TelemetryEventIndex build(const FlightRecorder &recorder,
+                                     std::chrono::milliseconds granule = std::chrono::milliseconds{1000});
+
+    TelemetryEventIndex(TelemetryEventIndex &&other) noexcept;
+    TelemetryEventIndex &operator=(TelemetryEventIndex &&other) noexcept;
+
+  private:
+    struct Granule {
+        std::uint64_t startMillis{0};
+        // Events active at any point of the granule.
+        std::uint8_t activeEvents{0};
+        // First transition that was not yet recorded when the granule opened;
+        // the one before it holds the state at the granule start.
+        std::uint32_t firstTransition{0};
+    };
+
+    struct Transition {
+        std::uint64_t timestampMillis{0};
+        std::uint8_t activeEvents{0};
+    };
+
+    struct Session {
+        SessionId id{};
+        std::uint64_t firstMillis{0};
+        std::uint64_t lastMillis{0};
+        std::uint8_t seenEvents{0};
+        std::uint8_t activeEvents{0};
+        std::vector<Granule> granules;
+        std::vector<Transition> transitions;
+    };
+
+    Session &sessionFor(const SessionId &sessionId, std::uint64_t timestampMillis);
+    void markGranules(Session &session, std::uint64_t fromMillis, std::uint64_t toMillis, std::uint8_t events) const;
+    void observeLocked(const SessionId &sessionId, std::uint64_t timestampMillis, std::uint8_t activeEvents);
+    void querySession(const Session &session, std::uint8_t events, std::uint64_t fromMillis, std::uint64_t toMillis,
+                      std::vector<EventRange> &out) const;
+
+    std::uint64_t granuleMillis_;
+    std::vector<Session> sessions_;
+    std::size_t lastSession_{0};
+    SessionId currentSession_{};
+    std::uint8_t currentEvents_{0};
+    mutable std::mutex mutex_;
+};
+
+} // namespace minitrain
@@ -0,0 +1,188 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+
+#include "minitrain/command_channel.hpp"
+#include "minitrain/telemetry.hpp"
+#include "minitrain/train_state.hpp"
+
+namespace minitrain {
+
+class TelemetryEventIndex;
+
+enum class FlightRecordType : std::uint8_t {
+    Padding = 0,
+    CommandFrame = 1,
+    SpeedMeasurement = 2,
+    TelemetryInput = 3,
+    MotorCommand = 4,
+    TelemetryOutput = 5,
+    StateTransition = 6,
+};
+
+struct FlightRecord {
+    FlightRecordType type{FlightRecordType::Padding};
+    std::uint64_t sequence{0};
+    std::chrono::steady_clock::time_point timestamp{};
+    const std::uint8_t *payload{nullptr};
+    std::size_t size{0};
+};
+
+// Command frames carry the local wall-clock arrival time as well, since the
+// processor derives command age from the sender's system clock.
+struct CommandFrameRecord {
+    CommandFrame frame;
+    std::chrono::system_clock::time_point arrivalSystem{};
+};
+
+struct SpeedMeasurementRecord {
+    float measuredSpeed{0.0F};
+    std::chrono::steady_clock::duration dt{};
+};
+
+struct StateTransitionRecord {
+    bool emergencyStop{false};
+    bool failSafeActive{false};
+    bool pilotReleaseActive{false};
+    bool horn{false};
+    bool lightsTelemetryOnly{false};
+    Direction direction{Direction::Neutral};
+    ActiveCab activeCab{ActiveCab::None};
+    LightsState lightsState{LightsState::BothRed};
+    LightsSource lightsSource{LightsSource::Automatic};
+    std::uint8_t lightsOverrideMask{0};
+    float targetSpeed{0.0F};
+    float appliedSpeed{0.0F};
+
+    static StateTransitionRecord fromState(const TrainState &state);
+    [[nodiscard]] bool sameModeAs(const StateTransitionRecord &other) const;
+};
+
+// Append-only circular log of binary records living in a memory-mapped file
+// (host builds) or a caller-provided region such as an RTC/PSRAM buffer that
+// survives a soft reset (ESP32). Appending is a couple of memcpy calls under
+// an uncontended mutex; no syscall happens on the hot path.
+//
+// Two alternating superblocks carry a generation counter and checksum. When
+// old records must be evicted the new tail is published before the space is
+// reused, and the head is published only once the record is complete, so a
+// crash at any point leaves a consistent log. A sparse index records the
+// position of the first record in every indexInterval for time-based seeks.
+class FlightRecorder {
+  public:
+    using Visitor = std::function<void(const FlightRecord &)>;
+
+    static constexpr std::size_t kRecordHeaderSize = 32;
+    static constexpr std::size_t kIndexEntries = 256;
+    static constexpr std::size_t kMinimumRegionSize = 16 * 1024;
+
+    FlightRecorder(std::uint8_t *region, std::size_t size,
+                   std::chrono::milliseconds indexInterval = std::chrono::milliseconds{1000});
+    ~FlightRecorder();
+
+    FlightRecorder(const FlightRecorder &) = delete;
+    FlightRecorder &operator=(const FlightRecorder &) = delete;
+    FlightRecorder(FlightRecorder &&) = delete;
+    FlightRecorder &operator=(FlightRecorder &&) = delete;
+
+#ifndef ESP_PLATFORM
+    // Opens (and recovers) or creates a log file of the given total size.
+    static std::unique_ptr<FlightRecorder> open(const std::string &path, std::size_t sizeBytes,
+                                                std::chrono::milliseconds indexInterval =
+                                                    std::chrono::milliseconds{1000});
+    static std::unique_ptr<FlightRecorder> openReadOnly(const std::string &path);
+    // Schedules write-back of dirty pages; never required for crash consistency.
+    void flush();
+#endif
+
+    bool append(FlightRecordType type, std::chrono::steady_clock::time_point timestamp, const std::uint8_t *prefix,
+                std::size_t prefixSize, const std::uint8_t *body = nullptr, std::size_t bodySize = 0);
+
+    void recordCommandFrame(const CommandFrame &frame, std::chrono::steady_clock::time_point arrival,
+                            std::chrono::system_clock::time_point arrivalSystem);
+    void recordSpeedMeasurement(float measuredSpeed, std::chrono::steady_clock::duration dt,
+                                std::chrono::steady_clock::time_point timestamp);
+    void recordTelemetry(FlightRecordType type, const TelemetrySample &sample,
+                         std::chrono::steady_clock::time_point timestamp);
+    void recordMotorCommand(float command, std::chrono::steady_clock::time_point timestamp);
+    void recordStateTransition(const StateTransitionRecord &transition, std::chrono::steady_clock::time_point timestamp);
+
+    // Feeds every appended record to the index. Records already retained are
+    // replayed into it first, so a recovered log is covered as well.
+    void attachEventIndex(TelemetryEventIndex *index);
+
+    // Visits retained records oldest first. The payload pointers are only valid
+    // during the callback.
+    void forEach(const Visitor &visitor) const;
+    void forEachSince(std::chrono::steady_clock::time_point since, const Visitor &visitor) const;
+
+    [[nodiscard]] bool valid() const { return region_ != nullptr; }
+    [[nodiscard]] bool readOnly() const { return readOnly_; }
+    [[nodiscard]] std::size_t dataCapacity() const;
+    [[nodiscard]] std::uint64_t recordCount() const;
+    [[nodiscard]] std::uint64_t droppedRecords() const;
+
+    static std::optional<CommandFrameRecord> decodeCommandFrame(const FlightRecord &record);
+    static std::optional<SpeedMeasurementRecord> decodeSpeedMeasurement(const FlightRecord &record);
+    static std::optional<TelemetrySample> decodeTelemetry(const FlightRecord &record);
+    static std::optional<float> decodeMotorCommand(const FlightRecord &record);
+    static std::optional<StateTransitionRecord> decodeStateTransition(const FlightRecord &record);
+
+  private:
+    struct Superblock {
+        std::uint32_t magic{0};
+        std::uint16_t version{0};
+        std::uint16_t reserved{0};
+        std::uint64_t generation{0};
+        std::uint64_t dataCapacity{0};
+        std::uint64_t head{0};
+        std::uint64_t tail{0};
+        std::uint64_t used{0};
+        std::uint64_t nextSequence{0};
+        std::uint64_t tailSequence{0};
+        std::int64_t lastIndexMicros{0};
+        std::uint32_t indexNext{0};
+        std::uint32_t checksum{0};
+    };
+
+    struct IndexEntry {
+        std::int64_t timestampMicros{0};
+        std::uint64_t offset{0};
+        std::uint64_t sequence{0};
+    };
+
+    FlightRecorder() = default;
+    void attach(std::uint8_t *region, std::size_t size, std::chrono::milliseconds indexInterval, bool readOnly);
+    void format();
+    bool recover();
+    void publish();
+    [[nodiscard]] std::optional<Superblock> loadSuperblock(std::size_t slot) const;
+    [[nodiscard]] IndexEntry indexEntry(std::size_t slot) const;
+    [[nodiscard]] std::size_t recordSpanAt(std::uint64_t offset) const;
+    void evictOldest();
+    void ensureFree(std::uint64_t bytes);
+    void walk(std::uint64_t offset, std::uint64_t sequence, const Visitor &visitor) const;
+
+    std::uint8_t *region_{nullptr};
+    std::size_t regionSize_{0};
+    std::uint8_t *data_{nullptr};
+    std::uint8_t *index_{nullptr};
+    std::int64_t indexIntervalMicros_{1000000};
+    bool readOnly_{false};
+    std::uint64_t dropped_{0};
+    Superblock state_{};
+    TelemetryEventIndex *eventIndex_{nullptr};
+    mutable std::mutex mutex_;
+#ifndef ESP_PLATFORM
+    int fd_{-1};
+#endif
+};
+
+} // namespace minitrain
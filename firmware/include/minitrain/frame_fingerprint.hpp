@@ -0,0 +1,49 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+#include "minitrain/camera_driver.hpp"
+
+namespace minitrain {
+
+constexpr std::size_t kFingerprintGrid = 8;
+constexpr std::size_t kFingerprintSamples = kFingerprintGrid * kFingerprintGrid;
+
+// Summary of a frame for spotting repeats. YUV422 frames are reduced to a
+// coarse luma grid by sampling a few hundred pixels. Baseline JPEGs (what the
+// OV2640 produces) get the same grid from the DC coefficients of their luma
+// blocks: the scan is Huffman-decoded, but no inverse DCT runs. Sensor noise
+// changes the entropy-coded bytes and length of every frame, but it barely
+// moves the block means. Other JPEGs only match when the sampled
+// entropy-coded bytes are identical.
+struct FrameFingerprint {
+    // Hash of kFingerprintSamples windows of the frame data (entropy-coded
+    // data for JPEG, so re-encoded tables do not matter) and of the grid;
+    // equal hashes mean an unchanged frame.
+    std::uint64_t hash{0};
+    // Entropy-coded bytes for JPEG, the frame length otherwise.
+    std::uint32_t payloadBytes{0};
+    // Mean luma of kFingerprintGrid x kFingerprintGrid cells, if hasLuma.
+    std::array<std::uint8_t, kFingerprintSamples> samples{};
+    bool hasLuma{false};
+
+    [[nodiscard]] bool valid() const { return payloadBytes != 0; }
+};
+
+struct FrameSimilarity {
+    // Mean absolute luma difference across the grid. A moving scene often
+    // compresses to nearly the same size, so frames are judged on the grid,
+    // never on their length.
+    unsigned lumaTolerance{3};
+};
+
+[[nodiscard]] FrameFingerprint fingerprintFrame(const camera_fb_t &frame);
+
+// True when both fingerprints are valid and describe an identical or
+// near-identical scene.
+[[nodiscard]] bool nearlyIdentical(const FrameFingerprint &previous, const FrameFingerprint &current,
+                                   const FrameSimilarity &similarity = {});
+
+} // namespace minitrain
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace minitrain {
+
+enum class JpegDefect : std::uint8_t {
+    None = 0,
+    // The stream or one of its segments ends early.
+    Truncated = 1,
+    MissingSoi = 2,
+    // Something other than a marker where one must start, or a marker that
+    // cannot appear there (e.g. a second SOI from a spliced frame).
+    BadMarker = 3,
+    BadSegmentLength = 4,
+    // SOS before any SOFn segment.
+    MissingFrameHeader = 5,
+    // EOI without any scan.
+    MissingScan = 6,
+    // Scan data runs to the end of the buffer without EOI.
+    MissingEoi = 7,
+    // Non-zero bytes after EOI.
+    TrailingData = 8,
+};
+
+[[nodiscard]] const char *toString(JpegDefect defect);
+
+// Structural check of a baseline or progressive JPEG: SOI, the length of
+// every marker segment, SOFn before SOS, marker use inside entropy-coded data
+// (only stuffed 0xFF00, RSTn and fill bytes) and a final EOI, optionally
+// followed by zero padding. Pixel data is not decoded. Scan data is searched
+// for 0xFF with memchr, which the C library vectorises, so a VGA frame takes
+// microseconds.
+[[nodiscard]] JpegDefect validateJpeg(const std::uint8_t *data, std::size_t size);
+
+} // namespace minitrain
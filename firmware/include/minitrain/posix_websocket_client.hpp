@@ -0,0 +1,213 @@
+#pragma once
+
+#ifndef ESP_PLATFORM
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "minitrain/byte_segment.hpp"
+#include "minitrain/command_channel.hpp"
+
+namespace minitrain {
+
+enum class TransportStatus : std::uint8_t {
+    Ok = 0,
+    // Nothing can be transferred until the socket is readable / writable.
+    WantRead = 1,
+    WantWrite = 2,
+    // Orderly end of stream from the peer.
+    Closed = 3,
+    Failed = 4,
+};
+
+// Byte stream carrying the WebSocket frames over a connected non-blocking
+// socket: plain TCP, or TLS supplied by the application. No call may block;
+// the event loop waits for the readiness a call asks for and retries.
+class WebSocketTransport {
+  public:
+    virtual ~WebSocketTransport() = default;
+
+    // Runs the security handshake until it returns Ok.
+    virtual TransportStatus handshake() = 0;
+    // Ok with transferred > 0, or any other status with transferred == 0.
+    virtual TransportStatus read(std::uint8_t *data, std::size_t size, std::size_t &transferred) = 0;
+    virtual TransportStatus write(const std::uint8_t *data, std::size_t size, std::size_t &transferred) = 0;
+};
+
+// Wraps a connected socket for host, e.g. a TLS session verifying host. The
+// socket stays owned by the client.
+using WebSocketTransportFactory = std::function<std::unique_ptr<WebSocketTransport>(int fd, const std::string &host)>;
+
+[[nodiscard]] std::unique_ptr<WebSocketTransport> makePlainTransport(int fd);
+
+struct WebSocketUri {
+    bool secure{false};
+    std::string host;
+    std::uint16_t port{0};
+    // Path and query, at least "/".
+    std::string resource;
+};
+
+// ws:// and wss:// URIs with an optional port; IPv6 hosts in brackets.
+[[nodiscard]] std::optional<WebSocketUri> parseWebSocketUri(const std::string &uri);
+
+// Sec-WebSocket-Accept value a server must answer clientKey with.
+[[nodiscard]] std::string webSocketAcceptKey(const std::string &clientKey);
+
+struct PosixWebSocketConfig {
+    // TCP connect, TLS handshake and HTTP upgrade together.
+    std::chrono::milliseconds connectTimeout{std::chrono::milliseconds{5000}};
+    // A send waits this long for its frames to reach the socket.
+    std::chrono::milliseconds sendTimeout{std::chrono::milliseconds{10000}};
+    // A ping goes out after this long without traffic from the server; the
+    // connection is dropped if nothing arrives within pongTimeout after it.
+    // Zero disables keepalive.
+    std::chrono::milliseconds pingInterval{std::chrono::milliseconds{15000}};
+    std::chrono::milliseconds pongTimeout{std::chrono::milliseconds{5000}};
+    // How long close() waits for the server to answer the close frame.
+    std::chrono::milliseconds closeTimeout{std::chrono::milliseconds{1000}};
+    // Larger reassembled messages fail the connection with status 1009.
+    std::size_t maxMessageBytes{1024 * 1024};
+    // Binary messages waiting for receiveBinary(); the oldest is dropped
+    // when full.
+    std::size_t receiveQueueDepth{64};
+    // Required for wss:// URIs; ws:// always uses makePlainTransport().
+    WebSocketTransportFactory secureTransport;
+};
+
+// RFC 6455 client on a non-blocking socket driven by an epoll event loop on
+// its own thread. The loop reads and reassembles messages, answers pings,
+// sends keepalive pings and writes queued frames as the socket accepts them.
+// Sends may come from any thread: each one masks its frames into the
+// outbound queue and waits until the loop has written them (or sendTimeout
+// passes), so send durations still reflect the uplink. Set the handlers
+// before open(); onConnected runs inside open(), the others on the loop
+// thread. With a binary handler set, binary messages go to it instead of
+// the receiveBinary() queue; the bytes are only valid during the call.
+class PosixWebSocketClient final : public WebSocketClient {
+  public:
+    using MessageHandler = std::function<void(const std::string &)>;
+    using BinaryHandler = std::function<void(const std::uint8_t *data, std::size_t size)>;
+    using EventHandler = std::function<void()>;
+
+    explicit PosixWebSocketClient(PosixWebSocketConfig config = {});
+    ~PosixWebSocketClient() override;
+
+    PosixWebSocketClient(const PosixWebSocketClient &) = delete;
+    PosixWebSocketClient &operator=(const PosixWebSocketClient &) = delete;
+
+    void setMessageHandler(MessageHandler handler) { messageHandler_ = std::move(handler); }
+    void setBinaryHandler(BinaryHandler handler) { binaryHandler_ = std::move(handler); }
+    void setOnConnected(EventHandler handler) { onConnected_ = std::move(handler); }
+    void setOnDisconnected(EventHandler handler) { onDisconnected_ = std::move(handler); }
+
+    // Connects and upgrades, blocking for at most connectTimeout, then starts
+    // the event loop. Returns false with lastError() set on failure.
+    bool open(const std::string &uri);
+    [[nodiscard]] bool isConnected() const { return connected_.load(std::memory_order_acquire); }
+    [[nodiscard]] std::string lastError() const;
+
+    bool sendText(const std::string &payload);
+    bool sendBinary(const std::uint8_t *payload, std::size_t length);
+    // One fragment per segment, written back to back.
+    bool sendBinary(const ByteSegment *segments, std::size_t count);
+    // Unsolicited ping, e.g. to probe the connection.
+    bool sendPing();
+
+    // WebSocketClient. connect() throws std::runtime_error if open() fails;
+    // close() sends a normal closure and waits for the loop to finish.
+    void connect(const std::string &uri) override;
+    void close() override;
+    void sendBinary(const std::vector<std::uint8_t> &data) override;
+    std::optional<std::vector<std::uint8_t>> receiveBinary(std::chrono::milliseconds timeout) override;
+
+    // Binary messages dropped because the receive queue was full.
+    [[nodiscard]] std::uint64_t droppedMessages() const { return droppedMessages_.load(std::memory_order_relaxed); }
+
+  private:
+    struct Frame {
+        std::uint8_t opcode{0};
+        bool fin{true};
+        const std::uint8_t *data{nullptr};
+        std::size_t size{0};
+    };
+
+    // Sends the segments as one message: the first frame carries the opcode,
+    // the rest are continuations and the last has FIN set.
+    bool send(std::uint8_t opcode, const ByteSegment *segments, std::size_t count);
+    void appendFrame(const Frame &frame);
+    bool connectSocket(const WebSocketUri &uri, std::chrono::steady_clock::time_point deadline);
+    bool upgrade(const WebSocketUri &uri, std::chrono::steady_clock::time_point deadline);
+    void eventLoop();
+    bool readAvailable();
+    void processFrames();
+    void deliverMessage(std::uint8_t opcode, const std::uint8_t *data, std::size_t size);
+    TransportStatus flushOutbound();
+    void failConnection(std::uint16_t status, const std::string &reason);
+    void queueControl(std::uint8_t opcode, const std::uint8_t *data, std::size_t size);
+    void wake() const;
+    void teardown();
+    void setError(std::string error);
+
+    PosixWebSocketConfig config_;
+    MessageHandler messageHandler_;
+    BinaryHandler binaryHandler_;
+    EventHandler onConnected_;
+    EventHandler onDisconnected_;
+
+    int socket_{-1};
+    int epoll_{-1};
+    int wakeFd_{-1};
+    std::unique_ptr<WebSocketTransport> transport_;
+    std::thread loop_;
+    std::atomic<bool> connected_{false};
+    std::atomic<bool> closeRequested_{false};
+
+    // Outbound frames, masked. Senders append to pending_ and wait until
+    // written_ passes the end of their frames; the loop moves pending_ into
+    // writing_ and bumps written_ as the transport accepts bytes.
+    mutable std::mutex sendMutex_;
+    std::condition_variable sendProgress_;
+    std::vector<std::uint8_t> pending_;
+    std::uint64_t queued_{0};
+    std::uint64_t written_{0};
+    std::mt19937 maskRng_;
+
+    // Loop thread only.
+    std::vector<std::uint8_t> writing_;
+    std::size_t writeOffset_{0};
+    std::vector<std::uint8_t> received_;
+    std::size_t receiveOffset_{0};
+    // Reassembly buffer; cleared per message but keeps its capacity.
+    std::vector<std::uint8_t> fragments_;
+    std::uint8_t fragmentOpcode_{0};
+    std::chrono::steady_clock::time_point lastReceive_{};
+    bool pingOutstanding_{false};
+    bool closeSent_{false};
+    bool closeReceived_{false};
+    std::chrono::steady_clock::time_point closeDeadline_{};
+
+    std::mutex inboxMutex_;
+    std::condition_variable inboxReady_;
+    std::deque<std::vector<std::uint8_t>> inbox_;
+    std::atomic<std::uint64_t> droppedMessages_{0};
+
+    mutable std::mutex errorMutex_;
+    std::string lastError_;
+};
+
+} // namespace minitrain
+
+#endif
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+namespace minitrain {
+
+// KLL streaming quantile sketch. Memory is bounded by roughly 3 * k retained
+// values (about 1.5 KB for the default k), independent of the stream length,
+// and two sketches can be merged without losing the error guarantee. The rank
+// error is around 1.7 / k with high probability.
+class QuantileSketch {
+  public:
+    static constexpr std::uint16_t kDefaultK = 128;
+
+    explicit QuantileSketch(std::uint16_t k = kDefaultK);
+
+    void add(float value);
+    void merge(const QuantileSketch &other);
+    void clear();
+
+    // Value below which a fraction q of the observations fall, q in [0, 1].
+    [[nodiscard]] std::optional<float> quantile(double q) const;
+    // Fraction of observations strictly below value.
+    [[nodiscard]] double rank(float value) const;
+
+    [[nodiscard]] std::uint64_t count() const { return count_; }
+    [[nodiscard]] std::optional<float> min() const;
+    [[nodiscard]] std::optional<float> max() const;
+    [[nodiscard]] std::size_t retainedValues() const;
+    [[nodiscard]] std::uint16_t k() const { return k_; }
+
+  private:
+    [[nodiscard]] std::size_t levelCapacity(std::size_t level) const;
+    void compress();
+    void compact(std::size_t level);
+    bool nextOffsetBit();
+
+    std::uint16_t k_;
+    std::uint64_t count_{0};
+    float min_{0.0F};
+    float max_{0.0F};
+    std::uint32_t randomState_{0x9E3779B9U};
+    std::vector<std::vector<float>> levels_;
+};
+
+} // namespace minitrain
@@ -6,6 +6,7 @@
 #include <memory>
 #include <string>
 
+#include "minitrain/byte_segment.hpp"
 #include "minitrain/esp_target_check.hpp"
 
 namespace minitrain {
@@ -22,6 +23,10 @@ struct TlsCredentialConfig {
 class SecureWebSocketClient {
   public:
     using MessageHandler = std::function<void(const std::string &)>;
+    // Receives each binary message once all of its fragments have arrived.
+    // The bytes live in a receive buffer that is reused for the next message,
+    // so they are only valid during the call.
+    using BinaryHandler = std::function<void(const std::uint8_t *data, std::size_t size)>;
     using EventHandler = std::function<void()>;
 
     explicit SecureWebSocketClient(TlsCredentialConfig config);
@@ -34,6 +39,7 @@ class SecureWebSocketClient {
     SecureWebSocketClient &operator=(SecureWebSocketClient &&) noexcept;
 
     void setMessageHandler(MessageHandler handler);
+    void setBinaryHandler(BinaryHandler handler);
     void setOnConnected(EventHandler handler);
     void setOnDisconnected(EventHandler handler);
 
@@ -42,6 +48,10 @@ class SecureWebSocketClient {
     bool isConnected() const;
     bool sendText(const std::string &payload);
     bool sendBinary(const std::uint8_t *payload, std::size_t length);
+    // Sends the segments as one binary message without joining them first.
+    // The fragments must not interleave with other sends, so callers sharing
+    // the connection should go through a single sender such as SendScheduler.
+    bool sendBinary(const ByteSegment *segments, std::size_t count);
 
     const TlsCredentialConfig &config() const { return config_; }
 
@@ -0,0 +1,196 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "minitrain/byte_segment.hpp"
+
+namespace minitrain {
+
+// Strict priority order: a lower value is always sent first.
+enum class TrafficClass : std::uint8_t { Control = 0, Telemetry = 1, Video = 2 };
+
+constexpr std::size_t kTrafficClassCount = 3;
+
+// Chunks of a chunked message are binary messages prefixed with this header:
+// the magic "MTCK", then message id, byte offset of the chunk and total
+// message length, all little-endian uint32. The magic tells chunks apart from
+// other binary messages on the same connection. The receiver has the whole
+// message once offset + chunk length == total length. See "Messages vidéo"
+// in docs/specs/interface-temps-reel.md.
+constexpr std::array<std::uint8_t, 4> kChunkMagic{'M', 'T', 'C', 'K'};
+constexpr std::size_t kChunkHeaderBytes = kChunkMagic.size() + 12;
+
+// Segments an OutboundMessage holds inline, so building one never allocates.
+constexpr std::size_t kMaxMessageSegments = 4;
+
+struct OutboundMessage {
+    bool binary{true};
+    std::array<ByteSegment, kMaxMessageSegments> segments{};
+    std::size_t segmentCount{0};
+    // Keeps the memory behind segments alive until the message is sent or
+    // dropped.
+    std::shared_ptr<const void> owner;
+    // Called once when the message leaves the scheduler: true once its last
+    // byte went to the transport, false if it was dropped, failed or
+    // cleared. owner is released first, so a camera frame carried by the
+    // message is already back with the driver. Runs without scheduler locks
+    // but must not call sendNext(). A capture of up to two pointers is stored
+    // inline; anything larger allocates.
+    std::function<void(bool sent)> onComplete;
+
+    static OutboundMessage text(std::string payload);
+    static OutboundMessage bytes(std::vector<std::uint8_t> payload);
+
+    // Returns false once kMaxMessageSegments are in use.
+    bool addSegment(ByteSegment segment);
+
+    [[nodiscard]] std::size_t size() const;
+};
+
+struct TrafficClassConfig {
+    // Older messages that have not started sending are dropped beyond this.
+    // The queue is allocated for this many messages up front.
+    std::size_t maxQueuedMessages{16};
+    // Binary messages are split into chunks of at most this many payload
+    // bytes so higher classes can go out in between; 0 sends them whole.
+    std::size_t chunkBytes{0};
+    // Counts the message being sent against maxQueuedMessages, so the class
+    // never holds more than that many messages. With a limit of 1 a message
+    // enqueued while another is being sent is dropped.
+    bool limitIncludesSending{false};
+};
+
+struct SendSchedulerConfig {
+    // Video holds one frame in total, waiting or being sent, so it ties up
+    // a single camera buffer however slow the uplink is.
+    std::array<TrafficClassConfig, kTrafficClassCount> classes{
+        {TrafficClassConfig{64, 0}, TrafficClassConfig{16, 0}, TrafficClassConfig{1, 4096, true}}};
+};
+
+struct TrafficClassStats {
+    std::uint64_t enqueuedMessages{0};
+    std::uint64_t sentMessages{0};
+    std::uint64_t droppedMessages{0};
+    std::uint64_t failedMessages{0};
+    std::uint64_t sentChunks{0};
+    // Payload bytes, chunk headers excluded.
+    std::uint64_t sentBytes{0};
+    // Times a message of this class went out while a lower class was midway
+    // through a chunked message.
+    std::uint64_t preemptions{0};
+    std::size_t queuedMessages{0};
+    std::size_t queuedBytes{0};
+    // From enqueue to the last byte handed to the transport.
+    std::chrono::microseconds averageLatency{0};
+    std::chrono::microseconds maxLatency{0};
+};
+
+// Multiplexes control, telemetry and video over one connection. Producers
+// enqueue from any thread; a single sender (the background worker or a caller
+// of sendNext) hands one message or chunk at a time to the transport, always
+// picking the highest non-empty class, so a large video frame delays a
+// control frame by at most one chunk. With the worker running, enqueue() is
+// the asynchronous send: the message is transmitted from its own buffers and
+// released, then completed, as soon as the transport is done with it.
+class SendScheduler {
+  public:
+    // Sends one complete WebSocket message made of the given segments.
+    using Transport = std::function<bool(bool binary, const ByteSegment *segments, std::size_t count)>;
+
+    explicit SendScheduler(Transport transport, SendSchedulerConfig config = {});
+    ~SendScheduler();
+
+    SendScheduler(const SendScheduler &) = delete;
+    SendScheduler &operator=(const SendScheduler &) = delete;
+
+    // Returns false for an empty message.
+    bool enqueue(TrafficClass trafficClass, OutboundMessage message);
+
+    // Sends the next message or chunk. Returns false when nothing was queued.
+    bool sendNext();
+
+    bool start();
+    void stop();
+    [[nodiscard]] bool isRunning() const { return running_.load(std::memory_order_acquire); }
+
+    // Drops every queued and partially sent message, e.g. after a disconnect.
+    void clear();
+
+    [[nodiscard]] TrafficClassStats stats(TrafficClass trafficClass) const;
+    [[nodiscard]] std::size_t pending() const;
+
+  private:
+    struct Pending {
+        OutboundMessage message;
+        std::size_t size{0};
+        std::chrono::steady_clock::time_point enqueued;
+    };
+
+    struct InFlight {
+        Pending pending;
+        std::uint32_t id{0};
+        std::size_t offset{0};
+    };
+
+    // Fixed ring of waiting messages, sized from the class config.
+    class PendingQueue {
+      public:
+        void reserve(std::size_t capacity) { slots_.resize(capacity); }
+        [[nodiscard]] bool empty() const { return count_ == 0; }
+        [[nodiscard]] std::size_t size() const { return count_; }
+        [[nodiscard]] Pending &front() { return slots_[head_]; }
+        // The caller keeps size() below the capacity.
+        void push_back(Pending pending) { slots_[(head_ + count_++) % slots_.size()] = std::move(pending); }
+        void pop_front() {
+            slots_[head_] = Pending{};
+            head_ = (head_ + 1) % slots_.size();
+            --count_;
+        }
+
+      private:
+        std::vector<Pending> slots_;
+        std::size_t head_{0};
+        std::size_t count_{0};
+    };
+
+    struct ClassState {
+        PendingQueue queue;
+        std::optional<InFlight> inFlight;
+        // A whole (unchunked) message is with the transport.
+        bool sending{false};
+        TrafficClassStats stats;
+    };
+
+    void run();
+    void complete(ClassState &state, const Pending &pending, std::chrono::steady_clock::time_point now);
+    // Releases the message memory, then reports the outcome.
+    static void finish(OutboundMessage &message, bool sent);
+
+    Transport transport_;
+    SendSchedulerConfig config_;
+    std::array<ClassState, kTrafficClassCount> classes_;
+    std::uint32_t nextMessageId_{0};
+    mutable std::mutex mutex_;
+    // Serialises senders so chunks of one message stay in order.
+    std::mutex sendMutex_;
+    std::condition_variable workAvailable_;
+    std::atomic<bool> running_{false};
+    bool stopRequested_{false};
+    std::thread worker_;
+    std::array<ByteSegment, kMaxMessageSegments + 1> gather_{};
+    std::array<std::uint8_t, kChunkHeaderBytes> chunkHeader_{};
+};
+
+} // namespace minitrain
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "minitrain/flight_recorder.hpp"
+#include "minitrain/pid_controller.hpp"
+#include "minitrain/train_controller.hpp"
+
+namespace minitrain {
+
+struct ReplayConfig {
+    PidController pid{0.8F, 0.2F, 0.05F, 0.0F, 1.0F};
+    std::chrono::steady_clock::duration staleCommandThreshold{std::chrono::milliseconds{MINITRAIN_FAILSAFE_THRESHOLD_MS}};
+    std::chrono::steady_clock::duration pilotReleaseDuration{std::chrono::milliseconds{MINITRAIN_PILOT_RELEASE_MS}};
+    std::chrono::steady_clock::duration failSafeRampDuration{std::chrono::milliseconds{MINITRAIN_FAILSAFE_RAMP_MS}};
+    float motorTolerance{1.0e-4F};
+    float telemetryTolerance{1.0e-3F};
+};
+
+struct ReplayMismatch {
+    FlightRecordType type{FlightRecordType::Padding};
+    // Sequence of the recorded output record that differs (or is missing).
+    std::uint64_t recordedSequence{0};
+    std::string detail;
+};
+
+struct ReplayReport {
+    std::string session;
+    bool loaded{false};
+    std::uint64_t inputRecords{0};
+    std::uint64_t motorCommands{0};
+    std::uint64_t telemetrySamples{0};
+    std::uint64_t motorMismatches{0};
+    std::uint64_t telemetryMismatches{0};
+    // Outputs present on one side only (recorded but not replayed, or the reverse).
+    std::uint64_t unmatchedOutputs{0};
+    float maxMotorError{0.0F};
+    std::optional<ReplayMismatch> firstMismatch;
+    std::chrono::steady_clock::duration recordedSpan{};
+    std::chrono::steady_clock::duration wallTime{};
+
+    [[nodiscard]] bool matches() const {
+        return loaded && motorMismatches == 0 && telemetryMismatches == 0 && unmatchedOutputs == 0;
+    }
+};
+
+// Feeds the recorded inputs (command frames, speed measurements, raw
+// telemetry) through a fresh CommandProcessor/TrainController pair driven by
+// a virtual clock that jumps from record to record, so replay runs as fast as
+// the controller code allows. Motor commands and published telemetry are
+// compared in order against the recorded outputs.
+ReplayReport replaySession(const FlightRecorder &recording, const ReplayConfig &config = {});
+
+#ifndef ESP_PLATFORM
+struct ReplaySummary {
+    std::vector<ReplayReport> sessions;
+    std::chrono::steady_clock::duration wallTime{};
+    std::chrono::steady_clock::duration recordedSpan{};
+    std::uint64_t inputRecords{0};
+
+    [[nodiscard]] std::size_t failures() const;
+    // Recorded time replayed per second of wall time.
+    [[nodiscard]] double speedup() const;
+};
+
+// Replays each recording file on a pool of worker threads (0 = one per core).
+ReplaySummary replaySessions(const std::vector<std::string> &paths, const ReplayConfig &config = {},
+                             unsigned threads = 0);
+#endif
+
+} // namespace minitrain
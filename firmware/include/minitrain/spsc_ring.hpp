@@ -0,0 +1,120 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+
+namespace minitrain {
+
+// Fixed-capacity lock-free ring for one producer and one consumer. The
+// producer may also evict the oldest entry to make room (camera streams keep
+// the freshest frames); eviction and consumption both claim entries with a
+// CAS on the tail, so they can race safely. Entries are stored in atomics and
+// must therefore be trivially copyable, e.g. pointers.
+//
+// head_ and tail_ are free-running 32-bit counters so they stay lock-free on
+// 32-bit targets such as the ESP32, where 64-bit atomics go through
+// libatomic's locks. Their difference is exact across wraparound, and the
+// slot array is a power of two so masking picks the same slot on both sides
+// of a wrap.
+template <typename T> class SpscRing {
+    static_assert(std::is_trivially_copyable_v<T>, "SpscRing entries must be trivially copyable");
+    static_assert(std::atomic<T>::is_always_lock_free, "SpscRing entries must be lock-free atomics");
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "SpscRing needs lock-free 32-bit atomics");
+
+  public:
+    explicit SpscRing(std::size_t capacity)
+        : capacity_(capacity == 0 ? 1 : capacity), mask_(slotCount(capacity_) - 1),
+          slots_(std::make_unique<std::atomic<T>[]>(mask_ + 1)) {}
+
+    SpscRing(const SpscRing &) = delete;
+    SpscRing &operator=(const SpscRing &) = delete;
+
+    // Producer only.
+    bool tryPush(T value) {
+        const std::uint32_t head = head_.load(std::memory_order_relaxed);
+        if (static_cast<std::uint32_t>(head - tail_.load(std::memory_order_acquire)) >= capacity_) {
+            return false;
+        }
+        slots_[head & mask_].store(value, std::memory_order_relaxed);
+        head_.store(head + 1U, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer, or the producer evicting the oldest entry.
+    bool tryPop(T &value) {
+        std::uint32_t tail = tail_.load(std::memory_order_relaxed);
+        while (true) {
+            if (tail == head_.load(std::memory_order_acquire)) {
+                return false;
+            }
+            value = slots_[tail & mask_].load(std::memory_order_relaxed);
+            if (tail_.compare_exchange_weak(tail, tail + 1U, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+    }
+
+    [[nodiscard]] std::size_t size() const {
+        // tail is read first and head only grows, so the difference is never negative.
+        const std::uint32_t tail = tail_.load(std::memory_order_acquire);
+        const std::uint32_t head = head_.load(std::memory_order_acquire);
+        return static_cast<std::uint32_t>(head - tail);
+    }
+    [[nodiscard]] bool empty() const { return size() == 0U; }
+    [[nodiscard]] std::size_t capacity() const { return capacity_; }
+
+  private:
+    static constexpr std::size_t kCacheLine = 64;
+
+    static std::uint32_t slotCount(std::size_t capacity) {
+        std::uint32_t count = 1;
+        while (count < capacity) {
+            count <<= 1U;
+        }
+        return count;
+    }
+
+    const std::size_t capacity_;
+    const std::uint32_t mask_;
+    std::unique_ptr<std::atomic<T>[]> slots_;
+    alignas(kCacheLine) std::atomic<std::uint32_t> head_{0};
+    alignas(kCacheLine) std::atomic<std::uint32_t> tail_{0};
+};
+
+// Lets a thread sleep until another one publishes something without either
+// side taking a lock on the fast path: notify() is two atomic operations
+// unless somebody is actually parked. Waiters follow the prepare/recheck/wait
+// protocol so a notification between the check and the wait is never lost:
+//
+//   auto key = event.prepareWait();
+//   if (conditionHolds()) { event.cancelWait(); ... } else { event.wait(key, deadline); }
+//
+// Linux parks on a futex; other targets fall back to a condition variable that
+// is only touched while a waiter is parked.
+class EventCount {
+  public:
+    EventCount();
+    ~EventCount();
+
+    EventCount(const EventCount &) = delete;
+    EventCount &operator=(const EventCount &) = delete;
+
+    [[nodiscard]] std::uint32_t prepareWait();
+    void cancelWait();
+    // Returns false if the deadline passed without a notification.
+    bool wait(std::uint32_t key, std::chrono::steady_clock::time_point deadline);
+    void notifyAll();
+
+  private:
+    struct Fallback;
+
+    std::atomic<std::uint32_t> epoch_{0};
+    std::atomic<std::uint32_t> waiters_{0};
+    std::unique_ptr<Fallback> fallback_;
+};
+
+} // namespace minitrain
@@ -0,0 +1,44 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/frame_fingerprint.hpp"
+
+namespace minitrain {
+
+struct StaticFrameFilterConfig {
+    // While the scene does not change, one frame per interval is still sent
+    // so the app can tell a still picture from a dead stream.
+    std::chrono::milliseconds keepAliveInterval{std::chrono::milliseconds{1000}};
+    FrameSimilarity similarity{};
+};
+
+// Decides, on the sending side, whether a frame is worth transmitting. Frames
+// are compared with the last frame that was sent rather than the previous
+// one, so a slow drift still gets through once it adds up. Not thread-safe;
+// owned by the video sender.
+class StaticFrameFilter {
+  public:
+    explicit StaticFrameFilter(StaticFrameFilterConfig config = {});
+
+    // Returns true if the frame should be sent and then remembers it as the
+    // reference. Frames without a fingerprint are always sent.
+    bool shouldSend(const SharedFrame &frame, std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+    // Forgets the reference so the next frame is sent, e.g. after a reconnect.
+    void reset();
+
+    [[nodiscard]] std::uint64_t sentFrames() const { return sent_; }
+    [[nodiscard]] std::uint64_t suppressedFrames() const { return suppressed_; }
+    [[nodiscard]] const StaticFrameFilterConfig &config() const { return config_; }
+
+  private:
+    StaticFrameFilterConfig config_;
+    FrameFingerprint reference_{};
+    std::chrono::steady_clock::time_point lastSent_{};
+    std::uint64_t sent_{0};
+    std::uint64_t suppressed_{0};
+};
+
+} // namespace minitrain
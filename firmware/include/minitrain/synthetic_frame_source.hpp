@@ -0,0 +1,89 @@
+#pragma once
+
+#ifndef ESP_PLATFORM
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "minitrain/camera_driver.hpp"
+
+namespace minitrain {
+
+struct SyntheticFrameConfig {
+    std::size_t width{320};
+    std::size_t height{240};
+    pixformat_t format{PIXFORMAT_JPEG};
+    // Bytes per generated JPEG at jpegQuality; YUV422 frames are always
+    // width * height * 2.
+    std::size_t jpegBytes{12 * 1024};
+    int jpegQuality{12};
+    // Time between frames and the maximum +/- deviation of each frame.
+    std::chrono::microseconds period{33333};
+    std::chrono::microseconds jitter{0};
+    // Pooled buffers, like camera_config_t::fb_count: once every buffer is
+    // held downstream, acquire() fails after bufferTimeout just like the
+    // driver does.
+    std::size_t bufferCount{2};
+    std::chrono::milliseconds bufferTimeout{std::chrono::milliseconds{100}};
+    // When set, the *.jpg / *.jpeg files of this directory are replayed in
+    // name order instead of generated frames.
+    std::string jpegDirectory;
+    std::uint32_t seed{1};
+};
+
+// Host stand-in for the camera driver so the video path can be exercised and
+// profiled without hardware. Frames are paced on an absolute schedule
+// (period plus jitter, no drift) and written into a fixed pool of buffers.
+// Generated JPEGs carry SOI/EOI markers around a pattern that changes every
+// frame; YUV422 frames are a moving gradient.
+class SyntheticFrameSource final : public FrameSource {
+  public:
+    // Returns nullptr if the configuration is unusable or the directory holds
+    // no JPEG files.
+    static std::unique_ptr<SyntheticFrameSource> create(const SyntheticFrameConfig &config);
+
+    camera_fb_t *acquire() override;
+    void release(camera_fb_t *frame) override;
+    // Generated JPEGs only: frame size and quality rescale the JPEG size,
+    // proportional to the pixel count and to 64 - quality, capped at the
+    // buffer size chosen at creation.
+    bool applySettings(framesize_t frameSize, int jpegQuality) override;
+
+    [[nodiscard]] std::uint64_t framesProduced() const;
+    [[nodiscard]] std::size_t buffersInUse() const;
+    [[nodiscard]] const SyntheticFrameConfig &config() const { return config_; }
+
+  private:
+    struct Buffer {
+        camera_fb_t frame{};
+        std::vector<std::uint8_t> storage;
+        bool inUse{false};
+    };
+
+    explicit SyntheticFrameSource(const SyntheticFrameConfig &config);
+
+    SyntheticFrameConfig config_;
+    std::vector<std::vector<std::uint8_t>> replay_;
+    std::vector<std::unique_ptr<Buffer>> buffers_;
+    std::chrono::steady_clock::time_point nextFrame_{};
+    std::mt19937 rng_;
+    std::size_t width_{0};
+    std::size_t height_{0};
+    std::size_t jpegBytes_{0};
+    std::size_t capacity_{0};
+    std::uint64_t produced_{0};
+    std::size_t inUse_{0};
+    mutable std::mutex mutex_;
+    std::condition_variable bufferReleased_;
+};
+
+} // namespace minitrain
+
+#endif
@@ -6,6 +6,7 @@
 #include <optional>
 #include <vector>
 
+#include "minitrain/telemetry_history.hpp"
 #include "minitrain/train_state.hpp"
 
 namespace minitrain {
@@ -36,18 +37,59 @@ struct TelemetrySample {
     TelemetrySource source{TelemetrySource::Instantaneous};
 };
 
+// Moving-window aggregator backed by a fixed-capacity ring. Running sums are
+// Kahan-compensated so that addSample() and average() stay O(1) regardless of
+// the window length. Raw samples are kept separately in a compact columnar
+// history that may be longer than the averaging window.
 class TelemetryAggregator {
   public:
-    explicit TelemetryAggregator(std::size_t windowSize = 10);
+    explicit TelemetryAggregator(std::size_t windowSize = 10, std::size_t historyCapacity = 0);
 
     void addSample(const TelemetrySample &sample);
     [[nodiscard]] std::optional<TelemetrySample> average() const;
-    [[nodiscard]] std::vector<TelemetrySample> history() const;
+    // The view stays valid until the next addSample() or clear().
+    [[nodiscard]] TelemetryHistory::View history() const;
     void clear();
 
+    [[nodiscard]] std::size_t size() const { return count_; }
+    [[nodiscard]] std::size_t windowSize() const { return window_.size(); }
+
   private:
-    std::vector<TelemetrySample> samples_;
-    std::size_t windowSize_;
+    class RunningSum {
+      public:
+        void add(double value);
+        void reset();
+        [[nodiscard]] double value() const { return sum_; }
+
+      private:
+        double sum_{0.0};
+        double compensation_{0.0};
+    };
+
+    struct WindowEntry {
+        float speedMetersPerSecond{0.0F};
+        float motorCurrentAmps{0.0F};
+        float batteryVoltage{0.0F};
+        float temperatureCelsius{0.0F};
+        float appliedSpeedMetersPerSecond{0.0F};
+        float failSafeProgress{0.0F};
+        bool failSafeActive{false};
+    };
+
+    void accumulate(const WindowEntry &entry, double sign);
+
+    std::vector<WindowEntry> window_;
+    TelemetrySample latest_{};
+    TelemetryHistory history_;
+    std::size_t head_{0};
+    std::size_t count_{0};
+    RunningSum speedSum_;
+    RunningSum currentSum_;
+    RunningSum voltageSum_;
+    RunningSum temperatureSum_;
+    RunningSum appliedSpeedSum_;
+    RunningSum failSafeProgressSum_;
+    std::size_t failSafeCount_{0};
 };
 
 } // namespace minitrain
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "minitrain/bit_stream.hpp"
+#include "minitrain/telemetry.hpp"
+
+namespace minitrain {
+
+struct TimedTelemetrySample {
+    std::uint64_t timestampMillis{0};
+    TelemetrySample sample{};
+};
+
+// Previous-value state shared by the compressor and decompressor. Both sides
+// start from zero so the first sample needs no special case.
+struct TelemetryPredictor {
+    struct IntegerChannel {
+        std::uint64_t previous{0};
+        std::uint64_t delta{0};
+    };
+
+    struct FloatChannel {
+        std::uint32_t previous{0};
+        // leading == 0xFF means no meaningful-bit window has been emitted yet.
+        std::uint8_t leading{0xFFU};
+        std::uint8_t trailing{0};
+    };
+
+    static constexpr std::size_t kFloatFields = 6;
+
+    IntegerChannel timestamp;
+    IntegerChannel sequence;
+    IntegerChannel commandTimestamp;
+    IntegerChannel failSafeElapsed;
+    std::array<FloatChannel, kFloatFields> floats{};
+    TelemetrySample metadata{};
+};
+
+// Gorilla-style streaming compressor: timestamps and counters are stored as
+// variable-width delta-of-deltas, float fields as the XOR with the previous
+// value (only the meaningful bits), and the session/lights/cab metadata as a
+// single bit unless it changed. A block is a 8-byte header followed by the
+// bit stream; finish() closes the block and starts a new one.
+class TelemetryCompressor {
+  public:
+    void append(const TelemetrySample &sample, std::uint64_t timestampMillis);
+    [[nodiscard]] std::vector<std::uint8_t> finish();
+    void reserve(std::size_t bytes);
+
+    [[nodiscard]] std::size_t sampleCount() const { return count_; }
+    // Encoded size of the current block so far, header included.
+    [[nodiscard]] std::size_t sizeBytes() const;
+
+  private:
+    BitWriter writer_;
+    TelemetryPredictor predictor_;
+    std::uint32_t count_{0};
+};
+
+class TelemetryDecompressor {
+  public:
+    // Throws std::invalid_argument when the block header is malformed; next()
+    // throws on a truncated bit stream.
+    TelemetryDecompressor(const std::uint8_t *data, std::size_t size);
+    explicit TelemetryDecompressor(const std::vector<std::uint8_t> &block)
+        : TelemetryDecompressor(block.data(), block.size()) {}
+
+    std::optional<TimedTelemetrySample> next();
+    [[nodiscard]] std::size_t sampleCount() const { return count_; }
+
+    static std::vector<TimedTelemetrySample> decodeAll(const std::vector<std::uint8_t> &block);
+
+  private:
+    BitReader reader_;
+    TelemetryPredictor predictor_;
+    std::uint32_t count_{0};
+    std::uint32_t decoded_{0};
+};
+
+} // namespace minitrain
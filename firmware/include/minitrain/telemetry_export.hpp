@@ -0,0 +1,161 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "minitrain/telemetry.hpp"
+
+namespace minitrain {
+
+enum class ExportColumn : std::uint8_t {
+    TimestampMillis = 0,
+    Speed,
+    MotorCurrent,
+    BatteryVoltage,
+    Temperature,
+    AppliedSpeed,
+    FailSafeProgress,
+    FailSafeActive,
+    FailSafeElapsedMillis,
+    Sequence,
+    CommandTimestamp,
+    LightsState,
+    LightsSource,
+    ActiveCab,
+    LightsOverrideMask,
+    LightsTelemetryOnly,
+    // 0 neutral, 1 forward, 2 reverse.
+    Direction,
+    Source,
+    SessionIdHigh,
+    SessionIdLow,
+    Count
+};
+
+enum class ExportColumnType : std::uint8_t {
+    Float32 = 0,
+    Unsigned = 1,
+};
+
+constexpr std::size_t kExportColumnCount = static_cast<std::size_t>(ExportColumn::Count);
+
+[[nodiscard]] const char *exportColumnName(ExportColumn column);
+[[nodiscard]] ExportColumnType exportColumnType(ExportColumn column);
+
+// Writes a self-describing columnar telemetry file. Rows are buffered into
+// blocks of blockRows samples; each column of a block is stored as its own
+// Gorilla-encoded chunk (XOR floats, delta-of-delta integers) together with
+// min/max/count, so readers can skip blocks without decoding them. The column
+// directory and block index are written as a footer by close().
+class TelemetryExportWriter {
+  public:
+    static constexpr std::size_t kDefaultBlockRows = 4096;
+
+    static std::unique_ptr<TelemetryExportWriter> create(const std::string &path,
+                                                         std::size_t blockRows = kDefaultBlockRows);
+    ~TelemetryExportWriter();
+
+    TelemetryExportWriter(const TelemetryExportWriter &) = delete;
+    TelemetryExportWriter &operator=(const TelemetryExportWriter &) = delete;
+
+    void append(const TelemetrySample &sample, std::uint64_t timestampMillis);
+    // Flushes the pending block and writes the footer; returns false on I/O errors.
+    bool close();
+
+    [[nodiscard]] std::uint64_t rowCount() const { return rowCount_; }
+
+  private:
+    struct ChunkEntry {
+        std::uint64_t offset{0};
+        std::uint32_t size{0};
+        double min{0.0};
+        double max{0.0};
+    };
+
+    TelemetryExportWriter(std::ofstream file, std::size_t blockRows);
+    void flushBlock();
+
+    std::ofstream file_;
+    std::size_t blockRows_;
+    std::uint64_t offset_{0};
+    std::uint64_t rowCount_{0};
+    bool closed_{false};
+    std::array<std::vector<std::uint64_t>, kExportColumnCount> pending_{};
+    std::vector<std::uint32_t> blockSizes_;
+    std::vector<ChunkEntry> chunks_;
+};
+
+#ifndef ESP_PLATFORM
+// Inclusive range predicate on one column; use +/-infinity for open bounds.
+struct ColumnRange {
+    ExportColumn column{ExportColumn::TimestampMillis};
+    double min{0.0};
+    double max{0.0};
+};
+
+struct TimeInterval {
+    std::uint64_t startMillis{0};
+    std::uint64_t endMillis{0};
+};
+
+struct ExportScanResult {
+    // Runs of consecutive matching rows, merged across block boundaries.
+    std::vector<TimeInterval> intervals;
+    std::uint64_t matchedRows{0};
+    std::uint64_t blocksScanned{0};
+    std::uint64_t blocksSkipped{0};
+};
+
+// Memory-maps an export file. Blocks are independent, so scans and column
+// reads are spread over worker threads one block at a time. Both throw
+// std::invalid_argument if a chunk turns out to be corrupted.
+class TelemetryExportReader {
+  public:
+    static std::unique_ptr<TelemetryExportReader> open(const std::string &path);
+    ~TelemetryExportReader();
+
+    TelemetryExportReader(const TelemetryExportReader &) = delete;
+    TelemetryExportReader &operator=(const TelemetryExportReader &) = delete;
+
+    [[nodiscard]] std::uint64_t rowCount() const { return rowCount_; }
+    [[nodiscard]] std::size_t blockCount() const { return blockRows_.size(); }
+    [[nodiscard]] bool hasColumn(ExportColumn column) const;
+
+    // Rows matching every predicate (a missing column matches nothing).
+    [[nodiscard]] ExportScanResult scan(const std::vector<ColumnRange> &predicates, unsigned threads = 0) const;
+    // Decodes a whole column; unsigned values above 2^53 lose precision.
+    [[nodiscard]] std::vector<double> readColumn(ExportColumn column, unsigned threads = 0) const;
+
+  private:
+    struct Chunk {
+        const std::uint8_t *data{nullptr};
+        std::uint32_t size{0};
+        double min{0.0};
+        double max{0.0};
+    };
+
+    TelemetryExportReader() = default;
+    bool parse();
+    [[nodiscard]] const Chunk *chunk(std::size_t block, ExportColumn column) const;
+    void decodeChunk(std::size_t block, ExportColumn column, std::vector<double> &out) const;
+
+    const std::uint8_t *mapping_{nullptr};
+    std::size_t size_{0};
+    int fd_{-1};
+    std::uint64_t rowCount_{0};
+    std::vector<std::uint32_t> blockRows_;
+    std::size_t fileColumns_{0};
+    // Position of each known column in the file directory, if present.
+    std::array<std::optional<std::size_t>, kExportColumnCount> columnSlots_{};
+    std::array<ExportColumnType, kExportColumnCount> columnTypes_{};
+    std::vector<Chunk> chunks_;
+};
+#endif
+
+} // namespace minitrain
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <vector>
+
+#include "minitrain/train_state.hpp"
+
+namespace minitrain {
+
+struct TelemetrySample;
+
+// Columnar, quantised ring of telemetry samples. Numeric fields are stored as
+// fixed-point integers (mm/s, mA, mV, centi-degrees) in one array per field,
+// while the session id, lights and cab data are run-length encoded because
+// they change only on operator actions. A sample costs about 25 bytes instead
+// of sizeof(TelemetrySample), and reads go through a View that decodes on the
+// fly without copying the history.
+class TelemetryHistory {
+  public:
+    class View;
+
+    explicit TelemetryHistory(std::size_t capacity, std::size_t runCapacity = 0);
+
+    void append(const TelemetrySample &sample);
+    void clear();
+
+    [[nodiscard]] std::size_t size() const { return count_; }
+    [[nodiscard]] bool empty() const { return count_ == 0; }
+    [[nodiscard]] std::size_t capacity() const { return speedMillimeters_.size(); }
+    [[nodiscard]] std::size_t runCount() const { return runCount_; }
+
+    // index 0 is the oldest retained sample.
+    [[nodiscard]] TelemetrySample at(std::size_t index) const;
+    [[nodiscard]] View view() const;
+
+  private:
+    struct MetadataRun {
+        std::uint64_t firstSample{0};
+        std::uint64_t commandTimestampBase{0};
+        std::array<std::uint8_t, 16> sessionId{};
+        LightsState lightsState{LightsState::BothRed};
+        LightsSource lightsSource{LightsSource::Automatic};
+        ActiveCab activeCab{ActiveCab::None};
+        std::uint8_t lightsOverrideMask{0};
+        bool lightsTelemetryOnly{false};
+    };
+
+    [[nodiscard]] bool fitsRun(const MetadataRun &run, const TelemetrySample &sample) const;
+    [[nodiscard]] const MetadataRun &runFor(std::uint64_t absoluteIndex) const;
+    void pushRun(const TelemetrySample &sample);
+    void dropOldestSample();
+
+    std::vector<std::int16_t> speedMillimeters_;
+    std::vector<std::int16_t> appliedSpeedMillimeters_;
+    std::vector<std::int16_t> currentMilliamps_;
+    std::vector<std::int16_t> temperatureCentidegrees_;
+    std::vector<std::uint16_t> voltageMillivolts_;
+    std::vector<std::uint16_t> failSafeProgress_;
+    std::vector<std::uint32_t> failSafeElapsedMillis_;
+    std::vector<std::uint32_t> sequence_;
+    std::vector<std::uint32_t> commandTimestampOffset_;
+    std::vector<std::uint8_t> flags_;
+
+    std::vector<MetadataRun> runs_;
+    std::size_t runHead_{0};
+    std::size_t runCount_{0};
+
+    std::size_t head_{0};
+    std::size_t count_{0};
+    std::uint64_t firstIndex_{0};
+};
+
+class TelemetryHistory::View {
+  public:
+    class const_iterator {
+      public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = TelemetrySample;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = TelemetrySample;
+
+        const_iterator(const TelemetryHistory *history, std::size_t index) : history_{history}, index_{index} {}
+
+        TelemetrySample operator*() const;
+        const_iterator &operator++() {
+            ++index_;
+            return *this;
+        }
+        bool operator==(const const_iterator &other) const { return index_ == other.index_; }
+        bool operator!=(const const_iterator &other) const { return index_ != other.index_; }
+
+      private:
+        const TelemetryHistory *history_;
+        std::size_t index_;
+    };
+
+    explicit View(const TelemetryHistory *history) : history_{history} {}
+
+    [[nodiscard]] std::size_t size() const { return history_->size(); }
+    [[nodiscard]] bool empty() const { return history_->empty(); }
+    [[nodiscard]] TelemetrySample operator[](std::size_t index) const;
+    [[nodiscard]] TelemetrySample front() const;
+    [[nodiscard]] TelemetrySample back() const;
+    [[nodiscard]] const_iterator begin() const { return {history_, 0}; }
+    [[nodiscard]] const_iterator end() const { return {history_, history_->size()}; }
+
+  private:
+    const TelemetryHistory *history_;
+};
+
+} // namespace minitrain
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "minitrain/telemetry.hpp"
+
+namespace minitrain {
+
+enum class RollupResolution : std::uint8_t {
+    OneSecond = 0,
+    TenSeconds = 1,
+    OneMinute = 2,
+};
+
+enum class RollupField : std::uint8_t {
+    Speed = 0,
+    MotorCurrent = 1,
+    BatteryVoltage = 2,
+    Temperature = 3,
+    AppliedSpeed = 4,
+};
+
+constexpr std::size_t kRollupFieldCount = 5;
+constexpr std::size_t kRollupResolutionCount = 3;
+
+struct RollupFieldStats {
+    float min{0.0F};
+    float max{0.0F};
+    double sum{0.0};
+
+    [[nodiscard]] float mean(std::uint32_t count) const {
+        return count == 0 ? 0.0F : static_cast<float>(sum / static_cast<double>(count));
+    }
+};
+
+struct RollupBucket {
+    std::uint64_t startMillis{0};
+    std::uint32_t count{0};
+    std::uint32_t failSafeSamples{0};
+    std::array<RollupFieldStats, kRollupFieldCount> fields{};
+
+    [[nodiscard]] const RollupFieldStats &field(RollupField which) const {
+        return fields[static_cast<std::size_t>(which)];
+    }
+};
+
+// Cascaded min/max/mean rollups at 1 s, 10 s and 1 min resolution. Each tier
+// keeps a fixed number of closed buckets, so the whole structure covers one
+// hour of history in bounded memory. Closing a bucket folds it into the next
+// coarser tier, which keeps the per-sample cost constant.
+class TelemetryRollup {
+  public:
+    static constexpr std::size_t kBucketsPerTier = 60;
+
+    TelemetryRollup();
+
+    void addSample(const TelemetrySample &sample, std::chrono::steady_clock::time_point timestamp);
+
+    // Buckets ordered oldest to newest. The last entry is the bucket still
+    // being filled and already includes the finer tiers' partial data.
+    [[nodiscard]] std::vector<RollupBucket> buckets(RollupResolution resolution) const;
+    [[nodiscard]] std::vector<std::uint8_t> encode(RollupResolution resolution,
+                                                   std::size_t maxBuckets = kBucketsPerTier) const;
+    void clear();
+
+    static std::chrono::milliseconds bucketWidth(RollupResolution resolution);
+
+    struct Decoded {
+        RollupResolution resolution{RollupResolution::OneSecond};
+        std::vector<RollupBucket> buckets;
+    };
+    static Decoded decode(const std::vector<std::uint8_t> &buffer);
+
+  private:
+    struct Tier {
+        std::uint64_t widthMillis{0};
+        std::vector<RollupBucket> closed;
+        std::size_t head{0};
+        std::size_t count{0};
+        std::optional<RollupBucket> open;
+    };
+
+    void closeBucket(std::size_t tierIndex);
+    void mergeInto(std::size_t tierIndex, const RollupBucket &bucket);
+
+    std::array<Tier, kRollupResolutionCount> tiers_;
+};
+
+} // namespace minitrain
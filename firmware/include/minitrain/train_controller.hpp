@@ -4,9 +4,14 @@
 #include <functional>
 #include <mutex>
 #include <cstdint>
+#include <optional>
+#include <vector>
 
+#include "minitrain/flight_recorder.hpp"
 #include "minitrain/pid_controller.hpp"
+#include "minitrain/quantile_sketch.hpp"
 #include "minitrain/telemetry.hpp"
+#include "minitrain/telemetry_rollup.hpp"
 #include "minitrain/train_state.hpp"
 
 namespace minitrain {
@@ -23,11 +28,30 @@ namespace minitrain {
 #define MINITRAIN_FAILSAFE_RAMP_MS 1000
 #endif
 
+#ifndef MINITRAIN_TELEMETRY_WINDOW_SAMPLES
+#define MINITRAIN_TELEMETRY_WINDOW_SAMPLES 100
+#endif
+
+#ifndef MINITRAIN_TELEMETRY_HISTORY_SAMPLES
+#define MINITRAIN_TELEMETRY_HISTORY_SAMPLES 3000
+#endif
+
+// Distributions the averages hide: current surges, speed-tracking error
+// (target minus measured, m/s) and command age at each control tick (ms).
+struct ControllerQuantiles {
+    QuantileSketch motorCurrentAmps;
+    QuantileSketch speedErrorMetersPerSecond;
+    QuantileSketch commandAgeMillis;
+
+    void merge(const ControllerQuantiles &other);
+};
+
 class TrainController {
   public:
     using MotorCommandWriter = std::function<void(float)>;
     using TelemetryPublisher = std::function<void(const TelemetrySample &)>;
     using Clock = std::function<std::chrono::steady_clock::time_point()>;
+    using HistoryVisitor = std::function<void(const TelemetryHistory::View &)>;
 
     TrainController(PidController speedController, MotorCommandWriter motorWriter, TelemetryPublisher telemetryPublisher,
                    std::chrono::steady_clock::duration staleCommandThreshold =
@@ -52,18 +76,33 @@ class TrainController {
 
     [[nodiscard]] TrainState state() const;
     [[nodiscard]] std::optional<TelemetrySample> aggregatedTelemetry() const;
+    [[nodiscard]] std::vector<RollupBucket> telemetryRollup(RollupResolution resolution) const;
+    [[nodiscard]] std::vector<std::uint8_t> encodeTelemetryRollup(RollupResolution resolution) const;
+    [[nodiscard]] ControllerQuantiles quantiles() const;
+    // Runs the visitor under the controller lock so the view cannot be invalidated meanwhile.
+    void visitTelemetryHistory(const HistoryVisitor &visitor) const;
+    // Records speed inputs, telemetry, motor commands and mode changes. The
+    // recorder must outlive the controller; pass nullptr to detach.
+    void attachFlightRecorder(FlightRecorder *recorder);
 
   private:
+    void writeMotorCommand(float command, std::chrono::steady_clock::time_point now);
+    void recordTransition(std::chrono::steady_clock::time_point now);
+
     mutable std::mutex mutex_;
     TrainState state_;
     PidController pid_;
     MotorCommandWriter motorWriter_;
     TelemetryPublisher telemetryPublisher_;
     TelemetryAggregator telemetryAggregator_;
+    TelemetryRollup telemetryRollup_;
+    ControllerQuantiles quantiles_;
     std::chrono::steady_clock::duration staleCommandThreshold_;
     std::chrono::steady_clock::duration pilotReleaseDuration_;
     std::chrono::steady_clock::duration failSafeRampDuration_;
     Clock clock_;
+    FlightRecorder *recorder_{nullptr};
+    std::optional<StateTransitionRecord> lastTransition_;
 };
 
 } // namespace minitrain
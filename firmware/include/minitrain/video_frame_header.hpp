@@ -0,0 +1,57 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/send_scheduler.hpp"
+
+namespace minitrain {
+
+// Prefix of every video message so the app can correlate a frame with the
+// commands it reflects (IF-DEP-01). Little-endian layout:
+//   u8  version, u8 flags, u16 header length (lets older readers skip fields
+//   added later), 16 B session id, u32 frame sequence, u64 capture time in
+//   microseconds on the firmware's steady clock, u32 last applied command
+//   sequence, u32 payload length, u64 capture time in microseconds since the
+//   Unix epoch. The last one is on the same wall clock as a command's
+//   timestamp_us, so the app can measure glass-to-glass latency against its
+//   own clock; the steady time only orders frames of one boot.
+struct VideoFrameHeader {
+    static constexpr std::uint8_t kVersion = 1;
+    // commandSequence is meaningful only with this flag; cleared until the
+    // first command of the session has been applied.
+    static constexpr std::uint8_t kFlagCommandApplied = 0x01;
+
+    std::uint8_t flags{0};
+    std::array<std::uint8_t, 16> sessionId{};
+    std::uint32_t frameSequence{0};
+    std::uint64_t captureMicros{0};
+    std::uint32_t commandSequence{0};
+    std::uint32_t payloadLength{0};
+    std::uint64_t captureUnixMicros{0};
+};
+
+constexpr std::size_t kVideoFrameHeaderSize = 1 + 1 + 2 + 16 + 4 + 8 + 4 + 4 + 8;
+
+void encodeVideoFrameHeader(const VideoFrameHeader &header, std::uint8_t *out);
+// Throws std::invalid_argument if the buffer is shorter than the header it
+// announces or the version is unknown.
+VideoFrameHeader decodeVideoFrameHeader(const std::uint8_t *data, std::size_t size);
+
+// Fills in sequence, capture times and length from the frame. The wall
+// clock capture time is the frame's age subtracted from system_clock::now().
+VideoFrameHeader makeVideoFrameHeader(const SharedFrame &frame, const std::array<std::uint8_t, 16> &sessionId,
+                                      std::optional<std::uint32_t> commandSequence);
+
+// Header followed by the JPEG as two gather segments; the frame buffer is
+// referenced, not copied, and stays held until the message is sent or
+// dropped. The message bookkeeping comes from pool when given (see
+// CameraStreamer::bufferPool()), else from the heap.
+OutboundMessage makeVideoMessage(const VideoFrameHeader &header, SharedFrame frame,
+                                 std::shared_ptr<BufferPool> pool = nullptr);
+
+} // namespace minitrain
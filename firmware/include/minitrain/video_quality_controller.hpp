@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "minitrain/camera_driver.hpp"
+#include "minitrain/send_scheduler.hpp"
+
+namespace minitrain {
+
+struct VideoQualityLevel {
+    framesize_t frameSize{FRAMESIZE_VGA};
+    // esp32-camera scale: 0-63, lower is better.
+    int jpegQuality{12};
+    std::chrono::milliseconds captureInterval{33};
+};
+
+struct VideoQualityConfig {
+    // Best first. On ESP no level may use a larger frame size than the one
+    // the camera was initialised with.
+    std::vector<VideoQualityLevel> levels;
+    // Step down once video needs more than this share of the measured uplink
+    // or the video queue stays above maxQueueLatency.
+    double downgradeUtilisation{0.9};
+    std::chrono::milliseconds maxQueueLatency{150};
+    // Step up only while video needs less than this share.
+    double upgradeUtilisation{0.5};
+    // Consecutive evaluations that must agree before a step, and the quiet
+    // period after a step while its effect reaches the queue.
+    std::size_t downgradeAfter{3};
+    std::size_t upgradeAfter{30};
+    std::chrono::milliseconds settleTime{1000};
+
+    static VideoQualityConfig defaults();
+};
+
+// Picks JPEG quality, frame size and capture interval from a ladder of levels
+// to keep video within the uplink. Throughput is estimated from how long the
+// transport takes per byte; demand from the size of recent frames and the
+// level's frame rate. recordSend() may be called from the sender thread,
+// everything else from the thread that feeds the camera into the scheduler.
+class VideoQualityController {
+  public:
+    explicit VideoQualityController(VideoQualityConfig config = VideoQualityConfig::defaults());
+
+    void recordSend(std::size_t bytes, std::chrono::microseconds elapsed);
+    void recordFrame(std::size_t bytes);
+
+    // Call once per queued frame with the scheduler's video stats. Returns
+    // the new level when it changes.
+    std::optional<VideoQualityLevel> evaluate(const TrafficClassStats &video,
+                                              std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now());
+
+    [[nodiscard]] const VideoQualityLevel &level() const { return config_.levels[levelIndex_]; }
+    [[nodiscard]] std::size_t levelIndex() const { return levelIndex_; }
+    // 0 until the first send has been timed.
+    [[nodiscard]] double throughputBytesPerSecond() const;
+    [[nodiscard]] double demandBytesPerSecond() const;
+
+  private:
+    VideoQualityConfig config_;
+    std::size_t levelIndex_{0};
+    double averageFrameBytes_{0.0};
+    std::uint64_t lastDropped_{0};
+    std::size_t pressure_{0};
+    std::size_t headroom_{0};
+    std::chrono::steady_clock::time_point lastChange_{};
+
+    // Sliding byte/busy-time window, halved once it spans more than a second.
+    mutable std::mutex sendMutex_;
+    double sentBytes_{0.0};
+    double busySeconds_{0.0};
+};
+
+} // namespace minitrain
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace minitrain {
+
+enum class SimdIsa : std::uint8_t { Scalar = 0, Sse2 = 1, Avx2 = 2, Neon = 3 };
+
+enum class LumaReduction : std::uint8_t {
+    // Each output pixel is the rounded mean of a factor x factor luma block.
+    Average = 0,
+    // Each output pixel is the top-left luma sample of its block; cheaper,
+    // but aliases on fine detail.
+    Subsample = 1,
+};
+
+[[nodiscard]] const char *toString(SimdIsa isa);
+
+// Fastest kernel set supported by this build and CPU (AVX2 is detected at
+// run time on x86).
+[[nodiscard]] SimdIsa yuvKernelIsa();
+// Every kernel set usable here, scalar first.
+[[nodiscard]] std::vector<SimdIsa> availableYuvKernels();
+
+// Output is (width / factor) x (height / factor) bytes.
+[[nodiscard]] constexpr std::size_t lumaOutputSize(std::size_t width, std::size_t height, std::size_t factor) {
+    return factor == 0 ? 0 : (width / factor) * (height / factor);
+}
+
+// Converts a packed YUYV (YUV422) frame into a grayscale image downscaled by
+// factor 1, 2 or 4; factor 1 just extracts the luma plane. width must be even
+// and dst must hold lumaOutputSize() bytes. Partial blocks at the right and
+// bottom edges are dropped. Every ISA produces identical output. Returns
+// false for unsupported arguments or an ISA not available here.
+bool yuv422ToLuma(const std::uint8_t *src, std::size_t width, std::size_t height, std::size_t factor,
+                  LumaReduction reduction, std::uint8_t *dst, SimdIsa isa = yuvKernelIsa());
+
+} // namespace minitrain
@@ -1,19 +1,26 @@
 #include <algorithm>
+#include <array>
 #include <atomic>
 #include <cctype>
 #include <chrono>
 #include <iostream>
 #include <memory>
+#include <optional>
 #include <sstream>
 #include <thread>
 #include <unordered_map>
 
 #include "minitrain/command_channel.hpp"
 #include "minitrain/command_processor.hpp"
+#include "minitrain/cab_camera_rig.hpp"
 #include "minitrain/camera_streamer.hpp"
 #include "minitrain/secure_websocket_client.hpp"
+#include "minitrain/send_scheduler.hpp"
+#include "minitrain/static_frame_filter.hpp"
 #include "minitrain/pid_controller.hpp"
 #include "minitrain/train_controller.hpp"
+#include "minitrain/video_frame_header.hpp"
+#include "minitrain/video_quality_controller.hpp"
 
 #include "tls_credentials.hpp"
 
@@ -144,11 +151,57 @@ int main() {
                 std::cout << "ERR: failed to process secure command: " << ex.what() << '\n';
             }
         });
+        // Gateways that speak the binary protocol send encoded CommandFrames.
+        websocket->setBinaryHandler([&processor](const std::uint8_t *data, std::size_t size) {
+            try {
+                const auto inbound = minitrain::CommandChannel::decodeFrame(data, size);
+                auto result = processor.processFrame(inbound, std::chrono::steady_clock::now());
+                std::cout << (result.success ? "OK: " : "ERR: ") << result.message << " (secure)" << '\n';
+            } catch (const std::exception &ex) {
+                std::cout << "ERR: failed to process secure command frame: " << ex.what() << '\n';
+            }
+        });
         if (!websocket->connect()) {
             std::cout << "ERR: unable to open secure WebSocket session" << '\n';
         }
     }
 
+    // Send durations feed the uplink estimate that picks the video quality.
+    minitrain::VideoQualityController videoQuality;
+
+    // Everything outbound goes through one sender so telemetry never waits
+    // behind more than one video chunk.
+    minitrain::SendScheduler sendScheduler(
+        [&websocket, &videoQuality](bool binary, const minitrain::ByteSegment *segments, std::size_t count) {
+            if (!websocket || !websocket->isConnected()) {
+                return false;
+            }
+            const auto started = std::chrono::steady_clock::now();
+            std::size_t bytes = 0;
+            bool sent = false;
+            if (binary) {
+                for (std::size_t i = 0; i < count; ++i) {
+                    bytes += segments[i].size;
+                }
+                sent = websocket->sendBinary(segments, count);
+            } else {
+                std::string text;
+                for (std::size_t i = 0; i < count; ++i) {
+                    text.append(reinterpret_cast<const char *>(segments[i].data), segments[i].size);
+                }
+                bytes = text.size();
+                sent = websocket->sendText(text);
+            }
+            if (sent) {
+                videoQuality.recordSend(bytes, std::chrono::duration_cast<std::chrono::microseconds>(
+                                                   std::chrono::steady_clock::now() - started));
+            }
+            return sent;
+        });
+    sendScheduler.start();
+    // A stopped train films the same scene; send it once a second instead.
+    minitrain::StaticFrameFilter staticFrameFilter;
+
     CameraStreamer cameraStreamer;
     std::atomic<bool> cameraStreamingActive{false};
     auto cameraErrorHandler = [&cameraStreamingActive](const std::string &message) {
@@ -157,8 +210,21 @@ int main() {
     };
 
     auto cameraConfig = CameraStreamer::createDefaultConfig();
-    if (cameraStreamer.initialize(cameraConfig, 33ms, 3, 5, cameraErrorHandler)) {
-        const bool started = cameraStreamer.start();
+    // Under Wi-Fi congestion the capture rate drops instead of the stream dying.
+    minitrain::CameraBackpressureConfig cameraBackpressure{};
+    cameraBackpressure.policy = minitrain::CameraBackpressure::AdaptiveInterval;
+    // The board carries one sensor, so it serves both cabs; a rear streamer
+    // passed to the rig would be kept warm and switched to with the cab.
+    // Out of fb_count 3 buffers the rig queues one frame and the video class
+    // holds one (waiting or being sent), so the driver always keeps one to
+    // capture into; frames go back to it as soon as their send completes.
+    minitrain::CabCameraConfig cabCameraConfig{};
+    cabCameraConfig.queueDepth = 1;
+    minitrain::CabCameraRig cabCameras(cabCameraConfig);
+    // Frames are read through the rig's subscriptions, never the streamer's
+    // default queue.
+    if (cameraStreamer.initialize(cameraConfig, 33ms, 1, 5, cameraErrorHandler, cameraBackpressure)) {
+        const bool started = cabCameras.start(&cameraStreamer);
         cameraStreamingActive.store(started);
         if (!started) {
             std::cout << "WARN: camera capture thread did not start" << '\n';
@@ -218,21 +284,38 @@ int main() {
                 std::ostringstream serializedTelemetry;
                 serializedTelemetry << "speed=" << telemetry.speedMetersPerSecond << ";battery=" << telemetry.batteryVoltage
                                     << ";temperature=" << telemetry.temperatureCelsius;
-                websocket->sendText(serializedTelemetry.str());
+                sendScheduler.enqueue(minitrain::TrafficClass::Telemetry,
+                                      minitrain::OutboundMessage::text(serializedTelemetry.str()));
             }
         } else {
             std::this_thread::sleep_for(10ms);
         }
 
         if (cameraStreamer.isRunning()) {
-            auto frame = cameraStreamer.tryAcquireFrame(10ms);
+            cabCameras.setActiveCab(controller.state().activeCab);
+            auto frame = cabCameras.tryAcquireFrame(10ms);
             while (frame) {
                 if (websocket && websocket->isConnected()) {
-                    websocket->sendBinary(frame->data(), frame->size());
+                    if (!staticFrameFilter.shouldSend(*frame)) {
+                        frame = cabCameras.tryAcquireFrame(std::chrono::milliseconds{0});
+                        continue;
+                    }
+                    const auto applied = processor.lastAppliedCommand();
+                    const auto header = minitrain::makeVideoFrameHeader(
+                        *frame, applied ? applied->sessionId : std::array<std::uint8_t, 16>{},
+                        applied ? std::optional<std::uint32_t>{applied->sequence} : std::nullopt);
+                    videoQuality.recordFrame(frame->size());
+                    sendScheduler.enqueue(minitrain::TrafficClass::Video,
+                                          minitrain::makeVideoMessage(header, std::move(*frame),
+                                                                      cameraStreamer.bufferPool()));
+                    if (const auto level = videoQuality.evaluate(sendScheduler.stats(minitrain::TrafficClass::Video))) {
+                        cabCameras.setVideoQuality(level->frameSize, level->jpegQuality);
+                        cabCameras.setActiveInterval(level->captureInterval);
+                    }
                 } else {
                     std::cout << "Camera frame captured (" << frame->size() << " bytes)" << '\n';
                 }
-                frame = cameraStreamer.tryAcquireFrame(std::chrono::milliseconds{0});
+                frame = cabCameras.tryAcquireFrame(std::chrono::milliseconds{0});
             }
         } else if (cameraStreamingActive.load()) {
             cameraStreamingActive.store(false);
@@ -240,9 +323,9 @@ int main() {
         }
     }
 
-    if (cameraStreamer.isRunning()) {
-        cameraStreamer.stop();
-    }
+    sendScheduler.stop();
+    sendScheduler.clear();
+    cabCameras.stop();
 
     return 0;
 }
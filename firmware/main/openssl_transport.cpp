@@ -0,0 +1,134 @@
+#include "openssl_transport.hpp"
+
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+#include <openssl/err.h>
+#include <openssl/pem.h>
+#include <openssl/ssl.h>
+#include <openssl/x509v3.h>
+
+namespace minitrain {
+
+namespace {
+
+struct BioDeleter {
+    void operator()(BIO *bio) const { BIO_free(bio); }
+};
+using BioPtr = std::unique_ptr<BIO, BioDeleter>;
+
+BioPtr memoryBio(const std::string &pem) { return BioPtr(BIO_new_mem_buf(pem.data(), static_cast<int>(pem.size()))); }
+
+TransportStatus mapError(SSL *ssl, int result) {
+    switch (SSL_get_error(ssl, result)) {
+    case SSL_ERROR_WANT_READ:
+        return TransportStatus::WantRead;
+    case SSL_ERROR_WANT_WRITE:
+        return TransportStatus::WantWrite;
+    case SSL_ERROR_ZERO_RETURN:
+        return TransportStatus::Closed;
+    default:
+        ERR_clear_error();
+        return TransportStatus::Failed;
+    }
+}
+
+class OpenSslTransport final : public WebSocketTransport {
+  public:
+    OpenSslTransport(std::shared_ptr<SSL_CTX> context, SSL *ssl) : context_(std::move(context)), ssl_(ssl) {}
+
+    ~OpenSslTransport() override {
+        // Best effort: the socket is non-blocking and about to be closed.
+        (void)SSL_shutdown(ssl_);
+        SSL_free(ssl_);
+    }
+
+    OpenSslTransport(const OpenSslTransport &) = delete;
+    OpenSslTransport &operator=(const OpenSslTransport &) = delete;
+
+    TransportStatus handshake() override {
+        const int result = SSL_connect(ssl_);
+        return result == 1 ? TransportStatus::Ok : mapError(ssl_, result);
+    }
+
+    TransportStatus read(std::uint8_t *data, std::size_t size, std::size_t &transferred) override {
+        transferred = 0;
+        const int result = SSL_read_ex(ssl_, data, size, &transferred);
+        return result == 1 ? TransportStatus::Ok : mapError(ssl_, result);
+    }
+
+    TransportStatus write(const std::uint8_t *data, std::size_t size, std::size_t &transferred) override {
+        transferred = 0;
+        const int result = SSL_write_ex(ssl_, data, size, &transferred);
+        return result == 1 ? TransportStatus::Ok : mapError(ssl_, result);
+    }
+
+  private:
+    std::shared_ptr<SSL_CTX> context_;
+    SSL *ssl_;
+};
+
+} // namespace
+
+WebSocketTransportFactory makeOpenSslTransportFactory(const TlsCredentialConfig &config) {
+    std::shared_ptr<SSL_CTX> context(SSL_CTX_new(TLS_client_method()), SSL_CTX_free);
+    if (!context) {
+        throw std::runtime_error("Unable to create a TLS context");
+    }
+    SSL_CTX_set_min_proto_version(context.get(), TLS1_2_VERSION);
+    // Frames are written from a buffer that may move between retries.
+    SSL_CTX_set_mode(context.get(), SSL_MODE_ENABLE_PARTIAL_WRITE | SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+    SSL_CTX_set_verify(context.get(), SSL_VERIFY_PEER, nullptr);
+
+    X509_STORE *store = SSL_CTX_get_cert_store(context.get());
+    auto caBio = memoryBio(config.caCertificatePem);
+    std::size_t authorities = 0;
+    while (X509 *certificate = PEM_read_bio_X509(caBio.get(), nullptr, nullptr, nullptr)) {
+        authorities += X509_STORE_add_cert(store, certificate) == 1 ? 1U : 0U;
+        X509_free(certificate);
+    }
+    ERR_clear_error();
+    if (authorities == 0) {
+        throw std::runtime_error("No usable CA certificate in MINITRAIN_CA_CERT_PEM");
+    }
+
+    if (!config.clientCertificatePem.empty()) {
+        auto certificateBio = memoryBio(config.clientCertificatePem);
+        auto keyBio = memoryBio(config.clientPrivateKeyPem);
+        X509 *certificate = PEM_read_bio_X509(certificateBio.get(), nullptr, nullptr, nullptr);
+        EVP_PKEY *key = PEM_read_bio_PrivateKey(keyBio.get(), nullptr, nullptr, nullptr);
+        const bool loaded = certificate != nullptr && key != nullptr &&
+                            SSL_CTX_use_certificate(context.get(), certificate) == 1 &&
+                            SSL_CTX_use_PrivateKey(context.get(), key) == 1 &&
+                            SSL_CTX_check_private_key(context.get()) == 1;
+        X509_free(certificate);
+        EVP_PKEY_free(key);
+        ERR_clear_error();
+        if (!loaded) {
+            throw std::runtime_error("Client certificate or key is unusable");
+        }
+    }
+
+    return [context, expectedHost = config.expectedHost,
+            enforce = config.enforceHostnameValidation](int fd, const std::string &host) -> std::unique_ptr<WebSocketTransport> {
+        SSL *ssl = SSL_new(context.get());
+        if (ssl == nullptr) {
+            return nullptr;
+        }
+        const std::string &name = expectedHost.empty() ? host : expectedHost;
+        SSL_set_tlsext_host_name(ssl, name.c_str());
+        if (enforce && SSL_set1_host(ssl, name.c_str()) != 1) {
+            SSL_free(ssl);
+            return nullptr;
+        }
+        if (SSL_set_fd(ssl, fd) != 1) {
+            SSL_free(ssl);
+            return nullptr;
+        }
+        SSL_set_connect_state(ssl);
+        return std::make_unique<OpenSslTransport>(context, ssl);
+    };
+}
+
+} // namespace minitrain
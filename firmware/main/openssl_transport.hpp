@@ -0,0 +1,14 @@
+#pragma once
+
+#include "minitrain/posix_websocket_client.hpp"
+#include "minitrain/secure_websocket_client.hpp"
+
+namespace minitrain {
+
+// TLS for PosixWebSocketClient on hosts with OpenSSL. Servers are verified
+// against caCertificatePem, and against expectedHost when
+// enforceHostnameValidation is set; the client certificate is presented when
+// configured. Throws std::runtime_error if the PEM material is unusable.
+WebSocketTransportFactory makeOpenSslTransportFactory(const TlsCredentialConfig &config);
+
+} // namespace minitrain
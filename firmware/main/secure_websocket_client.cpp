@@ -1,21 +1,33 @@
 #include "minitrain/secure_websocket_client.hpp"
 
+#include <chrono>
 #include <cstdint>
 #include <mutex>
 #include <stdexcept>
 #include <utility>
+#include <vector>
 
 #ifdef ESP_PLATFORM
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_tls.h"
 #include "esp_websocket_client.h"
+#else
+#include <iostream>
+
+#include "minitrain/posix_websocket_client.hpp"
+#ifdef MINITRAIN_HAVE_OPENSSL
+#include "openssl_transport.hpp"
+#endif
 #endif
 
 namespace minitrain {
 
 namespace {
 constexpr const char *kLogTag = "mt_secure_ws";
+constexpr int kSendTimeoutMs = 10000;
+// Room for the largest CommandFrame: a 36 byte header and a 64 KiB payload.
+constexpr std::size_t kMaxInboundMessageBytes = 72 * 1024;
 }
 
 struct SecureWebSocketClient::Impl {
@@ -23,8 +35,57 @@ struct SecureWebSocketClient::Impl {
     esp_websocket_client_handle_t client{nullptr};
     std::mutex mutex;
     MessageHandler messageHandler;
+    BinaryHandler binaryHandler;
     EventHandler onConnected;
     EventHandler onDisconnected;
+    // Websocket task only. A message arrives as one event per received chunk
+    // of each frame; chunks are appended here until the final frame is
+    // complete. The buffer keeps its capacity between messages.
+    std::vector<std::uint8_t> inbound;
+    int inboundOpcode{-1};
+
+    void handleData(const esp_websocket_event_data_t &data) {
+        if (data.op_code == WS_TRANSPORT_OPCODES_TEXT || data.op_code == WS_TRANSPORT_OPCODES_BINARY) {
+            if (data.payload_offset == 0) {
+                inbound.clear();
+                inboundOpcode = data.op_code;
+            }
+        } else if (data.op_code != WS_TRANSPORT_OPCODES_CONT) {
+            // Ping, pong and close are answered by the client itself.
+            return;
+        }
+        if (inboundOpcode < 0 || data.data_len < 0) {
+            return;
+        }
+        const auto length = static_cast<std::size_t>(data.data_len);
+        if (inbound.size() + length > kMaxInboundMessageBytes) {
+#ifdef ESP_LOGW
+            ESP_LOGW(kLogTag, "Dropping inbound message larger than %u bytes", static_cast<unsigned>(kMaxInboundMessageBytes));
+#endif
+            inbound.clear();
+            inboundOpcode = -1;
+            return;
+        }
+        const auto *bytes = reinterpret_cast<const std::uint8_t *>(data.data_ptr);
+        inbound.insert(inbound.end(), bytes, bytes + length);
+        if (!data.fin || data.payload_offset + data.data_len < data.payload_len) {
+            return;
+        }
+
+        const int opcode = inboundOpcode;
+        inboundOpcode = -1;
+        if (inbound.empty()) {
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        if (opcode == WS_TRANSPORT_OPCODES_TEXT) {
+            if (messageHandler) {
+                messageHandler(std::string(inbound.begin(), inbound.end()));
+            }
+        } else if (binaryHandler) {
+            binaryHandler(inbound.data(), inbound.size());
+        }
+    }
 
     static void handleEvent(void *handlerArg, esp_event_base_t base, int32_t eventId, void *eventData) {
         auto *self = static_cast<SecureWebSocketClient::Impl *>(handlerArg);
@@ -46,24 +107,18 @@ struct SecureWebSocketClient::Impl {
             }
             break;
         }
-        case WEBSOCKET_EVENT_DATA: {
-            auto *data = static_cast<esp_websocket_event_data_t *>(eventData);
-            if (data->op_code == WS_TRANSPORT_OPCODES_TEXT && data->data_len > 0) {
-                std::string message(static_cast<const char *>(data->data_ptr), data->data_len);
-                std::lock_guard<std::mutex> lock(self->mutex);
-                if (self->messageHandler) {
-                    self->messageHandler(message);
-                }
-            }
+        case WEBSOCKET_EVENT_DATA:
+            self->handleData(*static_cast<esp_websocket_event_data_t *>(eventData));
             break;
-        }
         default:
             break;
         }
     }
 #else
-    bool connected{false};
+    // Created on connect() so a reconnect starts from a fresh session.
+    std::unique_ptr<PosixWebSocketClient> client;
     MessageHandler messageHandler;
+    BinaryHandler binaryHandler;
     EventHandler onConnected;
     EventHandler onDisconnected;
 #endif
@@ -93,6 +148,10 @@ void SecureWebSocketClient::setMessageHandler(MessageHandler handler) {
     impl_->messageHandler = std::move(handler);
 }
 
+void SecureWebSocketClient::setBinaryHandler(BinaryHandler handler) {
+    impl_->binaryHandler = std::move(handler);
+}
+
 void SecureWebSocketClient::setOnConnected(EventHandler handler) {
     impl_->onConnected = std::move(handler);
 }
@@ -126,6 +185,9 @@ bool SecureWebSocketClient::connect() {
         return false;
     }
 
+    // Commands are small; the buffer only grows for unusually large messages.
+    impl_->inbound.reserve(1024);
+    impl_->inboundOpcode = -1;
     esp_websocket_register_events(impl_->client, WEBSOCKET_EVENT_ANY, &Impl::handleEvent, impl_.get());
 
     const esp_err_t err = esp_websocket_client_start(impl_->client);
@@ -139,9 +201,49 @@ bool SecureWebSocketClient::connect() {
     }
     return true;
 #else
-    impl_->connected = true;
-    if (impl_->onConnected) {
-        impl_->onConnected();
+    if (impl_->client && impl_->client->isConnected()) {
+        return true;
+    }
+    PosixWebSocketConfig wsConfig{};
+    wsConfig.sendTimeout = std::chrono::milliseconds{kSendTimeoutMs};
+    wsConfig.maxMessageBytes = kMaxInboundMessageBytes;
+#ifdef MINITRAIN_HAVE_OPENSSL
+    try {
+        wsConfig.secureTransport = makeOpenSslTransportFactory(config_);
+    } catch (const std::exception &ex) {
+        if (config_.uri.rfind("wss://", 0) == 0) {
+            std::cerr << kLogTag << ": " << ex.what() << '\n';
+            return false;
+        }
+    }
+#endif
+    impl_->client.reset();
+    impl_->client = std::make_unique<PosixWebSocketClient>(std::move(wsConfig));
+    // Forward through impl so handlers set later, or moved clients, still apply.
+    auto *impl = impl_.get();
+    impl_->client->setMessageHandler([impl](const std::string &message) {
+        if (impl->messageHandler) {
+            impl->messageHandler(message);
+        }
+    });
+    impl_->client->setBinaryHandler([impl](const std::uint8_t *data, std::size_t size) {
+        if (impl->binaryHandler) {
+            impl->binaryHandler(data, size);
+        }
+    });
+    impl_->client->setOnConnected([impl] {
+        if (impl->onConnected) {
+            impl->onConnected();
+        }
+    });
+    impl_->client->setOnDisconnected([impl] {
+        if (impl->onDisconnected) {
+            impl->onDisconnected();
+        }
+    });
+    if (!impl_->client->open(config_.uri)) {
+        std::cerr << kLogTag << ": " << impl_->client->lastError() << '\n';
+        return false;
     }
     return true;
 #endif
@@ -155,11 +257,8 @@ void SecureWebSocketClient::close() {
         impl_->client = nullptr;
     }
 #else
-    if (impl_ && impl_->connected) {
-        impl_->connected = false;
-        if (impl_->onDisconnected) {
-            impl_->onDisconnected();
-        }
+    if (impl_ && impl_->client) {
+        impl_->client->close();
     }
 #endif
 }
@@ -168,7 +267,7 @@ bool SecureWebSocketClient::isConnected() const {
 #ifdef ESP_PLATFORM
     return impl_ && impl_->client && esp_websocket_client_is_connected(impl_->client);
 #else
-    return impl_ && impl_->connected;
+    return impl_ && impl_->client && impl_->client->isConnected();
 #endif
 }
 
@@ -177,16 +276,10 @@ bool SecureWebSocketClient::sendText(const std::string &payload) {
     if (!impl_ || !impl_->client || !esp_websocket_client_is_connected(impl_->client)) {
         return false;
     }
-    const int result = esp_websocket_client_send_text(impl_->client, payload.c_str(), static_cast<int>(payload.size()), 10000);
+    const int result = esp_websocket_client_send_text(impl_->client, payload.c_str(), static_cast<int>(payload.size()), kSendTimeoutMs);
     return result >= 0;
 #else
-    if (!impl_->connected) {
-        return false;
-    }
-    if (impl_->messageHandler) {
-        impl_->messageHandler(payload);
-    }
-    return true;
+    return impl_ && impl_->client && impl_->client->sendText(payload);
 #endif
 }
 
@@ -196,15 +289,45 @@ bool SecureWebSocketClient::sendBinary(const std::uint8_t *payload, std::size_t
         return false;
     }
     const int result =
-        esp_websocket_client_send_bin(impl_->client, reinterpret_cast<const char *>(payload), static_cast<int>(length), 10000);
+        esp_websocket_client_send_bin(impl_->client, reinterpret_cast<const char *>(payload), static_cast<int>(length), kSendTimeoutMs);
     return result >= 0;
 #else
-    if (!impl_->connected) {
+    return impl_ && impl_->client && impl_->client->sendBinary(payload, length);
+#endif
+}
+
+bool SecureWebSocketClient::sendBinary(const ByteSegment *segments, std::size_t count) {
+    if (count <= 1) {
+        return count == 1 && sendBinary(segments[0].data, segments[0].size);
+    }
+#ifdef ESP_PLATFORM
+    if (!impl_ || !impl_->client || !esp_websocket_client_is_connected(impl_->client)) {
         return false;
     }
-    (void)payload;
-    (void)length;
-    return true;
+    // One fragment per segment: the first carries the binary opcode, the rest
+    // are continuations and an empty FIN frame closes the message.
+    bool sent = true;
+    for (std::size_t i = 0; i < count && sent; ++i) {
+        const auto *data = reinterpret_cast<const char *>(segments[i].data);
+        const int length = static_cast<int>(segments[i].size);
+        const int result = i == 0 ? esp_websocket_client_send_bin_partial(impl_->client, data, length, kSendTimeoutMs)
+                                  : esp_websocket_client_send_cont_msg(impl_->client, data, length, kSendTimeoutMs);
+        sent = result >= 0;
+    }
+    sent = sent && esp_websocket_client_send_fin(impl_->client, kSendTimeoutMs) >= 0;
+    if (!sent) {
+        // A timed-out fragment may be half written, so a FIN cannot repair the
+        // stream and the next data frame would land inside an open message
+        // (RFC 6455 5.4). Restart the connection instead of sending a FIN.
+#ifdef ESP_LOGW
+        ESP_LOGW(kLogTag, "Fragmented send failed; restarting websocket");
+#endif
+        esp_websocket_client_stop(impl_->client);
+        esp_websocket_client_start(impl_->client);
+    }
+    return sent;
+#else
+    return impl_ && impl_->client && impl_->client->sendBinary(segments, count);
 #endif
 }
 
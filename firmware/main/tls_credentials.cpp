@@ -13,18 +13,25 @@ namespace minitrain::config {
 
 namespace {
 
-std::string readConfigString(const char *configValue, const char *envVariable, const char *name) {
+std::string readConfigString(const char *configValue, const char *envVariable, const char *name, bool required = true) {
     if (configValue != nullptr && configValue[0] != '\0') {
         return std::string(configValue);
     }
     if (const char *env = std::getenv(envVariable); env != nullptr) {
         return std::string(env);
     }
+    if (!required) {
+        return {};
+    }
     throw std::runtime_error(std::string("Configuration value missing for ") + name);
 }
 
 std::string parseHostFromUri(const std::string &uri) {
+#ifdef ESP_PLATFORM
     static const std::regex uriRegex(R"(^wss://([^/:]+).*$)");
+#else
+    static const std::regex uriRegex(R"(^wss?://([^/:]+).*$)");
+#endif
     std::smatch match;
     if (std::regex_match(uri, match, uriRegex)) {
         return match[1];
@@ -41,25 +48,35 @@ TlsCredentialConfig loadTlsCredentialConfig() {
 #else
     credentials.uri = readConfigString(nullptr, "MINITRAIN_WSS_URI", "MINITRAIN_WSS_URI");
 #endif
+#ifdef ESP_PLATFORM
+    // The device only ever talks mTLS to the gateway.
+    if (credentials.uri.rfind("wss://", 0) != 0) {
+        throw std::runtime_error("MINITRAIN_WSS_URI must use wss:// on the device: " + credentials.uri);
+    }
+    const bool secure = true;
+#else
+    // Plain ws:// (a local gateway on the simulator) needs no certificates.
+    const bool secure = credentials.uri.rfind("ws://", 0) != 0;
+#endif
 #ifdef CONFIG_MINITRAIN_CA_CERT_PEM
-    credentials.caCertificatePem = readConfigString(CONFIG_MINITRAIN_CA_CERT_PEM, "MINITRAIN_CA_CERT_PEM", "MINITRAIN_CA_CERT_PEM");
+    credentials.caCertificatePem = readConfigString(CONFIG_MINITRAIN_CA_CERT_PEM, "MINITRAIN_CA_CERT_PEM", "MINITRAIN_CA_CERT_PEM", secure);
 #else
-    credentials.caCertificatePem = readConfigString(nullptr, "MINITRAIN_CA_CERT_PEM", "MINITRAIN_CA_CERT_PEM");
+    credentials.caCertificatePem = readConfigString(nullptr, "MINITRAIN_CA_CERT_PEM", "MINITRAIN_CA_CERT_PEM", secure);
 #endif
 #ifdef CONFIG_MINITRAIN_CLIENT_CERT_PEM
-    credentials.clientCertificatePem = readConfigString(CONFIG_MINITRAIN_CLIENT_CERT_PEM, "MINITRAIN_CLIENT_CERT_PEM", "MINITRAIN_CLIENT_CERT_PEM");
+    credentials.clientCertificatePem = readConfigString(CONFIG_MINITRAIN_CLIENT_CERT_PEM, "MINITRAIN_CLIENT_CERT_PEM", "MINITRAIN_CLIENT_CERT_PEM", secure);
 #else
-    credentials.clientCertificatePem = readConfigString(nullptr, "MINITRAIN_CLIENT_CERT_PEM", "MINITRAIN_CLIENT_CERT_PEM");
+    credentials.clientCertificatePem = readConfigString(nullptr, "MINITRAIN_CLIENT_CERT_PEM", "MINITRAIN_CLIENT_CERT_PEM", secure);
 #endif
 #ifdef CONFIG_MINITRAIN_CLIENT_KEY_PEM
-    credentials.clientPrivateKeyPem = readConfigString(CONFIG_MINITRAIN_CLIENT_KEY_PEM, "MINITRAIN_CLIENT_KEY_PEM", "MINITRAIN_CLIENT_KEY_PEM");
+    credentials.clientPrivateKeyPem = readConfigString(CONFIG_MINITRAIN_CLIENT_KEY_PEM, "MINITRAIN_CLIENT_KEY_PEM", "MINITRAIN_CLIENT_KEY_PEM", secure);
 #else
-    credentials.clientPrivateKeyPem = readConfigString(nullptr, "MINITRAIN_CLIENT_KEY_PEM", "MINITRAIN_CLIENT_KEY_PEM");
+    credentials.clientPrivateKeyPem = readConfigString(nullptr, "MINITRAIN_CLIENT_KEY_PEM", "MINITRAIN_CLIENT_KEY_PEM", secure);
 #endif
 #ifdef CONFIG_MINITRAIN_EXPECTED_HOST
-    credentials.expectedHost = readConfigString(CONFIG_MINITRAIN_EXPECTED_HOST, "MINITRAIN_EXPECTED_HOST", "MINITRAIN_EXPECTED_HOST");
+    credentials.expectedHost = readConfigString(CONFIG_MINITRAIN_EXPECTED_HOST, "MINITRAIN_EXPECTED_HOST", "MINITRAIN_EXPECTED_HOST", false);
 #else
-    credentials.expectedHost = readConfigString(nullptr, "MINITRAIN_EXPECTED_HOST", "MINITRAIN_EXPECTED_HOST");
+    credentials.expectedHost = readConfigString(nullptr, "MINITRAIN_EXPECTED_HOST", "MINITRAIN_EXPECTED_HOST", false);
 #endif
 #ifdef CONFIG_MINITRAIN_ENFORCE_HOST_VALIDATION
     credentials.enforceHostnameValidation = CONFIG_MINITRAIN_ENFORCE_HOST_VALIDATION;
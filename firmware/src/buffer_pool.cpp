@@ -0,0 +1,155 @@
+#include "minitrain/buffer_pool.hpp"
+
+#include <algorithm>
+
+namespace minitrain {
+
+namespace {
+// The free-list head packs a 16-bit ABA tag over a 16-bit index + 1 so it is
+// a 32-bit CAS: 64-bit atomics are not lock-free on the 32-bit ESP32. A pop
+// preempted across exactly 65536 other pushes could still be fooled, which
+// the handful of frame blocks in flight never comes near.
+constexpr std::uint32_t kIndexMask = 0xFFFFU;
+constexpr unsigned kTagShift = 16;
+constexpr std::size_t kBlockAlignment = alignof(std::max_align_t);
+
+std::size_t roundUp(std::size_t bytes) { return (bytes + kBlockAlignment - 1U) / kBlockAlignment * kBlockAlignment; }
+} // namespace
+
+struct BufferPool::SizeClass {
+    std::size_t blockBytes{0};
+    std::size_t blockCount{0};
+    std::unique_ptr<std::uint8_t[]> storage;
+    // Free list links, index + 1 so 0 can mean "none".
+    std::unique_ptr<std::atomic<std::uint32_t>[]> next;
+    // Tag in the upper half against ABA, top index + 1 in the lower half.
+    std::atomic<std::uint32_t> head{0};
+    std::atomic<std::size_t> inUse{0};
+    std::atomic<std::size_t> highWater{0};
+    // Word-sized so allocate() stays lock-free; they wrap on 32-bit targets.
+    std::atomic<std::size_t> acquired{0};
+    std::atomic<std::size_t> exhausted{0};
+
+    static_assert(std::atomic<std::uint32_t>::is_always_lock_free, "BufferPool needs lock-free 32-bit atomics");
+    static_assert(std::atomic<std::size_t>::is_always_lock_free, "BufferPool needs lock-free word-sized atomics");
+
+    [[nodiscard]] std::uint8_t *block(std::size_t index) const { return storage.get() + index * blockBytes; }
+
+    [[nodiscard]] bool contains(const void *pointer) const {
+        const auto *byte = static_cast<const std::uint8_t *>(pointer);
+        return byte >= storage.get() && byte < storage.get() + blockBytes * blockCount;
+    }
+
+    void push(std::uint32_t index) {
+        std::uint32_t current = head.load(std::memory_order_relaxed);
+        std::uint32_t desired = 0;
+        do {
+            next[index].store(current & kIndexMask, std::memory_order_relaxed);
+            desired = (((current >> kTagShift) + 1U) << kTagShift) | (index + 1U);
+        } while (!head.compare_exchange_weak(current, desired, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    bool pop(std::uint32_t &index) {
+        std::uint32_t current = head.load(std::memory_order_acquire);
+        while (true) {
+            const std::uint32_t top = current & kIndexMask;
+            if (top == 0) {
+                return false;
+            }
+            // A stale link is harmless: the tag makes the exchange fail.
+            const std::uint32_t following = next[top - 1U].load(std::memory_order_relaxed) & kIndexMask;
+            const std::uint32_t desired = (((current >> kTagShift) + 1U) << kTagShift) | following;
+            if (head.compare_exchange_weak(current, desired, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                index = top - 1U;
+                return true;
+            }
+        }
+    }
+};
+
+BufferPool::BufferPool(std::vector<BufferPoolClass> classes) {
+    std::sort(classes.begin(), classes.end(),
+              [](const BufferPoolClass &a, const BufferPoolClass &b) { return a.blockBytes < b.blockBytes; });
+    for (const auto &config : classes) {
+        if (config.blockBytes == 0 || config.blockCount == 0 || config.blockCount >= kIndexMask) {
+            continue;
+        }
+        auto sizeClass = std::make_unique<SizeClass>();
+        sizeClass->blockBytes = roundUp(config.blockBytes);
+        sizeClass->blockCount = config.blockCount;
+        sizeClass->storage = std::make_unique<std::uint8_t[]>(sizeClass->blockBytes * sizeClass->blockCount);
+        sizeClass->next = std::make_unique<std::atomic<std::uint32_t>[]>(sizeClass->blockCount);
+        for (std::size_t i = sizeClass->blockCount; i > 0; --i) {
+            sizeClass->push(static_cast<std::uint32_t>(i - 1U));
+        }
+        classes_.push_back(std::move(sizeClass));
+    }
+}
+
+BufferPool::~BufferPool() = default;
+
+void *BufferPool::allocate(std::size_t bytes) {
+    SizeClass *bestFit = nullptr;
+    for (const auto &sizeClass : classes_) {
+        if (sizeClass->blockBytes < bytes) {
+            continue;
+        }
+        bestFit = bestFit != nullptr ? bestFit : sizeClass.get();
+        std::uint32_t index = 0;
+        if (!sizeClass->pop(index)) {
+            continue;
+        }
+        const auto used = sizeClass->inUse.fetch_add(1, std::memory_order_relaxed) + 1U;
+        auto high = sizeClass->highWater.load(std::memory_order_relaxed);
+        while (used > high && !sizeClass->highWater.compare_exchange_weak(high, used, std::memory_order_relaxed)) {
+        }
+        sizeClass->acquired.fetch_add(1, std::memory_order_relaxed);
+        return sizeClass->block(index);
+    }
+    if (bestFit != nullptr) {
+        bestFit->exhausted.fetch_add(1, std::memory_order_relaxed);
+    }
+    return nullptr;
+}
+
+void BufferPool::release(void *block) {
+    for (const auto &sizeClass : classes_) {
+        if (sizeClass->contains(block)) {
+            const auto offset = static_cast<std::size_t>(static_cast<std::uint8_t *>(block) - sizeClass->storage.get());
+            sizeClass->inUse.fetch_sub(1, std::memory_order_relaxed);
+            sizeClass->push(static_cast<std::uint32_t>(offset / sizeClass->blockBytes));
+            return;
+        }
+    }
+}
+
+bool BufferPool::owns(const void *block) const {
+    return std::any_of(classes_.begin(), classes_.end(),
+                       [block](const std::unique_ptr<SizeClass> &sizeClass) { return sizeClass->contains(block); });
+}
+
+std::vector<BufferPoolStats> BufferPool::stats() const {
+    std::vector<BufferPoolStats> result;
+    result.reserve(classes_.size());
+    for (const auto &sizeClass : classes_) {
+        BufferPoolStats stats{};
+        stats.blockBytes = sizeClass->blockBytes;
+        stats.capacity = sizeClass->blockCount;
+        stats.inUse = sizeClass->inUse.load(std::memory_order_relaxed);
+        stats.highWater = sizeClass->highWater.load(std::memory_order_relaxed);
+        stats.acquired = sizeClass->acquired.load(std::memory_order_relaxed);
+        stats.exhausted = sizeClass->exhausted.load(std::memory_order_relaxed);
+        result.push_back(stats);
+    }
+    return result;
+}
+
+std::size_t BufferPool::inUse() const {
+    std::size_t total = 0;
+    for (const auto &sizeClass : classes_) {
+        total += sizeClass->inUse.load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+} // namespace minitrain
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+
+namespace minitrain::detail {
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+constexpr bool kIsLittleEndian = true;
+#else
+constexpr bool kIsLittleEndian = false;
+#endif
+
+inline std::uint16_t swap16(std::uint16_t value) {
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_bswap16)
+    return __builtin_bswap16(value);
+#  endif
+#endif
+    return static_cast<std::uint16_t>(((value & 0x00FFU) << 8U) | ((value & 0xFF00U) >> 8U));
+}
+
+inline std::uint32_t swap32(std::uint32_t value) {
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_bswap32)
+    return __builtin_bswap32(value);
+#  endif
+#endif
+    return ((value & 0x000000FFU) << 24U) | ((value & 0x0000FF00U) << 8U) | ((value & 0x00FF0000U) >> 8U) |
+           ((value & 0xFF000000U) >> 24U);
+}
+
+inline std::uint64_t swap64(std::uint64_t value) {
+#if defined(__has_builtin)
+#  if __has_builtin(__builtin_bswap64)
+    return __builtin_bswap64(value);
+#  endif
+#endif
+    std::uint64_t result = 0;
+    for (int i = 0; i < 8; ++i) {
+        result |= ((value >> (i * 8)) & 0xFFULL) << (56 - i * 8);
+    }
+    return result;
+}
+
+inline std::uint16_t hostToLittle16(std::uint16_t value) { return kIsLittleEndian ? value : swap16(value); }
+
+inline std::uint32_t hostToLittle32(std::uint32_t value) { return kIsLittleEndian ? value : swap32(value); }
+
+inline std::uint64_t hostToLittle64(std::uint64_t value) { return kIsLittleEndian ? value : swap64(value); }
+
+inline std::uint16_t littleToHost16(std::uint16_t value) { return hostToLittle16(value); }
+
+inline std::uint32_t littleToHost32(std::uint32_t value) { return hostToLittle32(value); }
+
+inline std::uint64_t littleToHost64(std::uint64_t value) { return hostToLittle64(value); }
+
+// Cursor-style helpers used by the binary encoders. They write/read little-endian
+// values and advance the pointer past the encoded bytes.
+inline void putLittle16(std::uint8_t *&out, std::uint16_t value) {
+    const std::uint16_t encoded = hostToLittle16(value);
+    std::memcpy(out, &encoded, sizeof(encoded));
+    out += sizeof(encoded);
+}
+
+inline void putLittle32(std::uint8_t *&out, std::uint32_t value) {
+    const std::uint32_t encoded = hostToLittle32(value);
+    std::memcpy(out, &encoded, sizeof(encoded));
+    out += sizeof(encoded);
+}
+
+inline void putLittle64(std::uint8_t *&out, std::uint64_t value) {
+    const std::uint64_t encoded = hostToLittle64(value);
+    std::memcpy(out, &encoded, sizeof(encoded));
+    out += sizeof(encoded);
+}
+
+inline void putLittleFloat(std::uint8_t *&out, float value) {
+    static_assert(sizeof(float) == sizeof(std::uint32_t), "Unexpected float size");
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putLittle32(out, bits);
+}
+
+inline std::uint16_t getLittle16(const std::uint8_t *&in) {
+    std::uint16_t value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return littleToHost16(value);
+}
+
+inline std::uint32_t getLittle32(const std::uint8_t *&in) {
+    std::uint32_t value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return littleToHost32(value);
+}
+
+inline std::uint64_t getLittle64(const std::uint8_t *&in) {
+    std::uint64_t value;
+    std::memcpy(&value, in, sizeof(value));
+    in += sizeof(value);
+    return littleToHost64(value);
+}
+
+inline float getLittleFloat(const std::uint8_t *&in) {
+    const std::uint32_t bits = getLittle32(in);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+} // namespace minitrain::detail
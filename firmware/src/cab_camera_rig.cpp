@@ -0,0 +1,162 @@
+#include "minitrain/cab_camera_rig.hpp"
+
+#include <algorithm>
+
+namespace minitrain {
+
+namespace {
+std::int64_t toMicros(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+} // namespace
+
+CabCameraRig::CabCameraRig(CabCameraConfig config) : config_(config) {}
+
+CabCameraRig::~CabCameraRig() { stop(); }
+
+bool CabCameraRig::start(CameraStreamer *front, CameraStreamer *rear) {
+    stop();
+    if (front == nullptr) {
+        return false;
+    }
+    std::scoped_lock lock(mutex_);
+    cameras_ = {front, rear};
+    active_.store(kFront, std::memory_order_release);
+    switchedAtMicros_.store(0, std::memory_order_relaxed);
+    awaitingFirstFrame_.store(false, std::memory_order_relaxed);
+    for (std::size_t i = 0; i < cameras_.size(); ++i) {
+        auto *camera = cameras_[i];
+        if (camera == nullptr) {
+            continue;
+        }
+        subscriptions_[i] = camera->subscribe(config_.queueDepth, FrameDropPolicy::DropOldest);
+        camera->setCaptureInterval(i == kFront ? config_.activeInterval : config_.standbyInterval);
+        if (!subscriptions_[i] || (!camera->isRunning() && !camera->start())) {
+            for (std::size_t j = 0; j <= i; ++j) {
+                if (cameras_[j] != nullptr) {
+                    cameras_[j]->unsubscribe(subscriptions_[j]);
+                    cameras_[j]->stop();
+                }
+            }
+            cameras_ = {};
+            subscriptions_ = {};
+            return false;
+        }
+    }
+    running_.store(true, std::memory_order_release);
+    return true;
+}
+
+void CabCameraRig::stop() {
+    std::scoped_lock lock(mutex_);
+    for (std::size_t i = 0; i < cameras_.size(); ++i) {
+        if (cameras_[i] != nullptr) {
+            cameras_[i]->unsubscribe(subscriptions_[i]);
+            cameras_[i]->stop();
+        }
+    }
+    cameras_ = {};
+    subscriptions_ = {};
+    running_.store(false, std::memory_order_release);
+}
+
+void CabCameraRig::setActiveCab(ActiveCab cab) {
+    if (cab == ActiveCab::None) {
+        return;
+    }
+    const std::size_t next = cab == ActiveCab::Front ? kFront : kRear;
+    std::scoped_lock lock(mutex_);
+    const std::size_t previous = active_.load(std::memory_order_relaxed);
+    if (!running_.load(std::memory_order_relaxed) || cameras_[next] == nullptr || next == previous) {
+        return;
+    }
+    // Stamped before the new camera is woken so its first capture counts as
+    // fresh and anything captured earlier as stale.
+    switchedAtMicros_.store(toMicros(std::chrono::steady_clock::now().time_since_epoch()), std::memory_order_release);
+    awaitingFirstFrame_.store(true, std::memory_order_release);
+    // Standby frames go before the camera is woken, so its fresh capture
+    // cannot be flushed with them.
+    subscriptions_[next]->flush();
+    cameras_[next]->setCaptureInterval(config_.activeInterval);
+    active_.store(next, std::memory_order_release);
+    cameras_[previous]->setCaptureInterval(config_.standbyInterval);
+    // Wakes a consumer still waiting on the old queue.
+    subscriptions_[previous]->flush();
+    switchovers_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void CabCameraRig::setActiveInterval(std::chrono::milliseconds interval) {
+    std::scoped_lock lock(mutex_);
+    config_.activeInterval = interval;
+    if (auto *camera = cameras_[active_.load(std::memory_order_relaxed)]) {
+        camera->setCaptureInterval(interval);
+    }
+}
+
+bool CabCameraRig::setVideoQuality(framesize_t frameSize, int jpegQuality) {
+    std::scoped_lock lock(mutex_);
+    bool applied = cameras_[kFront] != nullptr;
+    for (auto *camera : cameras_) {
+        if (camera != nullptr) {
+            applied = camera->setVideoQuality(frameSize, jpegQuality) && applied;
+        }
+    }
+    return applied;
+}
+
+std::optional<SharedFrame> CabCameraRig::tryAcquireFrame(std::chrono::milliseconds timeout) {
+    if (!running_.load(std::memory_order_acquire)) {
+        return std::nullopt;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    while (true) {
+        const std::size_t index = active_.load(std::memory_order_acquire);
+        const auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        auto frame = subscriptions_[index]->tryAcquire(std::max(remaining, std::chrono::milliseconds::zero()));
+        if (frame) {
+            const auto captured = toMicros(frame->captureTime().time_since_epoch());
+            if (index != active_.load(std::memory_order_acquire) ||
+                captured < switchedAtMicros_.load(std::memory_order_acquire)) {
+                staleFrames_.fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (awaitingFirstFrame_.exchange(false, std::memory_order_acq_rel)) {
+                const auto now = toMicros(std::chrono::steady_clock::now().time_since_epoch());
+                switchLatencyMicros_.store(now - switchedAtMicros_.load(std::memory_order_relaxed),
+                                           std::memory_order_relaxed);
+            }
+            return frame;
+        }
+        // An empty wake-up before the deadline is a switch flushing the
+        // queue; wait on the new camera instead.
+        if (std::chrono::steady_clock::now() >= deadline) {
+            return std::nullopt;
+        }
+    }
+}
+
+ActiveCab CabCameraRig::streamingCab() const {
+    if (!running_.load(std::memory_order_acquire)) {
+        return ActiveCab::None;
+    }
+    return active_.load(std::memory_order_acquire) == kFront ? ActiveCab::Front : ActiveCab::Rear;
+}
+
+CameraStreamer *CabCameraRig::streamer(ActiveCab cab) const {
+    std::scoped_lock lock(mutex_);
+    if (cab == ActiveCab::None) {
+        return nullptr;
+    }
+    return cameras_[cab == ActiveCab::Front ? kFront : kRear];
+}
+
+CabCameraStats CabCameraRig::stats() const {
+    CabCameraStats stats{};
+    stats.streamingCab = streamingCab();
+    stats.switchovers = switchovers_.load(std::memory_order_relaxed);
+    stats.lastSwitchLatency = std::chrono::microseconds{switchLatencyMicros_.load(std::memory_order_relaxed)};
+    stats.staleFrames = staleFrames_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+} // namespace minitrain
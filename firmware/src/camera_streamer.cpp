@@ -1,44 +1,280 @@
 #include "minitrain/camera_streamer.hpp"
 
 #include <algorithm>
+#include <new>
 
 namespace minitrain {
 
-CameraStreamer::Frame::Frame() = default;
+namespace {
+std::int64_t toMicros(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+}
+
+// Exponentially weighted moving average (1/8) kept in an atomic with a single
+// writer, so readers can take lock-free snapshots.
+void updateAverage(std::atomic<std::int64_t> &average, std::int64_t sample) {
+    const auto current = average.load(std::memory_order_relaxed);
+    average.store(current == 0 ? sample : current + (sample - current) / 8, std::memory_order_relaxed);
+}
 
-CameraStreamer::Frame::Frame(camera_fb_t *frame, CameraStreamer *owner) : frame_(frame), owner_(owner) {}
+double ratePerSecond(std::int64_t intervalMicros) {
+    return intervalMicros > 0 ? 1e6 / static_cast<double>(intervalMicros) : 0.0;
+}
+} // namespace
 
-CameraStreamer::Frame::Frame(Frame &&other) noexcept : frame_(other.frame_), owner_(other.owner_) {
-    other.frame_ = nullptr;
-    other.owner_ = nullptr;
+SharedFrame::SharedFrame(const SharedFrame &other) noexcept : block_(other.block_) {
+    if (block_ != nullptr) {
+        retain(block_);
+    }
+}
+
+SharedFrame &SharedFrame::operator=(const SharedFrame &other) noexcept {
+    if (this != &other) {
+        if (other.block_ != nullptr) {
+            retain(other.block_);
+        }
+        reset();
+        block_ = other.block_;
+    }
+    return *this;
 }
 
-CameraStreamer::Frame &CameraStreamer::Frame::operator=(Frame &&other) noexcept {
+SharedFrame::SharedFrame(SharedFrame &&other) noexcept : block_(other.block_) { other.block_ = nullptr; }
+
+SharedFrame &SharedFrame::operator=(SharedFrame &&other) noexcept {
     if (this != &other) {
-        release();
-        frame_ = other.frame_;
-        owner_ = other.owner_;
-        other.frame_ = nullptr;
-        other.owner_ = nullptr;
+        reset();
+        block_ = other.block_;
+        other.block_ = nullptr;
     }
     return *this;
 }
 
-CameraStreamer::Frame::~Frame() { release(); }
+SharedFrame::~SharedFrame() { reset(); }
+
+const std::uint8_t *SharedFrame::data() const { return block_ ? block_->frame->buf : nullptr; }
+
+std::size_t SharedFrame::size() const { return block_ ? block_->frame->len : 0U; }
 
-const std::uint8_t *CameraStreamer::Frame::data() const { return frame_ ? frame_->buf : nullptr; }
+std::chrono::steady_clock::time_point SharedFrame::captureTime() const {
+    return block_ ? block_->captured : std::chrono::steady_clock::time_point{};
+}
+
+std::uint64_t SharedFrame::sequence() const { return block_ ? block_->sequence : 0U; }
 
-std::size_t CameraStreamer::Frame::size() const { return frame_ ? frame_->len : 0U; }
+const FrameFingerprint &SharedFrame::fingerprint() const {
+    static const FrameFingerprint kNone{};
+    return block_ ? block_->fingerprint : kNone;
+}
 
-void CameraStreamer::Frame::release() {
-    if (frame_ && owner_) {
-        owner_->returnFrame(frame_);
+JpegDefect SharedFrame::jpegDefect() const { return block_ ? block_->defect : JpegDefect::None; }
+
+std::uint32_t SharedFrame::useCount() const {
+    return block_ ? block_->references.load(std::memory_order_relaxed) : 0U;
+}
+
+void SharedFrame::retain(Block *block) { block->references.fetch_add(1, std::memory_order_relaxed); }
+
+void SharedFrame::release(Block *block) {
+    if (block->references.fetch_sub(1, std::memory_order_acq_rel) == 1U) {
+        block->owner->returnFrame(block->frame);
+        block->owner->held_.fetch_sub(1, std::memory_order_relaxed);
+        if (auto *pool = block->pool) {
+            block->~Block();
+            pool->release(block);
+        } else {
+            delete block;
+        }
+    }
+}
+
+void SharedFrame::reset() {
+    if (block_ != nullptr) {
+        release(block_);
+        block_ = nullptr;
     }
-    frame_ = nullptr;
-    owner_ = nullptr;
 }
 
-CameraStreamer::CameraStreamer() = default;
+FrameSubscription::FrameSubscription(std::size_t depth, FrameDropPolicy policy)
+    : policy_(policy), queue_(policy == FrameDropPolicy::LatestOnly ? 1U : std::max<std::size_t>(1, depth)) {}
+
+FrameSubscription::~FrameSubscription() { flush(); }
+
+void FrameSubscription::offer(SharedFrame::Block *block) {
+    SharedFrame::retain(block);
+    while (!queue_.tryPush(block)) {
+        if (policy_ == FrameDropPolicy::DropNewest) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            SharedFrame::release(block);
+            return;
+        }
+        // The consumer may win the race for the oldest entry, in which case
+        // there is room on the next attempt.
+        SharedFrame::Block *oldest = nullptr;
+        if (queue_.tryPop(oldest)) {
+            dropped_.fetch_add(1, std::memory_order_relaxed);
+            SharedFrame::release(oldest);
+        }
+    }
+    available_.notifyAll();
+}
+
+void FrameSubscription::flush() {
+    SharedFrame::Block *block = nullptr;
+    while (queue_.tryPop(block)) {
+        SharedFrame::release(block);
+    }
+    available_.notifyAll();
+}
+
+SharedFrame FrameSubscription::deliver(SharedFrame::Block *block) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto nowMicros = toMicros(now.time_since_epoch());
+    const auto last = lastDeliveryMicros_.exchange(nowMicros, std::memory_order_relaxed);
+    if (last != 0) {
+        updateAverage(deliveryIntervalMicros_, nowMicros - last);
+    }
+    const auto latency = toMicros(now - block->captured);
+    updateAverage(latencyMicros_, std::max<std::int64_t>(latency, 1));
+    if (latency > maxLatencyMicros_.load(std::memory_order_relaxed)) {
+        maxLatencyMicros_.store(latency, std::memory_order_relaxed);
+    }
+    delivered_.fetch_add(1, std::memory_order_relaxed);
+    return SharedFrame(block);
+}
+
+std::optional<SharedFrame> FrameSubscription::tryAcquire(std::chrono::milliseconds timeout) {
+    SharedFrame::Block *block = nullptr;
+    if (queue_.tryPop(block)) {
+        return deliver(block);
+    }
+
+    const auto deadline = std::chrono::steady_clock::now() + timeout;
+    const auto key = available_.prepareWait();
+    if (queue_.tryPop(block)) {
+        available_.cancelWait();
+        return deliver(block);
+    }
+    // A wake-up without a frame means the queue was flushed meanwhile.
+    if (available_.wait(key, deadline) && queue_.tryPop(block)) {
+        return deliver(block);
+    }
+    return std::nullopt;
+}
+
+FrameSubscriptionStats FrameSubscription::stats() const {
+    FrameSubscriptionStats stats{};
+    stats.deliveredFrames = delivered_.load(std::memory_order_relaxed);
+    stats.droppedFrames = dropped_.load(std::memory_order_relaxed);
+    stats.pending = queue_.size();
+    stats.deliveredFps = ratePerSecond(deliveryIntervalMicros_.load(std::memory_order_relaxed));
+    stats.averageLatency = std::chrono::microseconds{latencyMicros_.load(std::memory_order_relaxed)};
+    stats.maxLatency = std::chrono::microseconds{maxLatencyMicros_.load(std::memory_order_relaxed)};
+    return stats;
+}
+
+FrameFanout::FrameFanout(Releaser releaser) : releaser_(std::move(releaser)) {}
+
+FrameFanout::~FrameFanout() { flush(); }
+
+template <typename Fn> void FrameFanout::forEachSubscriber(Fn &&fn) const {
+    // seq_cst on the count and the slot loads pairs with unsubscribe(): either
+    // this walk sees the emptied slot or unsubscribe() sees this reader.
+    readers_.fetch_add(1);
+    for (const auto &slot : slots_) {
+        if (auto *subscription = slot.load()) {
+            fn(*subscription);
+        }
+    }
+    readers_.fetch_sub(1, std::memory_order_release);
+}
+
+std::shared_ptr<FrameSubscription> FrameFanout::subscribe(std::size_t depth, FrameDropPolicy policy) {
+    std::scoped_lock lock(subscribersMutex_);
+    for (auto &slot : slots_) {
+        if (slot.load(std::memory_order_relaxed) == nullptr) {
+            auto subscription = std::make_shared<FrameSubscription>(depth, policy);
+            owned_.push_back(subscription);
+            slot.store(subscription.get(), std::memory_order_release);
+            return subscription;
+        }
+    }
+    return nullptr;
+}
+
+void FrameFanout::unsubscribe(const std::shared_ptr<FrameSubscription> &subscription) {
+    if (!subscription) {
+        return;
+    }
+    {
+        std::scoped_lock lock(subscribersMutex_);
+        const auto found = std::find(owned_.begin(), owned_.end(), subscription);
+        if (found == owned_.end()) {
+            return;
+        }
+        for (auto &slot : slots_) {
+            if (slot.load(std::memory_order_relaxed) == subscription.get()) {
+                slot.store(nullptr);
+            }
+        }
+        // Walks are a handful of loads; wait them out rather than defer.
+        while (readers_.load() != 0U) {
+            std::this_thread::yield();
+        }
+        owned_.erase(found);
+    }
+    subscription->flush();
+}
+
+std::size_t FrameFanout::subscriberCount() const {
+    std::size_t count = 0;
+    for (const auto &slot : slots_) {
+        count += slot.load(std::memory_order_acquire) != nullptr ? 1U : 0U;
+    }
+    return count;
+}
+
+std::uint64_t FrameFanout::droppedFrames() const {
+    std::uint64_t dropped = 0;
+    forEachSubscriber([&dropped](const FrameSubscription &subscription) { dropped += subscription.droppedFrames(); });
+    return dropped;
+}
+
+void FrameFanout::publish(camera_fb_t *frame, std::chrono::steady_clock::time_point captured,
+                          const FrameFingerprint &fingerprint, JpegDefect defect) {
+    if (frame == nullptr) {
+        return;
+    }
+    static_assert(sizeof(SharedFrame::Block) <= kFrameMetadataBytes, "Frame block outgrew its pool class");
+    // The publisher holds one reference while fanning out; if nobody takes
+    // the frame it goes straight back to the driver.
+    void *memory = pool_ ? pool_->allocate(sizeof(SharedFrame::Block)) : nullptr;
+    auto *block = memory != nullptr ? new (memory) SharedFrame::Block{} : new SharedFrame::Block{};
+    block->pool = memory != nullptr ? pool_.get() : nullptr;
+    block->frame = frame;
+    block->owner = this;
+    block->captured = captured;
+    block->sequence = nextSequence_++;
+    block->fingerprint = fingerprint;
+    block->defect = defect;
+    held_.fetch_add(1, std::memory_order_relaxed);
+    forEachSubscriber([block](FrameSubscription &subscription) { subscription.offer(block); });
+    SharedFrame::release(block);
+}
+
+void FrameFanout::flush() {
+    forEachSubscriber([](FrameSubscription &subscription) { subscription.flush(); });
+}
+
+void FrameFanout::returnFrame(camera_fb_t *frame) const {
+    if (releaser_) {
+        releaser_(frame);
+    }
+}
+
+CameraStreamer::CameraStreamer()
+    : source_(std::make_shared<EspCameraFrameSource>()),
+      fanout_([this](camera_fb_t *frame) { returnFrame(frame); }) {}
 
 CameraStreamer::~CameraStreamer() { stop(); }
 
@@ -46,7 +282,8 @@ bool CameraStreamer::initialize(const camera_config_t &config,
                                 std::chrono::milliseconds captureInterval,
                                 std::size_t maxBufferedFrames,
                                 std::size_t maxConsecutiveFailures,
-                                ErrorHandler errorHandler) {
+                                ErrorHandler errorHandler,
+                                CameraBackpressureConfig backpressure) {
     stop();
 
     config_ = config;
@@ -54,86 +291,150 @@ bool CameraStreamer::initialize(const camera_config_t &config,
     maxBufferedFrames_ = std::max<std::size_t>(1, maxBufferedFrames);
     maxConsecutiveFailures_ = std::max<std::size_t>(1, maxConsecutiveFailures);
     errorHandler_ = std::move(errorHandler);
+    backpressure_ = backpressure;
+    backpressure_.maxCaptureInterval = std::max(backpressure_.maxCaptureInterval, captureInterval_);
+
+    // Each frame buffer in flight needs a fanout block and, once queued for
+    // sending, a video message; one spare frame covers the hand-over. A pool
+    // that still has frames out is kept rather than freed under them.
+    if (!pool_ || pool_->inUse() == 0) {
+        const auto frames = static_cast<std::size_t>(std::max(config_.fb_count, 1)) + 1U;
+        statsPool_.store(nullptr);
+        waitForStatsReaders();
+        pool_ = std::make_shared<BufferPool>(std::vector<BufferPoolClass>{{kFrameMetadataBytes, frames * 2U}});
+        fanout_.setBufferPool(pool_);
+        statsPool_.store(pool_.get(), std::memory_order_release);
+    }
 
 #ifdef ESP_PLATFORM
-    esp_err_t err = esp_camera_init(&config_);
-    if (err != ESP_OK) {
-        if (errorHandler_) {
-            errorHandler_(std::string("Failed to initialise camera: ") + esp_err_to_name(err));
+    if (!customSource_) {
+        esp_err_t err = esp_camera_init(&config_);
+        if (err != ESP_OK) {
+            if (errorHandler_) {
+                errorHandler_(std::string("Failed to initialise camera: ") + esp_err_to_name(err));
+            }
+            return false;
         }
-        return false;
     }
 #endif
 
+    defaultQueue_.store(nullptr);
+    waitForStatsReaders();
+    fanout_.unsubscribe(defaultSubscription_);
+    defaultSubscription_.reset();
     initialized_ = true;
     return true;
 }
 
 bool CameraStreamer::start() {
-    if (!initialized_ || running_) {
-        return running_;
-    }
-
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        stopRequested_ = false;
-        frameQueue_.clear();
+    if (!initialized_ || running_.load(std::memory_order_acquire)) {
+        return running_.load(std::memory_order_acquire);
     }
 
-    running_ = true;
+    fanout_.flush();
+    stopRequested_.store(false, std::memory_order_release);
+    captured_.store(0, std::memory_order_relaxed);
+    captureSpacingMicros_.store(0, std::memory_order_relaxed);
+    missedTicks_.store(0, std::memory_order_relaxed);
+    retimed_.store(false, std::memory_order_relaxed);
+    lumaFrames_.store(0, std::memory_order_relaxed);
+    lumaSkipped_.store(0, std::memory_order_relaxed);
+    latestLuma_.store(0, std::memory_order_release);
+    captureIntervalMicros_.store(toMicros(captureInterval_), std::memory_order_relaxed);
+    minCaptureIntervalMicros_.store(toMicros(captureInterval_), std::memory_order_relaxed);
+    lastDropped_ = fanout_.droppedFrames();
+    calmFrames_ = 0;
+
+    running_.store(true, std::memory_order_release);
     captureThread_ = std::thread(&CameraStreamer::captureLoop, this);
     return true;
 }
 
 void CameraStreamer::stop() {
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        stopRequested_ = true;
-    }
-    frameAvailable_.notify_all();
+    stopRequested_.store(true, std::memory_order_release);
+    pacing_.notifyAll();
 
     if (captureThread_.joinable()) {
         captureThread_.join();
     }
-
-    std::deque<camera_fb_t *> remainingFrames;
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        remainingFrames.swap(frameQueue_);
-        running_ = false;
-    }
-
-    for (auto *frame : remainingFrames) {
-        returnFrame(frame);
-    }
+    running_.store(false, std::memory_order_release);
+    // Frames still held by consumers are returned when their last handle goes.
+    fanout_.flush();
 
 #ifdef ESP_PLATFORM
-    if (initialized_) {
+    if (initialized_ && !customSource_) {
         esp_camera_deinit();
     }
 #endif
 
     initialized_ = false;
-    stopRequested_ = false;
+    stopRequested_.store(false, std::memory_order_release);
 }
 
 std::optional<CameraStreamer::Frame> CameraStreamer::tryAcquireFrame(std::chrono::milliseconds timeout) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    if (!running_) {
+    if (!running_.load(std::memory_order_acquire)) {
         return std::nullopt;
     }
-
-    if (!frameAvailable_.wait_for(lock, timeout, [this]() { return !frameQueue_.empty() || !running_; })) {
-        return std::nullopt;
+    if (!defaultSubscription_) {
+        FrameDropPolicy policy = FrameDropPolicy::DropOldest;
+        if (backpressure_.policy == CameraBackpressure::LatestOnly) {
+            policy = FrameDropPolicy::LatestOnly;
+        } else if (backpressure_.policy == CameraBackpressure::DropNewest) {
+            policy = FrameDropPolicy::DropNewest;
+        }
+        defaultSubscription_ = fanout_.subscribe(maxBufferedFrames_, policy);
+        defaultQueue_.store(defaultSubscription_.get(), std::memory_order_release);
     }
+    return defaultSubscription_->tryAcquire(timeout);
+}
 
-    if (!running_ || frameQueue_.empty()) {
-        return std::nullopt;
+std::shared_ptr<FrameSubscription> CameraStreamer::subscribe(std::size_t depth, FrameDropPolicy policy) {
+    return fanout_.subscribe(depth, policy);
+}
+
+void CameraStreamer::unsubscribe(const std::shared_ptr<FrameSubscription> &subscription) {
+    fanout_.unsubscribe(subscription);
+}
+
+CameraStreamStats CameraStreamer::stats() const {
+    CameraStreamStats stats{};
+    stats.capturedFrames = captured_.load(std::memory_order_relaxed);
+    stats.captureFps = ratePerSecond(captureSpacingMicros_.load(std::memory_order_relaxed));
+    stats.captureInterval = std::chrono::microseconds{captureIntervalMicros_.load(std::memory_order_relaxed)};
+    stats.missedTicks = missedTicks_.load(std::memory_order_relaxed);
+    stats.droppedFrames = fanout_.droppedFrames();
+    stats.heldFrames = fanout_.heldFrames();
+    stats.lumaFrames = lumaFrames_.load(std::memory_order_relaxed);
+    stats.lumaSkipped = lumaSkipped_.load(std::memory_order_relaxed);
+    stats.corruptFrames = corruptFrames_.load(std::memory_order_relaxed);
+    stats.lastJpegDefect = lastJpegDefect_.load(std::memory_order_relaxed);
+    // seq_cst on the count and the pointer loads pairs with initialize():
+    // either this sees a cleared pointer or initialize() sees this reader.
+    statsReaders_.fetch_add(1);
+    if (const auto *pool = statsPool_.load()) {
+        for (const auto &poolClass : pool->stats()) {
+            stats.poolBlocksInUse += poolClass.inUse;
+            stats.poolHighWater += poolClass.highWater;
+            stats.poolExhausted += poolClass.exhausted;
+        }
+    }
+    if (const auto *queue = defaultQueue_.load()) {
+        const auto queueStats = queue->stats();
+        stats.deliveredFrames = queueStats.deliveredFrames;
+        stats.deliveredFps = queueStats.deliveredFps;
+        stats.queueDepth = queueStats.pending;
+        stats.averageLatency = queueStats.averageLatency;
+        stats.maxLatency = queueStats.maxLatency;
     }
+    statsReaders_.fetch_sub(1, std::memory_order_release);
+    return stats;
+}
 
-    auto *frame = frameQueue_.front();
-    frameQueue_.pop_front();
-    return Frame(frame, this);
+void CameraStreamer::waitForStatsReaders() const {
+    // stats() only copies counters; wait it out rather than defer.
+    while (statsReaders_.load() != 0U) {
+        std::this_thread::yield();
+    }
 }
 
 camera_config_t CameraStreamer::createDefaultConfig() {
@@ -177,98 +478,221 @@ camera_config_t CameraStreamer::createDefaultConfig() {
 
 void CameraStreamer::captureLoop() {
     std::size_t consecutiveFailures = 0;
-    std::size_t overflowEvents = 0;
-
-    while (true) {
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (stopRequested_) {
-                break;
-            }
-        }
-
-        camera_fb_t *frame = esp_camera_fb_get();
+    auto lastCapture = std::chrono::steady_clock::time_point{};
+    // Captures are paced on absolute ticks so the period does not stretch by
+    // the time spent in the driver; a tick that has already passed is skipped
+    // rather than captured late.
+    auto nextTick = std::chrono::steady_clock::now();
+
+    while (!stopRequested_.load(std::memory_order_acquire)) {
+        camera_fb_t *frame = source_->acquire();
         if (frame == nullptr) {
             ++consecutiveFailures;
             if (consecutiveFailures >= maxConsecutiveFailures_) {
                 if (errorHandler_) {
                     errorHandler_("Camera capture failed repeatedly; stopping stream");
                 }
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    stopRequested_ = true;
-                }
+                stopRequested_.store(true, std::memory_order_release);
                 break;
             }
             continue;
         }
 
         consecutiveFailures = 0;
-        camera_fb_t *droppedFrame = nullptr;
-        bool overflowed = false;
-
-        {
-            std::lock_guard<std::mutex> lock(mutex_);
-            if (stopRequested_) {
-                droppedFrame = frame;
-                frame = nullptr;
-            } else {
-                if (frameQueue_.size() >= maxBufferedFrames_) {
-                    droppedFrame = frameQueue_.front();
-                    frameQueue_.pop_front();
-                    overflowed = true;
-                }
-                frameQueue_.push_back(frame);
-                frame = nullptr;
-            }
+        if (stopRequested_.load(std::memory_order_acquire)) {
+            returnFrame(frame);
+            break;
         }
 
-        if (droppedFrame != nullptr) {
-            returnFrame(droppedFrame);
+        const auto now = std::chrono::steady_clock::now();
+        if (lastCapture != std::chrono::steady_clock::time_point{}) {
+            updateAverage(captureSpacingMicros_, toMicros(now - lastCapture));
         }
-
-        if (overflowed) {
-            if (errorHandler_) {
-                errorHandler_("Camera frame queue overflow; dropping oldest frame");
+        lastCapture = now;
+        // Counted before publishing so captured never trails delivered.
+        captured_.fetch_add(1, std::memory_order_relaxed);
+        const auto validation = jpegValidation_.load(std::memory_order_relaxed);
+        JpegDefect defect = JpegDefect::None;
+        if (frame->format == PIXFORMAT_JPEG && validation != JpegValidation::Off) {
+            defect = validateJpeg(frame->buf, frame->len);
+            if (defect != JpegDefect::None) {
+                corruptFrames_.fetch_add(1, std::memory_order_relaxed);
+                lastJpegDefect_.store(defect, std::memory_order_relaxed);
             }
-            ++overflowEvents;
-            if (overflowEvents >= maxConsecutiveFailures_) {
-                if (errorHandler_) {
-                    errorHandler_("Camera overwhelmed; stopping stream");
-                }
-                {
-                    std::lock_guard<std::mutex> lock(mutex_);
-                    stopRequested_ = true;
-                }
-                break;
+        }
+        if (defect != JpegDefect::None && validation == JpegValidation::Drop) {
+            returnFrame(frame);
+        } else {
+            // Before publishing: once published the frame may already be
+            // back with the driver.
+            if (frame->format == PIXFORMAT_YUV422 && lumaFactor_.load(std::memory_order_relaxed) != 0) {
+                runLumaStage(*frame, now);
             }
+            fanout_.publish(frame, now, fingerprintFrame(*frame), defect);
+        }
+
+        if (backpressure_.policy == CameraBackpressure::AdaptiveInterval) {
+            adaptCaptureInterval(fanout_.droppedFrames());
+        }
+        const auto interval = std::chrono::microseconds{captureIntervalMicros_.load(std::memory_order_relaxed)};
+        if (interval <= std::chrono::microseconds::zero()) {
+            nextTick = now;
+            continue;
+        }
+        nextTick += interval;
+        const auto wake = std::chrono::steady_clock::now();
+        if (nextTick <= wake) {
+            const auto missed = (wake - nextTick) / interval + 1;
+            nextTick += interval * missed;
+            missedTicks_.fetch_add(static_cast<std::uint64_t>(missed), std::memory_order_relaxed);
+        }
+        const auto key = pacing_.prepareWait();
+        if (retimed_.load(std::memory_order_acquire) || stopRequested_.load(std::memory_order_acquire)) {
+            pacing_.cancelWait();
         } else {
-            overflowEvents = 0;
+            (void)pacing_.wait(key, nextTick);
+        }
+        if (retimed_.exchange(false, std::memory_order_acq_rel)) {
+            nextTick = std::chrono::steady_clock::now();
         }
+    }
+
+    running_.store(false, std::memory_order_release);
+    // initialize() stops this thread before it drops the subscription.
+    if (auto *queue = defaultQueue_.load(std::memory_order_acquire)) {
+        queue->flush();
+    }
+}
+
+void CameraStreamer::adaptCaptureInterval(std::uint64_t droppedFrames) {
+    // Back off quickly while subscribers drop frames, recover slowly once
+    // they keep up, so congestion lowers the frame rate instead of wasting
+    // captures.
+    constexpr std::int64_t kBackoffStepMicros = 5000;
+    constexpr std::int64_t kRecoveryStepMicros = 2000;
+    constexpr std::size_t kCalmFramesBeforeRecovery = 15;
+
+    const bool congested = droppedFrames > lastDropped_;
+    const bool recover = !congested && ++calmFrames_ >= kCalmFramesBeforeRecovery;
+    calmFrames_ = congested || recover ? 0 : calmFrames_;
+    lastDropped_ = droppedFrames;
+    if (!congested && !recover) {
+        return;
+    }
+    // setCaptureInterval() may move the floor concurrently; recompute
+    // against the current floor until the update lands.
+    auto interval = captureIntervalMicros_.load(std::memory_order_relaxed);
+    std::int64_t updated = 0;
+    do {
+        const auto floor = minCaptureIntervalMicros_.load(std::memory_order_relaxed);
+        const auto ceiling = std::max(floor, toMicros(backpressure_.maxCaptureInterval));
+        updated = congested ? std::min(ceiling, std::max(interval + kBackoffStepMicros, interval * 3 / 2))
+                            : std::max(floor, interval - kRecoveryStepMicros);
+    } while (!captureIntervalMicros_.compare_exchange_weak(interval, updated, std::memory_order_relaxed));
+}
+
+void CameraStreamer::runLumaStage(const camera_fb_t &frame, std::chrono::steady_clock::time_point captured) {
+    const auto factor = lumaFactor_.load(std::memory_order_relaxed);
+    const auto reduction = lumaReduction_.load(std::memory_order_relaxed);
+    if (frame.len < frame.width * frame.height * 2U) {
+        return;
+    }
+
+    // Pairs with the fence in latestLumaFrame(): a reader that copied a
+    // buffer before this scan either shows up in its use count or sees that
+    // the buffer is no longer the latest and lets go of it.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    const auto latest = latestLuma_.load(std::memory_order_relaxed);
+    std::size_t index = kLumaBuffers;
+    for (std::size_t i = 0; i < kLumaBuffers; ++i) {
+        if (i + 1 != latest && (!lumaPool_[i] || lumaPool_[i].use_count() == 1)) {
+            index = i;
+            break;
+        }
+    }
+    if (index == kLumaBuffers) {
+        lumaSkipped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!lumaPool_[index]) {
+        lumaPool_[index] = std::make_shared<LumaFrame>();
+    }
+    LumaFrame *target = lumaPool_[index].get();
+    // Pairs with the release when the last reader dropped the buffer.
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    target->width = frame.width / factor;
+    target->height = frame.height / factor;
+    target->sequence = fanout_.nextSequence();
+    target->captureTime = captured;
+    target->pixels.resize(lumaOutputSize(frame.width, frame.height, factor));
+    if (!yuv422ToLuma(frame.buf, frame.width, frame.height, factor, reduction, target->pixels.data())) {
+        return;
+    }
+    latestLuma_.store(index + 1, std::memory_order_release);
+    lumaFrames_.fetch_add(1, std::memory_order_relaxed);
+}
 
-        frameAvailable_.notify_one();
+bool CameraStreamer::setLumaStage(std::size_t factor, LumaReduction reduction) {
+    if (factor != 0 && factor != 1 && factor != 2 && factor != 4) {
+        return false;
+    }
+    lumaReduction_.store(reduction, std::memory_order_relaxed);
+    lumaFactor_.store(factor, std::memory_order_relaxed);
+    return true;
+}
 
-        if (captureInterval_ > std::chrono::milliseconds::zero()) {
-            std::this_thread::sleep_for(captureInterval_);
+std::shared_ptr<const LumaFrame> CameraStreamer::latestLumaFrame() const {
+    // Take a reference, then confirm the buffer is still the published one;
+    // if the stage moved on meanwhile it may be rewriting it, so retry.
+    for (auto latest = latestLuma_.load(std::memory_order_acquire); latest != 0;) {
+        std::shared_ptr<const LumaFrame> frame = lumaPool_[latest - 1];
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto current = latestLuma_.load(std::memory_order_acquire);
+        if (current == latest) {
+            return frame;
         }
+        latest = current;
     }
+    return nullptr;
+}
 
-    {
-        std::lock_guard<std::mutex> lock(mutex_);
-        running_ = false;
+bool CameraStreamer::setVideoQuality(framesize_t frameSize, int jpegQuality) {
+    if (!source_->applySettings(frameSize, jpegQuality)) {
+        return false;
     }
-    frameAvailable_.notify_all();
+    config_.frame_size = frameSize;
+    config_.jpeg_quality = jpegQuality;
+    return true;
+}
+
+void CameraStreamer::setCaptureInterval(std::chrono::milliseconds interval) {
+    captureInterval_ = std::max(interval, std::chrono::milliseconds::zero());
+    const auto floor = toMicros(captureInterval_);
+    const auto previousFloor = minCaptureIntervalMicros_.exchange(floor, std::memory_order_relaxed);
+    // Move the floor, not the adaptation: a raised floor lifts the interval
+    // to it, a lowered one keeps any backoff above the floor. Without
+    // AdaptiveInterval the interval sits on the floor and simply follows it.
+    auto current = captureIntervalMicros_.load(std::memory_order_relaxed);
+    std::int64_t updated = 0;
+    do {
+        updated = std::max(floor, current - std::max<std::int64_t>(0, previousFloor - floor));
+    } while (!captureIntervalMicros_.compare_exchange_weak(current, updated, std::memory_order_relaxed));
+    retimed_.store(true, std::memory_order_release);
+    pacing_.notifyAll();
+}
+
+void CameraStreamer::setFrameSource(std::shared_ptr<FrameSource> source) {
+    stop();
+    customSource_ = source != nullptr;
+    source_ = customSource_ ? std::move(source) : std::make_shared<EspCameraFrameSource>();
 }
 
 void CameraStreamer::returnFrame(camera_fb_t *frame) {
     if (frame == nullptr) {
         return;
     }
-#ifdef ESP_PLATFORM
-    esp_camera_fb_return(frame);
-#else
-    (void)frame;
-#endif
+    source_->release(frame);
 }
 
 } // namespace minitrain
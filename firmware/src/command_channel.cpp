@@ -3,6 +3,8 @@
 #include "minitrain/command_processor.hpp"
 #include "minitrain/telemetry.hpp"
 
+#include "byte_order.hpp"
+
 #include <algorithm>
 #include <chrono>
 #include <cstring>
@@ -11,55 +13,12 @@
 namespace minitrain {
 namespace {
 
-#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
-constexpr bool kIsLittleEndian = true;
-#else
-constexpr bool kIsLittleEndian = false;
-#endif
-
-std::uint16_t swap16(std::uint16_t value) {
-#if defined(__has_builtin)
-#  if __has_builtin(__builtin_bswap16)
-    return __builtin_bswap16(value);
-#  endif
-#endif
-    return static_cast<std::uint16_t>(((value & 0x00FFU) << 8U) | ((value & 0xFF00U) >> 8U));
-}
-
-std::uint32_t swap32(std::uint32_t value) {
-#if defined(__has_builtin)
-#  if __has_builtin(__builtin_bswap32)
-    return __builtin_bswap32(value);
-#  endif
-#endif
-    return ((value & 0x000000FFU) << 24U) | ((value & 0x0000FF00U) << 8U) | ((value & 0x00FF0000U) >> 8U) |
-           ((value & 0xFF000000U) >> 24U);
-}
-
-std::uint64_t swap64(std::uint64_t value) {
-#if defined(__has_builtin)
-#  if __has_builtin(__builtin_bswap64)
-    return __builtin_bswap64(value);
-#  endif
-#endif
-    std::uint64_t result = 0;
-    for (int i = 0; i < 8; ++i) {
-        result |= ((value >> (i * 8)) & 0xFFULL) << (56 - i * 8);
-    }
-    return result;
-}
-
-std::uint16_t hostToLittle16(std::uint16_t value) { return kIsLittleEndian ? value : swap16(value); }
-
-std::uint32_t hostToLittle32(std::uint32_t value) { return kIsLittleEndian ? value : swap32(value); }
-
-std::uint64_t hostToLittle64(std::uint64_t value) { return kIsLittleEndian ? value : swap64(value); }
-
-std::uint16_t littleToHost16(std::uint16_t value) { return hostToLittle16(value); }
-
-std::uint32_t littleToHost32(std::uint32_t value) { return hostToLittle32(value); }
-
-std::uint64_t littleToHost64(std::uint64_t value) { return hostToLittle64(value); }
+using detail::hostToLittle16;
+using detail::hostToLittle32;
+using detail::hostToLittle64;
+using detail::littleToHost16;
+using detail::littleToHost32;
+using detail::littleToHost64;
 
 std::uint8_t encodeDirection(Direction direction) {
     switch (direction) {
@@ -171,47 +130,51 @@ void CommandChannel::publishTelemetry(const TelemetrySample &sample, std::uint32
 std::vector<std::uint8_t> CommandChannel::encodeFrame(const CommandFrame &frame) {
     const std::size_t totalSize = kCommandFrameHeaderSize + frame.payload.size();
     std::vector<std::uint8_t> buffer(totalSize);
+    encodeHeader(frame.header, frame.payload.size(), buffer.data());
+    if (!frame.payload.empty()) {
+        std::memcpy(buffer.data() + kCommandFrameHeaderSize, frame.payload.data(), frame.payload.size());
+    }
+    return buffer;
+}
 
-    std::uint8_t *out = buffer.data();
-    std::memcpy(out, frame.header.sessionId.data(), frame.header.sessionId.size());
-    out += frame.header.sessionId.size();
+void CommandChannel::encodeHeader(const CommandFrameHeader &header, std::size_t payloadSize, std::uint8_t *out) {
+    std::memcpy(out, header.sessionId.data(), header.sessionId.size());
+    out += header.sessionId.size();
 
-    const std::uint32_t sequence = hostToLittle32(frame.header.sequence);
+    const std::uint32_t sequence = hostToLittle32(header.sequence);
     std::memcpy(out, &sequence, sizeof(sequence));
     out += sizeof(sequence);
 
-    const std::uint64_t timestamp = hostToLittle64(frame.header.timestampMicros);
+    const std::uint64_t timestamp = hostToLittle64(header.timestampMicros);
     std::memcpy(out, &timestamp, sizeof(timestamp));
     out += sizeof(timestamp);
 
     static_assert(sizeof(float) == sizeof(std::uint32_t), "Unexpected float size");
     std::uint32_t speedBits;
-    std::memcpy(&speedBits, &frame.header.targetSpeedMetersPerSecond, sizeof(float));
+    std::memcpy(&speedBits, &header.targetSpeedMetersPerSecond, sizeof(float));
     speedBits = hostToLittle32(speedBits);
     std::memcpy(out, &speedBits, sizeof(speedBits));
     out += sizeof(speedBits);
 
-    const std::uint8_t direction = encodeDirection(frame.header.direction);
+    const std::uint8_t direction = encodeDirection(header.direction);
     *out++ = direction;
 
-    *out++ = frame.header.lightsOverride;
+    *out++ = header.lightsOverride;
 
-    const std::uint16_t auxLength = hostToLittle16(static_cast<std::uint16_t>(frame.payload.size()));
+    const std::uint16_t auxLength = hostToLittle16(static_cast<std::uint16_t>(payloadSize));
     std::memcpy(out, &auxLength, sizeof(auxLength));
-    out += sizeof(auxLength);
-
-    if (!frame.payload.empty()) {
-        std::memcpy(out, frame.payload.data(), frame.payload.size());
-    }
-    return buffer;
 }
 
 CommandFrame CommandChannel::decodeFrame(const std::vector<std::uint8_t> &buffer) {
-    if (buffer.size() < kCommandFrameHeaderSize) {
+    return decodeFrame(buffer.data(), buffer.size());
+}
+
+CommandFrame CommandChannel::decodeFrame(const std::uint8_t *data, std::size_t size) {
+    if (size < kCommandFrameHeaderSize) {
         throw std::invalid_argument("Buffer too small for command frame");
     }
     CommandFrame frame{};
-    const std::uint8_t *in = buffer.data();
+    const std::uint8_t *in = data;
     std::memcpy(frame.header.sessionId.data(), in, frame.header.sessionId.size());
     in += frame.header.sessionId.size();
 
@@ -242,7 +205,7 @@ CommandFrame CommandChannel::decodeFrame(const std::vector<std::uint8_t> &buffer
     in += sizeof(auxLength);
 
     const std::size_t expectedSize = kCommandFrameHeaderSize + frame.header.auxPayloadLength;
-    if (buffer.size() < expectedSize) {
+    if (size < expectedSize) {
         throw std::invalid_argument("Incomplete payload");
     }
 
@@ -1,15 +1,25 @@
 #include "minitrain/command_processor.hpp"
 
+#include "minitrain/flight_recorder.hpp"
 #include "minitrain/train_controller.hpp"
 
 #include <cstring>
 #include <stdexcept>
 
 namespace minitrain {
-CommandProcessor::CommandProcessor(TrainController &controller, std::optional<LegacyParser> legacyParser)
-    : controller_(controller), legacyParser_(std::move(legacyParser)) {}
+CommandProcessor::CommandProcessor(TrainController &controller, std::optional<LegacyParser> legacyParser,
+                                   SystemClock systemClock)
+    : controller_(controller), legacyParser_(std::move(legacyParser)), systemClock_(std::move(systemClock)) {
+    if (!systemClock_) {
+        systemClock_ = [] { return std::chrono::system_clock::now(); };
+    }
+}
 
 CommandResult CommandProcessor::processFrame(const CommandFrame &frame, std::chrono::steady_clock::time_point arrival) {
+    const auto arrivalSystem = systemClock_();
+    if (recorder_ != nullptr) {
+        recorder_->recordCommandFrame(frame, arrival, arrivalSystem);
+    }
     const bool telemetryOnly = (frame.header.lightsOverride & 0x80U) != 0;
     const std::uint8_t lightsMask = static_cast<std::uint8_t>(frame.header.lightsOverride & 0x7FU);
     controller_.setLightsOverride(lightsMask, telemetryOnly);
@@ -18,8 +28,6 @@ CommandResult CommandProcessor::processFrame(const CommandFrame &frame, std::chr
         return {true, "Telemetry frame"};
     }
 
-    const auto arrivalSystem = std::chrono::system_clock::now();
-
     if (lastArrival_) {
         const auto delta = arrival - *lastArrival_;
         if (delta <= std::chrono::milliseconds(30)) {
@@ -62,6 +70,10 @@ CommandResult CommandProcessor::processFrame(const CommandFrame &frame, std::chr
     }
 
     controller_.registerCommandTimestamp(remoteTimestamp);
+    {
+        std::scoped_lock lock(lastAppliedMutex_);
+        lastApplied_ = AppliedCommand{frame.header.sessionId, frame.header.sequence};
+    }
 
     if (!emergency && frame.payload.size() > 1 && legacyParser_) {
         std::vector<std::uint8_t> legacyPayload(frame.payload.begin() + 1, frame.payload.end());
@@ -83,6 +95,11 @@ CommandResult CommandProcessor::processFrame(const CommandFrame &frame, std::chr
 
 bool CommandProcessor::lowFrequencyFallbackActive() const { return lowFrequencyFallback_; }
 
+std::optional<AppliedCommand> CommandProcessor::lastAppliedCommand() const {
+    std::scoped_lock lock(lastAppliedMutex_);
+    return lastApplied_;
+}
+
 CommandResult CommandProcessor::handleLegacyPayload(const std::vector<std::uint8_t> &payload) {
     if (!legacyParser_) {
         return {false, "Legacy parser disabled"};
@@ -0,0 +1,348 @@
+#include "minitrain/event_index.hpp"
+
+#include "byte_order.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint32_t kIndexMagic = 0x4945544DU; // "MTEI"
+constexpr std::uint16_t kIndexVersion = 1;
+constexpr std::size_t kFileHeaderSize = 16;
+constexpr std::size_t kSessionHeaderSize = 16 + 8 + 8 + 4 + 4 + 4;
+constexpr std::size_t kGranuleSize = 8 + 1 + 4;
+constexpr std::size_t kTransitionSize = 8 + 1;
+
+// Session ids sit at fixed offsets of the recorded payloads: after the
+// system arrival time in command frames, after the numeric fields in telemetry.
+constexpr std::size_t kCommandSessionOffset = sizeof(std::int64_t);
+constexpr std::size_t kTelemetrySessionOffset = 6 * sizeof(float) + 4 + 4 + 8;
+
+std::uint64_t toMillis(std::chrono::steady_clock::time_point timestamp) {
+    const auto millis =
+        std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+    return millis > 0 ? static_cast<std::uint64_t>(millis) : 0U;
+}
+
+bool readSessionId(const FlightRecord &record, std::size_t offset, TelemetryEventIndex::SessionId &id) {
+    if (record.size < offset + id.size()) {
+        return false;
+    }
+    TelemetryEventIndex::SessionId candidate{};
+    std::memcpy(candidate.data(), record.payload + offset, candidate.size());
+    if (std::all_of(candidate.begin(), candidate.end(), [](std::uint8_t byte) { return byte == 0U; })) {
+        return false;
+    }
+    id = candidate;
+    return true;
+}
+
+void require(std::size_t remaining, std::size_t needed) {
+    if (remaining < needed) {
+        throw std::invalid_argument("Event index truncated");
+    }
+}
+} // namespace
+
+std::uint8_t trainEventsOf(const StateTransitionRecord &transition) {
+    std::uint8_t events = 0U;
+    events |= transition.failSafeActive ? kEventFailSafe : 0U;
+    events |= transition.pilotReleaseActive ? kEventPilotRelease : 0U;
+    events |= transition.emergencyStop ? kEventEmergencyStop : 0U;
+    events |= transition.lightsSource == LightsSource::Override ? kEventLightsOverride : 0U;
+    return events;
+}
+
+TelemetryEventIndex::TelemetryEventIndex(std::chrono::milliseconds granule)
+    : granuleMillis_(granule.count() > 0 ? static_cast<std::uint64_t>(granule.count()) : 1U) {}
+
+TelemetryEventIndex::TelemetryEventIndex(TelemetryEventIndex &&other) noexcept {
+    std::scoped_lock lock(other.mutex_);
+    granuleMillis_ = other.granuleMillis_;
+    sessions_ = std::move(other.sessions_);
+    lastSession_ = other.lastSession_;
+    currentSession_ = other.currentSession_;
+    currentEvents_ = other.currentEvents_;
+}
+
+TelemetryEventIndex &TelemetryEventIndex::operator=(TelemetryEventIndex &&other) noexcept {
+    if (this != &other) {
+        std::scoped_lock lock(mutex_, other.mutex_);
+        granuleMillis_ = other.granuleMillis_;
+        sessions_ = std::move(other.sessions_);
+        lastSession_ = other.lastSession_;
+        currentSession_ = other.currentSession_;
+        currentEvents_ = other.currentEvents_;
+    }
+    return *this;
+}
+
+TelemetryEventIndex::Session &TelemetryEventIndex::sessionFor(const SessionId &sessionId,
+                                                              std::uint64_t timestampMillis) {
+    if (lastSession_ < sessions_.size() && sessions_[lastSession_].id == sessionId) {
+        return sessions_[lastSession_];
+    }
+    const auto it = std::find_if(sessions_.begin(), sessions_.end(),
+                                 [&](const Session &session) { return session.id == sessionId; });
+    if (it != sessions_.end()) {
+        lastSession_ = static_cast<std::size_t>(it - sessions_.begin());
+        return *it;
+    }
+    Session session{};
+    session.id = sessionId;
+    session.firstMillis = timestampMillis;
+    session.lastMillis = timestampMillis;
+    sessions_.push_back(std::move(session));
+    lastSession_ = sessions_.size() - 1U;
+    return sessions_.back();
+}
+
+void TelemetryEventIndex::markGranules(Session &session, std::uint64_t fromMillis, std::uint64_t toMillis,
+                                       std::uint8_t events) const {
+    std::uint64_t start = fromMillis - fromMillis % granuleMillis_;
+    if (!session.granules.empty() && session.granules.back().startMillis >= start) {
+        session.granules.back().activeEvents |= events;
+        start = session.granules.back().startMillis + granuleMillis_;
+    }
+    for (; start <= toMillis; start += granuleMillis_) {
+        Granule granule{};
+        granule.startMillis = start;
+        granule.activeEvents = events;
+        granule.firstTransition = static_cast<std::uint32_t>(session.transitions.size());
+        session.granules.push_back(granule);
+    }
+}
+
+void TelemetryEventIndex::observeLocked(const SessionId &sessionId, std::uint64_t timestampMillis,
+                                        std::uint8_t activeEvents) {
+    Session &session = sessionFor(sessionId, timestampMillis);
+    // Clamp late samples so per-session time never runs backwards.
+    timestampMillis = std::max(timestampMillis, session.lastMillis);
+    if (session.activeEvents != 0U) {
+        markGranules(session, session.lastMillis, timestampMillis, session.activeEvents);
+    }
+    activeEvents &= kEventAll;
+    if (activeEvents != session.activeEvents) {
+        if (activeEvents != 0U) {
+            markGranules(session, timestampMillis, timestampMillis, activeEvents);
+        }
+        session.transitions.push_back({timestampMillis, activeEvents});
+        session.activeEvents = activeEvents;
+        session.seenEvents |= activeEvents;
+    }
+    session.lastMillis = timestampMillis;
+}
+
+void TelemetryEventIndex::observe(const SessionId &sessionId, std::uint64_t timestampMillis,
+                                  std::uint8_t activeEvents) {
+    std::scoped_lock lock(mutex_);
+    observeLocked(sessionId, timestampMillis, activeEvents);
+}
+
+void TelemetryEventIndex::observe(const FlightRecord &record) {
+    std::scoped_lock lock(mutex_);
+    switch (record.type) {
+    case FlightRecordType::CommandFrame:
+        readSessionId(record, kCommandSessionOffset, currentSession_);
+        break;
+    case FlightRecordType::TelemetryInput:
+    case FlightRecordType::TelemetryOutput:
+        readSessionId(record, kTelemetrySessionOffset, currentSession_);
+        break;
+    case FlightRecordType::StateTransition:
+        if (const auto transition = FlightRecorder::decodeStateTransition(record)) {
+            currentEvents_ = trainEventsOf(*transition);
+        }
+        break;
+    case FlightRecordType::Padding:
+        return;
+    default:
+        break;
+    }
+    observeLocked(currentSession_, toMillis(record.timestamp), currentEvents_);
+}
+
+void TelemetryEventIndex::querySession(const Session &session, std::uint8_t events, std::uint64_t fromMillis,
+                                       std::uint64_t toMillis, std::vector<EventRange> &out) const {
+    const auto &transitions = session.transitions;
+    const auto &granules = session.granules;
+    // First granule that can still contain fromMillis.
+    auto granule = std::upper_bound(granules.begin(), granules.end(), fromMillis,
+                                    [](std::uint64_t millis, const Granule &g) { return millis < g.startMillis; });
+    if (granule != granules.begin()) {
+        --granule;
+    }
+
+    std::size_t next = 0;
+    while (true) {
+        while (granule != granules.end() && (granule->activeEvents & events) == 0U) {
+            ++granule;
+        }
+        if (granule == granules.end() || granule->startMillis > toMillis) {
+            return;
+        }
+        next = std::max<std::size_t>(next, granule->firstTransition > 0U ? granule->firstTransition - 1U : 0U);
+        while (next < transitions.size() && (transitions[next].activeEvents & events) == 0U) {
+            ++next;
+        }
+        if (next == transitions.size() || transitions[next].timestampMillis > toMillis) {
+            return;
+        }
+
+        EventRange range{};
+        range.sessionId = session.id;
+        range.startMillis = transitions[next].timestampMillis;
+        std::size_t end = next;
+        while (end < transitions.size() && (transitions[end].activeEvents & events) != 0U) {
+            range.events |= transitions[end].activeEvents & events;
+            ++end;
+        }
+        range.endMillis = end < transitions.size() ? transitions[end].timestampMillis : session.lastMillis;
+        if (range.endMillis >= fromMillis) {
+            range.startMillis = std::max(range.startMillis, fromMillis);
+            range.endMillis = std::min(range.endMillis, toMillis);
+            out.push_back(range);
+        }
+        next = end;
+        while (granule != granules.end() && granule->startMillis + granuleMillis_ <= range.endMillis) {
+            ++granule;
+        }
+    }
+}
+
+std::vector<EventRange> TelemetryEventIndex::query(std::uint8_t events, std::uint64_t fromMillis,
+                                                   std::uint64_t toMillis,
+                                                   const std::optional<SessionId> &sessionId) const {
+    std::vector<EventRange> ranges;
+    if (fromMillis > toMillis || (events & kEventAll) == 0U) {
+        return ranges;
+    }
+    std::scoped_lock lock(mutex_);
+    for (const auto &session : sessions_) {
+        if ((sessionId && session.id != *sessionId) || (session.seenEvents & events) == 0U ||
+            session.firstMillis > toMillis || session.lastMillis < fromMillis) {
+            continue;
+        }
+        querySession(session, events, fromMillis, toMillis, ranges);
+    }
+    return ranges;
+}
+
+std::size_t TelemetryEventIndex::sessionCount() const {
+    std::scoped_lock lock(mutex_);
+    return sessions_.size();
+}
+
+std::size_t TelemetryEventIndex::granuleCount() const {
+    std::scoped_lock lock(mutex_);
+    std::size_t count = 0;
+    for (const auto &session : sessions_) {
+        count += session.granules.size();
+    }
+    return count;
+}
+
+std::size_t TelemetryEventIndex::transitionCount() const {
+    std::scoped_lock lock(mutex_);
+    std::size_t count = 0;
+    for (const auto &session : sessions_) {
+        count += session.transitions.size();
+    }
+    return count;
+}
+
+std::vector<std::uint8_t> TelemetryEventIndex::encode() const {
+    std::scoped_lock lock(mutex_);
+    std::size_t size = kFileHeaderSize;
+    for (const auto &session : sessions_) {
+        size += kSessionHeaderSize + session.granules.size() * kGranuleSize +
+                session.transitions.size() * kTransitionSize;
+    }
+    std::vector<std::uint8_t> buffer(size);
+    std::uint8_t *out = buffer.data();
+    detail::putLittle32(out, kIndexMagic);
+    detail::putLittle16(out, kIndexVersion);
+    detail::putLittle16(out, 0U);
+    detail::putLittle32(out, static_cast<std::uint32_t>(granuleMillis_));
+    detail::putLittle32(out, static_cast<std::uint32_t>(sessions_.size()));
+    for (const auto &session : sessions_) {
+        std::memcpy(out, session.id.data(), session.id.size());
+        out += session.id.size();
+        detail::putLittle64(out, session.firstMillis);
+        detail::putLittle64(out, session.lastMillis);
+        *out++ = session.seenEvents;
+        *out++ = session.activeEvents;
+        detail::putLittle16(out, 0U);
+        detail::putLittle32(out, static_cast<std::uint32_t>(session.granules.size()));
+        detail::putLittle32(out, static_cast<std::uint32_t>(session.transitions.size()));
+        for (const auto &granule : session.granules) {
+            detail::putLittle64(out, granule.startMillis);
+            *out++ = granule.activeEvents;
+            detail::putLittle32(out, granule.firstTransition);
+        }
+        for (const auto &transition : session.transitions) {
+            detail::putLittle64(out, transition.timestampMillis);
+            *out++ = transition.activeEvents;
+        }
+    }
+    return buffer;
+}
+
+TelemetryEventIndex TelemetryEventIndex::decode(const std::vector<std::uint8_t> &buffer) {
+    require(buffer.size(), kFileHeaderSize);
+    const std::uint8_t *in = buffer.data();
+    const std::uint8_t *end = buffer.data() + buffer.size();
+    if (detail::getLittle32(in) != kIndexMagic || detail::getLittle16(in) != kIndexVersion) {
+        throw std::invalid_argument("Not an event index");
+    }
+    in += 2;
+    const std::uint32_t granuleMillis = detail::getLittle32(in);
+    if (granuleMillis == 0U) {
+        throw std::invalid_argument("Event index granule must be positive");
+    }
+    TelemetryEventIndex index{std::chrono::milliseconds{granuleMillis}};
+    const std::uint32_t sessionCount = detail::getLittle32(in);
+    for (std::uint32_t s = 0; s < sessionCount; ++s) {
+        require(static_cast<std::size_t>(end - in), kSessionHeaderSize);
+        Session session{};
+        std::memcpy(session.id.data(), in, session.id.size());
+        in += session.id.size();
+        session.firstMillis = detail::getLittle64(in);
+        session.lastMillis = detail::getLittle64(in);
+        session.seenEvents = *in++;
+        session.activeEvents = *in++;
+        in += 2;
+        const std::uint32_t granuleCount = detail::getLittle32(in);
+        const std::uint32_t transitionCount = detail::getLittle32(in);
+        require(static_cast<std::size_t>(end - in),
+                granuleCount * kGranuleSize + static_cast<std::size_t>(transitionCount) * kTransitionSize);
+        session.granules.resize(granuleCount);
+        for (auto &granule : session.granules) {
+            granule.startMillis = detail::getLittle64(in);
+            granule.activeEvents = *in++;
+            granule.firstTransition = detail::getLittle32(in);
+            if (granule.firstTransition > transitionCount) {
+                throw std::invalid_argument("Event index granule points past its transitions");
+            }
+        }
+        session.transitions.resize(transitionCount);
+        for (auto &transition : session.transitions) {
+            transition.timestampMillis = detail::getLittle64(in);
+            transition.activeEvents = *in++;
+        }
+        index.sessions_.push_back(std::move(session));
+    }
+    return index;
+}
+
+TelemetryEventIndex TelemetryEventIndex::build(const FlightRecorder &recorder, std::chrono::milliseconds granule) {
+    TelemetryEventIndex index{granule};
+    recorder.forEach([&index](const FlightRecord &record) { index.observe(record); });
+    return index;
+}
+
+} // namespace minitrain
@@ -0,0 +1,652 @@
+#include "minitrain/flight_recorder.hpp"
+
+#include "byte_order.hpp"
+#include "minitrain/event_index.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#ifndef ESP_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint32_t kSuperblockMagic = 0x5246544DU; // "MTFR"
+constexpr std::uint16_t kFormatVersion = 1;
+constexpr std::uint16_t kRecordMarker = 0xF17EU;
+constexpr std::size_t kSuperblockSlotSize = 128;
+constexpr std::size_t kIndexEntrySize = 24;
+constexpr std::size_t kIndexOffset = 2 * kSuperblockSlotSize;
+constexpr std::size_t kDataOffset = kIndexOffset + FlightRecorder::kIndexEntries * kIndexEntrySize;
+
+constexpr std::size_t kTelemetryRecordSize = 6 * sizeof(float) + 4 + 4 + 8 + 16 + 7;
+constexpr std::size_t kSpeedRecordSize = sizeof(float) + 8;
+constexpr std::size_t kTransitionRecordSize = 6 + 2 * sizeof(float);
+
+constexpr std::uint64_t align8(std::uint64_t value) { return (value + 7U) & ~std::uint64_t{7}; }
+
+std::uint32_t fnv1a(const std::uint8_t *data, std::size_t size) {
+    std::uint32_t hash = 2166136261U;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= data[i];
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+std::int64_t toMicros(std::chrono::steady_clock::time_point timestamp) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(timestamp.time_since_epoch()).count();
+}
+
+std::chrono::steady_clock::time_point fromMicros(std::int64_t micros) {
+    return std::chrono::steady_clock::time_point{
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::microseconds{micros})};
+}
+
+std::uint8_t encodeDirection(Direction direction) {
+    switch (direction) {
+    case Direction::Forward:
+        return 1U;
+    case Direction::Reverse:
+        return 2U;
+    case Direction::Neutral:
+        break;
+    }
+    return 0U;
+}
+
+Direction decodeDirection(std::uint8_t code) {
+    switch (code) {
+    case 1U:
+        return Direction::Forward;
+    case 2U:
+        return Direction::Reverse;
+    default:
+        return Direction::Neutral;
+    }
+}
+
+struct RecordHeader {
+    std::uint16_t marker{0};
+    FlightRecordType type{FlightRecordType::Padding};
+    std::uint32_t length{0};
+    std::uint64_t sequence{0};
+    std::int64_t timestampMicros{0};
+    std::uint32_t checksum{0};
+};
+
+void writeRecordHeader(std::uint8_t *out, const RecordHeader &header) {
+    detail::putLittle16(out, header.marker);
+    *out++ = static_cast<std::uint8_t>(header.type);
+    *out++ = 0U;
+    detail::putLittle32(out, header.length);
+    detail::putLittle64(out, header.sequence);
+    detail::putLittle64(out, static_cast<std::uint64_t>(header.timestampMicros));
+    detail::putLittle32(out, header.checksum);
+    detail::putLittle32(out, 0U);
+}
+
+RecordHeader readRecordHeader(const std::uint8_t *in) {
+    RecordHeader header{};
+    header.marker = detail::getLittle16(in);
+    header.type = static_cast<FlightRecordType>(*in++);
+    ++in;
+    header.length = detail::getLittle32(in);
+    header.sequence = detail::getLittle64(in);
+    header.timestampMicros = static_cast<std::int64_t>(detail::getLittle64(in));
+    header.checksum = detail::getLittle32(in);
+    return header;
+}
+} // namespace
+
+StateTransitionRecord StateTransitionRecord::fromState(const TrainState &state) {
+    StateTransitionRecord record{};
+    record.emergencyStop = state.emergencyStop;
+    record.failSafeActive = state.failSafeActive;
+    record.pilotReleaseActive = state.pilotReleaseActive;
+    record.horn = state.horn;
+    record.lightsTelemetryOnly = state.lightsTelemetryOnly;
+    record.direction = state.direction;
+    record.activeCab = state.activeCab;
+    record.lightsState = state.lightsState;
+    record.lightsSource = state.lightsSource;
+    record.lightsOverrideMask = state.lightsOverrideMask;
+    record.targetSpeed = state.targetSpeed;
+    record.appliedSpeed = state.appliedSpeed;
+    return record;
+}
+
+bool StateTransitionRecord::sameModeAs(const StateTransitionRecord &other) const {
+    return emergencyStop == other.emergencyStop && failSafeActive == other.failSafeActive &&
+           pilotReleaseActive == other.pilotReleaseActive && horn == other.horn &&
+           lightsTelemetryOnly == other.lightsTelemetryOnly && direction == other.direction &&
+           activeCab == other.activeCab && lightsState == other.lightsState && lightsSource == other.lightsSource &&
+           lightsOverrideMask == other.lightsOverrideMask;
+}
+
+FlightRecorder::FlightRecorder(std::uint8_t *region, std::size_t size, std::chrono::milliseconds indexInterval) {
+    attach(region, size, indexInterval, false);
+}
+
+FlightRecorder::~FlightRecorder() {
+#ifndef ESP_PLATFORM
+    if (fd_ >= 0) {
+        if (region_ != nullptr) {
+            ::munmap(region_, regionSize_);
+        }
+        ::close(fd_);
+    }
+#endif
+}
+
+#ifndef ESP_PLATFORM
+std::unique_ptr<FlightRecorder> FlightRecorder::open(const std::string &path, std::size_t sizeBytes,
+                                                     std::chrono::milliseconds indexInterval) {
+    if (sizeBytes < kMinimumRegionSize) {
+        return nullptr;
+    }
+    const int fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 ||
+        (static_cast<std::size_t>(info.st_size) != sizeBytes && ::ftruncate(fd, static_cast<off_t>(sizeBytes)) != 0)) {
+        ::close(fd);
+        return nullptr;
+    }
+    void *mapping = ::mmap(nullptr, sizeBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<FlightRecorder> recorder(new FlightRecorder());
+    recorder->fd_ = fd;
+    recorder->regionSize_ = sizeBytes;
+    recorder->attach(static_cast<std::uint8_t *>(mapping), sizeBytes, indexInterval, false);
+    return recorder;
+}
+
+std::unique_ptr<FlightRecorder> FlightRecorder::openReadOnly(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < kMinimumRegionSize) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<FlightRecorder> recorder(new FlightRecorder());
+    recorder->fd_ = fd;
+    recorder->regionSize_ = size;
+    recorder->attach(static_cast<std::uint8_t *>(mapping), size, std::chrono::milliseconds{1000}, true);
+    if (!recorder->valid()) {
+        return nullptr;
+    }
+    return recorder;
+}
+
+void FlightRecorder::flush() {
+    std::scoped_lock lock(mutex_);
+    if (region_ != nullptr && fd_ >= 0 && !readOnly_) {
+        ::msync(region_, regionSize_, MS_ASYNC);
+    }
+}
+#endif
+
+void FlightRecorder::attach(std::uint8_t *region, std::size_t size, std::chrono::milliseconds indexInterval,
+                            bool readOnly) {
+    if (region == nullptr || size < kMinimumRegionSize) {
+        return;
+    }
+    region_ = region;
+    regionSize_ = size;
+    index_ = region + kIndexOffset;
+    data_ = region + kDataOffset;
+    indexIntervalMicros_ = std::max<std::int64_t>(
+        1, std::chrono::duration_cast<std::chrono::microseconds>(indexInterval).count());
+    readOnly_ = readOnly;
+    if (!recover()) {
+        if (readOnly_) {
+            region_ = nullptr;
+            return;
+        }
+        format();
+    }
+}
+
+std::optional<FlightRecorder::Superblock> FlightRecorder::loadSuperblock(std::size_t slot) const {
+    Superblock block{};
+    std::memcpy(&block, region_ + slot * kSuperblockSlotSize, sizeof(block));
+    const auto expected = fnv1a(reinterpret_cast<const std::uint8_t *>(&block), offsetof(Superblock, checksum));
+    const std::uint64_t capacity = (regionSize_ - kDataOffset) & ~std::uint64_t{7};
+    if (block.magic != kSuperblockMagic || block.version != kFormatVersion || block.checksum != expected ||
+        block.dataCapacity != capacity || block.head >= capacity || block.tail >= capacity ||
+        block.used > capacity) {
+        return std::nullopt;
+    }
+    return block;
+}
+
+bool FlightRecorder::recover() {
+    const auto first = loadSuperblock(0);
+    const auto second = loadSuperblock(1);
+    if (!first && !second) {
+        return false;
+    }
+    if (first && second) {
+        state_ = first->generation > second->generation ? *first : *second;
+    } else {
+        state_ = first ? *first : *second;
+    }
+    return true;
+}
+
+void FlightRecorder::format() {
+    state_ = Superblock{};
+    state_.magic = kSuperblockMagic;
+    state_.version = kFormatVersion;
+    state_.dataCapacity = (regionSize_ - kDataOffset) & ~std::uint64_t{7};
+    std::memset(index_, 0, kIndexEntries * kIndexEntrySize);
+    publish();
+    publish();
+}
+
+void FlightRecorder::publish() {
+    ++state_.generation;
+    state_.checksum = fnv1a(reinterpret_cast<const std::uint8_t *>(&state_), offsetof(Superblock, checksum));
+    // Record bytes must land before the superblock that references them.
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(region_ + (state_.generation % 2) * kSuperblockSlotSize, &state_, sizeof(state_));
+}
+
+FlightRecorder::IndexEntry FlightRecorder::indexEntry(std::size_t slot) const {
+    const std::uint8_t *in = index_ + slot * kIndexEntrySize;
+    IndexEntry entry{};
+    entry.timestampMicros = static_cast<std::int64_t>(detail::getLittle64(in));
+    entry.offset = detail::getLittle64(in);
+    entry.sequence = detail::getLittle64(in);
+    return entry;
+}
+
+std::size_t FlightRecorder::recordSpanAt(std::uint64_t offset) const {
+    const std::uint64_t remaining = state_.dataCapacity - offset;
+    if (remaining < kRecordHeaderSize) {
+        return static_cast<std::size_t>(remaining);
+    }
+    const auto header = readRecordHeader(data_ + offset);
+    return static_cast<std::size_t>(std::min<std::uint64_t>(align8(kRecordHeaderSize + header.length), remaining));
+}
+
+void FlightRecorder::evictOldest() {
+    const std::uint64_t offset = state_.tail;
+    const bool padding = state_.dataCapacity - offset < kRecordHeaderSize ||
+                         readRecordHeader(data_ + offset).type == FlightRecordType::Padding;
+    const std::uint64_t span = recordSpanAt(offset);
+    if (!padding) {
+        ++state_.tailSequence;
+    }
+    state_.tail = offset + span >= state_.dataCapacity ? 0U : offset + span;
+    state_.used -= span;
+}
+
+void FlightRecorder::ensureFree(std::uint64_t bytes) {
+    bool evicted = false;
+    while (state_.dataCapacity - state_.used < bytes && state_.used > 0) {
+        evictOldest();
+        evicted = true;
+    }
+    if (evicted) {
+        // The new tail must be durable before the evicted bytes are overwritten.
+        publish();
+    }
+}
+
+bool FlightRecorder::append(FlightRecordType type, std::chrono::steady_clock::time_point timestamp,
+                            const std::uint8_t *prefix, std::size_t prefixSize, const std::uint8_t *body,
+                            std::size_t bodySize) {
+    std::scoped_lock lock(mutex_);
+    if (region_ == nullptr || readOnly_) {
+        return false;
+    }
+    const std::uint64_t length = prefixSize + bodySize;
+    const std::uint64_t span = align8(kRecordHeaderSize + length);
+    if (span > state_.dataCapacity / 2 || length > std::numeric_limits<std::uint32_t>::max()) {
+        ++dropped_;
+        return false;
+    }
+
+    if (state_.head + span > state_.dataCapacity) {
+        const std::uint64_t padding = state_.dataCapacity - state_.head;
+        ensureFree(padding);
+        if (padding >= kRecordHeaderSize) {
+            RecordHeader pad{};
+            pad.marker = kRecordMarker;
+            pad.type = FlightRecordType::Padding;
+            pad.length = static_cast<std::uint32_t>(padding - kRecordHeaderSize);
+            writeRecordHeader(data_ + state_.head, pad);
+        }
+        state_.head = 0;
+        state_.used += padding;
+    }
+    ensureFree(span);
+
+    std::uint8_t *out = data_ + state_.head;
+    if (prefixSize > 0) {
+        std::memcpy(out + kRecordHeaderSize, prefix, prefixSize);
+    }
+    if (bodySize > 0) {
+        std::memcpy(out + kRecordHeaderSize + prefixSize, body, bodySize);
+    }
+    RecordHeader header{};
+    header.marker = kRecordMarker;
+    header.type = type;
+    header.length = static_cast<std::uint32_t>(length);
+    header.sequence = state_.nextSequence;
+    header.timestampMicros = toMicros(timestamp);
+    header.checksum = fnv1a(out + kRecordHeaderSize, static_cast<std::size_t>(length));
+    writeRecordHeader(out, header);
+
+    if (state_.nextSequence == state_.tailSequence ||
+        header.timestampMicros - state_.lastIndexMicros >= indexIntervalMicros_) {
+        std::uint8_t *entry = index_ + (state_.indexNext % kIndexEntries) * kIndexEntrySize;
+        detail::putLittle64(entry, static_cast<std::uint64_t>(header.timestampMicros));
+        detail::putLittle64(entry, state_.head);
+        detail::putLittle64(entry, header.sequence);
+        ++state_.indexNext;
+        state_.lastIndexMicros = header.timestampMicros;
+    }
+
+    state_.head = state_.head + span >= state_.dataCapacity ? 0U : state_.head + span;
+    state_.used += span;
+    ++state_.nextSequence;
+    publish();
+
+    if (eventIndex_ != nullptr) {
+        FlightRecord record{};
+        record.type = type;
+        record.sequence = header.sequence;
+        record.timestamp = timestamp;
+        record.payload = out + kRecordHeaderSize;
+        record.size = static_cast<std::size_t>(length);
+        eventIndex_->observe(record);
+    }
+    return true;
+}
+
+void FlightRecorder::attachEventIndex(TelemetryEventIndex *index) {
+    std::scoped_lock lock(mutex_);
+    eventIndex_ = index;
+    if (index != nullptr && region_ != nullptr) {
+        walk(state_.tail, state_.tailSequence, [index](const FlightRecord &record) { index->observe(record); });
+    }
+}
+
+void FlightRecorder::walk(std::uint64_t offset, std::uint64_t sequence, const Visitor &visitor) const {
+    while (sequence < state_.nextSequence) {
+        const std::uint64_t remaining = state_.dataCapacity - offset;
+        if (remaining < kRecordHeaderSize) {
+            offset = 0;
+            continue;
+        }
+        const auto header = readRecordHeader(data_ + offset);
+        if (header.marker != kRecordMarker) {
+            return;
+        }
+        const std::uint64_t span = align8(kRecordHeaderSize + header.length);
+        if (header.type != FlightRecordType::Padding) {
+            if (header.sequence != sequence || kRecordHeaderSize + header.length > remaining) {
+                return;
+            }
+            FlightRecord record{};
+            record.type = header.type;
+            record.sequence = header.sequence;
+            record.timestamp = fromMicros(header.timestampMicros);
+            record.payload = data_ + offset + kRecordHeaderSize;
+            record.size = header.length;
+            if (fnv1a(record.payload, record.size) == header.checksum) {
+                visitor(record);
+            }
+            ++sequence;
+        }
+        offset = offset + span >= state_.dataCapacity ? 0U : offset + span;
+    }
+}
+
+void FlightRecorder::forEach(const Visitor &visitor) const {
+    std::scoped_lock lock(mutex_);
+    if (region_ == nullptr) {
+        return;
+    }
+    walk(state_.tail, state_.tailSequence, visitor);
+}
+
+void FlightRecorder::forEachSince(std::chrono::steady_clock::time_point since, const Visitor &visitor) const {
+    std::scoped_lock lock(mutex_);
+    if (region_ == nullptr) {
+        return;
+    }
+    const std::int64_t sinceMicros = toMicros(since);
+    std::uint64_t offset = state_.tail;
+    std::uint64_t sequence = state_.tailSequence;
+    std::int64_t bestTimestamp = std::numeric_limits<std::int64_t>::min();
+    for (std::size_t slot = 0; slot < std::min<std::size_t>(kIndexEntries, state_.indexNext); ++slot) {
+        const auto entry = indexEntry(slot);
+        if (entry.sequence < state_.tailSequence || entry.sequence >= state_.nextSequence ||
+            entry.timestampMicros > sinceMicros || entry.timestampMicros <= bestTimestamp ||
+            entry.offset + kRecordHeaderSize > state_.dataCapacity) {
+            continue;
+        }
+        const auto header = readRecordHeader(data_ + entry.offset);
+        if (header.marker != kRecordMarker || header.sequence != entry.sequence) {
+            continue;
+        }
+        bestTimestamp = entry.timestampMicros;
+        offset = entry.offset;
+        sequence = entry.sequence;
+    }
+    walk(offset, sequence, [&](const FlightRecord &record) {
+        if (toMicros(record.timestamp) >= sinceMicros) {
+            visitor(record);
+        }
+    });
+}
+
+std::size_t FlightRecorder::dataCapacity() const {
+    std::scoped_lock lock(mutex_);
+    return static_cast<std::size_t>(state_.dataCapacity);
+}
+
+std::uint64_t FlightRecorder::recordCount() const {
+    std::scoped_lock lock(mutex_);
+    return state_.nextSequence - state_.tailSequence;
+}
+
+std::uint64_t FlightRecorder::droppedRecords() const {
+    std::scoped_lock lock(mutex_);
+    return dropped_;
+}
+
+void FlightRecorder::recordCommandFrame(const CommandFrame &frame, std::chrono::steady_clock::time_point arrival,
+                                        std::chrono::system_clock::time_point arrivalSystem) {
+    std::array<std::uint8_t, sizeof(std::int64_t) + kCommandFrameHeaderSize> prefix{};
+    std::uint8_t *out = prefix.data();
+    detail::putLittle64(out, static_cast<std::uint64_t>(
+                                 std::chrono::duration_cast<std::chrono::microseconds>(arrivalSystem.time_since_epoch())
+                                     .count()));
+    CommandChannel::encodeHeader(frame.header, frame.payload.size(), out);
+    append(FlightRecordType::CommandFrame, arrival, prefix.data(), prefix.size(), frame.payload.data(),
+           frame.payload.size());
+}
+
+void FlightRecorder::recordSpeedMeasurement(float measuredSpeed, std::chrono::steady_clock::duration dt,
+                                            std::chrono::steady_clock::time_point timestamp) {
+    std::array<std::uint8_t, kSpeedRecordSize> payload{};
+    std::uint8_t *out = payload.data();
+    detail::putLittleFloat(out, measuredSpeed);
+    detail::putLittle64(out, static_cast<std::uint64_t>(
+                                 std::chrono::duration_cast<std::chrono::nanoseconds>(dt).count()));
+    append(FlightRecordType::SpeedMeasurement, timestamp, payload.data(), payload.size());
+}
+
+void FlightRecorder::recordTelemetry(FlightRecordType type, const TelemetrySample &sample,
+                                     std::chrono::steady_clock::time_point timestamp) {
+    std::array<std::uint8_t, kTelemetryRecordSize> payload{};
+    std::uint8_t *out = payload.data();
+    detail::putLittleFloat(out, sample.speedMetersPerSecond);
+    detail::putLittleFloat(out, sample.motorCurrentAmps);
+    detail::putLittleFloat(out, sample.batteryVoltage);
+    detail::putLittleFloat(out, sample.temperatureCelsius);
+    detail::putLittleFloat(out, sample.appliedSpeedMetersPerSecond);
+    detail::putLittleFloat(out, sample.failSafeProgress);
+    detail::putLittle32(out, sample.failSafeElapsedMillis);
+    detail::putLittle32(out, sample.sequence);
+    detail::putLittle64(out, sample.commandTimestamp);
+    std::memcpy(out, sample.sessionId.data(), sample.sessionId.size());
+    out += sample.sessionId.size();
+    *out++ = static_cast<std::uint8_t>((sample.failSafeActive ? 0x01U : 0x00U) |
+                                       (sample.lightsTelemetryOnly ? 0x02U : 0x00U));
+    *out++ = static_cast<std::uint8_t>(sample.activeCab);
+    *out++ = static_cast<std::uint8_t>(sample.lightsState);
+    *out++ = static_cast<std::uint8_t>(sample.lightsSource);
+    *out++ = sample.lightsOverrideMask;
+    *out++ = static_cast<std::uint8_t>(sample.source);
+    *out++ = encodeDirection(sample.appliedDirection);
+    append(type, timestamp, payload.data(), payload.size());
+}
+
+void FlightRecorder::recordMotorCommand(float command, std::chrono::steady_clock::time_point timestamp) {
+    std::array<std::uint8_t, sizeof(float)> payload{};
+    std::uint8_t *out = payload.data();
+    detail::putLittleFloat(out, command);
+    append(FlightRecordType::MotorCommand, timestamp, payload.data(), payload.size());
+}
+
+void FlightRecorder::recordStateTransition(const StateTransitionRecord &transition,
+                                           std::chrono::steady_clock::time_point timestamp) {
+    std::array<std::uint8_t, kTransitionRecordSize> payload{};
+    std::uint8_t *out = payload.data();
+    std::uint8_t flags = 0U;
+    flags |= transition.emergencyStop ? 0x01U : 0x00U;
+    flags |= transition.failSafeActive ? 0x02U : 0x00U;
+    flags |= transition.pilotReleaseActive ? 0x04U : 0x00U;
+    flags |= transition.horn ? 0x08U : 0x00U;
+    flags |= transition.lightsTelemetryOnly ? 0x10U : 0x00U;
+    *out++ = flags;
+    *out++ = encodeDirection(transition.direction);
+    *out++ = static_cast<std::uint8_t>(transition.activeCab);
+    *out++ = static_cast<std::uint8_t>(transition.lightsState);
+    *out++ = static_cast<std::uint8_t>(transition.lightsSource);
+    *out++ = transition.lightsOverrideMask;
+    detail::putLittleFloat(out, transition.targetSpeed);
+    detail::putLittleFloat(out, transition.appliedSpeed);
+    append(FlightRecordType::StateTransition, timestamp, payload.data(), payload.size());
+}
+
+std::optional<CommandFrameRecord> FlightRecorder::decodeCommandFrame(const FlightRecord &record) {
+    if (record.type != FlightRecordType::CommandFrame || record.size < sizeof(std::int64_t)) {
+        return std::nullopt;
+    }
+    const std::uint8_t *in = record.payload;
+    CommandFrameRecord result{};
+    result.arrivalSystem = std::chrono::system_clock::time_point{std::chrono::duration_cast<
+        std::chrono::system_clock::duration>(std::chrono::microseconds{static_cast<std::int64_t>(detail::getLittle64(in))})};
+    try {
+        result.frame = CommandChannel::decodeFrame(std::vector<std::uint8_t>(in, record.payload + record.size));
+    } catch (const std::invalid_argument &) {
+        return std::nullopt;
+    }
+    return result;
+}
+
+std::optional<SpeedMeasurementRecord> FlightRecorder::decodeSpeedMeasurement(const FlightRecord &record) {
+    if (record.type != FlightRecordType::SpeedMeasurement || record.size < kSpeedRecordSize) {
+        return std::nullopt;
+    }
+    const std::uint8_t *in = record.payload;
+    SpeedMeasurementRecord result{};
+    result.measuredSpeed = detail::getLittleFloat(in);
+    result.dt = std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+        std::chrono::nanoseconds{static_cast<std::int64_t>(detail::getLittle64(in))});
+    return result;
+}
+
+std::optional<TelemetrySample> FlightRecorder::decodeTelemetry(const FlightRecord &record) {
+    if ((record.type != FlightRecordType::TelemetryInput && record.type != FlightRecordType::TelemetryOutput) ||
+        record.size < kTelemetryRecordSize) {
+        return std::nullopt;
+    }
+    const std::uint8_t *in = record.payload;
+    TelemetrySample sample{};
+    sample.speedMetersPerSecond = detail::getLittleFloat(in);
+    sample.motorCurrentAmps = detail::getLittleFloat(in);
+    sample.batteryVoltage = detail::getLittleFloat(in);
+    sample.temperatureCelsius = detail::getLittleFloat(in);
+    sample.appliedSpeedMetersPerSecond = detail::getLittleFloat(in);
+    sample.failSafeProgress = detail::getLittleFloat(in);
+    sample.failSafeElapsedMillis = detail::getLittle32(in);
+    sample.sequence = detail::getLittle32(in);
+    sample.commandTimestamp = detail::getLittle64(in);
+    std::memcpy(sample.sessionId.data(), in, sample.sessionId.size());
+    in += sample.sessionId.size();
+    const std::uint8_t flags = *in++;
+    sample.failSafeActive = (flags & 0x01U) != 0;
+    sample.lightsTelemetryOnly = (flags & 0x02U) != 0;
+    sample.activeCab = static_cast<ActiveCab>(*in++);
+    sample.lightsState = static_cast<LightsState>(*in++);
+    sample.lightsSource = static_cast<LightsSource>(*in++);
+    sample.lightsOverrideMask = *in++;
+    sample.source = static_cast<TelemetrySource>(*in++);
+    sample.appliedDirection = decodeDirection(*in++);
+    return sample;
+}
+
+std::optional<float> FlightRecorder::decodeMotorCommand(const FlightRecord &record) {
+    if (record.type != FlightRecordType::MotorCommand || record.size < sizeof(float)) {
+        return std::nullopt;
+    }
+    const std::uint8_t *in = record.payload;
+    return detail::getLittleFloat(in);
+}
+
+std::optional<StateTransitionRecord> FlightRecorder::decodeStateTransition(const FlightRecord &record) {
+    if (record.type != FlightRecordType::StateTransition || record.size < kTransitionRecordSize) {
+        return std::nullopt;
+    }
+    const std::uint8_t *in = record.payload;
+    StateTransitionRecord transition{};
+    const std::uint8_t flags = *in++;
+    transition.emergencyStop = (flags & 0x01U) != 0;
+    transition.failSafeActive = (flags & 0x02U) != 0;
+    transition.pilotReleaseActive = (flags & 0x04U) != 0;
+    transition.horn = (flags & 0x08U) != 0;
+    transition.lightsTelemetryOnly = (flags & 0x10U) != 0;
+    transition.direction = decodeDirection(*in++);
+    transition.activeCab = static_cast<ActiveCab>(*in++);
+    transition.lightsState = static_cast<LightsState>(*in++);
+    transition.lightsSource = static_cast<LightsSource>(*in++);
+    transition.lightsOverrideMask = *in++;
+    transition.targetSpeed = detail::getLittleFloat(in);
+    transition.appliedSpeed = detail::getLittleFloat(in);
+    return transition;
+}
+
+} // namespace minitrain
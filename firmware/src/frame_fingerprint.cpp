@@ -0,0 +1,485 @@
+#include "minitrain/frame_fingerprint.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+
+namespace minitrain {
+
+namespace {
+constexpr std::size_t kSampleWindows = kFingerprintSamples;
+constexpr std::size_t kSampleWindowBytes = 8;
+constexpr std::size_t kLumaSamplesPerCell = 4;
+constexpr std::uint64_t kFnvOffset = 14695981039346656037ULL;
+constexpr std::uint64_t kFnvPrime = 1099511628211ULL;
+
+std::uint64_t hashBytes(std::uint64_t hash, const std::uint8_t *data, std::size_t size) {
+    for (std::size_t i = 0; i < size; ++i) {
+        hash = (hash ^ data[i]) * kFnvPrime;
+    }
+    return hash;
+}
+
+// Hashes the sampled windows; data too short to window is hashed whole.
+std::uint64_t sampleHash(const std::uint8_t *data, std::size_t size) {
+    if (size <= kSampleWindows * kSampleWindowBytes) {
+        return hashBytes(kFnvOffset, data, size);
+    }
+    std::uint64_t hash = kFnvOffset;
+    const std::size_t stride = (size - kSampleWindowBytes) / (kSampleWindows - 1);
+    for (std::size_t window = 0; window < kSampleWindows; ++window) {
+        hash = hashBytes(hash, data + window * stride, kSampleWindowBytes);
+    }
+    return hash;
+}
+
+// Baseline JPEG allows two tables of each kind and four components.
+constexpr std::size_t kJpegTables = 2;
+constexpr std::size_t kJpegComponents = 4;
+constexpr unsigned kLookaheadBits = 8;
+
+struct HuffmanTable {
+    bool present{false};
+    // Codes of up to kLookaheadBits bits: (length << 8) | value, 0 if longer.
+    std::array<std::uint16_t, 1U << kLookaheadBits> fast{};
+    std::array<std::int32_t, 18> maxCode{};
+    std::array<std::int32_t, 17> valueOffset{};
+    std::array<std::uint8_t, 256> values{};
+};
+
+struct JpegComponent {
+    std::uint8_t id{0};
+    std::uint8_t h{1};
+    std::uint8_t v{1};
+    std::uint8_t quantTable{0};
+    std::uint8_t dcTable{0};
+    std::uint8_t acTable{0};
+};
+
+// What the DC walk needs from the marker segments. Kept per capture thread
+// (a few KB) rather than on its stack.
+struct JpegHeaders {
+    std::size_t entropyOffset{0};
+    bool baseline{false};
+    // Cleared by a quantisation or Huffman table that does not parse; the
+    // scan is then hashed but not walked.
+    bool tablesValid{true};
+    std::uint16_t width{0};
+    std::uint16_t height{0};
+    std::uint16_t restartInterval{0};
+    std::array<std::uint16_t, 4> dcQuant{};
+    std::array<JpegComponent, kJpegComponents> components{};
+    std::size_t componentCount{0};
+    // Components of the scan, as indices into components.
+    std::array<std::size_t, kJpegComponents> scan{};
+    std::size_t scanCount{0};
+    std::array<HuffmanTable, kJpegTables> dc{};
+    std::array<HuffmanTable, kJpegTables> ac{};
+};
+
+bool buildHuffmanTable(const std::uint8_t *counts, const std::uint8_t *values, std::size_t valueCount,
+                       HuffmanTable &table) {
+    table.fast.fill(0);
+    std::int32_t code = 0;
+    std::size_t index = 0;
+    for (unsigned length = 1; length <= 16; ++length) {
+        table.valueOffset[length] = static_cast<std::int32_t>(index) - code;
+        for (unsigned i = 0; i < counts[length - 1]; ++i, ++index, ++code) {
+            if (index >= valueCount || code >= (1 << length)) {
+                return false;
+            }
+            if (length <= kLookaheadBits) {
+                const unsigned shift = kLookaheadBits - length;
+                const auto first = static_cast<std::size_t>(code) << shift;
+                for (std::size_t fill = 0; fill < (std::size_t{1} << shift); ++fill) {
+                    table.fast[first + fill] = static_cast<std::uint16_t>((length << 8U) | values[index]);
+                }
+            }
+        }
+        table.maxCode[length] = counts[length - 1] != 0 ? code - 1 : -1;
+        code <<= 1;
+    }
+    table.maxCode[17] = 0x7FFFFFFF;
+    std::copy(values, values + index, table.values.begin());
+    table.present = true;
+    return true;
+}
+
+// Walks the marker segments up to SOS. Returns false if the stream does not
+// parse that far; headers.baseline tells whether the scan can be walked.
+bool parseJpegHeaders(const std::uint8_t *data, std::size_t size, JpegHeaders &headers) {
+    // Reset in place: the struct is too large to build on a capture stack.
+    headers.entropyOffset = 0;
+    headers.baseline = false;
+    headers.tablesValid = true;
+    headers.restartInterval = 0;
+    headers.componentCount = 0;
+    headers.scanCount = 0;
+    for (std::size_t i = 0; i < kJpegTables; ++i) {
+        headers.dc[i].present = false;
+        headers.ac[i].present = false;
+    }
+    if (size < 4 || data[0] != 0xFFU || data[1] != 0xD8U) {
+        return false;
+    }
+    std::size_t offset = 2;
+    while (offset + 4 <= size) {
+        if (data[offset] != 0xFFU) {
+            return false;
+        }
+        const std::uint8_t marker = data[offset + 1];
+        if (marker == 0xFFU) {
+            ++offset;
+            continue;
+        }
+        if (marker == 0x01U || (marker >= 0xD0U && marker <= 0xD7U)) {
+            offset += 2;
+            continue;
+        }
+        const std::size_t length = (static_cast<std::size_t>(data[offset + 2]) << 8U) | data[offset + 3];
+        if (length < 2 || offset + 2 + length > size) {
+            return false;
+        }
+        const std::uint8_t *segment = data + offset + 4;
+        const std::size_t segmentSize = length - 2;
+        if (marker == 0xC0U || marker == 0xC1U) {
+            // Baseline or extended sequential Huffman; only 8-bit samples
+            // are walked.
+            headers.componentCount = segmentSize >= 6 && segment[0] == 8U ? segment[5] : 0;
+            headers.baseline = headers.componentCount != 0 && headers.componentCount <= kJpegComponents &&
+                               segmentSize >= 6 + 3 * headers.componentCount;
+            if (headers.baseline) {
+                headers.height = static_cast<std::uint16_t>((segment[1] << 8U) | segment[2]);
+                headers.width = static_cast<std::uint16_t>((segment[3] << 8U) | segment[4]);
+            }
+            for (std::size_t i = 0; i < headers.componentCount && headers.baseline; ++i) {
+                auto &component = headers.components[i];
+                component.id = segment[6 + 3 * i];
+                component.h = static_cast<std::uint8_t>(segment[7 + 3 * i] >> 4U);
+                component.v = static_cast<std::uint8_t>(segment[7 + 3 * i] & 0x0FU);
+                component.quantTable = static_cast<std::uint8_t>(segment[8 + 3 * i] & 0x03U);
+                headers.baseline = component.h >= 1 && component.v >= 1 && component.h <= 4 && component.v <= 4;
+            }
+        } else if (marker >= 0xC2U && marker <= 0xCFU && marker != 0xC4U && marker != 0xC8U && marker != 0xCCU) {
+            // Progressive, lossless or arithmetic-coded: not walked.
+            headers.baseline = false;
+            headers.componentCount = 0;
+        } else if (marker == 0xDBU) {
+            std::size_t at = 0;
+            while (at < segmentSize) {
+                const bool wide = (segment[at] >> 4U) != 0;
+                const std::size_t id = segment[at] & 0x03U;
+                const std::size_t tableBytes = wide ? 128 : 64;
+                if (at + 1 + tableBytes > segmentSize) {
+                    headers.tablesValid = false;
+                    break;
+                }
+                headers.dcQuant[id] = wide ? static_cast<std::uint16_t>((segment[at + 1] << 8U) | segment[at + 2])
+                                           : segment[at + 1];
+                at += 1 + tableBytes;
+            }
+        } else if (marker == 0xC4U) {
+            std::size_t at = 0;
+            while (at + 17 <= segmentSize) {
+                const std::size_t tableClass = segment[at] >> 4U;
+                const std::size_t id = segment[at] & 0x0FU;
+                std::size_t valueCount = 0;
+                for (std::size_t i = 0; i < 16; ++i) {
+                    valueCount += segment[at + 1 + i];
+                }
+                if (tableClass > 1 || id >= kJpegTables || valueCount > 256 || at + 17 + valueCount > segmentSize ||
+                    !buildHuffmanTable(segment + at + 1, segment + at + 17, valueCount,
+                                       tableClass == 0 ? headers.dc[id] : headers.ac[id])) {
+                    headers.tablesValid = false;
+                    break;
+                }
+                at += 17 + valueCount;
+            }
+        } else if (marker == 0xDDU && segmentSize >= 2) {
+            headers.restartInterval = static_cast<std::uint16_t>((segment[0] << 8U) | segment[1]);
+        } else if (marker == 0xDAU) {
+            headers.entropyOffset = offset + 2 + length;
+            if (segmentSize < 1 || segmentSize < 1 + 2U * segment[0] + 3) {
+                headers.baseline = false;
+                return headers.entropyOffset < size;
+            }
+            headers.scanCount = std::min<std::size_t>(segment[0], kJpegComponents);
+            for (std::size_t i = 0; i < headers.scanCount && headers.baseline; ++i) {
+                const std::uint8_t id = segment[1 + 2 * i];
+                const std::uint8_t tables = segment[2 + 2 * i];
+                std::size_t match = 0;
+                while (match < headers.componentCount && headers.components[match].id != id) {
+                    ++match;
+                }
+                if (match == headers.componentCount || (tables >> 4U) >= kJpegTables ||
+                    (tables & 0x0FU) >= kJpegTables) {
+                    headers.baseline = false;
+                    break;
+                }
+                headers.components[match].dcTable = static_cast<std::uint8_t>(tables >> 4U);
+                headers.components[match].acTable = static_cast<std::uint8_t>(tables & 0x0FU);
+                headers.scan[i] = match;
+            }
+            return headers.entropyOffset < size;
+        }
+        offset += 2 + length;
+    }
+    return false;
+}
+
+// MSB-first reader over entropy-coded data: drops stuffed zero bytes and
+// stops at the next marker, feeding zero bits past it.
+class EntropyReader {
+  public:
+    EntropyReader(const std::uint8_t *data, std::size_t size) : data_(data), size_(size) {}
+
+    std::uint32_t peek(unsigned count) {
+        fill();
+        return bits_ >> (32U - count);
+    }
+
+    void skip(unsigned count) {
+        bits_ <<= count;
+        count_ -= static_cast<int>(count);
+    }
+
+    std::int32_t receive(unsigned count) {
+        if (count == 0) {
+            return 0;
+        }
+        const auto raw = static_cast<std::int32_t>(peek(count));
+        skip(count);
+        // Values below 2^(count-1) stand for negative differences.
+        return raw < (1 << (count - 1U)) ? raw - (1 << count) + 1 : raw;
+    }
+
+    // Drops the padding bits and consumes an RSTn marker; false if the next
+    // bytes are not one.
+    bool restart() {
+        bits_ = 0;
+        count_ = 0;
+        atMarker_ = false;
+        if (position_ + 1 < size_ && data_[position_] == 0xFFU && data_[position_ + 1] >= 0xD0U &&
+            data_[position_ + 1] <= 0xD7U) {
+            position_ += 2;
+            return true;
+        }
+        return false;
+    }
+
+  private:
+    void fill() {
+        while (count_ <= 24) {
+            std::uint32_t byte = 0;
+            if (!atMarker_ && position_ < size_) {
+                byte = data_[position_];
+                if (byte == 0xFFU) {
+                    if (position_ + 1 < size_ && data_[position_ + 1] == 0x00U) {
+                        position_ += 2;
+                    } else {
+                        atMarker_ = true;
+                        byte = 0;
+                    }
+                } else {
+                    ++position_;
+                }
+            }
+            bits_ |= byte << (24 - count_);
+            count_ += 8;
+        }
+    }
+
+    const std::uint8_t *data_;
+    std::size_t size_;
+    std::size_t position_{0};
+    std::uint32_t bits_{0};
+    int count_{0};
+    bool atMarker_{false};
+};
+
+// Returns the symbol, or -1 for a code the table does not define.
+int decodeSymbol(EntropyReader &reader, const HuffmanTable &table) {
+    const std::uint16_t fast = table.fast[reader.peek(kLookaheadBits)];
+    if (fast != 0) {
+        reader.skip(fast >> 8U);
+        return fast & 0xFFU;
+    }
+    unsigned length = kLookaheadBits + 1;
+    auto code = static_cast<std::int32_t>(reader.peek(length));
+    while (length <= 16 && code > table.maxCode[length]) {
+        ++length;
+        code = static_cast<std::int32_t>(reader.peek(length));
+    }
+    if (length > 16) {
+        return -1;
+    }
+    reader.skip(length);
+    return table.values[static_cast<std::size_t>(table.valueOffset[length] + code)];
+}
+
+// Decodes every block of a baseline scan but keeps only the luma DC
+// coefficients: each is the mean of its 8x8 block, so together they are a
+// 1/8 scale picture. They are averaged into the kFingerprintGrid cells.
+// Noise that reshuffles the entropy-coded bytes barely moves them.
+bool jpegDcLuma(const std::uint8_t *data, std::size_t size, const JpegHeaders &headers,
+                std::array<std::uint8_t, kFingerprintSamples> &luma) {
+    const std::size_t lumaBlocksX = (headers.width + 7U) / 8U;
+    const std::size_t lumaBlocksY = (headers.height + 7U) / 8U;
+    if (!headers.baseline || !headers.tablesValid || headers.scanCount != headers.componentCount ||
+        lumaBlocksX < kFingerprintGrid || lumaBlocksY < kFingerprintGrid) {
+        return false;
+    }
+    std::uint8_t maxH = 1;
+    std::uint8_t maxV = 1;
+    for (std::size_t i = 0; i < headers.componentCount; ++i) {
+        const auto &component = headers.components[i];
+        if (!headers.dc[component.dcTable].present || !headers.ac[component.acTable].present) {
+            return false;
+        }
+        maxH = std::max(maxH, component.h);
+        maxV = std::max(maxV, component.v);
+    }
+    // A single-component scan is not interleaved: one block per MCU.
+    const bool interleaved = headers.componentCount > 1;
+    const std::size_t unitsX = interleaved ? (headers.width + 8U * maxH - 1U) / (8U * maxH) : lumaBlocksX;
+    const std::size_t unitsY = interleaved ? (headers.height + 8U * maxV - 1U) / (8U * maxV) : lumaBlocksY;
+    const auto &luminance = headers.components[0];
+    const std::int32_t quant = headers.dcQuant[luminance.quantTable];
+
+    std::array<std::int64_t, kFingerprintSamples> sums{};
+    std::array<std::uint16_t, kFingerprintSamples> counts{};
+    std::array<std::int32_t, kJpegComponents> predictors{};
+    EntropyReader reader(data, size);
+    std::size_t unitsSinceRestart = 0;
+    for (std::size_t unitY = 0; unitY < unitsY; ++unitY) {
+        for (std::size_t unitX = 0; unitX < unitsX; ++unitX) {
+            if (headers.restartInterval != 0 && unitsSinceRestart == headers.restartInterval) {
+                if (!reader.restart()) {
+                    return false;
+                }
+                predictors.fill(0);
+                unitsSinceRestart = 0;
+            }
+            ++unitsSinceRestart;
+            for (std::size_t position = 0; position < headers.scanCount; ++position) {
+                const std::size_t index = headers.scan[position];
+                const auto &component = headers.components[index];
+                const auto &dcTable = headers.dc[component.dcTable];
+                const auto &acTable = headers.ac[component.acTable];
+                const std::size_t blocksH = interleaved ? component.h : 1U;
+                const std::size_t blocksV = interleaved ? component.v : 1U;
+                for (std::size_t blockY = 0; blockY < blocksV; ++blockY) {
+                    for (std::size_t blockX = 0; blockX < blocksH; ++blockX) {
+                        const int category = decodeSymbol(reader, dcTable);
+                        if (category < 0 || category > 11) {
+                            return false;
+                        }
+                        predictors[index] += reader.receive(static_cast<unsigned>(category));
+                        for (unsigned k = 1; k < 64;) {
+                            const int symbol = decodeSymbol(reader, acTable);
+                            if (symbol < 0) {
+                                return false;
+                            }
+                            const unsigned run = static_cast<unsigned>(symbol) >> 4U;
+                            const unsigned bits = static_cast<unsigned>(symbol) & 0x0FU;
+                            if (bits == 0) {
+                                if (run != 15) {
+                                    break;
+                                }
+                                k += 16;
+                                continue;
+                            }
+                            (void)reader.receive(bits);
+                            k += run + 1;
+                        }
+                        if (index != 0) {
+                            continue;
+                        }
+                        const std::size_t x = unitX * blocksH + blockX;
+                        const std::size_t y = unitY * blocksV + blockY;
+                        if (x < lumaBlocksX && y < lumaBlocksY) {
+                            const std::size_t row = y * kFingerprintGrid / lumaBlocksY;
+                            const std::size_t cell = row * kFingerprintGrid + x * kFingerprintGrid / lumaBlocksX;
+                            sums[cell] += predictors[0];
+                            ++counts[cell];
+                        }
+                    }
+                }
+            }
+        }
+    }
+    for (std::size_t cell = 0; cell < kFingerprintSamples; ++cell) {
+        // DC is 8x the block mean, level-shifted by 128.
+        const std::int64_t mean = counts[cell] != 0 ? sums[cell] * quant / (8 * counts[cell]) + 128 : 0;
+        luma[cell] = static_cast<std::uint8_t>(std::clamp<std::int64_t>(mean, 0, 255));
+    }
+    return true;
+}
+} // namespace
+
+FrameFingerprint fingerprintFrame(const camera_fb_t &frame) {
+    FrameFingerprint fingerprint{};
+    if (frame.buf == nullptr || frame.len == 0) {
+        return fingerprint;
+    }
+    const std::uint8_t *data = frame.buf;
+    std::size_t size = frame.len;
+
+    if (frame.format == PIXFORMAT_JPEG) {
+        thread_local JpegHeaders headers;
+        const bool parsed = parseJpegHeaders(data, size, headers);
+        const std::size_t entropy = parsed ? headers.entropyOffset : 0;
+        data += entropy;
+        size -= entropy;
+        // Without EOI the trailing bytes would be the same marker everywhere.
+        if (size > 2 && data[size - 2] == 0xFFU && data[size - 1] == 0xD9U) {
+            size -= 2;
+        }
+        fingerprint.hasLuma = parsed && jpegDcLuma(data, size, headers, fingerprint.samples);
+    } else if (frame.format == PIXFORMAT_YUV422 && frame.width >= kFingerprintGrid * kLumaSamplesPerCell &&
+               frame.height >= kFingerprintGrid * kLumaSamplesPerCell && frame.len >= frame.width * frame.height * 2U) {
+        // YUYV: luma sits on the even bytes.
+        constexpr std::size_t kSamplesPerAxis = kFingerprintGrid * kLumaSamplesPerCell;
+        for (std::size_t cellY = 0; cellY < kFingerprintGrid; ++cellY) {
+            for (std::size_t cellX = 0; cellX < kFingerprintGrid; ++cellX) {
+                unsigned sum = 0;
+                for (std::size_t sy = 0; sy < kLumaSamplesPerCell; ++sy) {
+                    const std::size_t y = ((cellY * kLumaSamplesPerCell + sy) * frame.height) / kSamplesPerAxis;
+                    for (std::size_t sx = 0; sx < kLumaSamplesPerCell; ++sx) {
+                        const std::size_t x = ((cellX * kLumaSamplesPerCell + sx) * frame.width) / kSamplesPerAxis;
+                        sum += frame.buf[(y * frame.width + x) * 2U];
+                    }
+                }
+                fingerprint.samples[cellY * kFingerprintGrid + cellX] =
+                    static_cast<std::uint8_t>(sum / (kLumaSamplesPerCell * kLumaSamplesPerCell));
+            }
+        }
+        fingerprint.hasLuma = true;
+    }
+
+    fingerprint.payloadBytes = static_cast<std::uint32_t>(size);
+    fingerprint.hash = sampleHash(data, size);
+    if (fingerprint.hasLuma) {
+        fingerprint.hash = hashBytes(fingerprint.hash, fingerprint.samples.data(), fingerprint.samples.size());
+    }
+    return fingerprint;
+}
+
+bool nearlyIdentical(const FrameFingerprint &previous, const FrameFingerprint &current,
+                     const FrameSimilarity &similarity) {
+    if (!previous.valid() || !current.valid()) {
+        return false;
+    }
+    if (previous.hash == current.hash && previous.payloadBytes == current.payloadBytes) {
+        return true;
+    }
+    if (previous.hasLuma && current.hasLuma) {
+        unsigned difference = 0;
+        for (std::size_t i = 0; i < previous.samples.size(); ++i) {
+            difference += static_cast<unsigned>(std::abs(previous.samples[i] - current.samples[i]));
+        }
+        return difference <= similarity.lumaTolerance * previous.samples.size();
+    }
+    return false;
+}
+
+} // namespace minitrain
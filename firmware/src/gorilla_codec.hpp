@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "minitrain/bit_stream.hpp"
+#include "minitrain/telemetry_compression.hpp"
+
+// Gorilla channel codecs shared by the compressed telemetry blocks and the
+// columnar export: delta-of-delta integers and XOR-encoded floats.
+
+namespace minitrain::detail {
+
+inline std::uint32_t floatBits(float value) {
+    std::uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    return bits;
+}
+
+inline float bitsToFloat(std::uint32_t bits) {
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+inline std::int64_t signExtend(std::uint64_t value, unsigned bits) {
+    const std::uint64_t sign = std::uint64_t{1} << (bits - 1U);
+    return static_cast<std::int64_t>((value ^ sign) - sign);
+}
+
+inline bool fits(std::int64_t value, unsigned bits) {
+    const std::int64_t limit = std::int64_t{1} << (bits - 1U);
+    return value >= -limit && value < limit;
+}
+
+// Control prefixes: 0 | 10+7 | 110+9 | 1110+12 | 11110+32 | 11111+64 bits.
+inline void writeDeltaOfDelta(BitWriter &writer, TelemetryPredictor::IntegerChannel &channel, std::uint64_t value) {
+    const std::uint64_t delta = value - channel.previous;
+    const auto dod = static_cast<std::int64_t>(delta - channel.delta);
+    if (dod == 0) {
+        writer.write(0b0U, 1);
+    } else if (fits(dod, 7)) {
+        writer.write(0b10U, 2);
+        writer.write(static_cast<std::uint64_t>(dod), 7);
+    } else if (fits(dod, 9)) {
+        writer.write(0b110U, 3);
+        writer.write(static_cast<std::uint64_t>(dod), 9);
+    } else if (fits(dod, 12)) {
+        writer.write(0b1110U, 4);
+        writer.write(static_cast<std::uint64_t>(dod), 12);
+    } else if (fits(dod, 32)) {
+        writer.write(0b11110U, 5);
+        writer.write(static_cast<std::uint64_t>(dod), 32);
+    } else {
+        writer.write(0b11111U, 5);
+        writer.write(static_cast<std::uint64_t>(dod), 64);
+    }
+    channel.delta = delta;
+    channel.previous = value;
+}
+
+inline std::uint64_t readDeltaOfDelta(BitReader &reader, TelemetryPredictor::IntegerChannel &channel) {
+    std::int64_t dod = 0;
+    if (reader.readBit()) {
+        unsigned bits = 7;
+        if (reader.readBit()) {
+            bits = 9;
+            if (reader.readBit()) {
+                bits = 12;
+                if (reader.readBit()) {
+                    bits = reader.readBit() ? 64U : 32U;
+                }
+            }
+        }
+        dod = signExtend(reader.read(bits), bits);
+    }
+    channel.delta += static_cast<std::uint64_t>(dod);
+    channel.previous += channel.delta;
+    return channel.previous;
+}
+
+inline unsigned leadingZeros(std::uint32_t value) { return static_cast<unsigned>(__builtin_clz(value)); }
+
+inline unsigned trailingZeros(std::uint32_t value) { return static_cast<unsigned>(__builtin_ctz(value)); }
+
+inline void writeFloat(BitWriter &writer, TelemetryPredictor::FloatChannel &channel, float value) {
+    const std::uint32_t bits = floatBits(value);
+    const std::uint32_t xored = bits ^ channel.previous;
+    channel.previous = bits;
+    if (xored == 0U) {
+        writer.write(0b0U, 1);
+        return;
+    }
+    // xored is non-zero, so the leading count fits the 5-bit field.
+    const unsigned leading = leadingZeros(xored);
+    const unsigned trailing = trailingZeros(xored);
+    if (channel.leading != 0xFFU && leading >= channel.leading && trailing >= channel.trailing) {
+        const unsigned meaningful = 32U - channel.leading - channel.trailing;
+        writer.write(0b10U, 2);
+        writer.write(xored >> channel.trailing, meaningful);
+        return;
+    }
+    const unsigned meaningful = 32U - leading - trailing;
+    writer.write(0b11U, 2);
+    writer.write(leading, 5);
+    writer.write(meaningful - 1U, 5);
+    writer.write(xored >> trailing, meaningful);
+    channel.leading = static_cast<std::uint8_t>(leading);
+    channel.trailing = static_cast<std::uint8_t>(trailing);
+}
+
+inline float readFloat(BitReader &reader, TelemetryPredictor::FloatChannel &channel) {
+    if (reader.readBit()) {
+        if (reader.readBit()) {
+            channel.leading = static_cast<std::uint8_t>(reader.read(5));
+            const auto meaningful = static_cast<unsigned>(reader.read(5)) + 1U;
+            if (channel.leading + meaningful > 32U) {
+                throw std::invalid_argument("Corrupted float window in telemetry block");
+            }
+            channel.trailing = static_cast<std::uint8_t>(32U - channel.leading - meaningful);
+        } else if (channel.leading == 0xFFU) {
+            throw std::invalid_argument("Float window reused before being defined");
+        }
+        const unsigned meaningful = 32U - channel.leading - channel.trailing;
+        channel.previous ^= static_cast<std::uint32_t>(reader.read(meaningful) << channel.trailing);
+    }
+    return bitsToFloat(channel.previous);
+}
+
+} // namespace minitrain::detail
@@ -0,0 +1,131 @@
+#include "minitrain/jpeg_validator.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint8_t kMarkerPrefix = 0xFFU;
+constexpr std::uint8_t kSoi = 0xD8U;
+constexpr std::uint8_t kEoi = 0xD9U;
+constexpr std::uint8_t kSos = 0xDAU;
+constexpr std::uint8_t kTem = 0x01U;
+
+bool isRestart(std::uint8_t marker) { return marker >= 0xD0U && marker <= 0xD7U; }
+
+// SOF0..SOF15 without DHT (C4), JPG (C8) and DAC (CC), which share the range.
+bool isFrameHeader(std::uint8_t marker) {
+    return marker >= 0xC0U && marker <= 0xCFU && marker != 0xC4U && marker != 0xC8U && marker != 0xCCU;
+}
+
+// Skips entropy-coded data from offset and returns the offset of the marker
+// that ends it, or size if the data runs out first.
+std::size_t skipScan(const std::uint8_t *data, std::size_t size, std::size_t offset) {
+    while (offset < size) {
+        const auto *found = static_cast<const std::uint8_t *>(std::memchr(data + offset, kMarkerPrefix, size - offset));
+        if (found == nullptr) {
+            return size;
+        }
+        offset = static_cast<std::size_t>(found - data);
+        if (offset + 1 >= size) {
+            return size;
+        }
+        const std::uint8_t next = data[offset + 1];
+        if (next == 0x00U || isRestart(next)) {
+            offset += 2;
+        } else if (next == kMarkerPrefix) {
+            offset += 1;
+        } else {
+            return offset;
+        }
+    }
+    return size;
+}
+} // namespace
+
+const char *toString(JpegDefect defect) {
+    switch (defect) {
+    case JpegDefect::None:
+        return "none";
+    case JpegDefect::Truncated:
+        return "truncated";
+    case JpegDefect::MissingSoi:
+        return "missing SOI";
+    case JpegDefect::BadMarker:
+        return "bad marker";
+    case JpegDefect::BadSegmentLength:
+        return "bad segment length";
+    case JpegDefect::MissingFrameHeader:
+        return "missing frame header";
+    case JpegDefect::MissingScan:
+        return "missing scan";
+    case JpegDefect::MissingEoi:
+        return "missing EOI";
+    case JpegDefect::TrailingData:
+        return "trailing data";
+    }
+    return "unknown";
+}
+
+JpegDefect validateJpeg(const std::uint8_t *data, std::size_t size) {
+    if (data == nullptr || size < 4) {
+        return JpegDefect::Truncated;
+    }
+    if (data[0] != kMarkerPrefix || data[1] != kSoi) {
+        return JpegDefect::MissingSoi;
+    }
+    bool frameHeader = false;
+    bool scan = false;
+    std::size_t offset = 2;
+    while (true) {
+        if (offset >= size) {
+            return scan ? JpegDefect::MissingEoi : JpegDefect::Truncated;
+        }
+        if (data[offset] != kMarkerPrefix) {
+            return JpegDefect::BadMarker;
+        }
+        // Any number of fill bytes may precede a marker.
+        while (offset < size && data[offset] == kMarkerPrefix) {
+            ++offset;
+        }
+        if (offset >= size) {
+            return JpegDefect::Truncated;
+        }
+        const std::uint8_t marker = data[offset++];
+        if (marker == kEoi) {
+            if (!scan) {
+                return JpegDefect::MissingScan;
+            }
+            const bool padding = std::all_of(data + offset, data + size, [](std::uint8_t byte) { return byte == 0U; });
+            return padding ? JpegDefect::None : JpegDefect::TrailingData;
+        }
+        if (marker == kSoi || marker == 0x00U) {
+            return JpegDefect::BadMarker;
+        }
+        if (marker == kTem || isRestart(marker)) {
+            continue;
+        }
+        if (offset + 2 > size) {
+            return JpegDefect::Truncated;
+        }
+        const std::size_t length = (static_cast<std::size_t>(data[offset]) << 8U) | data[offset + 1];
+        if (length < 2 || (isFrameHeader(marker) && length < 8) || (marker == kSos && length < 6)) {
+            return JpegDefect::BadSegmentLength;
+        }
+        if (length > size - offset) {
+            return JpegDefect::Truncated;
+        }
+        offset += length;
+        frameHeader = frameHeader || isFrameHeader(marker);
+        if (marker == kSos) {
+            if (!frameHeader) {
+                return JpegDefect::MissingFrameHeader;
+            }
+            scan = true;
+            offset = skipScan(data, size, offset);
+        }
+    }
+}
+
+} // namespace minitrain
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace minitrain::detail {
+
+// Runs fn(index) for every index in [0, count) on up to `threads` workers
+// (0 = one per hardware thread), the calling thread included. Workers claim
+// the next index until the range is exhausted. The first exception stops
+// the workers and is rethrown on the calling thread.
+template <typename Fn>
+void parallelFor(std::size_t count, unsigned threads, Fn &&fn) {
+    if (threads == 0) {
+        threads = std::max(1U, std::thread::hardware_concurrency());
+    }
+    threads = static_cast<unsigned>(std::min<std::size_t>(threads, std::max<std::size_t>(1, count)));
+    std::atomic<std::size_t> next{0};
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    auto worker = [&] {
+        for (std::size_t index = next.fetch_add(1); index < count; index = next.fetch_add(1)) {
+            try {
+                fn(index);
+            } catch (...) {
+                std::scoped_lock lock(errorMutex);
+                if (!error) {
+                    error = std::current_exception();
+                }
+                next.store(count);
+            }
+        }
+    };
+    std::vector<std::thread> pool;
+    pool.reserve(threads - 1);
+    for (unsigned i = 1; i < threads; ++i) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (auto &thread : pool) {
+        thread.join();
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+} // namespace minitrain::detail
@@ -0,0 +1,913 @@
+#include "minitrain/posix_websocket_client.hpp"
+
+#ifndef ESP_PLATFORM
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint8_t kContinuation = 0x0U;
+constexpr std::uint8_t kText = 0x1U;
+constexpr std::uint8_t kBinary = 0x2U;
+constexpr std::uint8_t kClose = 0x8U;
+constexpr std::uint8_t kPing = 0x9U;
+constexpr std::uint8_t kPong = 0xAU;
+constexpr std::size_t kMaxControlPayload = 125;
+constexpr std::size_t kReadChunk = 16 * 1024;
+// Reads per wake-up, so a chatty server cannot starve queued sends.
+constexpr std::size_t kReadsPerWake = 8;
+constexpr std::size_t kMaxResponseHeader = 8 * 1024;
+constexpr std::uint16_t kNormalClosure = 1000;
+constexpr std::uint16_t kProtocolError = 1002;
+constexpr std::uint16_t kMessageTooBig = 1009;
+constexpr const char *kAcceptGuid = "258EAFA5-E914-47DA-95CA-C5AB0DC85B11";
+
+class PlainTransport final : public WebSocketTransport {
+  public:
+    explicit PlainTransport(int fd) : fd_(fd) {}
+
+    TransportStatus handshake() override { return TransportStatus::Ok; }
+
+    TransportStatus read(std::uint8_t *data, std::size_t size, std::size_t &transferred) override {
+        transferred = 0;
+        while (true) {
+            const ssize_t result = ::recv(fd_, data, size, 0);
+            if (result > 0) {
+                transferred = static_cast<std::size_t>(result);
+                return TransportStatus::Ok;
+            }
+            if (result == 0) {
+                return TransportStatus::Closed;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? TransportStatus::WantRead : TransportStatus::Failed;
+        }
+    }
+
+    TransportStatus write(const std::uint8_t *data, std::size_t size, std::size_t &transferred) override {
+        transferred = 0;
+        while (true) {
+            const ssize_t result = ::send(fd_, data, size, MSG_NOSIGNAL);
+            if (result >= 0) {
+                transferred = static_cast<std::size_t>(result);
+                return TransportStatus::Ok;
+            }
+            if (errno == EINTR) {
+                continue;
+            }
+            return errno == EAGAIN || errno == EWOULDBLOCK ? TransportStatus::WantWrite : TransportStatus::Failed;
+        }
+    }
+
+  private:
+    int fd_;
+};
+
+std::uint32_t rotateLeft(std::uint32_t value, unsigned bits) { return (value << bits) | (value >> (32U - bits)); }
+
+// Only for the handshake's Sec-WebSocket-Accept check.
+std::array<std::uint8_t, 20> sha1(const std::string &message) {
+    std::uint32_t h[5] = {0x67452301U, 0xEFCDAB89U, 0x98BADCFEU, 0x10325476U, 0xC3D2E1F0U};
+    std::vector<std::uint8_t> data(message.begin(), message.end());
+    const std::uint64_t bits = static_cast<std::uint64_t>(data.size()) * 8U;
+    data.push_back(0x80U);
+    while (data.size() % 64U != 56U) {
+        data.push_back(0x00U);
+    }
+    for (int shift = 56; shift >= 0; shift -= 8) {
+        data.push_back(static_cast<std::uint8_t>(bits >> static_cast<unsigned>(shift)));
+    }
+    for (std::size_t chunk = 0; chunk < data.size(); chunk += 64) {
+        std::uint32_t w[80];
+        for (std::size_t i = 0; i < 16; ++i) {
+            const std::uint8_t *p = &data[chunk + i * 4];
+            w[i] = (static_cast<std::uint32_t>(p[0]) << 24U) | (static_cast<std::uint32_t>(p[1]) << 16U) |
+                   (static_cast<std::uint32_t>(p[2]) << 8U) | p[3];
+        }
+        for (std::size_t i = 16; i < 80; ++i) {
+            w[i] = rotateLeft(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+        }
+        std::uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+        for (std::size_t i = 0; i < 80; ++i) {
+            std::uint32_t f = 0;
+            std::uint32_t k = 0;
+            if (i < 20) {
+                f = (b & c) | (~b & d);
+                k = 0x5A827999U;
+            } else if (i < 40) {
+                f = b ^ c ^ d;
+                k = 0x6ED9EBA1U;
+            } else if (i < 60) {
+                f = (b & c) | (b & d) | (c & d);
+                k = 0x8F1BBCDCU;
+            } else {
+                f = b ^ c ^ d;
+                k = 0xCA62C1D6U;
+            }
+            const std::uint32_t temp = rotateLeft(a, 5) + f + e + k + w[i];
+            e = d;
+            d = c;
+            c = rotateLeft(b, 30);
+            b = a;
+            a = temp;
+        }
+        h[0] += a;
+        h[1] += b;
+        h[2] += c;
+        h[3] += d;
+        h[4] += e;
+    }
+    std::array<std::uint8_t, 20> digest{};
+    for (std::size_t i = 0; i < 20; ++i) {
+        digest[i] = static_cast<std::uint8_t>(h[i / 4] >> (24U - (i % 4U) * 8U));
+    }
+    return digest;
+}
+
+std::string base64(const std::uint8_t *data, std::size_t size) {
+    static constexpr char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    std::string out;
+    out.reserve((size + 2) / 3 * 4);
+    for (std::size_t i = 0; i < size; i += 3) {
+        const std::uint32_t triple = (static_cast<std::uint32_t>(data[i]) << 16U) |
+                                     (i + 1 < size ? static_cast<std::uint32_t>(data[i + 1]) << 8U : 0U) |
+                                     (i + 2 < size ? data[i + 2] : 0U);
+        out.push_back(kAlphabet[(triple >> 18U) & 0x3FU]);
+        out.push_back(kAlphabet[(triple >> 12U) & 0x3FU]);
+        out.push_back(i + 1 < size ? kAlphabet[(triple >> 6U) & 0x3FU] : '=');
+        out.push_back(i + 2 < size ? kAlphabet[triple & 0x3FU] : '=');
+    }
+    return out;
+}
+
+std::string toLower(std::string text) {
+    std::transform(text.begin(), text.end(), text.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return text;
+}
+
+std::string trim(const std::string &text) {
+    const auto first = text.find_first_not_of(" \t");
+    if (first == std::string::npos) {
+        return {};
+    }
+    return text.substr(first, text.find_last_not_of(" \t") - first + 1);
+}
+
+// Waits until fd is ready for what status asks for; false on timeout, error
+// or a status that is not a retry.
+bool waitReady(int fd, TransportStatus status, std::chrono::steady_clock::time_point deadline) {
+    if (status != TransportStatus::WantRead && status != TransportStatus::WantWrite) {
+        return false;
+    }
+    pollfd entry{fd, static_cast<short>(status == TransportStatus::WantRead ? POLLIN : POLLOUT), 0};
+    while (true) {
+        const auto remaining =
+            std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        const int result = ::poll(&entry, 1, static_cast<int>(remaining.count()));
+        if (result > 0) {
+            return true;
+        }
+        if (result < 0 && errno != EINTR) {
+            return false;
+        }
+    }
+}
+
+// XORs the payload with the repeating 4-byte key, eight bytes at a time.
+void applyMask(std::uint8_t *data, std::size_t size, const std::uint8_t (&key)[4]) {
+    std::uint8_t pattern[8];
+    std::memcpy(pattern, key, 4);
+    std::memcpy(pattern + 4, key, 4);
+    std::uint64_t wide = 0;
+    std::memcpy(&wide, pattern, sizeof(wide));
+    std::size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data + i, sizeof(word));
+        word ^= wide;
+        std::memcpy(data + i, &word, sizeof(word));
+    }
+    for (; i < size; ++i) {
+        data[i] ^= key[i % 4U];
+    }
+}
+} // namespace
+
+std::unique_ptr<WebSocketTransport> makePlainTransport(int fd) { return std::make_unique<PlainTransport>(fd); }
+
+std::optional<WebSocketUri> parseWebSocketUri(const std::string &uri) {
+    WebSocketUri result{};
+    std::size_t offset = 0;
+    const std::string scheme = toLower(uri.substr(0, uri.find("://")));
+    if (scheme == "ws") {
+        result.port = 80;
+    } else if (scheme == "wss") {
+        result.secure = true;
+        result.port = 443;
+    } else {
+        return std::nullopt;
+    }
+    offset = scheme.size() + 3;
+    const auto authorityEnd = std::min(uri.find_first_of("/?", offset), uri.size());
+    const std::string authority = uri.substr(offset, authorityEnd - offset);
+    std::string port;
+    if (!authority.empty() && authority.front() == '[') {
+        const auto close = authority.find(']');
+        if (close == std::string::npos) {
+            return std::nullopt;
+        }
+        result.host = authority.substr(1, close - 1);
+        if (close + 1 < authority.size()) {
+            if (authority[close + 1] != ':') {
+                return std::nullopt;
+            }
+            port = authority.substr(close + 2);
+        }
+    } else {
+        const auto colon = authority.find(':');
+        result.host = authority.substr(0, colon);
+        if (colon != std::string::npos) {
+            port = authority.substr(colon + 1);
+        }
+    }
+    if (result.host.empty()) {
+        return std::nullopt;
+    }
+    if (!port.empty()) {
+        if (port.size() > 5 || !std::all_of(port.begin(), port.end(), [](char c) { return c >= '0' && c <= '9'; })) {
+            return std::nullopt;
+        }
+        const unsigned long value = std::stoul(port);
+        if (value == 0 || value > 65535UL) {
+            return std::nullopt;
+        }
+        result.port = static_cast<std::uint16_t>(value);
+    }
+    result.resource = uri.substr(authorityEnd);
+    if (result.resource.empty() || result.resource.front() != '/') {
+        result.resource.insert(result.resource.begin(), '/');
+    }
+    return result;
+}
+
+std::string webSocketAcceptKey(const std::string &clientKey) {
+    const auto digest = sha1(clientKey + kAcceptGuid);
+    return base64(digest.data(), digest.size());
+}
+
+PosixWebSocketClient::PosixWebSocketClient(PosixWebSocketConfig config)
+    : config_(std::move(config)), maskRng_(std::random_device{}()) {}
+
+PosixWebSocketClient::~PosixWebSocketClient() { close(); }
+
+bool PosixWebSocketClient::open(const std::string &uri) {
+    if (isConnected()) {
+        return true;
+    }
+    teardown();
+    const auto parsed = parseWebSocketUri(uri);
+    if (!parsed) {
+        setError("Invalid WebSocket URI " + uri);
+        return false;
+    }
+    if (parsed->secure && !config_.secureTransport) {
+        setError("wss:// needs a secure transport");
+        return false;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + config_.connectTimeout;
+    if (!connectSocket(*parsed, deadline)) {
+        teardown();
+        return false;
+    }
+    transport_ = parsed->secure ? config_.secureTransport(socket_, parsed->host) : makePlainTransport(socket_);
+    if (!transport_) {
+        setError("No transport for " + parsed->host);
+        teardown();
+        return false;
+    }
+    TransportStatus status = transport_->handshake();
+    while (status != TransportStatus::Ok) {
+        if (!waitReady(socket_, status, deadline)) {
+            setError("Secure handshake with " + parsed->host + " failed");
+            teardown();
+            return false;
+        }
+        status = transport_->handshake();
+    }
+    if (!upgrade(*parsed, deadline)) {
+        teardown();
+        return false;
+    }
+
+    epoll_ = ::epoll_create1(EPOLL_CLOEXEC);
+    wakeFd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    epoll_event socketEvent{};
+    socketEvent.events = EPOLLIN;
+    socketEvent.data.fd = socket_;
+    epoll_event wakeEvent{};
+    wakeEvent.events = EPOLLIN;
+    wakeEvent.data.fd = wakeFd_;
+    if (epoll_ < 0 || wakeFd_ < 0 || ::epoll_ctl(epoll_, EPOLL_CTL_ADD, socket_, &socketEvent) != 0 ||
+        ::epoll_ctl(epoll_, EPOLL_CTL_ADD, wakeFd_, &wakeEvent) != 0) {
+        setError("Failed to set up the event loop");
+        teardown();
+        return false;
+    }
+
+    {
+        std::scoped_lock lock(sendMutex_);
+        pending_.clear();
+        queued_ = 0;
+        written_ = 0;
+    }
+    writing_.clear();
+    writeOffset_ = 0;
+    fragments_.clear();
+    fragmentOpcode_ = 0;
+    lastReceive_ = std::chrono::steady_clock::now();
+    pingOutstanding_ = false;
+    closeSent_ = false;
+    closeReceived_ = false;
+    closeRequested_.store(false, std::memory_order_release);
+    connected_.store(true, std::memory_order_release);
+    if (onConnected_) {
+        onConnected_();
+    }
+    loop_ = std::thread(&PosixWebSocketClient::eventLoop, this);
+    return true;
+}
+
+bool PosixWebSocketClient::connectSocket(const WebSocketUri &uri, std::chrono::steady_clock::time_point deadline) {
+    addrinfo hints{};
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo *addresses = nullptr;
+    const std::string port = std::to_string(uri.port);
+    if (::getaddrinfo(uri.host.c_str(), port.c_str(), &hints, &addresses) != 0 || addresses == nullptr) {
+        setError("Unable to resolve " + uri.host);
+        return false;
+    }
+    for (const addrinfo *address = addresses; address != nullptr; address = address->ai_next) {
+        const int fd = ::socket(address->ai_family, address->ai_socktype | SOCK_NONBLOCK | SOCK_CLOEXEC,
+                                address->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+        bool connected = ::connect(fd, address->ai_addr, address->ai_addrlen) == 0;
+        if (!connected && errno == EINPROGRESS && waitReady(fd, TransportStatus::WantWrite, deadline)) {
+            int error = 0;
+            socklen_t length = sizeof(error);
+            connected = ::getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) == 0 && error == 0;
+        }
+        if (connected) {
+            // Telemetry and command replies are small; do not hold them back.
+            const int noDelay = 1;
+            (void)::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+            socket_ = fd;
+            break;
+        }
+        ::close(fd);
+    }
+    ::freeaddrinfo(addresses);
+    if (socket_ < 0) {
+        setError("Unable to connect to " + uri.host + ":" + port);
+        return false;
+    }
+    return true;
+}
+
+bool PosixWebSocketClient::upgrade(const WebSocketUri &uri, std::chrono::steady_clock::time_point deadline) {
+    std::uint8_t nonce[16];
+    std::random_device random;
+    for (auto &byte : nonce) {
+        byte = static_cast<std::uint8_t>(random());
+    }
+    const std::string key = base64(nonce, sizeof(nonce));
+    std::string host = uri.host.find(':') != std::string::npos ? "[" + uri.host + "]" : uri.host;
+    if (uri.port != (uri.secure ? 443U : 80U)) {
+        host += ":" + std::to_string(uri.port);
+    }
+    const std::string request = "GET " + uri.resource + " HTTP/1.1\r\nHost: " + host +
+                                "\r\nUpgrade: websocket\r\nConnection: Upgrade\r\nSec-WebSocket-Key: " + key +
+                                "\r\nSec-WebSocket-Version: 13\r\n\r\n";
+
+    std::size_t sent = 0;
+    while (sent < request.size()) {
+        std::size_t transferred = 0;
+        const auto status = transport_->write(reinterpret_cast<const std::uint8_t *>(request.data()) + sent,
+                                              request.size() - sent, transferred);
+        sent += transferred;
+        if (status != TransportStatus::Ok && !waitReady(socket_, status, deadline)) {
+            setError("Failed to send the WebSocket upgrade request");
+            return false;
+        }
+    }
+
+    std::string response;
+    std::size_t headerEnd = std::string::npos;
+    while (headerEnd == std::string::npos) {
+        std::uint8_t buffer[1024];
+        std::size_t transferred = 0;
+        const auto status = transport_->read(buffer, sizeof(buffer), transferred);
+        response.append(reinterpret_cast<const char *>(buffer), transferred);
+        headerEnd = response.find("\r\n\r\n");
+        if (headerEnd == std::string::npos &&
+            (response.size() > kMaxResponseHeader ||
+             (status != TransportStatus::Ok && !waitReady(socket_, status, deadline)))) {
+            setError("No WebSocket upgrade response from " + uri.host);
+            return false;
+        }
+    }
+    // Frames the server sent right after the response.
+    received_.assign(response.begin() + static_cast<std::ptrdiff_t>(headerEnd + 4), response.end());
+    receiveOffset_ = 0;
+
+    const auto statusEnd = response.find("\r\n");
+    const std::string statusLine = response.substr(0, statusEnd);
+    if (statusLine.compare(0, 5, "HTTP/") != 0 || statusLine.find(" 101") == std::string::npos) {
+        setError("WebSocket upgrade rejected: " + statusLine);
+        return false;
+    }
+    bool upgraded = false;
+    bool connectionUpgrade = false;
+    bool accepted = false;
+    std::size_t lineStart = statusEnd + 2;
+    while (lineStart < headerEnd) {
+        const auto lineEnd = response.find("\r\n", lineStart);
+        const std::string line = response.substr(lineStart, lineEnd - lineStart);
+        lineStart = lineEnd + 2;
+        const auto colon = line.find(':');
+        if (colon == std::string::npos) {
+            continue;
+        }
+        const std::string name = toLower(trim(line.substr(0, colon)));
+        const std::string value = trim(line.substr(colon + 1));
+        if (name == "upgrade") {
+            upgraded = toLower(value) == "websocket";
+        } else if (name == "connection") {
+            connectionUpgrade = toLower(value).find("upgrade") != std::string::npos;
+        } else if (name == "sec-websocket-accept") {
+            accepted = value == webSocketAcceptKey(key);
+        }
+    }
+    if (!upgraded || !connectionUpgrade || !accepted) {
+        setError("Invalid WebSocket upgrade response from " + uri.host);
+        return false;
+    }
+    return true;
+}
+
+void PosixWebSocketClient::eventLoop() {
+    const auto keepalive = config_.pingInterval;
+    bool writeArmed = false;
+    processFrames();
+    bool alive = true;
+    while (alive) {
+        if (closeRequested_.load(std::memory_order_acquire) && !closeSent_) {
+            const std::uint8_t status[2] = {static_cast<std::uint8_t>(kNormalClosure >> 8U),
+                                            static_cast<std::uint8_t>(kNormalClosure & 0xFFU)};
+            queueControl(kClose, status, sizeof(status));
+        }
+        const auto flushed = flushOutbound();
+        if (flushed == TransportStatus::Failed || flushed == TransportStatus::Closed) {
+            setError("Socket write failed");
+            break;
+        }
+        if (closeSent_ && closeReceived_ && writing_.empty()) {
+            break;
+        }
+        const bool wantWrite = flushed == TransportStatus::WantWrite;
+        if (wantWrite != writeArmed) {
+            epoll_event event{};
+            event.events = EPOLLIN | (wantWrite ? EPOLLOUT : 0U);
+            event.data.fd = socket_;
+            (void)::epoll_ctl(epoll_, EPOLL_CTL_MOD, socket_, &event);
+            writeArmed = wantWrite;
+        }
+
+        const auto now = std::chrono::steady_clock::now();
+        std::optional<std::chrono::steady_clock::time_point> due;
+        if (closeSent_) {
+            due = closeDeadline_;
+        } else if (keepalive.count() > 0) {
+            due = lastReceive_ + keepalive + (pingOutstanding_ ? config_.pongTimeout : std::chrono::milliseconds{0});
+        }
+        if (due && *due <= now) {
+            if (closeSent_) {
+                setError("Close handshake timed out");
+                break;
+            }
+            if (pingOutstanding_) {
+                setError("Keepalive timed out");
+                break;
+            }
+            queueControl(kPing, nullptr, 0);
+            pingOutstanding_ = true;
+            continue;
+        }
+        int timeout = -1;
+        if (due) {
+            const auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(*due - now) + std::chrono::milliseconds{1};
+            timeout = static_cast<int>(wait.count());
+        }
+
+        epoll_event events[2];
+        const int ready = ::epoll_wait(epoll_, events, 2, timeout);
+        if (ready < 0 && errno != EINTR) {
+            setError("Event loop failed");
+            break;
+        }
+        bool readable = false;
+        for (int i = 0; i < ready; ++i) {
+            if (events[i].data.fd == wakeFd_) {
+                std::uint64_t count = 0;
+                (void)::read(wakeFd_, &count, sizeof(count));
+            } else {
+                readable = readable || (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) != 0U;
+            }
+        }
+        if (readable) {
+            alive = readAvailable();
+        }
+    }
+
+    {
+        std::scoped_lock lock(sendMutex_);
+        connected_.store(false, std::memory_order_release);
+    }
+    sendProgress_.notify_all();
+    inboxReady_.notify_all();
+    if (onDisconnected_) {
+        onDisconnected_();
+    }
+}
+
+bool PosixWebSocketClient::readAvailable() {
+    std::uint8_t buffer[kReadChunk];
+    for (std::size_t reads = 0; reads < kReadsPerWake; ++reads) {
+        std::size_t transferred = 0;
+        const auto status = transport_->read(buffer, sizeof(buffer), transferred);
+        if (status == TransportStatus::Ok) {
+            received_.insert(received_.end(), buffer, buffer + transferred);
+            lastReceive_ = std::chrono::steady_clock::now();
+            pingOutstanding_ = false;
+            processFrames();
+            continue;
+        }
+        if (status == TransportStatus::WantRead || status == TransportStatus::WantWrite) {
+            return true;
+        }
+        if (!closeReceived_) {
+            setError(status == TransportStatus::Closed ? "Connection closed by the server" : "Socket read failed");
+        }
+        return false;
+    }
+    return true;
+}
+
+void PosixWebSocketClient::processFrames() {
+    while (!closeReceived_) {
+        const std::uint8_t *in = received_.data() + receiveOffset_;
+        const std::size_t available = received_.size() - receiveOffset_;
+        if (available < 2) {
+            break;
+        }
+        const bool fin = (in[0] & 0x80U) != 0U;
+        const std::uint8_t opcode = in[0] & 0x0FU;
+        if ((in[0] & 0x70U) != 0U) {
+            failConnection(kProtocolError, "Reserved bits set in a server frame");
+            break;
+        }
+        if ((in[1] & 0x80U) != 0U) {
+            failConnection(kProtocolError, "Server frames must not be masked");
+            break;
+        }
+        std::size_t header = 2;
+        std::uint64_t length = in[1] & 0x7FU;
+        if (length == 126U) {
+            if (available < 4) {
+                break;
+            }
+            length = (static_cast<std::uint64_t>(in[2]) << 8U) | in[3];
+            header = 4;
+        } else if (length == 127U) {
+            if (available < 10) {
+                break;
+            }
+            length = 0;
+            for (std::size_t i = 0; i < 8; ++i) {
+                length = (length << 8U) | in[2 + i];
+            }
+            header = 10;
+        }
+        const bool control = (opcode & 0x08U) != 0U;
+        if (control && (!fin || length > kMaxControlPayload)) {
+            failConnection(kProtocolError, "Fragmented or oversized control frame");
+            break;
+        }
+        if (!control && length > config_.maxMessageBytes - std::min(fragments_.size(), config_.maxMessageBytes)) {
+            failConnection(kMessageTooBig, "Server message exceeds the size limit");
+            break;
+        }
+        const auto size = static_cast<std::size_t>(length);
+        if (available - header < size) {
+            break;
+        }
+        const std::uint8_t *payload = in + header;
+        receiveOffset_ += header + size;
+
+        switch (opcode) {
+        case kContinuation:
+            if (fragmentOpcode_ == 0U) {
+                failConnection(kProtocolError, "Continuation without a message");
+                break;
+            }
+            fragments_.insert(fragments_.end(), payload, payload + size);
+            if (fin) {
+                deliverMessage(fragmentOpcode_, fragments_.data(), fragments_.size());
+                fragments_.clear();
+                fragmentOpcode_ = 0;
+            }
+            break;
+        case kText:
+        case kBinary:
+            if (fragmentOpcode_ != 0U) {
+                failConnection(kProtocolError, "New message inside a fragmented one");
+                break;
+            }
+            if (fin) {
+                deliverMessage(opcode, payload, size);
+            } else {
+                fragments_.assign(payload, payload + size);
+                fragmentOpcode_ = opcode;
+            }
+            break;
+        case kClose:
+            if (size == 1) {
+                failConnection(kProtocolError, "Malformed close frame");
+                break;
+            }
+            if (!closeSent_) {
+                // Echo the status code, as RFC 6455 asks.
+                queueControl(kClose, payload, std::min<std::size_t>(size, 2));
+                setError(size >= 2 ? "Server closed the connection with status " +
+                                         std::to_string((static_cast<unsigned>(payload[0]) << 8U) | payload[1])
+                                   : "Server closed the connection");
+            }
+            closeReceived_ = true;
+            break;
+        case kPing:
+            queueControl(kPong, payload, size);
+            break;
+        case kPong:
+            break;
+        default:
+            failConnection(kProtocolError, "Unknown opcode");
+            break;
+        }
+    }
+    if (receiveOffset_ == received_.size()) {
+        received_.clear();
+        receiveOffset_ = 0;
+    } else if (receiveOffset_ >= kReadChunk) {
+        received_.erase(received_.begin(), received_.begin() + static_cast<std::ptrdiff_t>(receiveOffset_));
+        receiveOffset_ = 0;
+    }
+}
+
+void PosixWebSocketClient::deliverMessage(std::uint8_t opcode, const std::uint8_t *data, std::size_t size) {
+    if (opcode == kText) {
+        if (messageHandler_) {
+            messageHandler_(std::string(reinterpret_cast<const char *>(data), size));
+        }
+        return;
+    }
+    if (binaryHandler_) {
+        binaryHandler_(data, size);
+        return;
+    }
+    {
+        std::scoped_lock lock(inboxMutex_);
+        if (inbox_.size() >= std::max<std::size_t>(config_.receiveQueueDepth, 1)) {
+            inbox_.pop_front();
+            droppedMessages_.fetch_add(1, std::memory_order_relaxed);
+        }
+        inbox_.emplace_back(data, data + size);
+    }
+    inboxReady_.notify_one();
+}
+
+TransportStatus PosixWebSocketClient::flushOutbound() {
+    std::size_t progress = 0;
+    bool advanced = false;
+    TransportStatus status = TransportStatus::Ok;
+    while (true) {
+        if (writeOffset_ == writing_.size()) {
+            std::scoped_lock lock(sendMutex_);
+            written_ += progress;
+            progress = 0;
+            writing_.clear();
+            writeOffset_ = 0;
+            writing_.swap(pending_);
+            if (writing_.empty()) {
+                break;
+            }
+        }
+        std::size_t transferred = 0;
+        status = transport_->write(writing_.data() + writeOffset_, writing_.size() - writeOffset_, transferred);
+        if (status != TransportStatus::Ok) {
+            break;
+        }
+        writeOffset_ += transferred;
+        progress += transferred;
+        advanced = true;
+    }
+    if (progress > 0) {
+        std::scoped_lock lock(sendMutex_);
+        written_ += progress;
+    }
+    if (advanced) {
+        sendProgress_.notify_all();
+    }
+    return status;
+}
+
+void PosixWebSocketClient::failConnection(std::uint16_t status, const std::string &reason) {
+    setError(reason);
+    if (!closeSent_) {
+        const std::uint8_t code[2] = {static_cast<std::uint8_t>(status >> 8U), static_cast<std::uint8_t>(status & 0xFFU)};
+        queueControl(kClose, code, sizeof(code));
+    }
+    // Nothing more is read; the loop exits once the close frame is out.
+    closeReceived_ = true;
+    receiveOffset_ = received_.size();
+}
+
+void PosixWebSocketClient::queueControl(std::uint8_t opcode, const std::uint8_t *data, std::size_t size) {
+    {
+        std::scoped_lock lock(sendMutex_);
+        appendFrame(Frame{opcode, true, data, size});
+    }
+    if (opcode == kClose) {
+        closeSent_ = true;
+        closeDeadline_ = std::chrono::steady_clock::now() + config_.closeTimeout;
+    }
+}
+
+void PosixWebSocketClient::appendFrame(const Frame &frame) {
+    std::uint8_t header[14];
+    std::size_t headerSize = 2;
+    header[0] = static_cast<std::uint8_t>((frame.fin ? 0x80U : 0x00U) | frame.opcode);
+    if (frame.size < 126U) {
+        header[1] = static_cast<std::uint8_t>(0x80U | frame.size);
+    } else if (frame.size <= 0xFFFFU) {
+        header[1] = 0x80U | 126U;
+        header[2] = static_cast<std::uint8_t>(frame.size >> 8U);
+        header[3] = static_cast<std::uint8_t>(frame.size);
+        headerSize = 4;
+    } else {
+        header[1] = 0x80U | 127U;
+        const auto length = static_cast<std::uint64_t>(frame.size);
+        for (std::size_t i = 0; i < 8; ++i) {
+            header[2 + i] = static_cast<std::uint8_t>(length >> (56U - i * 8U));
+        }
+        headerSize = 10;
+    }
+    std::uint8_t key[4];
+    const std::uint32_t random = maskRng_();
+    std::memcpy(key, &random, sizeof(key));
+    std::memcpy(header + headerSize, key, sizeof(key));
+    headerSize += sizeof(key);
+
+    const std::size_t start = pending_.size();
+    pending_.insert(pending_.end(), header, header + headerSize);
+    if (frame.size > 0) {
+        pending_.insert(pending_.end(), frame.data, frame.data + frame.size);
+        applyMask(pending_.data() + start + headerSize, frame.size, key);
+    }
+    queued_ += headerSize + frame.size;
+}
+
+bool PosixWebSocketClient::send(std::uint8_t opcode, const ByteSegment *segments, std::size_t count) {
+    std::unique_lock<std::mutex> lock(sendMutex_);
+    if (!connected_.load(std::memory_order_acquire) || closeRequested_.load(std::memory_order_acquire)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < count; ++i) {
+        appendFrame(Frame{i == 0 ? opcode : kContinuation, i + 1 == count, segments[i].data, segments[i].size});
+    }
+    const std::uint64_t end = queued_;
+    wake();
+    const auto deadline = std::chrono::steady_clock::now() + config_.sendTimeout;
+    sendProgress_.wait_until(lock, deadline,
+                             [&] { return written_ >= end || !connected_.load(std::memory_order_acquire); });
+    return written_ >= end;
+}
+
+bool PosixWebSocketClient::sendText(const std::string &payload) {
+    const ByteSegment segment{reinterpret_cast<const std::uint8_t *>(payload.data()), payload.size()};
+    return send(kText, &segment, 1);
+}
+
+bool PosixWebSocketClient::sendBinary(const std::uint8_t *payload, std::size_t length) {
+    const ByteSegment segment{payload, length};
+    return send(kBinary, &segment, 1);
+}
+
+bool PosixWebSocketClient::sendBinary(const ByteSegment *segments, std::size_t count) {
+    return count > 0 && send(kBinary, segments, count);
+}
+
+bool PosixWebSocketClient::sendPing() {
+    const ByteSegment segment{};
+    return send(kPing, &segment, 1);
+}
+
+void PosixWebSocketClient::connect(const std::string &uri) {
+    if (!open(uri)) {
+        throw std::runtime_error(lastError());
+    }
+}
+
+void PosixWebSocketClient::close() {
+    if (loop_.joinable() && loop_.get_id() == std::this_thread::get_id()) {
+        // From a handler: the loop closes and exits on its own.
+        closeRequested_.store(true, std::memory_order_release);
+        return;
+    }
+    closeRequested_.store(true, std::memory_order_release);
+    if (loop_.joinable()) {
+        wake();
+    }
+    teardown();
+}
+
+void PosixWebSocketClient::sendBinary(const std::vector<std::uint8_t> &data) {
+    (void)sendBinary(data.data(), data.size());
+}
+
+std::optional<std::vector<std::uint8_t>> PosixWebSocketClient::receiveBinary(std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(inboxMutex_);
+    if (!inboxReady_.wait_for(lock, timeout, [this] { return !inbox_.empty() || !isConnected(); }) ||
+        inbox_.empty()) {
+        return std::nullopt;
+    }
+    auto message = std::move(inbox_.front());
+    inbox_.pop_front();
+    return message;
+}
+
+std::string PosixWebSocketClient::lastError() const {
+    std::scoped_lock lock(errorMutex_);
+    return lastError_;
+}
+
+void PosixWebSocketClient::wake() const {
+    const std::uint64_t one = 1;
+    (void)::write(wakeFd_, &one, sizeof(one));
+}
+
+void PosixWebSocketClient::teardown() {
+    if (loop_.joinable()) {
+        loop_.join();
+    }
+    connected_.store(false, std::memory_order_release);
+    transport_.reset();
+    for (int *fd : {&socket_, &epoll_, &wakeFd_}) {
+        if (*fd >= 0) {
+            ::close(*fd);
+            *fd = -1;
+        }
+    }
+}
+
+void PosixWebSocketClient::setError(std::string error) {
+    std::scoped_lock lock(errorMutex_);
+    lastError_ = std::move(error);
+}
+
+} // namespace minitrain
+
+#endif
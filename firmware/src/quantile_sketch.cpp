@@ -0,0 +1,188 @@
+#include "minitrain/quantile_sketch.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace minitrain {
+
+namespace {
+constexpr double kCapacityDecay = 2.0 / 3.0;
+constexpr std::size_t kMinLevelCapacity = 8;
+} // namespace
+
+QuantileSketch::QuantileSketch(std::uint16_t k) : k_{std::max<std::uint16_t>(k, 8)}, levels_(1) {
+    levels_.front().reserve(k_);
+}
+
+std::size_t QuantileSketch::levelCapacity(std::size_t level) const {
+    const std::size_t depth = levels_.size() - 1 - level;
+    const double capacity = std::ceil(static_cast<double>(k_) * std::pow(kCapacityDecay, static_cast<double>(depth)));
+    return std::max(kMinLevelCapacity, static_cast<std::size_t>(capacity));
+}
+
+bool QuantileSketch::nextOffsetBit() {
+    // xorshift32: deterministic so that replays and tests are reproducible.
+    randomState_ ^= randomState_ << 13U;
+    randomState_ ^= randomState_ >> 17U;
+    randomState_ ^= randomState_ << 5U;
+    return (randomState_ & 0x1U) != 0;
+}
+
+void QuantileSketch::add(float value) {
+    if (std::isnan(value)) {
+        return;
+    }
+    if (count_ == 0) {
+        min_ = value;
+        max_ = value;
+    } else {
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+    ++count_;
+    levels_.front().push_back(value);
+    if (levels_.front().size() >= levelCapacity(0)) {
+        compress();
+    }
+}
+
+void QuantileSketch::compact(std::size_t level) {
+    if (level + 1 == levels_.size()) {
+        levels_.emplace_back();
+    }
+    auto &items = levels_[level];
+    auto &parent = levels_[level + 1];
+    std::sort(items.begin(), items.end());
+
+    // An odd leftover stays at this level so total weight is preserved exactly.
+    std::optional<float> leftover;
+    if (items.size() % 2 != 0) {
+        leftover = items.back();
+        items.pop_back();
+    }
+    const std::size_t offset = nextOffsetBit() ? 1U : 0U;
+    for (std::size_t i = offset; i < items.size(); i += 2) {
+        parent.push_back(items[i]);
+    }
+    items.clear();
+    if (leftover) {
+        items.push_back(*leftover);
+    }
+}
+
+void QuantileSketch::compress() {
+    bool compacted = true;
+    while (compacted) {
+        compacted = false;
+        for (std::size_t level = 0; level < levels_.size(); ++level) {
+            if (levels_[level].size() >= levelCapacity(level)) {
+                compact(level);
+                compacted = true;
+                break;
+            }
+        }
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch &other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        min_ = other.min_;
+        max_ = other.max_;
+    } else {
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+    count_ += other.count_;
+    k_ = std::min(k_, other.k_);
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (std::size_t level = 0; level < other.levels_.size(); ++level) {
+        const auto &source = other.levels_[level];
+        levels_[level].insert(levels_[level].end(), source.begin(), source.end());
+    }
+    compress();
+}
+
+void QuantileSketch::clear() {
+    count_ = 0;
+    min_ = 0.0F;
+    max_ = 0.0F;
+    levels_.assign(1, {});
+}
+
+std::optional<float> QuantileSketch::quantile(double q) const {
+    if (count_ == 0) {
+        return std::nullopt;
+    }
+    if (q <= 0.0) {
+        return min_;
+    }
+    if (q >= 1.0) {
+        return max_;
+    }
+
+    std::vector<std::pair<float, std::uint64_t>> weighted;
+    weighted.reserve(retainedValues());
+    for (std::size_t level = 0; level < levels_.size(); ++level) {
+        const std::uint64_t weight = std::uint64_t{1} << level;
+        for (const float value : levels_[level]) {
+            weighted.emplace_back(value, weight);
+        }
+    }
+    std::sort(weighted.begin(), weighted.end(),
+              [](const auto &lhs, const auto &rhs) { return lhs.first < rhs.first; });
+
+    const double target = q * static_cast<double>(count_);
+    std::uint64_t cumulative = 0;
+    for (const auto &[value, weight] : weighted) {
+        cumulative += weight;
+        if (static_cast<double>(cumulative) >= target) {
+            return value;
+        }
+    }
+    return max_;
+}
+
+double QuantileSketch::rank(float value) const {
+    if (count_ == 0) {
+        return 0.0;
+    }
+    std::uint64_t below = 0;
+    for (std::size_t level = 0; level < levels_.size(); ++level) {
+        for (const float item : levels_[level]) {
+            if (item < value) {
+                below += std::uint64_t{1} << level;
+            }
+        }
+    }
+    return static_cast<double>(below) / static_cast<double>(count_);
+}
+
+std::optional<float> QuantileSketch::min() const {
+    if (count_ == 0) {
+        return std::nullopt;
+    }
+    return min_;
+}
+
+std::optional<float> QuantileSketch::max() const {
+    if (count_ == 0) {
+        return std::nullopt;
+    }
+    return max_;
+}
+
+std::size_t QuantileSketch::retainedValues() const {
+    std::size_t total = 0;
+    for (const auto &level : levels_) {
+        total += level.size();
+    }
+    return total;
+}
+
+} // namespace minitrain
@@ -0,0 +1,293 @@
+#include "minitrain/send_scheduler.hpp"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "byte_order.hpp"
+
+namespace minitrain {
+
+namespace {
+std::chrono::microseconds updateAverage(std::chrono::microseconds average, std::chrono::microseconds sample) {
+    return average.count() == 0 ? sample : average + (sample - average) / 8;
+}
+} // namespace
+
+OutboundMessage OutboundMessage::text(std::string payload) {
+    auto storage = std::make_shared<std::string>(std::move(payload));
+    OutboundMessage message;
+    message.binary = false;
+    message.addSegment({reinterpret_cast<const std::uint8_t *>(storage->data()), storage->size()});
+    message.owner = std::move(storage);
+    return message;
+}
+
+OutboundMessage OutboundMessage::bytes(std::vector<std::uint8_t> payload) {
+    auto storage = std::make_shared<std::vector<std::uint8_t>>(std::move(payload));
+    OutboundMessage message;
+    message.addSegment({storage->data(), storage->size()});
+    message.owner = std::move(storage);
+    return message;
+}
+
+bool OutboundMessage::addSegment(ByteSegment segment) {
+    if (segmentCount == segments.size()) {
+        return false;
+    }
+    segments[segmentCount++] = segment;
+    return true;
+}
+
+std::size_t OutboundMessage::size() const {
+    std::size_t total = 0;
+    for (std::size_t i = 0; i < segmentCount; ++i) {
+        total += segments[i].size;
+    }
+    return total;
+}
+
+SendScheduler::SendScheduler(Transport transport, SendSchedulerConfig config)
+    : transport_(std::move(transport)), config_(config) {
+    // Queues are sized once here so enqueue() never allocates.
+    for (std::size_t i = 0; i < kTrafficClassCount; ++i) {
+        classes_[i].queue.reserve(std::max<std::size_t>(config_.classes[i].maxQueuedMessages, 1));
+    }
+}
+
+SendScheduler::~SendScheduler() {
+    stop();
+    // Completes whatever is left so owners of completion callbacks hear back.
+    clear();
+}
+
+void SendScheduler::finish(OutboundMessage &message, bool sent) {
+    auto done = std::move(message.onComplete);
+    message.segmentCount = 0;
+    message.owner.reset();
+    if (done) {
+        done(sent);
+    }
+}
+
+bool SendScheduler::enqueue(TrafficClass trafficClass, OutboundMessage message) {
+    const std::size_t size = message.size();
+    if (size == 0) {
+        return false;
+    }
+    const auto index = static_cast<std::size_t>(trafficClass);
+    const auto &classConfig = config_.classes[index];
+    std::size_t limit = std::max<std::size_t>(classConfig.maxQueuedMessages, 1);
+    Pending incoming{std::move(message), size, std::chrono::steady_clock::now()};
+    // The queue never holds more than its limit, so one message at most
+    // makes room for the new one.
+    std::optional<Pending> dropped;
+    {
+        std::scoped_lock lock(mutex_);
+        auto &state = classes_[index];
+        if (classConfig.limitIncludesSending && (state.inFlight || state.sending)) {
+            --limit;
+        }
+        ++state.stats.enqueuedMessages;
+        if (limit == 0) {
+            ++state.stats.droppedMessages;
+            dropped = std::move(incoming);
+        } else {
+            if (state.queue.size() >= limit) {
+                state.stats.queuedBytes -= state.queue.front().size;
+                --state.stats.queuedMessages;
+                ++state.stats.droppedMessages;
+                dropped = std::move(state.queue.front());
+                state.queue.pop_front();
+            }
+            state.queue.push_back(std::move(incoming));
+            ++state.stats.queuedMessages;
+            state.stats.queuedBytes += size;
+        }
+    }
+    workAvailable_.notify_one();
+    if (dropped) {
+        finish(dropped->message, false);
+    }
+    return true;
+}
+
+bool SendScheduler::sendNext() {
+    std::scoped_lock sendLock(sendMutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::size_t index = 0;
+    while (index < kTrafficClassCount && !classes_[index].inFlight && classes_[index].queue.empty()) {
+        ++index;
+    }
+    if (index == kTrafficClassCount) {
+        return false;
+    }
+    bool preempting = false;
+    for (std::size_t lower = index + 1; lower < kTrafficClassCount; ++lower) {
+        preempting = preempting || classes_[lower].inFlight.has_value();
+    }
+
+    auto &state = classes_[index];
+    const std::size_t chunkBytes = config_.classes[index].chunkBytes;
+    if (!state.inFlight) {
+        Pending next = std::move(state.queue.front());
+        state.queue.pop_front();
+        --state.stats.queuedMessages;
+        state.stats.queuedBytes -= next.size;
+        if (!next.message.binary || chunkBytes == 0) {
+            state.sending = true;
+            lock.unlock();
+            const bool sent = transport_(next.message.binary, next.message.segments.data(), next.message.segmentCount);
+            lock.lock();
+            state.sending = false;
+            if (!sent) {
+                ++state.stats.failedMessages;
+            } else {
+                ++state.stats.sentChunks;
+                state.stats.sentBytes += next.size;
+                state.stats.preemptions += preempting ? 1U : 0U;
+                complete(state, next, std::chrono::steady_clock::now());
+            }
+            lock.unlock();
+            finish(next.message, sent);
+            return true;
+        }
+        state.inFlight = InFlight{std::move(next), nextMessageId_++, 0};
+    }
+
+    // The in-flight message is only touched by the holder of sendMutex_, so
+    // it stays valid while the transport runs unlocked.
+    auto &flight = *state.inFlight;
+    const std::size_t length = std::min(chunkBytes, flight.pending.size - flight.offset);
+    std::uint8_t *out = std::copy(kChunkMagic.begin(), kChunkMagic.end(), chunkHeader_.data());
+    detail::putLittle32(out, flight.id);
+    detail::putLittle32(out, static_cast<std::uint32_t>(flight.offset));
+    detail::putLittle32(out, static_cast<std::uint32_t>(flight.pending.size));
+    std::size_t gathered = 0;
+    gather_[gathered++] = {chunkHeader_.data(), chunkHeader_.size()};
+    std::size_t skip = flight.offset;
+    std::size_t remaining = length;
+    const auto &message = flight.pending.message;
+    for (std::size_t i = 0; i < message.segmentCount && remaining > 0; ++i) {
+        const auto &segment = message.segments[i];
+        if (skip >= segment.size) {
+            skip -= segment.size;
+            continue;
+        }
+        const std::size_t take = std::min(segment.size - skip, remaining);
+        gather_[gathered++] = {segment.data + skip, take};
+        remaining -= take;
+        skip = 0;
+    }
+
+    lock.unlock();
+    const bool sent = transport_(true, gather_.data(), gathered);
+    lock.lock();
+    if (!sent) {
+        // The receiver drops the incomplete message when the next id arrives.
+        ++state.stats.failedMessages;
+    } else {
+        ++state.stats.sentChunks;
+        state.stats.sentBytes += length;
+        state.stats.preemptions += preempting ? 1U : 0U;
+        flight.offset += length;
+        if (flight.offset < flight.pending.size) {
+            return true;
+        }
+        complete(state, flight.pending, std::chrono::steady_clock::now());
+    }
+    OutboundMessage done = std::move(flight.pending.message);
+    state.inFlight.reset();
+    lock.unlock();
+    finish(done, sent);
+    return true;
+}
+
+void SendScheduler::complete(ClassState &state, const Pending &pending, std::chrono::steady_clock::time_point now) {
+    const auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - pending.enqueued);
+    ++state.stats.sentMessages;
+    state.stats.averageLatency = updateAverage(state.stats.averageLatency, std::max(latency, std::chrono::microseconds{1}));
+    state.stats.maxLatency = std::max(state.stats.maxLatency, latency);
+}
+
+bool SendScheduler::start() {
+    if (running_.load(std::memory_order_acquire)) {
+        return true;
+    }
+    {
+        std::scoped_lock lock(mutex_);
+        stopRequested_ = false;
+    }
+    worker_ = std::thread([this] { run(); });
+    running_.store(true, std::memory_order_release);
+    return true;
+}
+
+void SendScheduler::stop() {
+    {
+        std::scoped_lock lock(mutex_);
+        stopRequested_ = true;
+    }
+    workAvailable_.notify_all();
+    if (worker_.joinable()) {
+        worker_.join();
+    }
+    running_.store(false, std::memory_order_release);
+}
+
+void SendScheduler::run() {
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            workAvailable_.wait(lock, [this] {
+                return stopRequested_ || std::any_of(classes_.begin(), classes_.end(), [](const ClassState &state) {
+                           return state.inFlight.has_value() || !state.queue.empty();
+                       });
+            });
+            if (stopRequested_) {
+                return;
+            }
+        }
+        sendNext();
+    }
+}
+
+void SendScheduler::clear() {
+    std::vector<OutboundMessage> dropped;
+    {
+        std::scoped_lock lock(sendMutex_, mutex_);
+        for (auto &state : classes_) {
+            state.stats.droppedMessages += state.queue.size() + (state.inFlight ? 1U : 0U);
+            state.stats.queuedMessages = 0;
+            state.stats.queuedBytes = 0;
+            if (state.inFlight) {
+                dropped.push_back(std::move(state.inFlight->pending.message));
+            }
+            while (!state.queue.empty()) {
+                dropped.push_back(std::move(state.queue.front().message));
+                state.queue.pop_front();
+            }
+            state.inFlight.reset();
+        }
+    }
+    for (auto &message : dropped) {
+        finish(message, false);
+    }
+}
+
+TrafficClassStats SendScheduler::stats(TrafficClass trafficClass) const {
+    std::scoped_lock lock(mutex_);
+    return classes_[static_cast<std::size_t>(trafficClass)].stats;
+}
+
+std::size_t SendScheduler::pending() const {
+    std::scoped_lock lock(mutex_);
+    std::size_t total = 0;
+    for (const auto &state : classes_) {
+        total += state.queue.size() + (state.inFlight ? 1U : 0U);
+    }
+    return total;
+}
+
+} // namespace minitrain
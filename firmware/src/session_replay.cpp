@@ -0,0 +1,263 @@
+#include "minitrain/session_replay.hpp"
+
+#include "minitrain/command_processor.hpp"
+
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include <sstream>
+
+namespace minitrain {
+
+namespace {
+
+struct RecordedOutput {
+    std::uint64_t sequence{0};
+    float motorCommand{0.0F};
+    TelemetrySample telemetry{};
+};
+
+bool closeEnough(float expected, float actual, float tolerance) {
+    return std::fabs(expected - actual) <= tolerance || (std::isnan(expected) && std::isnan(actual));
+}
+
+std::optional<std::string> compareTelemetry(const TelemetrySample &expected, const TelemetrySample &actual,
+                                            float tolerance) {
+    const std::pair<const char *, std::pair<float, float>> values[] = {
+        {"speed", {expected.speedMetersPerSecond, actual.speedMetersPerSecond}},
+        {"current", {expected.motorCurrentAmps, actual.motorCurrentAmps}},
+        {"voltage", {expected.batteryVoltage, actual.batteryVoltage}},
+        {"temperature", {expected.temperatureCelsius, actual.temperatureCelsius}},
+        {"appliedSpeed", {expected.appliedSpeedMetersPerSecond, actual.appliedSpeedMetersPerSecond}},
+        {"failSafeProgress", {expected.failSafeProgress, actual.failSafeProgress}},
+    };
+    for (const auto &[name, pair] : values) {
+        if (!closeEnough(pair.first, pair.second, tolerance)) {
+            std::ostringstream detail;
+            detail << name << " expected " << pair.first << " got " << pair.second;
+            return detail.str();
+        }
+    }
+    if (expected.failSafeActive != actual.failSafeActive) {
+        return std::string{"failSafeActive differs"};
+    }
+    if (expected.failSafeElapsedMillis != actual.failSafeElapsedMillis) {
+        return std::string{"failSafeElapsedMillis differs"};
+    }
+    if (expected.lightsState != actual.lightsState || expected.lightsSource != actual.lightsSource ||
+        expected.lightsOverrideMask != actual.lightsOverrideMask ||
+        expected.lightsTelemetryOnly != actual.lightsTelemetryOnly) {
+        return std::string{"lights differ"};
+    }
+    if (expected.activeCab != actual.activeCab || expected.appliedDirection != actual.appliedDirection) {
+        return std::string{"cab or direction differs"};
+    }
+    if (expected.sequence != actual.sequence || expected.sessionId != actual.sessionId) {
+        return std::string{"sequence or session differs"};
+    }
+    return std::nullopt;
+}
+
+// Pairs recorded and replayed outputs as they appear, so memory stays bounded
+// by the divergence between the two streams rather than the session length.
+class OutputComparator {
+  public:
+    OutputComparator(ReplayReport &report, const ReplayConfig &config) : report_{report}, config_{config} {}
+
+    void recordedMotor(std::uint64_t sequence, float command) {
+        expectedMotor_.push_back({sequence, command, {}});
+        drain();
+    }
+    void replayedMotor(float command) {
+        actualMotor_.push_back(command);
+        drain();
+    }
+    void recordedTelemetry(std::uint64_t sequence, const TelemetrySample &sample) {
+        expectedTelemetry_.push_back({sequence, 0.0F, sample});
+        drain();
+    }
+    void replayedTelemetry(const TelemetrySample &sample) {
+        actualTelemetry_.push_back(sample);
+        drain();
+    }
+
+    void finish() {
+        const auto unmatchedMotor = std::max(expectedMotor_.size(), actualMotor_.size());
+        const auto unmatchedTelemetry = std::max(expectedTelemetry_.size(), actualTelemetry_.size());
+        report_.unmatchedOutputs += unmatchedMotor + unmatchedTelemetry;
+        if (!expectedMotor_.empty()) {
+            noteMismatch(FlightRecordType::MotorCommand, expectedMotor_.front().sequence, "motor command not replayed");
+        } else if (!actualMotor_.empty()) {
+            noteMismatch(FlightRecordType::MotorCommand, 0, "extra motor command replayed");
+        }
+        if (!expectedTelemetry_.empty()) {
+            noteMismatch(FlightRecordType::TelemetryOutput, expectedTelemetry_.front().sequence,
+                         "telemetry not replayed");
+        } else if (!actualTelemetry_.empty()) {
+            noteMismatch(FlightRecordType::TelemetryOutput, 0, "extra telemetry replayed");
+        }
+    }
+
+  private:
+    void drain() {
+        while (!expectedMotor_.empty() && !actualMotor_.empty()) {
+            const auto expected = expectedMotor_.front();
+            const float actual = actualMotor_.front();
+            expectedMotor_.pop_front();
+            actualMotor_.pop_front();
+            ++report_.motorCommands;
+            const float error = std::fabs(expected.motorCommand - actual);
+            report_.maxMotorError = std::max(report_.maxMotorError, error);
+            if (!closeEnough(expected.motorCommand, actual, config_.motorTolerance)) {
+                ++report_.motorMismatches;
+                std::ostringstream detail;
+                detail << "motor expected " << expected.motorCommand << " got " << actual;
+                noteMismatch(FlightRecordType::MotorCommand, expected.sequence, detail.str());
+            }
+        }
+        while (!expectedTelemetry_.empty() && !actualTelemetry_.empty()) {
+            const auto expected = expectedTelemetry_.front();
+            const auto actual = actualTelemetry_.front();
+            expectedTelemetry_.pop_front();
+            actualTelemetry_.pop_front();
+            ++report_.telemetrySamples;
+            if (auto detail = compareTelemetry(expected.telemetry, actual, config_.telemetryTolerance)) {
+                ++report_.telemetryMismatches;
+                noteMismatch(FlightRecordType::TelemetryOutput, expected.sequence, *detail);
+            }
+        }
+    }
+
+    void noteMismatch(FlightRecordType type, std::uint64_t sequence, std::string detail) {
+        if (!report_.firstMismatch) {
+            report_.firstMismatch = ReplayMismatch{type, sequence, std::move(detail)};
+        }
+    }
+
+    ReplayReport &report_;
+    const ReplayConfig &config_;
+    std::deque<RecordedOutput> expectedMotor_;
+    std::deque<float> actualMotor_;
+    std::deque<RecordedOutput> expectedTelemetry_;
+    std::deque<TelemetrySample> actualTelemetry_;
+};
+
+} // namespace
+
+ReplayReport replaySession(const FlightRecorder &recording, const ReplayConfig &config) {
+    const auto wallStart = std::chrono::steady_clock::now();
+    ReplayReport report{};
+    report.loaded = recording.valid();
+    if (!report.loaded) {
+        return report;
+    }
+
+    OutputComparator comparator{report, config};
+    std::chrono::steady_clock::time_point now{};
+    std::chrono::system_clock::time_point systemNow{};
+    std::chrono::steady_clock::time_point firstInput{};
+    std::optional<TrainController> controller;
+    std::optional<CommandProcessor> processor;
+
+    recording.forEach([&](const FlightRecord &record) {
+        const bool input = record.type == FlightRecordType::CommandFrame ||
+                           record.type == FlightRecordType::SpeedMeasurement ||
+                           record.type == FlightRecordType::TelemetryInput;
+        if (input) {
+            now = record.timestamp;
+            if (!controller) {
+                // The controller starts its command-age clock at construction.
+                firstInput = now;
+                controller.emplace(
+                    config.pid, [&comparator](float command) { comparator.replayedMotor(command); },
+                    [&comparator](const TelemetrySample &sample) { comparator.replayedTelemetry(sample); },
+                    config.staleCommandThreshold, config.pilotReleaseDuration, config.failSafeRampDuration,
+                    [&now] { return now; });
+                processor.emplace(*controller, std::nullopt, [&systemNow] { return systemNow; });
+            }
+            report.recordedSpan = now - firstInput;
+            ++report.inputRecords;
+        } else if (!controller) {
+            // Outputs whose input was evicted from the ring cannot be reproduced.
+            return;
+        }
+
+        switch (record.type) {
+        case FlightRecordType::CommandFrame:
+            if (const auto recorded = FlightRecorder::decodeCommandFrame(record)) {
+                systemNow = recorded->arrivalSystem;
+                processor->processFrame(recorded->frame, now);
+            }
+            break;
+        case FlightRecordType::SpeedMeasurement:
+            if (const auto measurement = FlightRecorder::decodeSpeedMeasurement(record)) {
+                controller->onSpeedMeasurement(measurement->measuredSpeed, measurement->dt);
+            }
+            break;
+        case FlightRecordType::TelemetryInput:
+            if (const auto sample = FlightRecorder::decodeTelemetry(record)) {
+                controller->onTelemetrySample(*sample);
+            }
+            break;
+        case FlightRecordType::MotorCommand:
+            if (const auto command = FlightRecorder::decodeMotorCommand(record)) {
+                comparator.recordedMotor(record.sequence, *command);
+            }
+            break;
+        case FlightRecordType::TelemetryOutput:
+            if (const auto sample = FlightRecorder::decodeTelemetry(record)) {
+                comparator.recordedTelemetry(record.sequence, *sample);
+            }
+            break;
+        case FlightRecordType::StateTransition:
+        case FlightRecordType::Padding:
+            break;
+        }
+    });
+
+    comparator.finish();
+    report.wallTime = std::chrono::steady_clock::now() - wallStart;
+    return report;
+}
+
+#ifndef ESP_PLATFORM
+std::size_t ReplaySummary::failures() const {
+    return static_cast<std::size_t>(
+        std::count_if(sessions.begin(), sessions.end(), [](const ReplayReport &report) { return !report.matches(); }));
+}
+
+double ReplaySummary::speedup() const {
+    const auto wallSeconds = std::chrono::duration<double>(wallTime).count();
+    if (wallSeconds <= 0.0) {
+        return 0.0;
+    }
+    return std::chrono::duration<double>(recordedSpan).count() / wallSeconds;
+}
+
+ReplaySummary replaySessions(const std::vector<std::string> &paths, const ReplayConfig &config, unsigned threads) {
+    const auto wallStart = std::chrono::steady_clock::now();
+    ReplaySummary summary{};
+    summary.sessions.resize(paths.size());
+
+    // Sessions are independent; workers claim the next one until the list is exhausted.
+    detail::parallelFor(paths.size(), threads, [&](std::size_t index) {
+        ReplayReport report{};
+        if (auto recording = FlightRecorder::openReadOnly(paths[index])) {
+            report = replaySession(*recording, config);
+        }
+        report.session = paths[index];
+        summary.sessions[index] = std::move(report);
+    });
+
+    for (const auto &report : summary.sessions) {
+        summary.recordedSpan += report.recordedSpan;
+        summary.inputRecords += report.inputRecords;
+    }
+    summary.wallTime = std::chrono::steady_clock::now() - wallStart;
+    return summary;
+}
+#endif
+
+} // namespace minitrain
@@ -0,0 +1,85 @@
+#include "minitrain/spsc_ring.hpp"
+
+#include <climits>
+#include <condition_variable>
+#include <mutex>
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+#include <cerrno>
+#include <ctime>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#define MINITRAIN_HAS_FUTEX 1
+#endif
+
+namespace minitrain {
+
+struct EventCount::Fallback {
+    std::mutex mutex;
+    std::condition_variable changed;
+};
+
+EventCount::EventCount() : fallback_(std::make_unique<Fallback>()) {}
+
+EventCount::~EventCount() = default;
+
+std::uint32_t EventCount::prepareWait() {
+    // Paired with notifyAll(): either the waiter sees the new epoch or the
+    // notifier sees the waiter.
+    waiters_.fetch_add(1, std::memory_order_seq_cst);
+    return epoch_.load(std::memory_order_seq_cst);
+}
+
+void EventCount::cancelWait() { waiters_.fetch_sub(1, std::memory_order_seq_cst); }
+
+bool EventCount::wait(std::uint32_t key, std::chrono::steady_clock::time_point deadline) {
+    bool notified = false;
+#ifdef MINITRAIN_HAS_FUTEX
+    while (true) {
+        if (epoch_.load(std::memory_order_acquire) != key) {
+            notified = true;
+            break;
+        }
+        const auto now = std::chrono::steady_clock::now();
+        if (now >= deadline) {
+            break;
+        }
+        const auto remaining = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - now).count();
+        timespec timeout{};
+        timeout.tv_sec = static_cast<time_t>(remaining / 1'000'000'000);
+        timeout.tv_nsec = static_cast<long>(remaining % 1'000'000'000);
+        // Returns immediately with EAGAIN if the epoch already moved on.
+        ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch_), FUTEX_WAIT_PRIVATE, key, &timeout, nullptr,
+                  0);
+    }
+#else
+    {
+        std::unique_lock<std::mutex> lock(fallback_->mutex);
+        notified = fallback_->changed.wait_until(
+            lock, deadline, [this, key] { return epoch_.load(std::memory_order_acquire) != key; });
+    }
+#endif
+    waiters_.fetch_sub(1, std::memory_order_seq_cst);
+    return notified;
+}
+
+void EventCount::notifyAll() {
+    epoch_.fetch_add(1, std::memory_order_seq_cst);
+    if (waiters_.load(std::memory_order_seq_cst) == 0U) {
+        return;
+    }
+#ifdef MINITRAIN_HAS_FUTEX
+    ::syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&epoch_), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr,
+              0);
+#else
+    {
+        // Orders the epoch change with a waiter that is between its predicate
+        // check and going to sleep.
+        std::lock_guard<std::mutex> lock(fallback_->mutex);
+    }
+    fallback_->changed.notify_all();
+#endif
+}
+
+} // namespace minitrain
@@ -0,0 +1,21 @@
+#include "minitrain/static_frame_filter.hpp"
+
+namespace minitrain {
+
+StaticFrameFilter::StaticFrameFilter(StaticFrameFilterConfig config) : config_(config) {}
+
+bool StaticFrameFilter::shouldSend(const SharedFrame &frame, std::chrono::steady_clock::time_point now) {
+    const auto &fingerprint = frame.fingerprint();
+    if (nearlyIdentical(reference_, fingerprint, config_.similarity) && now - lastSent_ < config_.keepAliveInterval) {
+        ++suppressed_;
+        return false;
+    }
+    reference_ = fingerprint;
+    lastSent_ = now;
+    ++sent_;
+    return true;
+}
+
+void StaticFrameFilter::reset() { reference_ = FrameFingerprint{}; }
+
+} // namespace minitrain
@@ -0,0 +1,232 @@
+#include "minitrain/synthetic_frame_source.hpp"
+
+#ifndef ESP_PLATFORM
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <thread>
+
+namespace minitrain {
+
+namespace {
+// SOI, SOF0 and SOS headers, one body byte and EOI.
+constexpr std::size_t kJpegHeaderBytes = 2 + 13 + 10;
+constexpr std::size_t kMinimumJpegBytes = kJpegHeaderBytes + 3;
+constexpr int kJpegQualityLevels = 64;
+
+bool frameDimensions(framesize_t frameSize, std::size_t &width, std::size_t &height) {
+    if (frameSize == FRAMESIZE_VGA) {
+        width = 640;
+        height = 480;
+    } else if (frameSize == FRAMESIZE_QVGA) {
+        width = 320;
+        height = 240;
+    } else if (frameSize == FRAMESIZE_QQVGA) {
+        width = 160;
+        height = 120;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+bool isJpegPath(const std::filesystem::path &path) {
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return extension == ".jpg" || extension == ".jpeg";
+}
+
+std::vector<std::vector<std::uint8_t>> loadJpegs(const std::string &directory) {
+    std::vector<std::filesystem::path> paths;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file() && isJpegPath(entry.path())) {
+            paths.push_back(entry.path());
+        }
+    }
+    std::sort(paths.begin(), paths.end());
+
+    std::vector<std::vector<std::uint8_t>> images;
+    for (const auto &path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        if (!bytes.empty()) {
+            images.push_back(std::move(bytes));
+        }
+    }
+    return images;
+}
+} // namespace
+
+std::unique_ptr<SyntheticFrameSource> SyntheticFrameSource::create(const SyntheticFrameConfig &config) {
+    if (config.width == 0 || config.height == 0 || config.bufferCount == 0 ||
+        (config.format != PIXFORMAT_JPEG && config.format != PIXFORMAT_YUV422)) {
+        return nullptr;
+    }
+    std::unique_ptr<SyntheticFrameSource> source(new SyntheticFrameSource(config));
+    if (!config.jpegDirectory.empty()) {
+        source->replay_ = loadJpegs(config.jpegDirectory);
+        if (source->replay_.empty()) {
+            return nullptr;
+        }
+        source->config_.format = PIXFORMAT_JPEG;
+    }
+
+    std::size_t capacity = source->config_.format == PIXFORMAT_YUV422 ? config.width * config.height * 2U
+                                                                      : std::max(config.jpegBytes, kMinimumJpegBytes);
+    for (const auto &image : source->replay_) {
+        capacity = std::max(capacity, image.size());
+    }
+    source->width_ = config.width;
+    source->height_ = config.height;
+    source->jpegBytes_ = std::max(config.jpegBytes, kMinimumJpegBytes);
+    source->capacity_ = capacity;
+    for (std::size_t i = 0; i < config.bufferCount; ++i) {
+        auto buffer = std::make_unique<Buffer>();
+        buffer->storage.resize(capacity);
+        buffer->frame.buf = buffer->storage.data();
+        buffer->frame.width = config.width;
+        buffer->frame.height = config.height;
+        buffer->frame.format = source->config_.format;
+        source->buffers_.push_back(std::move(buffer));
+    }
+    return source;
+}
+
+SyntheticFrameSource::SyntheticFrameSource(const SyntheticFrameConfig &config) : config_(config), rng_(config.seed) {}
+
+camera_fb_t *SyntheticFrameSource::acquire() {
+    // Absolute schedule: jitter moves single frames, never the timeline. A
+    // source that fell behind by more than a period skips the missed slots,
+    // like a sensor that keeps running while nobody reads it.
+    const auto now = std::chrono::steady_clock::now();
+    if (nextFrame_ == std::chrono::steady_clock::time_point{} || now - nextFrame_ > config_.period) {
+        nextFrame_ = now;
+    }
+    auto due = nextFrame_;
+    if (config_.jitter.count() > 0) {
+        std::uniform_int_distribution<std::int64_t> offset(-config_.jitter.count(), config_.jitter.count());
+        due += std::chrono::microseconds{offset(rng_)};
+    }
+    nextFrame_ += config_.period;
+    std::this_thread::sleep_until(due);
+
+    Buffer *buffer = nullptr;
+    std::uint64_t index = 0;
+    std::size_t width = 0;
+    std::size_t height = 0;
+    std::size_t jpegBytes = 0;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        const auto available = [this] {
+            return std::any_of(buffers_.begin(), buffers_.end(), [](const auto &entry) { return !entry->inUse; });
+        };
+        if (!bufferReleased_.wait_for(lock, config_.bufferTimeout, available)) {
+            return nullptr;
+        }
+        for (auto &entry : buffers_) {
+            if (!entry->inUse) {
+                buffer = entry.get();
+                break;
+            }
+        }
+        buffer->inUse = true;
+        ++inUse_;
+        index = produced_++;
+        width = width_;
+        height = height_;
+        jpegBytes = jpegBytes_;
+    }
+
+    buffer->frame.len = 0;
+    buffer->frame.width = width;
+    buffer->frame.height = height;
+    if (!replay_.empty()) {
+        const auto &image = replay_[index % replay_.size()];
+        std::memcpy(buffer->storage.data(), image.data(), image.size());
+        buffer->frame.len = image.size();
+    } else if (config_.format == PIXFORMAT_YUV422) {
+        // YUYV rows with a luma gradient sliding one step per frame.
+        std::uint8_t *out = buffer->storage.data();
+        for (std::size_t y = 0; y < config_.height; ++y) {
+            for (std::size_t x = 0; x < config_.width; ++x) {
+                *out++ = static_cast<std::uint8_t>(x + y + index * 4U);
+                *out++ = 128U;
+            }
+        }
+        buffer->frame.len = config_.width * config_.height * 2U;
+    } else {
+        // SOI, a single-component SOF0 and SOS, a frame-dependent body
+        // without marker bytes, EOI: structurally valid, not decodable.
+        const std::size_t size = jpegBytes;
+        const std::uint8_t header[kJpegHeaderBytes] = {
+            // SOI
+            0xFFU, 0xD8U,
+            // SOF0: 8-bit samples, height, width, one component
+            0xFFU, 0xC0U, 0x00U, 0x0BU, 0x08U, static_cast<std::uint8_t>(height >> 8U),
+            static_cast<std::uint8_t>(height), static_cast<std::uint8_t>(width >> 8U), static_cast<std::uint8_t>(width),
+            0x01U, 0x01U, 0x11U, 0x00U,
+            // SOS: one component, full spectral range
+            0xFFU, 0xDAU, 0x00U, 0x08U, 0x01U, 0x01U, 0x00U, 0x00U, 0x3FU, 0x00U};
+        std::uint8_t *out = buffer->storage.data();
+        std::memcpy(out, header, sizeof(header));
+        for (std::size_t i = sizeof(header); i + 2 < size; ++i) {
+            out[i] = static_cast<std::uint8_t>((i * 31U + index) % 0xFFU);
+        }
+        out[size - 2] = 0xFFU;
+        out[size - 1] = 0xD9U;
+        buffer->frame.len = size;
+    }
+    return &buffer->frame;
+}
+
+void SyntheticFrameSource::release(camera_fb_t *frame) {
+    {
+        std::scoped_lock lock(mutex_);
+        for (auto &entry : buffers_) {
+            if (&entry->frame == frame && entry->inUse) {
+                entry->inUse = false;
+                --inUse_;
+                break;
+            }
+        }
+    }
+    bufferReleased_.notify_one();
+}
+
+bool SyntheticFrameSource::applySettings(framesize_t frameSize, int jpegQuality) {
+    std::size_t width = 0;
+    std::size_t height = 0;
+    if (!replay_.empty() || config_.format != PIXFORMAT_JPEG || !frameDimensions(frameSize, width, height) ||
+        jpegQuality < 0 || jpegQuality >= kJpegQualityLevels) {
+        return false;
+    }
+    const double pixels = static_cast<double>(width * height) / static_cast<double>(config_.width * config_.height);
+    const double quality = static_cast<double>(kJpegQualityLevels - jpegQuality) /
+                           static_cast<double>(kJpegQualityLevels - std::clamp(config_.jpegQuality, 0, kJpegQualityLevels - 1));
+    const auto bytes = static_cast<std::size_t>(static_cast<double>(config_.jpegBytes) * pixels * quality);
+    std::scoped_lock lock(mutex_);
+    width_ = width;
+    height_ = height;
+    jpegBytes_ = std::clamp(bytes, kMinimumJpegBytes, capacity_);
+    return true;
+}
+
+std::uint64_t SyntheticFrameSource::framesProduced() const {
+    std::scoped_lock lock(mutex_);
+    return produced_;
+}
+
+std::size_t SyntheticFrameSource::buffersInUse() const {
+    std::scoped_lock lock(mutex_);
+    return inUse_;
+}
+
+} // namespace minitrain
+
+#endif
@@ -1,47 +1,81 @@
 #include "minitrain/telemetry.hpp"
 
-#include <numeric>
+#include <algorithm>
 
 namespace minitrain {
 
-TelemetryAggregator::TelemetryAggregator(std::size_t windowSize) : windowSize_{windowSize} {
-    samples_.reserve(windowSize_);
+void TelemetryAggregator::RunningSum::add(double value) {
+    const double corrected = value - compensation_;
+    const double next = sum_ + corrected;
+    compensation_ = (next - sum_) - corrected;
+    sum_ = next;
+}
+
+void TelemetryAggregator::RunningSum::reset() {
+    sum_ = 0.0;
+    compensation_ = 0.0;
+}
+
+TelemetryAggregator::TelemetryAggregator(std::size_t windowSize, std::size_t historyCapacity)
+    : window_(std::max<std::size_t>(1, windowSize)),
+      history_{historyCapacity == 0 ? std::max<std::size_t>(1, windowSize) : historyCapacity} {}
+
+void TelemetryAggregator::accumulate(const WindowEntry &entry, double sign) {
+    speedSum_.add(sign * entry.speedMetersPerSecond);
+    currentSum_.add(sign * entry.motorCurrentAmps);
+    voltageSum_.add(sign * entry.batteryVoltage);
+    temperatureSum_.add(sign * entry.temperatureCelsius);
+    appliedSpeedSum_.add(sign * entry.appliedSpeedMetersPerSecond);
+    failSafeProgressSum_.add(sign * entry.failSafeProgress);
 }
 
 void TelemetryAggregator::addSample(const TelemetrySample &sample) {
-    if (samples_.size() == windowSize_) {
-        samples_.erase(samples_.begin());
+    WindowEntry entry{};
+    entry.speedMetersPerSecond = sample.speedMetersPerSecond;
+    entry.motorCurrentAmps = sample.motorCurrentAmps;
+    entry.batteryVoltage = sample.batteryVoltage;
+    entry.temperatureCelsius = sample.temperatureCelsius;
+    entry.appliedSpeedMetersPerSecond = sample.appliedSpeedMetersPerSecond;
+    entry.failSafeProgress = sample.failSafeProgress;
+    entry.failSafeActive = sample.failSafeActive;
+    const std::size_t capacity = window_.size();
+    if (count_ == capacity) {
+        const auto &evicted = window_[head_];
+        accumulate(evicted, -1.0);
+        if (evicted.failSafeActive) {
+            --failSafeCount_;
+        }
+        window_[head_] = entry;
+        head_ = (head_ + 1) % capacity;
+    } else {
+        window_[(head_ + count_) % capacity] = entry;
+        ++count_;
     }
-    samples_.push_back(sample);
+
+    accumulate(entry, 1.0);
+    if (entry.failSafeActive) {
+        ++failSafeCount_;
+    }
+    latest_ = sample;
+    history_.append(sample);
 }
 
 std::optional<TelemetrySample> TelemetryAggregator::average() const {
-    if (samples_.empty()) {
+    if (count_ == 0) {
         return std::nullopt;
     }
 
-    TelemetrySample result{};
-    bool anyFailSafe = false;
-    float failSafeProgressAccum = 0.0F;
-    for (const auto &sample : samples_) {
-        result.speedMetersPerSecond += sample.speedMetersPerSecond;
-        result.motorCurrentAmps += sample.motorCurrentAmps;
-        result.batteryVoltage += sample.batteryVoltage;
-        result.temperatureCelsius += sample.temperatureCelsius;
-        result.appliedSpeedMetersPerSecond += sample.appliedSpeedMetersPerSecond;
-        anyFailSafe = anyFailSafe || sample.failSafeActive;
-        failSafeProgressAccum += sample.failSafeProgress;
-    }
+    const double size = static_cast<double>(count_);
+    const auto &latest = latest_;
 
-    const float size = static_cast<float>(samples_.size());
-    result.speedMetersPerSecond /= size;
-    result.motorCurrentAmps /= size;
-    result.batteryVoltage /= size;
-    result.temperatureCelsius /= size;
-    result.appliedSpeedMetersPerSecond /= size;
-    result.failSafeProgress = failSafeProgressAccum / size;
-    result.failSafeActive = anyFailSafe;
-    const auto &latest = samples_.back();
+    TelemetrySample result{};
+    result.speedMetersPerSecond = static_cast<float>(speedSum_.value() / size);
+    result.motorCurrentAmps = static_cast<float>(currentSum_.value() / size);
+    result.batteryVoltage = static_cast<float>(voltageSum_.value() / size);
+    result.temperatureCelsius = static_cast<float>(temperatureSum_.value() / size);
+    result.appliedSpeedMetersPerSecond = static_cast<float>(appliedSpeedSum_.value() / size);
+    result.failSafeProgress = static_cast<float>(failSafeProgressSum_.value() / size);
+    result.failSafeActive = failSafeCount_ > 0;
     result.sessionId = latest.sessionId;
     result.sequence = latest.sequence;
     result.commandTimestamp = latest.commandTimestamp;
@@ -57,12 +91,19 @@ std::optional<TelemetrySample> TelemetryAggregator::average() const {
     return result;
 }
 
-std::vector<TelemetrySample> TelemetryAggregator::history() const {
-    return samples_;
-}
+TelemetryHistory::View TelemetryAggregator::history() const { return history_.view(); }
 
 void TelemetryAggregator::clear() {
-    samples_.clear();
+    head_ = 0;
+    count_ = 0;
+    history_.clear();
+    speedSum_.reset();
+    currentSum_.reset();
+    voltageSum_.reset();
+    temperatureSum_.reset();
+    appliedSpeedSum_.reset();
+    failSafeProgressSum_.reset();
+    failSafeCount_ = 0;
 }
 
 } // namespace minitrain
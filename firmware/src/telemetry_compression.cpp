@@ -0,0 +1,183 @@
+#include "minitrain/telemetry_compression.hpp"
+
+#include "byte_order.hpp"
+#include "gorilla_codec.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint8_t kBlockVersion = 1;
+constexpr std::size_t kBlockHeaderSize = 8;
+
+using detail::readDeltaOfDelta;
+using detail::readFloat;
+using detail::writeDeltaOfDelta;
+using detail::writeFloat;
+
+std::array<float *, TelemetryPredictor::kFloatFields> floatFields(TelemetrySample &sample) {
+    return {&sample.speedMetersPerSecond, &sample.motorCurrentAmps,           &sample.batteryVoltage,
+            &sample.temperatureCelsius,   &sample.appliedSpeedMetersPerSecond, &sample.failSafeProgress};
+}
+
+bool sameMetadata(const TelemetrySample &a, const TelemetrySample &b) {
+    return a.failSafeActive == b.failSafeActive && a.lightsTelemetryOnly == b.lightsTelemetryOnly &&
+           a.source == b.source && a.appliedDirection == b.appliedDirection && a.activeCab == b.activeCab &&
+           a.lightsState == b.lightsState && a.lightsSource == b.lightsSource &&
+           a.lightsOverrideMask == b.lightsOverrideMask && a.sessionId == b.sessionId;
+}
+
+std::uint64_t encodeDirection(Direction direction) {
+    switch (direction) {
+    case Direction::Forward:
+        return 1U;
+    case Direction::Reverse:
+        return 2U;
+    case Direction::Neutral:
+        break;
+    }
+    return 0U;
+}
+
+Direction decodeDirection(std::uint64_t code) {
+    switch (code) {
+    case 1U:
+        return Direction::Forward;
+    case 2U:
+        return Direction::Reverse;
+    default:
+        return Direction::Neutral;
+    }
+}
+
+void writeMetadata(BitWriter &writer, TelemetrySample &previous, const TelemetrySample &sample) {
+    if (sameMetadata(previous, sample)) {
+        writer.write(0b0U, 1);
+        return;
+    }
+    writer.write(0b1U, 1);
+    writer.writeBit(sample.failSafeActive);
+    writer.writeBit(sample.lightsTelemetryOnly);
+    writer.writeBit(sample.source == TelemetrySource::Aggregated);
+    writer.write(encodeDirection(sample.appliedDirection), 2);
+    writer.write(static_cast<std::uint64_t>(sample.activeCab), 2);
+    writer.write(static_cast<std::uint64_t>(sample.lightsState), 3);
+    writer.write(static_cast<std::uint64_t>(sample.lightsSource), 2);
+    writer.write(sample.lightsOverrideMask, 8);
+    const bool sessionChanged = previous.sessionId != sample.sessionId;
+    writer.writeBit(sessionChanged);
+    if (sessionChanged) {
+        for (const auto byte : sample.sessionId) {
+            writer.write(byte, 8);
+        }
+    }
+    previous = sample;
+}
+
+void readMetadata(BitReader &reader, TelemetrySample &previous) {
+    if (!reader.readBit()) {
+        return;
+    }
+    previous.failSafeActive = reader.readBit();
+    previous.lightsTelemetryOnly = reader.readBit();
+    previous.source = reader.readBit() ? TelemetrySource::Aggregated : TelemetrySource::Instantaneous;
+    previous.appliedDirection = decodeDirection(reader.read(2));
+    previous.activeCab = static_cast<ActiveCab>(reader.read(2));
+    previous.lightsState = static_cast<LightsState>(reader.read(3));
+    previous.lightsSource = static_cast<LightsSource>(reader.read(2));
+    previous.lightsOverrideMask = static_cast<std::uint8_t>(reader.read(8));
+    if (reader.readBit()) {
+        for (auto &byte : previous.sessionId) {
+            byte = static_cast<std::uint8_t>(reader.read(8));
+        }
+    }
+}
+} // namespace
+
+void TelemetryCompressor::append(const TelemetrySample &sample, std::uint64_t timestampMillis) {
+    writeDeltaOfDelta(writer_, predictor_.timestamp, timestampMillis);
+    const float fields[TelemetryPredictor::kFloatFields] = {
+        sample.speedMetersPerSecond, sample.motorCurrentAmps,           sample.batteryVoltage,
+        sample.temperatureCelsius,   sample.appliedSpeedMetersPerSecond, sample.failSafeProgress};
+    for (std::size_t i = 0; i < TelemetryPredictor::kFloatFields; ++i) {
+        writeFloat(writer_, predictor_.floats[i], fields[i]);
+    }
+    writeDeltaOfDelta(writer_, predictor_.sequence, sample.sequence);
+    writeDeltaOfDelta(writer_, predictor_.commandTimestamp, sample.commandTimestamp);
+    writeDeltaOfDelta(writer_, predictor_.failSafeElapsed, sample.failSafeElapsedMillis);
+    writeMetadata(writer_, predictor_.metadata, sample);
+    ++count_;
+}
+
+std::vector<std::uint8_t> TelemetryCompressor::finish() {
+    std::vector<std::uint8_t> block(kBlockHeaderSize + writer_.bytes().size());
+    std::uint8_t *out = block.data();
+    *out++ = kBlockVersion;
+    *out++ = 0U;
+    detail::putLittle16(out, 0U);
+    detail::putLittle32(out, count_);
+    if (!writer_.bytes().empty()) {
+        std::memcpy(out, writer_.bytes().data(), writer_.bytes().size());
+    }
+    writer_.clear();
+    predictor_ = TelemetryPredictor{};
+    count_ = 0;
+    return block;
+}
+
+void TelemetryCompressor::reserve(std::size_t bytes) { writer_.reserve(bytes); }
+
+std::size_t TelemetryCompressor::sizeBytes() const { return kBlockHeaderSize + writer_.bytes().size(); }
+
+TelemetryDecompressor::TelemetryDecompressor(const std::uint8_t *data, std::size_t size)
+    : reader_{data + (size >= kBlockHeaderSize ? kBlockHeaderSize : size),
+              size >= kBlockHeaderSize ? size - kBlockHeaderSize : 0} {
+    if (size < kBlockHeaderSize || data[0] != kBlockVersion) {
+        throw std::invalid_argument("Invalid compressed telemetry block header");
+    }
+    const std::uint8_t *in = data + 4;
+    count_ = detail::getLittle32(in);
+}
+
+std::optional<TimedTelemetrySample> TelemetryDecompressor::next() {
+    if (decoded_ == count_) {
+        return std::nullopt;
+    }
+    TimedTelemetrySample result{};
+    result.timestampMillis = readDeltaOfDelta(reader_, predictor_.timestamp);
+    const auto fields = floatFields(result.sample);
+    for (std::size_t i = 0; i < fields.size(); ++i) {
+        *fields[i] = readFloat(reader_, predictor_.floats[i]);
+    }
+    result.sample.sequence = static_cast<std::uint32_t>(readDeltaOfDelta(reader_, predictor_.sequence));
+    result.sample.commandTimestamp = readDeltaOfDelta(reader_, predictor_.commandTimestamp);
+    result.sample.failSafeElapsedMillis = static_cast<std::uint32_t>(readDeltaOfDelta(reader_, predictor_.failSafeElapsed));
+    readMetadata(reader_, predictor_.metadata);
+
+    const auto &metadata = predictor_.metadata;
+    result.sample.failSafeActive = metadata.failSafeActive;
+    result.sample.lightsTelemetryOnly = metadata.lightsTelemetryOnly;
+    result.sample.source = metadata.source;
+    result.sample.appliedDirection = metadata.appliedDirection;
+    result.sample.activeCab = metadata.activeCab;
+    result.sample.lightsState = metadata.lightsState;
+    result.sample.lightsSource = metadata.lightsSource;
+    result.sample.lightsOverrideMask = metadata.lightsOverrideMask;
+    result.sample.sessionId = metadata.sessionId;
+    ++decoded_;
+    return result;
+}
+
+std::vector<TimedTelemetrySample> TelemetryDecompressor::decodeAll(const std::vector<std::uint8_t> &block) {
+    TelemetryDecompressor decompressor{block};
+    std::vector<TimedTelemetrySample> samples;
+    samples.reserve(decompressor.sampleCount());
+    while (auto sample = decompressor.next()) {
+        samples.push_back(*sample);
+    }
+    return samples;
+}
+
+} // namespace minitrain
@@ -0,0 +1,482 @@
+#include "minitrain/telemetry_export.hpp"
+
+#include "byte_order.hpp"
+#include "gorilla_codec.hpp"
+#include "parallel_for.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#ifndef ESP_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint32_t kExportMagic = 0x5843544DU; // "MTCX"
+constexpr std::uint16_t kExportVersion = 1;
+constexpr std::size_t kFileHeaderSize = 8;
+constexpr std::size_t kTrailerSize = 16;
+constexpr std::size_t kChunkEntrySize = 8 + 4 + 8 + 8;
+
+struct ColumnInfo {
+    const char *name;
+    ExportColumnType type;
+};
+
+constexpr std::array<ColumnInfo, kExportColumnCount> kColumns{{
+    {"timestamp_ms", ExportColumnType::Unsigned},
+    {"speed_mps", ExportColumnType::Float32},
+    {"motor_current_a", ExportColumnType::Float32},
+    {"battery_voltage_v", ExportColumnType::Float32},
+    {"temperature_c", ExportColumnType::Float32},
+    {"applied_speed_mps", ExportColumnType::Float32},
+    {"fail_safe_progress", ExportColumnType::Float32},
+    {"fail_safe_active", ExportColumnType::Unsigned},
+    {"fail_safe_elapsed_ms", ExportColumnType::Unsigned},
+    {"sequence", ExportColumnType::Unsigned},
+    {"command_timestamp", ExportColumnType::Unsigned},
+    {"lights_state", ExportColumnType::Unsigned},
+    {"lights_source", ExportColumnType::Unsigned},
+    {"active_cab", ExportColumnType::Unsigned},
+    {"lights_override_mask", ExportColumnType::Unsigned},
+    {"lights_telemetry_only", ExportColumnType::Unsigned},
+    {"direction", ExportColumnType::Unsigned},
+    {"source", ExportColumnType::Unsigned},
+    {"session_id_high", ExportColumnType::Unsigned},
+    {"session_id_low", ExportColumnType::Unsigned},
+}};
+
+std::uint64_t sessionHalf(const std::array<std::uint8_t, 16> &sessionId, std::size_t first) {
+    std::uint64_t value = 0;
+    for (std::size_t i = first; i < first + 8U; ++i) {
+        value = (value << 8U) | sessionId[i];
+    }
+    return value;
+}
+
+std::uint64_t directionCode(Direction direction) {
+    switch (direction) {
+    case Direction::Forward:
+        return 1U;
+    case Direction::Reverse:
+        return 2U;
+    case Direction::Neutral:
+        break;
+    }
+    return 0U;
+}
+
+// Raw column value: float bits for Float32 columns, the integer otherwise.
+std::uint64_t columnValue(ExportColumn column, const TelemetrySample &sample, std::uint64_t timestampMillis) {
+    switch (column) {
+    case ExportColumn::TimestampMillis:
+        return timestampMillis;
+    case ExportColumn::Speed:
+        return detail::floatBits(sample.speedMetersPerSecond);
+    case ExportColumn::MotorCurrent:
+        return detail::floatBits(sample.motorCurrentAmps);
+    case ExportColumn::BatteryVoltage:
+        return detail::floatBits(sample.batteryVoltage);
+    case ExportColumn::Temperature:
+        return detail::floatBits(sample.temperatureCelsius);
+    case ExportColumn::AppliedSpeed:
+        return detail::floatBits(sample.appliedSpeedMetersPerSecond);
+    case ExportColumn::FailSafeProgress:
+        return detail::floatBits(sample.failSafeProgress);
+    case ExportColumn::FailSafeActive:
+        return sample.failSafeActive ? 1U : 0U;
+    case ExportColumn::FailSafeElapsedMillis:
+        return sample.failSafeElapsedMillis;
+    case ExportColumn::Sequence:
+        return sample.sequence;
+    case ExportColumn::CommandTimestamp:
+        return sample.commandTimestamp;
+    case ExportColumn::LightsState:
+        return static_cast<std::uint64_t>(sample.lightsState);
+    case ExportColumn::LightsSource:
+        return static_cast<std::uint64_t>(sample.lightsSource);
+    case ExportColumn::ActiveCab:
+        return static_cast<std::uint64_t>(sample.activeCab);
+    case ExportColumn::LightsOverrideMask:
+        return sample.lightsOverrideMask;
+    case ExportColumn::LightsTelemetryOnly:
+        return sample.lightsTelemetryOnly ? 1U : 0U;
+    case ExportColumn::Direction:
+        return directionCode(sample.appliedDirection);
+    case ExportColumn::Source:
+        return static_cast<std::uint64_t>(sample.source);
+    case ExportColumn::SessionIdHigh:
+        return sessionHalf(sample.sessionId, 0);
+    case ExportColumn::SessionIdLow:
+        return sessionHalf(sample.sessionId, 8);
+    case ExportColumn::Count:
+        break;
+    }
+    return 0U;
+}
+
+double toDouble(ExportColumnType type, std::uint64_t raw) {
+    if (type == ExportColumnType::Float32) {
+        return static_cast<double>(detail::bitsToFloat(static_cast<std::uint32_t>(raw)));
+    }
+    return static_cast<double>(raw);
+}
+
+void putDouble(std::vector<std::uint8_t> &out, double value) {
+    std::uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    std::uint8_t buffer[8];
+    std::uint8_t *cursor = buffer;
+    detail::putLittle64(cursor, bits);
+    out.insert(out.end(), buffer, buffer + sizeof(buffer));
+}
+
+template <typename T>
+void putInteger(std::vector<std::uint8_t> &out, T value) {
+    for (std::size_t i = 0; i < sizeof(T); ++i) {
+        out.push_back(static_cast<std::uint8_t>(static_cast<std::uint64_t>(value) >> (8U * i)));
+    }
+}
+
+} // namespace
+
+const char *exportColumnName(ExportColumn column) { return kColumns[static_cast<std::size_t>(column)].name; }
+
+ExportColumnType exportColumnType(ExportColumn column) { return kColumns[static_cast<std::size_t>(column)].type; }
+
+std::unique_ptr<TelemetryExportWriter> TelemetryExportWriter::create(const std::string &path, std::size_t blockRows) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+        return nullptr;
+    }
+    std::unique_ptr<TelemetryExportWriter> writer(new TelemetryExportWriter(std::move(file), blockRows));
+    std::vector<std::uint8_t> header;
+    putInteger(header, kExportMagic);
+    putInteger(header, kExportVersion);
+    putInteger(header, std::uint16_t{0});
+    writer->file_.write(reinterpret_cast<const char *>(header.data()), static_cast<std::streamsize>(header.size()));
+    writer->offset_ = header.size();
+    return writer;
+}
+
+TelemetryExportWriter::TelemetryExportWriter(std::ofstream file, std::size_t blockRows)
+    : file_{std::move(file)}, blockRows_{std::max<std::size_t>(1, blockRows)} {
+    for (auto &column : pending_) {
+        column.reserve(blockRows_);
+    }
+}
+
+TelemetryExportWriter::~TelemetryExportWriter() { close(); }
+
+void TelemetryExportWriter::append(const TelemetrySample &sample, std::uint64_t timestampMillis) {
+    if (closed_) {
+        return;
+    }
+    for (std::size_t column = 0; column < kExportColumnCount; ++column) {
+        pending_[column].push_back(columnValue(static_cast<ExportColumn>(column), sample, timestampMillis));
+    }
+    ++rowCount_;
+    if (pending_[0].size() == blockRows_) {
+        flushBlock();
+    }
+}
+
+void TelemetryExportWriter::flushBlock() {
+    const std::size_t rows = pending_[0].size();
+    if (rows == 0) {
+        return;
+    }
+    blockSizes_.push_back(static_cast<std::uint32_t>(rows));
+    for (std::size_t column = 0; column < kExportColumnCount; ++column) {
+        const auto type = kColumns[column].type;
+        BitWriter writer;
+        TelemetryPredictor::IntegerChannel integer{};
+        TelemetryPredictor::FloatChannel floating{};
+        ChunkEntry entry{};
+        entry.offset = offset_;
+        entry.min = std::numeric_limits<double>::infinity();
+        entry.max = -std::numeric_limits<double>::infinity();
+        for (const auto raw : pending_[column]) {
+            if (type == ExportColumnType::Float32) {
+                detail::writeFloat(writer, floating, detail::bitsToFloat(static_cast<std::uint32_t>(raw)));
+            } else {
+                detail::writeDeltaOfDelta(writer, integer, raw);
+            }
+            const double value = toDouble(type, raw);
+            if (!std::isnan(value)) {
+                entry.min = std::min(entry.min, value);
+                entry.max = std::max(entry.max, value);
+            }
+        }
+        entry.size = static_cast<std::uint32_t>(writer.bytes().size());
+        file_.write(reinterpret_cast<const char *>(writer.bytes().data()), static_cast<std::streamsize>(entry.size));
+        offset_ += entry.size;
+        chunks_.push_back(entry);
+        pending_[column].clear();
+    }
+}
+
+bool TelemetryExportWriter::close() {
+    if (closed_) {
+        return static_cast<bool>(file_);
+    }
+    flushBlock();
+    closed_ = true;
+
+    std::vector<std::uint8_t> footer;
+    putInteger(footer, static_cast<std::uint16_t>(kExportColumnCount));
+    putInteger(footer, std::uint16_t{0});
+    putInteger(footer, static_cast<std::uint32_t>(blockSizes_.size()));
+    putInteger(footer, rowCount_);
+    for (const auto &column : kColumns) {
+        const auto length = std::strlen(column.name);
+        footer.push_back(static_cast<std::uint8_t>(column.type));
+        footer.push_back(static_cast<std::uint8_t>(length));
+        footer.insert(footer.end(), column.name, column.name + length);
+    }
+    for (std::size_t block = 0; block < blockSizes_.size(); ++block) {
+        putInteger(footer, blockSizes_[block]);
+        for (std::size_t column = 0; column < kExportColumnCount; ++column) {
+            const auto &entry = chunks_[block * kExportColumnCount + column];
+            putInteger(footer, entry.offset);
+            putInteger(footer, entry.size);
+            putDouble(footer, entry.min);
+            putDouble(footer, entry.max);
+        }
+    }
+    putInteger(footer, offset_);
+    putInteger(footer, kExportMagic);
+    putInteger(footer, std::uint32_t{0});
+    file_.write(reinterpret_cast<const char *>(footer.data()), static_cast<std::streamsize>(footer.size()));
+    file_.close();
+    return !file_.fail();
+}
+
+#ifndef ESP_PLATFORM
+std::unique_ptr<TelemetryExportReader> TelemetryExportReader::open(const std::string &path) {
+    const int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return nullptr;
+    }
+    struct stat info {};
+    if (::fstat(fd, &info) != 0 || static_cast<std::size_t>(info.st_size) < kFileHeaderSize + kTrailerSize) {
+        ::close(fd);
+        return nullptr;
+    }
+    const auto size = static_cast<std::size_t>(info.st_size);
+    void *mapping = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED) {
+        ::close(fd);
+        return nullptr;
+    }
+    std::unique_ptr<TelemetryExportReader> reader(new TelemetryExportReader());
+    reader->mapping_ = static_cast<const std::uint8_t *>(mapping);
+    reader->size_ = size;
+    reader->fd_ = fd;
+    if (!reader->parse()) {
+        return nullptr;
+    }
+    return reader;
+}
+
+TelemetryExportReader::~TelemetryExportReader() {
+    if (mapping_ != nullptr) {
+        ::munmap(const_cast<std::uint8_t *>(mapping_), size_);
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+    }
+}
+
+bool TelemetryExportReader::parse() {
+    const std::uint8_t *in = mapping_;
+    if (detail::getLittle32(in) != kExportMagic || detail::getLittle16(in) != kExportVersion) {
+        return false;
+    }
+    const std::uint8_t *trailer = mapping_ + size_ - kTrailerSize;
+    const std::uint64_t footerOffset = detail::getLittle64(trailer);
+    if (detail::getLittle32(trailer) != kExportMagic || footerOffset < kFileHeaderSize ||
+        footerOffset > size_ - kTrailerSize || size_ - kTrailerSize - footerOffset < 16U) {
+        return false;
+    }
+    const std::uint8_t *const footerEnd = mapping_ + size_ - kTrailerSize;
+    in = mapping_ + footerOffset;
+    fileColumns_ = detail::getLittle16(in);
+    in += 2;
+    const std::uint32_t blocks = detail::getLittle32(in);
+    rowCount_ = detail::getLittle64(in);
+
+    for (std::size_t column = 0; column < fileColumns_; ++column) {
+        if (footerEnd - in < 2) {
+            return false;
+        }
+        const auto type = static_cast<ExportColumnType>(*in++);
+        const std::size_t length = *in++;
+        if (static_cast<std::size_t>(footerEnd - in) < length) {
+            return false;
+        }
+        const std::string name(reinterpret_cast<const char *>(in), length);
+        in += length;
+        for (std::size_t known = 0; known < kExportColumnCount; ++known) {
+            if (name == kColumns[known].name) {
+                columnSlots_[known] = column;
+                columnTypes_[known] = type;
+            }
+        }
+    }
+
+    const std::size_t blockEntrySize = 4U + fileColumns_ * kChunkEntrySize;
+    if (static_cast<std::size_t>(footerEnd - in) != blocks * blockEntrySize) {
+        return false;
+    }
+    std::uint64_t rows = 0;
+    blockRows_.reserve(blocks);
+    chunks_.reserve(static_cast<std::size_t>(blocks) * fileColumns_);
+    for (std::uint32_t block = 0; block < blocks; ++block) {
+        blockRows_.push_back(detail::getLittle32(in));
+        rows += blockRows_.back();
+        for (std::size_t column = 0; column < fileColumns_; ++column) {
+            const std::uint64_t offset = detail::getLittle64(in);
+            Chunk entry{};
+            entry.size = detail::getLittle32(in);
+            const std::uint64_t minBits = detail::getLittle64(in);
+            const std::uint64_t maxBits = detail::getLittle64(in);
+            std::memcpy(&entry.min, &minBits, sizeof(double));
+            std::memcpy(&entry.max, &maxBits, sizeof(double));
+            // Written so a corrupt offset near UINT64_MAX cannot wrap past the check.
+            if (offset < kFileHeaderSize || offset > footerOffset || entry.size > footerOffset - offset) {
+                return false;
+            }
+            entry.data = mapping_ + offset;
+            chunks_.push_back(entry);
+        }
+    }
+    return rows == rowCount_;
+}
+
+bool TelemetryExportReader::hasColumn(ExportColumn column) const {
+    return columnSlots_[static_cast<std::size_t>(column)].has_value();
+}
+
+const TelemetryExportReader::Chunk *TelemetryExportReader::chunk(std::size_t block, ExportColumn column) const {
+    const auto &slot = columnSlots_[static_cast<std::size_t>(column)];
+    if (!slot) {
+        return nullptr;
+    }
+    return &chunks_[block * fileColumns_ + *slot];
+}
+
+void TelemetryExportReader::decodeChunk(std::size_t block, ExportColumn column, std::vector<double> &out) const {
+    const Chunk *entry = chunk(block, column);
+    const auto type = columnTypes_[static_cast<std::size_t>(column)];
+    BitReader reader{entry->data, entry->size};
+    TelemetryPredictor::IntegerChannel integer{};
+    TelemetryPredictor::FloatChannel floating{};
+    out.resize(blockRows_[block]);
+    for (auto &value : out) {
+        if (type == ExportColumnType::Float32) {
+            value = static_cast<double>(detail::readFloat(reader, floating));
+        } else {
+            value = static_cast<double>(detail::readDeltaOfDelta(reader, integer));
+        }
+    }
+}
+
+ExportScanResult TelemetryExportReader::scan(const std::vector<ColumnRange> &predicates, unsigned threads) const {
+    struct BlockResult {
+        bool scanned{false};
+        bool firstMatched{false};
+        bool lastMatched{false};
+        std::uint64_t matched{0};
+        std::vector<TimeInterval> intervals;
+    };
+    std::vector<BlockResult> results(blockCount());
+    const bool satisfiable =
+        hasColumn(ExportColumn::TimestampMillis) &&
+        std::all_of(predicates.begin(), predicates.end(),
+                    [this](const ColumnRange &predicate) { return hasColumn(predicate.column); });
+
+    if (satisfiable) {
+        detail::parallelFor(blockCount(), threads, [&](std::size_t block) {
+            for (const auto &predicate : predicates) {
+                const Chunk *entry = chunk(block, predicate.column);
+                if (entry->max < predicate.min || entry->min > predicate.max) {
+                    return;
+                }
+            }
+            auto &result = results[block];
+            result.scanned = true;
+            std::vector<double> timestamps;
+            decodeChunk(block, ExportColumn::TimestampMillis, timestamps);
+            std::vector<bool> matches(timestamps.size(), true);
+            std::vector<double> values;
+            for (const auto &predicate : predicates) {
+                decodeChunk(block, predicate.column, values);
+                for (std::size_t row = 0; row < values.size(); ++row) {
+                    matches[row] = matches[row] && values[row] >= predicate.min && values[row] <= predicate.max;
+                }
+            }
+            for (std::size_t row = 0; row < matches.size(); ++row) {
+                if (!matches[row]) {
+                    continue;
+                }
+                const auto timestamp = static_cast<std::uint64_t>(timestamps[row]);
+                if (row > 0 && matches[row - 1]) {
+                    result.intervals.back().endMillis = timestamp;
+                } else {
+                    result.intervals.push_back({timestamp, timestamp});
+                }
+                ++result.matched;
+            }
+            result.firstMatched = !matches.empty() && matches.front();
+            result.lastMatched = !matches.empty() && matches.back();
+        });
+    }
+
+    ExportScanResult scan{};
+    bool previousEndedInMatch = false;
+    for (auto &result : results) {
+        if (!result.scanned) {
+            ++scan.blocksSkipped;
+            previousEndedInMatch = false;
+            continue;
+        }
+        ++scan.blocksScanned;
+        scan.matchedRows += result.matched;
+        auto begin = result.intervals.begin();
+        if (previousEndedInMatch && result.firstMatched && begin != result.intervals.end()) {
+            scan.intervals.back().endMillis = begin->endMillis;
+            ++begin;
+        }
+        scan.intervals.insert(scan.intervals.end(), begin, result.intervals.end());
+        previousEndedInMatch = result.lastMatched;
+    }
+    return scan;
+}
+
+std::vector<double> TelemetryExportReader::readColumn(ExportColumn column, unsigned threads) const {
+    if (!hasColumn(column)) {
+        return {};
+    }
+    std::vector<std::size_t> firstRow(blockCount() + 1, 0);
+    for (std::size_t block = 0; block < blockCount(); ++block) {
+        firstRow[block + 1] = firstRow[block] + blockRows_[block];
+    }
+    std::vector<double> values(firstRow.back());
+    detail::parallelFor(blockCount(), threads, [&](std::size_t block) {
+        std::vector<double> decoded;
+        decodeChunk(block, column, decoded);
+        std::copy(decoded.begin(), decoded.end(), values.begin() + static_cast<std::ptrdiff_t>(firstRow[block]));
+    });
+    return values;
+}
+#endif
+
+} // namespace minitrain
@@ -0,0 +1,201 @@
+#include "minitrain/telemetry_history.hpp"
+
+#include "minitrain/telemetry.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint8_t kFlagFailSafe = 0x01U;
+constexpr std::uint8_t kFlagAggregated = 0x02U;
+constexpr std::uint8_t kDirectionShift = 2U;
+constexpr std::uint8_t kDirectionMask = 0x03U;
+
+template <typename T>
+T quantise(float value, float scale) {
+    const float scaled = std::round(value * scale);
+    if (std::isnan(scaled)) {
+        return T{0};
+    }
+    const float lowest = static_cast<float>(std::numeric_limits<T>::min());
+    const float highest = static_cast<float>(std::numeric_limits<T>::max());
+    return static_cast<T>(std::clamp(scaled, lowest, highest));
+}
+
+std::uint8_t encodeDirection(Direction direction) {
+    switch (direction) {
+    case Direction::Forward:
+        return 1U;
+    case Direction::Reverse:
+        return 2U;
+    case Direction::Neutral:
+        break;
+    }
+    return 0U;
+}
+
+Direction decodeDirection(std::uint8_t code) {
+    switch (code) {
+    case 1U:
+        return Direction::Forward;
+    case 2U:
+        return Direction::Reverse;
+    default:
+        return Direction::Neutral;
+    }
+}
+} // namespace
+
+TelemetryHistory::TelemetryHistory(std::size_t capacity, std::size_t runCapacity) {
+    const std::size_t samples = std::max<std::size_t>(1, capacity);
+    speedMillimeters_.resize(samples);
+    appliedSpeedMillimeters_.resize(samples);
+    currentMilliamps_.resize(samples);
+    temperatureCentidegrees_.resize(samples);
+    voltageMillivolts_.resize(samples);
+    failSafeProgress_.resize(samples);
+    failSafeElapsedMillis_.resize(samples);
+    sequence_.resize(samples);
+    commandTimestampOffset_.resize(samples);
+    flags_.resize(samples);
+    runs_.resize(runCapacity == 0 ? std::max<std::size_t>(4, samples / 16) : runCapacity);
+}
+
+bool TelemetryHistory::fitsRun(const MetadataRun &run, const TelemetrySample &sample) const {
+    return run.sessionId == sample.sessionId && run.lightsState == sample.lightsState &&
+           run.lightsSource == sample.lightsSource && run.activeCab == sample.activeCab &&
+           run.lightsOverrideMask == sample.lightsOverrideMask &&
+           run.lightsTelemetryOnly == sample.lightsTelemetryOnly &&
+           sample.commandTimestamp >= run.commandTimestampBase &&
+           sample.commandTimestamp - run.commandTimestampBase <= std::numeric_limits<std::uint32_t>::max();
+}
+
+void TelemetryHistory::pushRun(const TelemetrySample &sample) {
+    // Out of run slots: drop samples until the oldest run has been released.
+    while (runCount_ == runs_.size()) {
+        dropOldestSample();
+    }
+
+    MetadataRun run{};
+    run.firstSample = firstIndex_ + count_;
+    run.commandTimestampBase = sample.commandTimestamp;
+    run.sessionId = sample.sessionId;
+    run.lightsState = sample.lightsState;
+    run.lightsSource = sample.lightsSource;
+    run.activeCab = sample.activeCab;
+    run.lightsOverrideMask = sample.lightsOverrideMask;
+    run.lightsTelemetryOnly = sample.lightsTelemetryOnly;
+    runs_[(runHead_ + runCount_) % runs_.size()] = run;
+    ++runCount_;
+}
+
+void TelemetryHistory::dropOldestSample() {
+    head_ = (head_ + 1) % capacity();
+    --count_;
+    ++firstIndex_;
+    while (runCount_ > 1 && runs_[(runHead_ + 1) % runs_.size()].firstSample <= firstIndex_) {
+        runHead_ = (runHead_ + 1) % runs_.size();
+        --runCount_;
+    }
+}
+
+void TelemetryHistory::append(const TelemetrySample &sample) {
+    if (count_ == capacity()) {
+        dropOldestSample();
+    }
+    if (runCount_ == 0 || count_ == 0 || !fitsRun(runs_[(runHead_ + runCount_ - 1) % runs_.size()], sample)) {
+        if (count_ == 0) {
+            runCount_ = 0;
+        }
+        pushRun(sample);
+    }
+    const auto &run = runs_[(runHead_ + runCount_ - 1) % runs_.size()];
+
+    const std::size_t slot = (head_ + count_) % capacity();
+    speedMillimeters_[slot] = quantise<std::int16_t>(sample.speedMetersPerSecond, 1000.0F);
+    appliedSpeedMillimeters_[slot] = quantise<std::int16_t>(sample.appliedSpeedMetersPerSecond, 1000.0F);
+    currentMilliamps_[slot] = quantise<std::int16_t>(sample.motorCurrentAmps, 1000.0F);
+    temperatureCentidegrees_[slot] = quantise<std::int16_t>(sample.temperatureCelsius, 100.0F);
+    voltageMillivolts_[slot] = quantise<std::uint16_t>(sample.batteryVoltage, 1000.0F);
+    failSafeProgress_[slot] = quantise<std::uint16_t>(sample.failSafeProgress, 65535.0F);
+    failSafeElapsedMillis_[slot] = sample.failSafeElapsedMillis;
+    sequence_[slot] = sample.sequence;
+    commandTimestampOffset_[slot] = static_cast<std::uint32_t>(sample.commandTimestamp - run.commandTimestampBase);
+
+    std::uint8_t flags = 0U;
+    if (sample.failSafeActive) {
+        flags |= kFlagFailSafe;
+    }
+    if (sample.source == TelemetrySource::Aggregated) {
+        flags |= kFlagAggregated;
+    }
+    flags |= static_cast<std::uint8_t>(encodeDirection(sample.appliedDirection) << kDirectionShift);
+    flags_[slot] = flags;
+    ++count_;
+}
+
+void TelemetryHistory::clear() {
+    head_ = 0;
+    count_ = 0;
+    runHead_ = 0;
+    runCount_ = 0;
+}
+
+const TelemetryHistory::MetadataRun &TelemetryHistory::runFor(std::uint64_t absoluteIndex) const {
+    // Runs are sorted by first sample; binary search over the ring.
+    std::size_t low = 0;
+    std::size_t high = runCount_;
+    while (high - low > 1) {
+        const std::size_t mid = (low + high) / 2;
+        if (runs_[(runHead_ + mid) % runs_.size()].firstSample <= absoluteIndex) {
+            low = mid;
+        } else {
+            high = mid;
+        }
+    }
+    return runs_[(runHead_ + low) % runs_.size()];
+}
+
+TelemetrySample TelemetryHistory::at(std::size_t index) const {
+    const std::size_t slot = (head_ + index) % capacity();
+    const auto &run = runFor(firstIndex_ + index);
+
+    TelemetrySample sample{};
+    sample.speedMetersPerSecond = static_cast<float>(speedMillimeters_[slot]) / 1000.0F;
+    sample.appliedSpeedMetersPerSecond = static_cast<float>(appliedSpeedMillimeters_[slot]) / 1000.0F;
+    sample.motorCurrentAmps = static_cast<float>(currentMilliamps_[slot]) / 1000.0F;
+    sample.temperatureCelsius = static_cast<float>(temperatureCentidegrees_[slot]) / 100.0F;
+    sample.batteryVoltage = static_cast<float>(voltageMillivolts_[slot]) / 1000.0F;
+    sample.failSafeProgress = static_cast<float>(failSafeProgress_[slot]) / 65535.0F;
+    sample.failSafeElapsedMillis = failSafeElapsedMillis_[slot];
+    sample.sequence = sequence_[slot];
+    sample.commandTimestamp = run.commandTimestampBase + commandTimestampOffset_[slot];
+
+    const std::uint8_t flags = flags_[slot];
+    sample.failSafeActive = (flags & kFlagFailSafe) != 0;
+    sample.source = (flags & kFlagAggregated) != 0 ? TelemetrySource::Aggregated : TelemetrySource::Instantaneous;
+    sample.appliedDirection = decodeDirection(static_cast<std::uint8_t>((flags >> kDirectionShift) & kDirectionMask));
+
+    sample.sessionId = run.sessionId;
+    sample.lightsState = run.lightsState;
+    sample.lightsSource = run.lightsSource;
+    sample.activeCab = run.activeCab;
+    sample.lightsOverrideMask = run.lightsOverrideMask;
+    sample.lightsTelemetryOnly = run.lightsTelemetryOnly;
+    return sample;
+}
+
+TelemetryHistory::View TelemetryHistory::view() const { return View{this}; }
+
+TelemetrySample TelemetryHistory::View::const_iterator::operator*() const { return history_->at(index_); }
+
+TelemetrySample TelemetryHistory::View::operator[](std::size_t index) const { return history_->at(index); }
+
+TelemetrySample TelemetryHistory::View::front() const { return history_->at(0); }
+
+TelemetrySample TelemetryHistory::View::back() const { return history_->at(history_->size() - 1); }
+
+} // namespace minitrain
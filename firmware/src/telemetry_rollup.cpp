@@ -0,0 +1,218 @@
+#include "minitrain/telemetry_rollup.hpp"
+
+#include "byte_order.hpp"
+
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+namespace minitrain {
+
+namespace {
+constexpr std::uint8_t kRollupWireVersion = 1;
+constexpr std::size_t kRollupHeaderSize = 1 + 1 + 2 + 4 + 8;
+constexpr std::size_t kRollupBucketSize = 4 + 2 + 2 + kRollupFieldCount * 3 * sizeof(float);
+
+constexpr std::array<std::uint64_t, kRollupResolutionCount> kTierWidthsMillis{1000U, 10000U, 60000U};
+
+std::array<float, kRollupFieldCount> extractFields(const TelemetrySample &sample) {
+    return {sample.speedMetersPerSecond, sample.motorCurrentAmps, sample.batteryVoltage, sample.temperatureCelsius,
+            sample.appliedSpeedMetersPerSecond};
+}
+
+void combine(RollupBucket &target, const RollupBucket &source) {
+    if (source.count == 0) {
+        return;
+    }
+    for (std::size_t i = 0; i < kRollupFieldCount; ++i) {
+        auto &field = target.fields[i];
+        const auto &incoming = source.fields[i];
+        if (target.count == 0) {
+            field = incoming;
+        } else {
+            field.min = std::min(field.min, incoming.min);
+            field.max = std::max(field.max, incoming.max);
+            field.sum += incoming.sum;
+        }
+    }
+    target.count += source.count;
+    target.failSafeSamples += source.failSafeSamples;
+}
+
+std::uint16_t saturate16(std::uint32_t value) {
+    return static_cast<std::uint16_t>(std::min<std::uint32_t>(value, std::numeric_limits<std::uint16_t>::max()));
+}
+} // namespace
+
+TelemetryRollup::TelemetryRollup() {
+    for (std::size_t i = 0; i < tiers_.size(); ++i) {
+        tiers_[i].widthMillis = kTierWidthsMillis[i];
+        tiers_[i].closed.resize(kBucketsPerTier);
+    }
+}
+
+std::chrono::milliseconds TelemetryRollup::bucketWidth(RollupResolution resolution) {
+    return std::chrono::milliseconds{kTierWidthsMillis[static_cast<std::size_t>(resolution)]};
+}
+
+void TelemetryRollup::addSample(const TelemetrySample &sample, std::chrono::steady_clock::time_point timestamp) {
+    const auto millis = std::chrono::duration_cast<std::chrono::milliseconds>(timestamp.time_since_epoch()).count();
+
+    RollupBucket single{};
+    single.startMillis = millis < 0 ? 0U : static_cast<std::uint64_t>(millis);
+    single.count = 1;
+    single.failSafeSamples = sample.failSafeActive ? 1U : 0U;
+    const auto values = extractFields(sample);
+    for (std::size_t i = 0; i < kRollupFieldCount; ++i) {
+        single.fields[i] = RollupFieldStats{values[i], values[i], static_cast<double>(values[i])};
+    }
+    mergeInto(0, single);
+}
+
+void TelemetryRollup::mergeInto(std::size_t tierIndex, const RollupBucket &bucket) {
+    auto &tier = tiers_[tierIndex];
+    const std::uint64_t start = bucket.startMillis - (bucket.startMillis % tier.widthMillis);
+    // Late samples are folded into the open bucket rather than reopening a closed one.
+    if (tier.open && start > tier.open->startMillis) {
+        closeBucket(tierIndex);
+    }
+    if (!tier.open) {
+        tier.open = RollupBucket{};
+        tier.open->startMillis = start;
+    }
+    combine(*tier.open, bucket);
+}
+
+void TelemetryRollup::closeBucket(std::size_t tierIndex) {
+    auto &tier = tiers_[tierIndex];
+    const RollupBucket finished = *tier.open;
+    tier.open.reset();
+
+    const std::size_t capacity = tier.closed.size();
+    if (tier.count == capacity) {
+        tier.closed[tier.head] = finished;
+        tier.head = (tier.head + 1) % capacity;
+    } else {
+        tier.closed[(tier.head + tier.count) % capacity] = finished;
+        ++tier.count;
+    }
+
+    if (tierIndex + 1 < tiers_.size()) {
+        mergeInto(tierIndex + 1, finished);
+    }
+}
+
+std::vector<RollupBucket> TelemetryRollup::buckets(RollupResolution resolution) const {
+    const auto tierIndex = static_cast<std::size_t>(resolution);
+    const auto &tier = tiers_[tierIndex];
+
+    std::vector<RollupBucket> result;
+    result.reserve(tier.count + tierIndex + 1);
+    for (std::size_t i = 0; i < tier.count; ++i) {
+        result.push_back(tier.closed[(tier.head + i) % tier.closed.size()]);
+    }
+
+    // Data still sitting in finer open buckets has not been folded upwards yet.
+    std::optional<RollupBucket> pending;
+    for (std::size_t j = tierIndex + 1; j-- > 0;) {
+        const auto &open = tiers_[j].open;
+        if (!open) {
+            continue;
+        }
+        const std::uint64_t start = open->startMillis - (open->startMillis % tier.widthMillis);
+        if (pending && pending->startMillis != start) {
+            result.push_back(*pending);
+            pending.reset();
+        }
+        if (!pending) {
+            pending = RollupBucket{};
+            pending->startMillis = start;
+        }
+        combine(*pending, *open);
+    }
+    if (pending) {
+        result.push_back(*pending);
+    }
+    if (result.size() > kBucketsPerTier) {
+        result.erase(result.begin(), result.end() - static_cast<std::ptrdiff_t>(kBucketsPerTier));
+    }
+    return result;
+}
+
+std::vector<std::uint8_t> TelemetryRollup::encode(RollupResolution resolution, std::size_t maxBuckets) const {
+    auto selected = buckets(resolution);
+    if (selected.size() > maxBuckets) {
+        selected.erase(selected.begin(), selected.end() - static_cast<std::ptrdiff_t>(maxBuckets));
+    }
+
+    const auto width = static_cast<std::uint32_t>(kTierWidthsMillis[static_cast<std::size_t>(resolution)]);
+    std::vector<std::uint8_t> buffer(kRollupHeaderSize + selected.size() * kRollupBucketSize);
+    std::uint8_t *out = buffer.data();
+    *out++ = kRollupWireVersion;
+    *out++ = static_cast<std::uint8_t>(resolution);
+    detail::putLittle16(out, static_cast<std::uint16_t>(selected.size()));
+    detail::putLittle32(out, width);
+    detail::putLittle64(out, selected.empty() ? 0U : selected.front().startMillis);
+
+    std::uint64_t previousStart = selected.empty() ? 0U : selected.front().startMillis;
+    for (const auto &bucket : selected) {
+        detail::putLittle32(out, static_cast<std::uint32_t>((bucket.startMillis - previousStart) / width));
+        previousStart = bucket.startMillis;
+        detail::putLittle16(out, saturate16(bucket.count));
+        detail::putLittle16(out, saturate16(bucket.failSafeSamples));
+        for (const auto &field : bucket.fields) {
+            detail::putLittleFloat(out, field.min);
+            detail::putLittleFloat(out, field.max);
+            detail::putLittleFloat(out, field.mean(bucket.count));
+        }
+    }
+    return buffer;
+}
+
+TelemetryRollup::Decoded TelemetryRollup::decode(const std::vector<std::uint8_t> &buffer) {
+    if (buffer.size() < kRollupHeaderSize) {
+        throw std::invalid_argument("Buffer too small for telemetry rollup");
+    }
+    const std::uint8_t *in = buffer.data();
+    if (*in++ != kRollupWireVersion) {
+        throw std::invalid_argument("Unsupported telemetry rollup version");
+    }
+    const std::uint8_t resolutionCode = *in++;
+    if (resolutionCode >= kRollupResolutionCount) {
+        throw std::invalid_argument("Unknown telemetry rollup resolution");
+    }
+    const std::uint16_t bucketCount = detail::getLittle16(in);
+    const std::uint32_t width = detail::getLittle32(in);
+    std::uint64_t start = detail::getLittle64(in);
+    if (buffer.size() < kRollupHeaderSize + bucketCount * kRollupBucketSize) {
+        throw std::invalid_argument("Incomplete telemetry rollup");
+    }
+
+    Decoded decoded;
+    decoded.resolution = static_cast<RollupResolution>(resolutionCode);
+    decoded.buckets.reserve(bucketCount);
+    for (std::uint16_t i = 0; i < bucketCount; ++i) {
+        RollupBucket bucket{};
+        start += static_cast<std::uint64_t>(detail::getLittle32(in)) * width;
+        bucket.startMillis = start;
+        bucket.count = detail::getLittle16(in);
+        bucket.failSafeSamples = detail::getLittle16(in);
+        for (auto &field : bucket.fields) {
+            field.min = detail::getLittleFloat(in);
+            field.max = detail::getLittleFloat(in);
+            field.sum = static_cast<double>(detail::getLittleFloat(in)) * bucket.count;
+        }
+        decoded.buckets.push_back(bucket);
+    }
+    return decoded;
+}
+
+void TelemetryRollup::clear() {
+    for (auto &tier : tiers_) {
+        tier.head = 0;
+        tier.count = 0;
+        tier.open.reset();
+    }
+}
+
+} // namespace minitrain
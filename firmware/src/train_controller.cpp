@@ -76,13 +76,19 @@ TelemetrySample makeAvailabilitySample(const TrainState &state,
 }
 } // namespace
 
+void ControllerQuantiles::merge(const ControllerQuantiles &other) {
+    motorCurrentAmps.merge(other.motorCurrentAmps);
+    speedErrorMetersPerSecond.merge(other.speedErrorMetersPerSecond);
+    commandAgeMillis.merge(other.commandAgeMillis);
+}
+
 TrainController::TrainController(PidController speedController, MotorCommandWriter motorWriter,
                                  TelemetryPublisher telemetryPublisher,
                                  std::chrono::steady_clock::duration staleCommandThreshold,
                                  std::chrono::steady_clock::duration pilotReleaseDuration,
                                  std::chrono::steady_clock::duration failSafeRampDuration, Clock clock)
     : state_{}, pid_{std::move(speedController)}, motorWriter_{std::move(motorWriter)},
-      telemetryPublisher_{std::move(telemetryPublisher)}, telemetryAggregator_{20},
+      telemetryPublisher_{std::move(telemetryPublisher)}, telemetryAggregator_{MINITRAIN_TELEMETRY_WINDOW_SAMPLES, MINITRAIN_TELEMETRY_HISTORY_SAMPLES},
       staleCommandThreshold_{staleCommandThreshold}, pilotReleaseDuration_{pilotReleaseDuration},
       failSafeRampDuration_{failSafeRampDuration},
       clock_{std::move(clock)} {
@@ -103,6 +109,7 @@ void TrainController::setTargetSpeed(float metersPerSecond) {
         state_.emergencyStop = false;
     }
     updateLights(state_);
+    recordTransition(clock_());
 }
 
 void TrainController::setDirection(Direction direction) {
@@ -114,6 +121,7 @@ void TrainController::setDirection(Direction direction) {
         state_.setActiveCab(direction == Direction::Forward ? ActiveCab::Front : ActiveCab::Rear);
     }
     updateLights(state_);
+    recordTransition(clock_());
 }
 
 void TrainController::toggleHeadlights(bool enabled) {
@@ -121,17 +129,20 @@ void TrainController::toggleHeadlights(bool enabled) {
     const std::uint8_t mask = enabled ? 0x01U : 0x00U;
     state_.setLightsOverride(mask, false);
     updateLights(state_);
+    recordTransition(clock_());
 }
 
 void TrainController::toggleHorn(bool enabled) {
     std::scoped_lock lock(mutex_);
     state_.setHorn(enabled);
+    recordTransition(clock_());
 }
 
 void TrainController::setActiveCab(ActiveCab cab) {
     std::scoped_lock lock(mutex_);
     state_.setActiveCab(cab);
     updateLights(state_);
+    recordTransition(clock_());
 }
 
 void TrainController::setLightsOverride(std::uint8_t mask, bool telemetryOnly) {
@@ -140,25 +151,33 @@ void TrainController::setLightsOverride(std::uint8_t mask, bool telemetryOnly) {
     if (!telemetryOnly) {
         updateLights(state_);
     }
+    recordTransition(clock_());
 }
 
 void TrainController::triggerEmergencyStop() {
     std::scoped_lock lock(mutex_);
+    const auto now = clock_();
     state_.applyEmergencyStop();
     pid_.reset();
-    motorWriter_(0.0F);
+    // Stop the motor before any lighting or flight-recorder work.
+    writeMotorCommand(0.0F, now);
     updateLights(state_);
+    recordTransition(now);
 }
 
 void TrainController::onSpeedMeasurement(float measuredSpeed, std::chrono::steady_clock::duration dt) {
     std::scoped_lock lock(mutex_);
     const auto now = clock_();
+    if (recorder_ != nullptr) {
+        recorder_->recordSpeedMeasurement(measuredSpeed, dt, now);
+    }
     state_.updateAppliedSpeed(measuredSpeed);
     if (state_.emergencyStop) {
-        motorWriter_(0.0F);
+        writeMotorCommand(0.0F, now);
         return;
     }
     const auto age = now - state_.realtime.lastCommandTimestamp;
+    quantiles_.commandAgeMillis.add(std::chrono::duration<float, std::milli>(age).count());
     const bool pilotReleaseEnabled = pilotReleaseDuration_ > std::chrono::steady_clock::duration::zero();
     bool pilotReleaseTriggered = false;
 
@@ -201,9 +220,14 @@ void TrainController::onSpeedMeasurement(float measuredSpeed, std::chrono::stead
     }
 
     updateLights(state_);
+    recordTransition(now);
 
     if (state_.pilotReleaseActive && (!state_.realtime.pilotReleaseTelemetrySent || pilotReleaseTriggered)) {
-        telemetryPublisher_(makeAvailabilitySample(state_, now));
+        const auto availability = makeAvailabilitySample(state_, now);
+        if (recorder_ != nullptr) {
+            recorder_->recordTelemetry(FlightRecordType::TelemetryOutput, availability, now);
+        }
+        telemetryPublisher_(availability);
         state_.realtime.pilotReleaseTelemetrySent = true;
     }
 
@@ -231,22 +255,27 @@ void TrainController::onSpeedMeasurement(float measuredSpeed, std::chrono::stead
             state_.realtime.failSafeRampStart = now;
         }
         state_.updateTargetSpeed(newTarget);
-        motorWriter_(0.0F);
+        recordTransition(now);
+        writeMotorCommand(0.0F, now);
         return;
     }
 
     if (state_.pilotReleaseActive) {
-        motorWriter_(0.0F);
+        writeMotorCommand(0.0F, now);
         return;
     }
 
+    quantiles_.speedErrorMetersPerSecond.add(state_.targetSpeed - measuredSpeed);
     const float pidOutput = pid_.update(state_.targetSpeed, measuredSpeed, dt);
-    motorWriter_(clampMotorCommand(pidOutput));
+    writeMotorCommand(clampMotorCommand(pidOutput), now);
 }
 
 void TrainController::onTelemetrySample(const TelemetrySample &sample) {
     std::scoped_lock lock(mutex_);
     const auto now = clock_();
+    if (recorder_ != nullptr) {
+        recorder_->recordTelemetry(FlightRecordType::TelemetryInput, sample, now);
+    }
     TelemetrySample enriched = sample;
     enriched.failSafeActive = state_.failSafeActive;
     const auto metrics = computeFailSafeTelemetry(state_, now);
@@ -261,7 +290,12 @@ void TrainController::onTelemetrySample(const TelemetrySample &sample) {
     enriched.appliedDirection = state_.direction;
     enriched.source = TelemetrySource::Instantaneous;
     telemetryAggregator_.addSample(enriched);
+    telemetryRollup_.addSample(enriched, now);
+    quantiles_.motorCurrentAmps.add(enriched.motorCurrentAmps);
     state_.setBatteryVoltage(sample.batteryVoltage);
+    if (recorder_ != nullptr) {
+        recorder_->recordTelemetry(FlightRecordType::TelemetryOutput, enriched, now);
+    }
     telemetryPublisher_(enriched);
 }
 
@@ -286,6 +320,7 @@ void TrainController::registerCommandTimestamp(std::chrono::steady_clock::time_p
         }
     }
     updateLights(state_);
+    recordTransition(clock_());
 }
 
 TrainState TrainController::state() const {
@@ -298,4 +333,50 @@ std::optional<TelemetrySample> TrainController::aggregatedTelemetry() const {
     return telemetryAggregator_.average();
 }
 
+std::vector<RollupBucket> TrainController::telemetryRollup(RollupResolution resolution) const {
+    std::scoped_lock lock(mutex_);
+    return telemetryRollup_.buckets(resolution);
+}
+
+void TrainController::visitTelemetryHistory(const HistoryVisitor &visitor) const {
+    std::scoped_lock lock(mutex_);
+    visitor(telemetryAggregator_.history());
+}
+
+ControllerQuantiles TrainController::quantiles() const {
+    std::scoped_lock lock(mutex_);
+    return quantiles_;
+}
+
+void TrainController::attachFlightRecorder(FlightRecorder *recorder) {
+    std::scoped_lock lock(mutex_);
+    recorder_ = recorder;
+    lastTransition_.reset();
+    recordTransition(clock_());
+}
+
+void TrainController::writeMotorCommand(float command, std::chrono::steady_clock::time_point now) {
+    motorWriter_(command);
+    if (recorder_ != nullptr) {
+        recorder_->recordMotorCommand(command, now);
+    }
+}
+
+void TrainController::recordTransition(std::chrono::steady_clock::time_point now) {
+    if (recorder_ == nullptr) {
+        return;
+    }
+    const auto current = StateTransitionRecord::fromState(state_);
+    if (lastTransition_ && lastTransition_->sameModeAs(current)) {
+        return;
+    }
+    lastTransition_ = current;
+    recorder_->recordStateTransition(current, now);
+}
+
+std::vector<std::uint8_t> TrainController::encodeTelemetryRollup(RollupResolution resolution) const {
+    std::scoped_lock lock(mutex_);
+    return telemetryRollup_.encode(resolution);
+}
+
 } // namespace minitrain
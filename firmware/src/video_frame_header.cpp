@@ -0,0 +1,91 @@
+#include "minitrain/video_frame_header.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <stdexcept>
+#include <utility>
+
+#include "byte_order.hpp"
+
+namespace minitrain {
+
+namespace {
+struct VideoMessageStorage {
+    std::array<std::uint8_t, kVideoFrameHeaderSize> header{};
+    SharedFrame frame;
+};
+} // namespace
+
+void encodeVideoFrameHeader(const VideoFrameHeader &header, std::uint8_t *out) {
+    *out++ = VideoFrameHeader::kVersion;
+    *out++ = header.flags;
+    detail::putLittle16(out, static_cast<std::uint16_t>(kVideoFrameHeaderSize));
+    std::memcpy(out, header.sessionId.data(), header.sessionId.size());
+    out += header.sessionId.size();
+    detail::putLittle32(out, header.frameSequence);
+    detail::putLittle64(out, header.captureMicros);
+    detail::putLittle32(out, header.commandSequence);
+    detail::putLittle32(out, header.payloadLength);
+    detail::putLittle64(out, header.captureUnixMicros);
+}
+
+VideoFrameHeader decodeVideoFrameHeader(const std::uint8_t *data, std::size_t size) {
+    if (size < 4) {
+        throw std::invalid_argument("Video frame header truncated");
+    }
+    const std::uint8_t *in = data;
+    if (*in++ != VideoFrameHeader::kVersion) {
+        throw std::invalid_argument("Unsupported video frame header version");
+    }
+    VideoFrameHeader header{};
+    header.flags = *in++;
+    const std::uint16_t headerLength = detail::getLittle16(in);
+    if (headerLength < kVideoFrameHeaderSize || headerLength > size) {
+        throw std::invalid_argument("Video frame header truncated");
+    }
+    std::memcpy(header.sessionId.data(), in, header.sessionId.size());
+    in += header.sessionId.size();
+    header.frameSequence = detail::getLittle32(in);
+    header.captureMicros = detail::getLittle64(in);
+    header.commandSequence = detail::getLittle32(in);
+    header.payloadLength = detail::getLittle32(in);
+    header.captureUnixMicros = detail::getLittle64(in);
+    return header;
+}
+
+VideoFrameHeader makeVideoFrameHeader(const SharedFrame &frame, const std::array<std::uint8_t, 16> &sessionId,
+                                      std::optional<std::uint32_t> commandSequence) {
+    VideoFrameHeader header{};
+    header.sessionId = sessionId;
+    header.frameSequence = static_cast<std::uint32_t>(frame.sequence());
+    header.captureMicros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(frame.captureTime().time_since_epoch()).count());
+    const auto age = std::chrono::steady_clock::now() - frame.captureTime();
+    const auto captureWallClock = std::chrono::system_clock::now() -
+                                  std::chrono::duration_cast<std::chrono::system_clock::duration>(age);
+    header.captureUnixMicros = static_cast<std::uint64_t>(
+        std::chrono::duration_cast<std::chrono::microseconds>(captureWallClock.time_since_epoch()).count());
+    if (commandSequence) {
+        header.flags |= VideoFrameHeader::kFlagCommandApplied;
+        header.commandSequence = *commandSequence;
+    }
+    header.payloadLength = static_cast<std::uint32_t>(frame.size());
+    return header;
+}
+
+OutboundMessage makeVideoMessage(const VideoFrameHeader &header, SharedFrame frame, std::shared_ptr<BufferPool> pool) {
+    auto storage = std::allocate_shared<VideoMessageStorage>(PoolAllocator<VideoMessageStorage>(std::move(pool)));
+    encodeVideoFrameHeader(header, storage->header.data());
+    storage->frame = std::move(frame);
+
+    OutboundMessage message;
+    message.addSegment({storage->header.data(), storage->header.size()});
+    if (storage->frame.size() > 0) {
+        message.addSegment({storage->frame.data(), storage->frame.size()});
+    }
+    message.owner = std::move(storage);
+    return message;
+}
+
+} // namespace minitrain
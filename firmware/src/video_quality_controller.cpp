@@ -0,0 +1,95 @@
+#include "minitrain/video_quality_controller.hpp"
+
+#include <algorithm>
+#include <utility>
+
+namespace minitrain {
+
+namespace {
+constexpr double kWindowSeconds = 1.0;
+} // namespace
+
+VideoQualityConfig VideoQualityConfig::defaults() {
+    using std::chrono::milliseconds;
+    VideoQualityConfig config{};
+    config.levels = {
+        {FRAMESIZE_VGA, 12, milliseconds{33}},
+        {FRAMESIZE_VGA, 20, milliseconds{33}},
+        {FRAMESIZE_QVGA, 15, milliseconds{33}},
+        {FRAMESIZE_QVGA, 25, milliseconds{66}},
+        {FRAMESIZE_QQVGA, 30, milliseconds{100}},
+    };
+    return config;
+}
+
+VideoQualityController::VideoQualityController(VideoQualityConfig config) : config_(std::move(config)) {
+    if (config_.levels.empty()) {
+        config_.levels = VideoQualityConfig::defaults().levels;
+    }
+}
+
+void VideoQualityController::recordSend(std::size_t bytes, std::chrono::microseconds elapsed) {
+    std::scoped_lock lock(sendMutex_);
+    sentBytes_ += static_cast<double>(bytes);
+    busySeconds_ += std::max(elapsed.count(), std::int64_t{1}) / 1e6;
+    if (busySeconds_ > kWindowSeconds) {
+        sentBytes_ /= 2.0;
+        busySeconds_ /= 2.0;
+    }
+}
+
+void VideoQualityController::recordFrame(std::size_t bytes) {
+    const auto size = static_cast<double>(bytes);
+    averageFrameBytes_ = averageFrameBytes_ == 0.0 ? size : averageFrameBytes_ + (size - averageFrameBytes_) / 8.0;
+}
+
+double VideoQualityController::throughputBytesPerSecond() const {
+    std::scoped_lock lock(sendMutex_);
+    return busySeconds_ > 0.0 ? sentBytes_ / busySeconds_ : 0.0;
+}
+
+double VideoQualityController::demandBytesPerSecond() const {
+    const auto interval = std::max<std::int64_t>(level().captureInterval.count(), 1);
+    return averageFrameBytes_ * 1000.0 / static_cast<double>(interval);
+}
+
+std::optional<VideoQualityLevel> VideoQualityController::evaluate(const TrafficClassStats &video,
+                                                                  std::chrono::steady_clock::time_point now) {
+    const double throughput = throughputBytesPerSecond();
+    const double utilisation = throughput > 0.0 ? demandBytesPerSecond() / throughput : 0.0;
+    const bool dropping = video.droppedMessages > lastDropped_;
+    lastDropped_ = video.droppedMessages;
+    const bool congested = dropping || video.averageLatency > config_.maxQueueLatency ||
+                           (throughput > 0.0 && utilisation > config_.downgradeUtilisation);
+    const bool idle = throughput > 0.0 && !dropping && video.queuedMessages == 0 &&
+                      utilisation < config_.upgradeUtilisation;
+
+    // Counters only run outside the settle period so a step is judged on
+    // what happens after it took effect.
+    if (lastChange_ != std::chrono::steady_clock::time_point{} && now - lastChange_ < config_.settleTime) {
+        pressure_ = 0;
+        headroom_ = 0;
+        return std::nullopt;
+    }
+    pressure_ = congested ? pressure_ + 1 : 0;
+    headroom_ = idle ? headroom_ + 1 : 0;
+
+    std::size_t next = levelIndex_;
+    if (pressure_ >= config_.downgradeAfter && levelIndex_ + 1 < config_.levels.size()) {
+        next = levelIndex_ + 1;
+    } else if (headroom_ >= config_.upgradeAfter && levelIndex_ > 0) {
+        next = levelIndex_ - 1;
+    }
+    if (next == levelIndex_) {
+        return std::nullopt;
+    }
+    levelIndex_ = next;
+    pressure_ = 0;
+    headroom_ = 0;
+    // Frame sizes at the new level are unknown until the camera delivers.
+    averageFrameBytes_ = 0.0;
+    lastChange_ = now;
+    return level();
+}
+
+} // namespace minitrain
@@ -0,0 +1,347 @@
+#include "minitrain/yuv_kernels.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define MINITRAIN_YUV_SSE2 1
+#include <emmintrin.h>
+#endif
+
+#if defined(MINITRAIN_YUV_SSE2) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+// AVX2 kernels are compiled with a target attribute and picked at run time,
+// so the library still runs on CPUs without AVX2.
+#define MINITRAIN_YUV_AVX2 1
+#include <immintrin.h>
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define MINITRAIN_YUV_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace minitrain {
+
+namespace {
+// Processes as many whole SIMD blocks of a row as fit and returns how many
+// output pixels were written; the scalar loop finishes the row.
+using RowKernel = std::size_t (*)(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out);
+
+void scalarRow(const std::uint8_t *const *rows, std::size_t factor, LumaReduction reduction, std::size_t start,
+               std::size_t outWidth, std::uint8_t *out) {
+    // YUYV: the luma of pixel x is byte 2x.
+    if (reduction == LumaReduction::Subsample || factor == 1) {
+        for (std::size_t x = start; x < outWidth; ++x) {
+            out[x] = rows[0][x * factor * 2U];
+        }
+        return;
+    }
+    const unsigned area = static_cast<unsigned>(factor * factor);
+    for (std::size_t x = start; x < outWidth; ++x) {
+        unsigned sum = 0;
+        for (std::size_t r = 0; r < factor; ++r) {
+            for (std::size_t i = 0; i < factor; ++i) {
+                sum += rows[r][(x * factor + i) * 2U];
+            }
+        }
+        out[x] = static_cast<std::uint8_t>((sum + area / 2U) / area);
+    }
+}
+
+#ifdef MINITRAIN_YUV_SSE2
+inline __m128i loadLuma16(const std::uint8_t *p) {
+    return _mm_and_si128(_mm_loadu_si128(reinterpret_cast<const __m128i *>(p)), _mm_set1_epi16(0x00FF));
+}
+
+std::size_t sse2Extract(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        const std::uint8_t *in = rows[0] + x * 2U;
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(loadLuma16(in), loadLuma16(in + 16)));
+    }
+    return x;
+}
+
+std::size_t sse2Average2(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i rounding = _mm_set1_epi16(2);
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const std::size_t offset = x * 4U;
+        const __m128i a = _mm_add_epi16(loadLuma16(rows[0] + offset), loadLuma16(rows[1] + offset));
+        const __m128i b = _mm_add_epi16(loadLuma16(rows[0] + offset + 16), loadLuma16(rows[1] + offset + 16));
+        // madd against ones adds the two columns of each block.
+        __m128i sums = _mm_packs_epi32(_mm_madd_epi16(a, ones), _mm_madd_epi16(b, ones));
+        sums = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 2);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(sums, sums));
+    }
+    return x;
+}
+
+std::size_t sse2Average4(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    const __m128i ones = _mm_set1_epi16(1);
+    const __m128i rounding = _mm_set1_epi16(8);
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const std::size_t offset = x * 8U;
+        __m128i pairs[4];
+        for (std::size_t block = 0; block < 4; ++block) {
+            __m128i column = loadLuma16(rows[0] + offset + block * 16U);
+            for (std::size_t r = 1; r < 4; ++r) {
+                column = _mm_add_epi16(column, loadLuma16(rows[r] + offset + block * 16U));
+            }
+            pairs[block] = _mm_madd_epi16(column, ones);
+        }
+        // A second madd joins the two pixel pairs of each 4-wide block.
+        const __m128i low = _mm_madd_epi16(_mm_packs_epi32(pairs[0], pairs[1]), ones);
+        const __m128i high = _mm_madd_epi16(_mm_packs_epi32(pairs[2], pairs[3]), ones);
+        __m128i sums = _mm_packs_epi32(low, high);
+        sums = _mm_srli_epi16(_mm_add_epi16(sums, rounding), 4);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(sums, sums));
+    }
+    return x;
+}
+
+std::size_t sse2Subsample2(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    const __m128i mask = _mm_set1_epi32(0xFF);
+    std::size_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        const auto *in = reinterpret_cast<const __m128i *>(rows[0] + x * 4U);
+        const __m128i low = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(in), mask),
+                                            _mm_and_si128(_mm_loadu_si128(in + 1), mask));
+        const __m128i high = _mm_packs_epi32(_mm_and_si128(_mm_loadu_si128(in + 2), mask),
+                                             _mm_and_si128(_mm_loadu_si128(in + 3), mask));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(low, high));
+    }
+    return x;
+}
+
+std::size_t sse2Subsample4(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    const __m128i mask = _mm_set_epi32(0, 0xFF, 0, 0xFF);
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const auto *in = reinterpret_cast<const __m128i *>(rows[0] + x * 8U);
+        __m128i picked[4];
+        for (std::size_t block = 0; block < 4; ++block) {
+            picked[block] = _mm_shuffle_epi32(_mm_and_si128(_mm_loadu_si128(in + block), mask), _MM_SHUFFLE(2, 0, 2, 0));
+        }
+        const __m128i values = _mm_packs_epi32(_mm_unpacklo_epi64(picked[0], picked[1]),
+                                               _mm_unpacklo_epi64(picked[2], picked[3]));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm_packus_epi16(values, values));
+    }
+    return x;
+}
+#endif
+
+#ifdef MINITRAIN_YUV_AVX2
+__attribute__((target("avx2"))) inline __m256i loadLuma32(const std::uint8_t *p) {
+    return _mm256_and_si256(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(p)), _mm256_set1_epi16(0x00FF));
+}
+
+__attribute__((target("avx2"))) std::size_t avx2Extract(const std::uint8_t *const *rows, std::size_t outWidth,
+                                                        std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 32 <= outWidth; x += 32) {
+        const std::uint8_t *in = rows[0] + x * 2U;
+        // packus works per 128-bit lane; the permute restores pixel order.
+        const __m256i packed = _mm256_packus_epi16(loadLuma32(in), loadLuma32(in + 32));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(out + x), _mm256_permute4x64_epi64(packed, 0xD8));
+    }
+    return x;
+}
+
+__attribute__((target("avx2"))) std::size_t avx2Average2(const std::uint8_t *const *rows, std::size_t outWidth,
+                                                         std::uint8_t *out) {
+    const __m256i ones = _mm256_set1_epi16(1);
+    const __m256i rounding = _mm256_set1_epi16(2);
+    std::size_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        const std::size_t offset = x * 4U;
+        const __m256i a = _mm256_add_epi16(loadLuma32(rows[0] + offset), loadLuma32(rows[1] + offset));
+        const __m256i b = _mm256_add_epi16(loadLuma32(rows[0] + offset + 32), loadLuma32(rows[1] + offset + 32));
+        __m256i sums = _mm256_packs_epi32(_mm256_madd_epi16(a, ones), _mm256_madd_epi16(b, ones));
+        sums = _mm256_permute4x64_epi64(sums, 0xD8);
+        sums = _mm256_srli_epi16(_mm256_add_epi16(sums, rounding), 2);
+        const __m256i bytes = _mm256_packus_epi16(sums, sums);
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x), _mm256_castsi256_si128(bytes));
+        _mm_storel_epi64(reinterpret_cast<__m128i *>(out + x + 8), _mm256_extracti128_si256(bytes, 1));
+    }
+    return x;
+}
+
+bool cpuHasAvx2() {
+    static const bool supported = __builtin_cpu_supports("avx2") != 0;
+    return supported;
+}
+#endif
+
+#ifdef MINITRAIN_YUV_NEON
+std::size_t neonExtract(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        vst1q_u8(out + x, vld2q_u8(rows[0] + x * 2U).val[0]);
+    }
+    return x;
+}
+
+std::size_t neonAverage2(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const std::size_t offset = x * 4U;
+        const uint16x8_t sums = vaddq_u16(vpaddlq_u8(vld2q_u8(rows[0] + offset).val[0]),
+                                          vpaddlq_u8(vld2q_u8(rows[1] + offset).val[0]));
+        vst1_u8(out + x, vrshrn_n_u16(sums, 2));
+    }
+    return x;
+}
+
+std::size_t neonAverage4(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const std::size_t offset = x * 8U;
+        uint16x8_t low = vpaddlq_u8(vld2q_u8(rows[0] + offset).val[0]);
+        uint16x8_t high = vpaddlq_u8(vld2q_u8(rows[0] + offset + 32).val[0]);
+        for (std::size_t r = 1; r < 4; ++r) {
+            low = vaddq_u16(low, vpaddlq_u8(vld2q_u8(rows[r] + offset).val[0]));
+            high = vaddq_u16(high, vpaddlq_u8(vld2q_u8(rows[r] + offset + 32).val[0]));
+        }
+        const uint16x8_t sums = vcombine_u16(vpadd_u16(vget_low_u16(low), vget_high_u16(low)),
+                                             vpadd_u16(vget_low_u16(high), vget_high_u16(high)));
+        vst1_u8(out + x, vrshrn_n_u16(sums, 4));
+    }
+    return x;
+}
+
+std::size_t neonSubsample2(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 16 <= outWidth; x += 16) {
+        vst1q_u8(out + x, vld4q_u8(rows[0] + x * 4U).val[0]);
+    }
+    return x;
+}
+
+std::size_t neonSubsample4(const std::uint8_t *const *rows, std::size_t outWidth, std::uint8_t *out) {
+    std::size_t x = 0;
+    for (; x + 8 <= outWidth; x += 8) {
+        const uint8x16_t everyGroup = vld4q_u8(rows[0] + x * 8U).val[0];
+        vst1_u8(out + x, vmovn_u16(vreinterpretq_u16_u8(everyGroup)));
+    }
+    return x;
+}
+#endif
+
+bool isaAvailable(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Scalar:
+        return true;
+#ifdef MINITRAIN_YUV_SSE2
+    case SimdIsa::Sse2:
+        return true;
+#endif
+#ifdef MINITRAIN_YUV_AVX2
+    case SimdIsa::Avx2:
+        return cpuHasAvx2();
+#endif
+#ifdef MINITRAIN_YUV_NEON
+    case SimdIsa::Neon:
+        return true;
+#endif
+    default:
+        return false;
+    }
+}
+
+RowKernel selectKernel(SimdIsa isa, std::size_t factor, LumaReduction reduction) {
+    const bool subsample = reduction == LumaReduction::Subsample;
+    (void)subsample;
+    switch (isa) {
+#ifdef MINITRAIN_YUV_AVX2
+    case SimdIsa::Avx2:
+        if (factor == 1) {
+            return avx2Extract;
+        }
+        if (factor == 2 && !subsample) {
+            return avx2Average2;
+        }
+        // The remaining shapes are memory bound; SSE2 is as fast.
+        return selectKernel(SimdIsa::Sse2, factor, reduction);
+#endif
+#ifdef MINITRAIN_YUV_SSE2
+    case SimdIsa::Sse2:
+        if (factor == 1) {
+            return sse2Extract;
+        }
+        if (factor == 2) {
+            return subsample ? sse2Subsample2 : sse2Average2;
+        }
+        return subsample ? sse2Subsample4 : sse2Average4;
+#endif
+#ifdef MINITRAIN_YUV_NEON
+    case SimdIsa::Neon:
+        if (factor == 1) {
+            return neonExtract;
+        }
+        if (factor == 2) {
+            return subsample ? neonSubsample2 : neonAverage2;
+        }
+        return subsample ? neonSubsample4 : neonAverage4;
+#endif
+    default:
+        return nullptr;
+    }
+}
+} // namespace
+
+const char *toString(SimdIsa isa) {
+    switch (isa) {
+    case SimdIsa::Sse2:
+        return "sse2";
+    case SimdIsa::Avx2:
+        return "avx2";
+    case SimdIsa::Neon:
+        return "neon";
+    case SimdIsa::Scalar:
+    default:
+        return "scalar";
+    }
+}
+
+SimdIsa yuvKernelIsa() {
+    for (const auto isa : {SimdIsa::Avx2, SimdIsa::Neon, SimdIsa::Sse2}) {
+        if (isaAvailable(isa)) {
+            return isa;
+        }
+    }
+    return SimdIsa::Scalar;
+}
+
+std::vector<SimdIsa> availableYuvKernels() {
+    std::vector<SimdIsa> kernels;
+    for (const auto isa : {SimdIsa::Scalar, SimdIsa::Sse2, SimdIsa::Avx2, SimdIsa::Neon}) {
+        if (isaAvailable(isa)) {
+            kernels.push_back(isa);
+        }
+    }
+    return kernels;
+}
+
+bool yuv422ToLuma(const std::uint8_t *src, std::size_t width, std::size_t height, std::size_t factor,
+                  LumaReduction reduction, std::uint8_t *dst, SimdIsa isa) {
+    if (src == nullptr || dst == nullptr || width % 2U != 0 || (factor != 1 && factor != 2 && factor != 4) ||
+        !isaAvailable(isa)) {
+        return false;
+    }
+    const std::size_t outWidth = width / factor;
+    const std::size_t outHeight = height / factor;
+    const std::size_t stride = width * 2U;
+    const RowKernel kernel = selectKernel(isa, factor, reduction);
+    const std::uint8_t *rows[4] = {};
+    for (std::size_t y = 0; y < outHeight; ++y) {
+        for (std::size_t r = 0; r < factor; ++r) {
+            rows[r] = src + (y * factor + r) * stride;
+        }
+        const std::size_t done = kernel != nullptr ? kernel(rows, outWidth, dst) : 0;
+        scalarRow(rows, factor, reduction, done, outWidth, dst);
+        dst += outWidth;
+    }
+    return true;
+}
+
+} // namespace minitrain
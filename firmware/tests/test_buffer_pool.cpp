@@ -0,0 +1,167 @@
+#include "minitrain/buffer_pool.hpp"
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/synthetic_frame_source.hpp"
+#include "minitrain/video_frame_header.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runBufferPoolTests() {
+    using namespace std::chrono_literals;
+
+    BufferPool pool({{1024, 1}, {64, 2}});
+    const auto classes = pool.stats();
+    if (classes.size() != 2U || classes[0].blockBytes != 64U || classes[1].capacity != 1U) {
+        std::cerr << "Buffer pool classes should be sorted by block size" << std::endl;
+        return 1;
+    }
+    // Free-list indices are 16 bits so the head stays a 32-bit CAS.
+    BufferPool bounded({{16, 70000}, {16, 4}});
+    if (bounded.stats().size() != 1U || bounded.stats()[0].capacity != 4U) {
+        std::cerr << "Buffer pool should skip classes beyond its index range" << std::endl;
+        return 1;
+    }
+    void *first = pool.allocate(40);
+    void *second = pool.allocate(64);
+    // The small class is empty, so the next small request spills upwards.
+    void *spilled = pool.allocate(1);
+    if (first == nullptr || second == nullptr || spilled == nullptr || first == second || !pool.owns(spilled) ||
+        pool.allocate(8) != nullptr || pool.allocate(4096) != nullptr) {
+        std::cerr << "Buffer pool handed out the wrong blocks" << std::endl;
+        return 1;
+    }
+    if (reinterpret_cast<std::uintptr_t>(first) % alignof(std::max_align_t) != 0U) {
+        std::cerr << "Buffer pool blocks should be suitably aligned" << std::endl;
+        return 1;
+    }
+    pool.release(second);
+    if (pool.allocate(10) != second) {
+        std::cerr << "Released blocks should be reused" << std::endl;
+        return 1;
+    }
+    auto stats = pool.stats();
+    if (stats[0].inUse != 2U || stats[0].highWater != 2U || stats[0].acquired != 3U || stats[0].exhausted != 1U ||
+        stats[1].inUse != 1U || stats[1].exhausted != 0U || pool.inUse() != 3U) {
+        std::cerr << "Buffer pool occupancy metrics are wrong" << std::endl;
+        return 1;
+    }
+    pool.release(first);
+    pool.release(second);
+    pool.release(spilled);
+    int local = 0;
+    if (pool.inUse() != 0U || pool.stats()[0].highWater != 2U || pool.owns(&local)) {
+        std::cerr << "High-water mark should survive releases" << std::endl;
+        return 1;
+    }
+
+    // Concurrent acquire/release: no block may be handed to two owners.
+    BufferPool shared({{sizeof(std::uint64_t), 8}});
+    std::atomic<bool> corrupted{false};
+    std::vector<std::thread> workers;
+    for (std::uint64_t id = 1; id <= 4; ++id) {
+        workers.emplace_back([&shared, &corrupted, id] {
+            for (int i = 0; i < 50000; ++i) {
+                auto *block = static_cast<std::uint64_t *>(shared.allocate(sizeof(std::uint64_t)));
+                if (block == nullptr) {
+                    continue;
+                }
+                *block = id;
+                std::this_thread::yield();
+                if (*block != id) {
+                    corrupted.store(true);
+                }
+                shared.release(block);
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (corrupted.load() || shared.inUse() != 0U || shared.stats()[0].highWater > 8U) {
+        std::cerr << "Buffer pool lost a block under contention" << std::endl;
+        return 1;
+    }
+
+    // allocate_shared keeps the pool alive and falls back to the heap.
+    auto owner = std::make_shared<BufferPool>(std::vector<BufferPoolClass>{{128, 1}});
+    auto pooled = std::allocate_shared<std::array<std::uint8_t, 32>>(PoolAllocator<std::array<std::uint8_t, 32>>(owner));
+    auto heap = std::allocate_shared<std::array<std::uint8_t, 32>>(PoolAllocator<std::array<std::uint8_t, 32>>(owner));
+    if (owner->inUse() != 1U || owner->stats()[0].exhausted != 1U) {
+        std::cerr << "Pool allocator should fall back to the heap when exhausted" << std::endl;
+        return 1;
+    }
+    std::weak_ptr<BufferPool> watch = owner;
+    owner.reset();
+    heap.reset();
+    if (watch.expired()) {
+        std::cerr << "Pool allocations should keep their pool alive" << std::endl;
+        return 1;
+    }
+    pooled.reset();
+    if (!watch.expired()) {
+        std::cerr << "Pool should go away with its last allocation" << std::endl;
+        return 1;
+    }
+
+    // Streaming: frame bookkeeping and video messages stay in the pool.
+    SyntheticFrameConfig cameraConfig{};
+    cameraConfig.period = 2ms;
+    cameraConfig.bufferCount = 3;
+    std::shared_ptr<SyntheticFrameSource> source = SyntheticFrameSource::create(cameraConfig);
+    CameraStreamer streamer;
+    streamer.setFrameSource(source);
+    auto config = CameraStreamer::createDefaultConfig();
+    config.fb_count = 3;
+    if (streamer.bufferPool() || !streamer.initialize(config) || !streamer.bufferPool() || !streamer.start()) {
+        std::cerr << "Failed to start the pooled stream" << std::endl;
+        return 1;
+    }
+    const auto streamPool = streamer.bufferPool();
+    std::vector<OutboundMessage> messages;
+    std::size_t received = 0;
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (received < 50 && std::chrono::steady_clock::now() < deadline) {
+        auto frame = streamer.tryAcquireFrame(100ms);
+        if (!frame) {
+            continue;
+        }
+        ++received;
+        messages.push_back(makeVideoMessage(makeVideoFrameHeader(*frame, {}, std::nullopt), std::move(*frame),
+                                            streamPool));
+        if (messages.size() > 2U) {
+            messages.erase(messages.begin());
+        }
+    }
+    const auto streaming = streamer.stats();
+    messages.clear();
+    streamer.stop();
+    const auto stopped = streamer.stats();
+    if (received < 50 || streaming.poolExhausted != 0U || streaming.poolHighWater < 2U ||
+        streaming.poolHighWater > 8U || stopped.poolBlocksInUse != 0U) {
+        std::cerr << "Streaming should run from the pool (high water " << streaming.poolHighWater << ", exhausted "
+                  << streaming.poolExhausted << ", in use " << stopped.poolBlocksInUse << ")" << std::endl;
+        return 1;
+    }
+    // Re-initialising an idle streamer may resize the pool.
+    config.fb_count = 1;
+    if (!streamer.initialize(config) || streamer.bufferPool() == streamPool ||
+        streamer.bufferPool()->stats()[0].capacity != 4U) {
+        std::cerr << "An idle pool should be resized from fb_count" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,117 @@
+#include "minitrain/cab_camera_rig.hpp"
+
+#include "minitrain/synthetic_frame_source.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+std::shared_ptr<SyntheticFrameSource> makeCamera(std::size_t width, std::size_t height) {
+    SyntheticFrameConfig config{};
+    config.width = width;
+    config.height = height;
+    config.period = std::chrono::milliseconds{1};
+    config.bufferCount = 3;
+    return SyntheticFrameSource::create(config);
+}
+
+// Frames acquired within the window, counted per camera by frame width.
+struct Tally {
+    std::size_t front{0};
+    std::size_t rear{0};
+};
+
+Tally collect(CabCameraRig &rig, std::chrono::milliseconds window) {
+    Tally tally{};
+    const auto deadline = std::chrono::steady_clock::now() + window;
+    while (std::chrono::steady_clock::now() < deadline) {
+        if (auto frame = rig.tryAcquireFrame(std::chrono::milliseconds{10})) {
+            (frame->raw()->width == 320 ? tally.front : tally.rear) += 1;
+        }
+    }
+    return tally;
+}
+} // namespace
+
+int runCabCameraRigTests() {
+    using namespace std::chrono_literals;
+
+    CameraStreamer front;
+    CameraStreamer rear;
+    front.setFrameSource(makeCamera(320, 240));
+    rear.setFrameSource(makeCamera(160, 120));
+    CabCameraConfig config{};
+    config.activeInterval = 20ms;
+    config.standbyInterval = 400ms;
+    CabCameraRig rig(config);
+    if (rig.start(nullptr) || !front.initialize(CameraStreamer::createDefaultConfig()) ||
+        !rear.initialize(CameraStreamer::createDefaultConfig()) || !rig.start(&front, &rear) ||
+        rig.streamingCab() != ActiveCab::Front || rig.streamer(ActiveCab::Rear) != &rear) {
+        std::cerr << "Cab camera rig failed to start" << std::endl;
+        return 1;
+    }
+
+    // Only the front camera streams; the rear one idles at standby rate.
+    auto tally = collect(rig, 300ms);
+    if (tally.front < 8U || tally.rear != 0U || rear.stats().capturedFrames > 2U) {
+        std::cerr << "Standby camera should stay slow and unsent (front " << tally.front << ", rear captured "
+                  << rear.stats().capturedFrames << ")" << std::endl;
+        return 1;
+    }
+
+    // Switching wakes the rear camera at once: its first frame arrives well
+    // within one active frame interval, without re-initialising anything.
+    const auto frontCaptured = front.stats().capturedFrames;
+    rig.setActiveCab(ActiveCab::Rear);
+    auto first = rig.tryAcquireFrame(100ms);
+    if (!first || first->raw()->width != 160U || rig.streamingCab() != ActiveCab::Rear ||
+        rig.stats().switchovers != 1U || rig.stats().lastSwitchLatency > std::chrono::microseconds{config.activeInterval}) {
+        std::cerr << "Switchover to the rear cab was not immediate (latency "
+                  << rig.stats().lastSwitchLatency.count() << " us)" << std::endl;
+        return 1;
+    }
+    first.reset();
+    rig.setActiveCab(ActiveCab::None);
+    tally = collect(rig, 300ms);
+    if (tally.front != 0U || tally.rear < 8U || front.stats().capturedFrames > frontCaptured + 2U ||
+        rig.streamingCab() != ActiveCab::Rear) {
+        std::cerr << "Rear cab should stream alone after the switch" << std::endl;
+        return 1;
+    }
+    rig.setActiveCab(ActiveCab::Front);
+    tally = collect(rig, 100ms);
+    if (tally.rear != 0U || tally.front < 3U || rig.stats().switchovers != 2U) {
+        std::cerr << "Switching back should restore the front camera" << std::endl;
+        return 1;
+    }
+    rig.stop();
+    if (rig.isRunning() || front.isRunning() || rear.isRunning() || rig.tryAcquireFrame(0ms)) {
+        std::cerr << "Stopping the rig should stop both cameras" << std::endl;
+        return 1;
+    }
+
+    // A single-sensor board keeps its only camera for both cabs.
+    CameraStreamer only;
+    only.setFrameSource(makeCamera(320, 240));
+    if (!only.initialize(CameraStreamer::createDefaultConfig()) || !rig.start(&only)) {
+        std::cerr << "Single camera rig failed to start" << std::endl;
+        return 1;
+    }
+    rig.setActiveCab(ActiveCab::Rear);
+    tally = collect(rig, 100ms);
+    rig.stop();
+    if (tally.front < 3U || rig.stats().switchovers != 2U) {
+        std::cerr << "Single camera rig should ignore a missing rear camera" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
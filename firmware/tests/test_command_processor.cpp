@@ -190,6 +190,26 @@ int runCommandProcessorTests() {
         }
     }
 
+    {
+        CommandProcessor sequencedProcessor(controller);
+        if (sequencedProcessor.lastAppliedCommand()) {
+            std::cerr << "No command should be reported before the first frame" << std::endl;
+            ++failures;
+        }
+        auto frame = makeFrame(1.0F, Direction::Forward, 0x00U);
+        frame.header.sessionId[0] = 0xA5U;
+        frame.header.sequence = 42;
+        sequencedProcessor.processFrame(frame, baseTime);
+        auto telemetryFrame = makeFrame(0.0F, Direction::Neutral, 0x80U);
+        telemetryFrame.header.sequence = 43;
+        sequencedProcessor.processFrame(telemetryFrame, baseTime + std::chrono::milliseconds(10));
+        const auto applied = sequencedProcessor.lastAppliedCommand();
+        if (!applied || applied->sequence != 42U || applied->sessionId[0] != 0xA5U) {
+            std::cerr << "Last applied command should ignore telemetry-only frames" << std::endl;
+            ++failures;
+        }
+    }
+
     return failures;
 }
 
@@ -0,0 +1,162 @@
+#include "minitrain/command_processor.hpp"
+#include "minitrain/event_index.hpp"
+#include "minitrain/flight_recorder.hpp"
+#include "minitrain/pid_controller.hpp"
+#include "minitrain/train_controller.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+bool sameRanges(const std::vector<EventRange> &lhs, const std::vector<EventRange> &rhs) {
+    if (lhs.size() != rhs.size()) {
+        return false;
+    }
+    for (std::size_t i = 0; i < lhs.size(); ++i) {
+        if (lhs[i].sessionId != rhs[i].sessionId || lhs[i].startMillis != rhs[i].startMillis ||
+            lhs[i].endMillis != rhs[i].endMillis || lhs[i].events != rhs[i].events) {
+            return false;
+        }
+    }
+    return true;
+}
+} // namespace
+
+int runEventIndexTests() {
+    using namespace std::chrono_literals;
+    const auto origin = std::chrono::steady_clock::time_point{} + 1h;
+    const std::uint64_t base = 3'600'000U;
+
+    std::vector<std::uint8_t> region(1024 * 1024);
+    FlightRecorder recorder{region.data(), region.size()};
+    TelemetryEventIndex index;
+    recorder.attachEventIndex(&index);
+
+    auto now = origin;
+    TrainController controller(
+        PidController{0.5F, 0.0F, 0.0F, 0.0F, 1.0F}, [](float) {}, [](const TelemetrySample &) {}, 150ms, 5000ms,
+        1000ms, [&now] { return now; });
+    const auto systemClock = [] { return std::chrono::system_clock::time_point{}; };
+    CommandProcessor processor(controller, std::nullopt, systemClock);
+    controller.attachFlightRecorder(&recorder);
+    processor.attachFlightRecorder(&recorder);
+
+    CommandFrame frame{};
+    frame.header.sessionId[0] = 0xA1U;
+    frame.header.targetSpeedMetersPerSecond = 0.5F;
+    frame.header.direction = Direction::Forward;
+    frame.payload = {0x00U};
+    frame.header.auxPayloadLength = 1;
+    const auto send = [&](CommandProcessor &link, std::uint8_t lightsOverride, std::uint8_t flags, float target) {
+        frame.header.lightsOverride = lightsOverride;
+        frame.header.targetSpeedMetersPerSecond = target;
+        frame.payload[0] = flags;
+        ++frame.header.sequence;
+        link.processFrame(frame, now);
+    };
+
+    // Link lost after the first frame: fail-safe after 150 ms, pilot release
+    // after 5 s, then the operator reconnects at 6 s.
+    send(processor, 0x00U, 0x00U, 0.5F);
+    while (now < origin + 6000ms) {
+        now += 20ms;
+        controller.onSpeedMeasurement(0.2F, 20ms);
+    }
+    CommandProcessor reconnected(controller, std::nullopt, systemClock);
+    reconnected.attachFlightRecorder(&recorder);
+    send(reconnected, 0x00U, 0x00U, 0.5F);
+    // Lights override from 6.02 s to 7.02 s, emergency stop from 8 s on.
+    while (now < origin + 9000ms) {
+        now += 20ms;
+        const auto elapsed = now - origin;
+        send(reconnected, elapsed < 7020ms ? 0x03U : 0x00U, elapsed == 8000ms ? 0x04U : 0x00U, elapsed < 8000ms ? 0.5F : 0.0F);
+        controller.onSpeedMeasurement(0.2F, 20ms);
+    }
+
+    const auto failSafe = index.query(kEventFailSafe, 0, ~std::uint64_t{0});
+    if (failSafe.size() != 1U || failSafe[0].sessionId != frame.header.sessionId ||
+        failSafe[0].startMillis != base + 160U || failSafe[0].endMillis != base + 5020U) {
+        std::cerr << "Fail-safe range not indexed" << std::endl;
+        return 1;
+    }
+    const auto pilotRelease = index.query(kEventPilotRelease, 0, ~std::uint64_t{0});
+    if (pilotRelease.size() != 1U || pilotRelease[0].startMillis != base + 5020U ||
+        pilotRelease[0].endMillis != base + 6000U) {
+        std::cerr << "Pilot release range not indexed" << std::endl;
+        return 1;
+    }
+    const auto lights = index.query(kEventLightsOverride, 0, ~std::uint64_t{0});
+    if (lights.size() != 1U || lights[0].startMillis != base + 6020U || lights[0].endMillis != base + 7020U) {
+        std::cerr << "Lights override range not indexed" << std::endl;
+        return 1;
+    }
+    const auto emergency = index.query(kEventEmergencyStop, 0, ~std::uint64_t{0});
+    if (emergency.size() != 1U || emergency[0].startMillis != base + 8000U ||
+        emergency[0].endMillis != base + 9000U) {
+        std::cerr << "Open emergency stop range should end at the last record" << std::endl;
+        return 1;
+    }
+
+    // Adjacent fail-safe and pilot release merge; results are clipped to the window.
+    const auto linkLoss = index.query(kEventFailSafe | kEventPilotRelease, base + 1000U, base + 20000U);
+    if (linkLoss.size() != 1U || linkLoss[0].startMillis != base + 1000U || linkLoss[0].endMillis != base + 6000U ||
+        linkLoss[0].events != (kEventFailSafe | kEventPilotRelease)) {
+        std::cerr << "Link loss query should merge and clip ranges" << std::endl;
+        return 1;
+    }
+    if (!index.query(kEventAll, base + 7100U, base + 7900U).empty() ||
+        index.query(kEventAll, 0, ~std::uint64_t{0}, TelemetryEventIndex::SessionId{}).size() != 0U) {
+        std::cerr << "Quiet windows and unknown sessions should match nothing" << std::endl;
+        return 1;
+    }
+    // The state recorded on attach predates any frame and lands in the
+    // all-zero session. One granule per second that saw an event: every second
+    // of this run did.
+    if (index.sessionCount() != 2U || index.granuleCount() != 10U) {
+        std::cerr << "Event index should stay sparse, got " << index.granuleCount() << " granules" << std::endl;
+        return 1;
+    }
+
+    const auto everything = index.query(kEventAll, 0, ~std::uint64_t{0});
+    const auto rebuilt = TelemetryEventIndex::build(recorder);
+    const auto decoded = TelemetryEventIndex::decode(index.encode());
+    if (!sameRanges(rebuilt.query(kEventAll, 0, ~std::uint64_t{0}), everything) ||
+        !sameRanges(decoded.query(kEventAll, 0, ~std::uint64_t{0}), everything) ||
+        !sameRanges(decoded.query(kEventLightsOverride, base, base + 7000U), index.query(kEventLightsOverride, base,
+                                                                                          base + 7000U))) {
+        std::cerr << "Rebuilt and decoded indexes should answer like the live one" << std::endl;
+        return 1;
+    }
+
+    // Long quiet sessions cost nothing; a short event costs a single granule.
+    TelemetryEventIndex sparse{1000ms};
+    const TelemetryEventIndex::SessionId other{0xB2U};
+    for (std::uint64_t t = 0; t <= 3'600'000U; t += 20U) {
+        sparse.observe(other, t, t >= 1'800'000U && t < 1'800'200U ? kEventEmergencyStop : 0U);
+    }
+    const auto stop = sparse.query(kEventEmergencyStop, 1'000'000U, 2'000'000U, other);
+    if (sparse.granuleCount() != 1U || sparse.transitionCount() != 2U || stop.size() != 1U ||
+        stop[0].startMillis != 1'800'000U || stop[0].endMillis != 1'800'200U) {
+        std::cerr << "Sparse event index lookup failed" << std::endl;
+        return 1;
+    }
+
+    auto truncated = index.encode();
+    truncated.resize(truncated.size() - 3U);
+    try {
+        (void)TelemetryEventIndex::decode(truncated);
+        std::cerr << "Truncated event index should be rejected" << std::endl;
+        return 1;
+    } catch (const std::invalid_argument &) {
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,181 @@
+#include "minitrain/command_processor.hpp"
+#include "minitrain/flight_recorder.hpp"
+#include "minitrain/pid_controller.hpp"
+#include "minitrain/train_controller.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runFlightRecorderTests() {
+    using namespace std::chrono_literals;
+    const auto origin = std::chrono::steady_clock::time_point{} + 1h;
+
+    // Small in-memory region: force several wraparounds and evictions.
+    std::vector<std::uint8_t> region(FlightRecorder::kMinimumRegionSize);
+    {
+        FlightRecorder recorder{region.data(), region.size(), 100ms};
+        if (!recorder.valid()) {
+            std::cerr << "Flight recorder rejected a minimum-sized region" << std::endl;
+            return 1;
+        }
+        for (int i = 0; i < 2000; ++i) {
+            recorder.recordSpeedMeasurement(static_cast<float>(i), 20ms, origin + i * 10ms);
+        }
+        std::uint64_t expectedSequence = 0;
+        float lastSpeed = -1.0F;
+        std::size_t visited = 0;
+        bool ordered = true;
+        recorder.forEach([&](const FlightRecord &record) {
+            const auto decoded = FlightRecorder::decodeSpeedMeasurement(record);
+            if (!decoded || (visited > 0 && record.sequence != expectedSequence) || decoded->measuredSpeed <= lastSpeed ||
+                decoded->dt != std::chrono::steady_clock::duration{20ms}) {
+                ordered = false;
+            }
+            expectedSequence = record.sequence + 1;
+            lastSpeed = decoded ? decoded->measuredSpeed : lastSpeed;
+            ++visited;
+        });
+        if (!ordered || visited != recorder.recordCount() || visited == 0 || visited >= 2000 ||
+            lastSpeed != 1999.0F) {
+            std::cerr << "Flight recorder should keep the newest records in order after wrapping" << std::endl;
+            return 1;
+        }
+
+        std::size_t recent = 0;
+        float firstRecent = -1.0F;
+        recorder.forEachSince(origin + 19'500ms, [&](const FlightRecord &record) {
+            const auto decoded = FlightRecorder::decodeSpeedMeasurement(record);
+            if (recent == 0 && decoded) {
+                firstRecent = decoded->measuredSpeed;
+            }
+            ++recent;
+        });
+        if (recent != 50 || firstRecent != 1950.0F) {
+            std::cerr << "Indexed seek returned the wrong records" << std::endl;
+            return 1;
+        }
+    }
+
+    // Re-attaching the same region recovers the log instead of reformatting it.
+    {
+        FlightRecorder recovered{region.data(), region.size(), 100ms};
+        const auto retained = recovered.recordCount();
+        recovered.recordMotorCommand(0.25F, origin + 30s);
+        float last = 0.0F;
+        recovered.forEach([&](const FlightRecord &record) {
+            if (const auto command = FlightRecorder::decodeMotorCommand(record)) {
+                last = *command;
+            }
+        });
+        if (retained == 0 || recovered.recordCount() < retained || last != 0.25F) {
+            std::cerr << "Flight recorder did not recover its superblock" << std::endl;
+            return 1;
+        }
+    }
+
+    // An emergency stop reaches the motor before anything is logged.
+    {
+        std::vector<std::uint8_t> stopRegion(FlightRecorder::kMinimumRegionSize);
+        FlightRecorder recorder{stopRegion.data(), stopRegion.size(), 100ms};
+        std::size_t recordsAtStop = 0;
+        TrainController controller(
+            PidController{0.5F, 0.0F, 0.0F, 0.0F, 1.0F},
+            [&recorder, &recordsAtStop](float command) {
+                if (command == 0.0F) {
+                    recordsAtStop = recorder.recordCount();
+                }
+            },
+            [](const TelemetrySample &) {}, 150ms, 5000ms, 1000ms, [&origin] { return origin; });
+        controller.attachFlightRecorder(&recorder);
+        const auto before = recorder.recordCount();
+        controller.triggerEmergencyStop();
+        if (recordsAtStop != before || recorder.recordCount() <= before) {
+            std::cerr << "Emergency stop should write the motor before recording" << std::endl;
+            return 1;
+        }
+    }
+
+    // File-backed log with controller and command processor attached.
+    const auto path =
+        (std::filesystem::temp_directory_path() / ("minitrain_flight_" + std::to_string(::getpid()) + ".bin"))
+            .string();
+    std::filesystem::remove(path);
+    {
+        auto recorder = FlightRecorder::open(path, 64 * 1024);
+        if (!recorder) {
+            std::cerr << "Unable to create flight recorder file" << std::endl;
+            return 1;
+        }
+        auto now = origin;
+        TrainController controller(
+            PidController{0.5F, 0.0F, 0.0F, 0.0F, 1.0F}, [](float) {}, [](const TelemetrySample &) {}, 150ms,
+            5000ms, 1000ms, [&now] { return now; });
+        CommandProcessor processor(controller);
+        controller.attachFlightRecorder(recorder.get());
+        processor.attachFlightRecorder(recorder.get());
+
+        CommandFrame frame{};
+        frame.header.sequence = 7;
+        frame.header.targetSpeedMetersPerSecond = 1.5F;
+        frame.header.direction = Direction::Forward;
+        frame.payload = {0x00U};
+        frame.header.auxPayloadLength = 1;
+        processor.processFrame(frame, now);
+        now += 20ms;
+        controller.onSpeedMeasurement(0.5F, 20ms);
+        TelemetrySample sample{};
+        sample.motorCurrentAmps = 0.8F;
+        sample.batteryVoltage = 11.1F;
+        controller.onTelemetrySample(sample);
+        recorder->flush();
+    }
+    {
+        auto reader = FlightRecorder::openReadOnly(path);
+        if (!reader || !reader->readOnly()) {
+            std::cerr << "Unable to reopen flight recorder file" << std::endl;
+            return 1;
+        }
+        std::size_t frames = 0;
+        std::size_t motorCommands = 0;
+        std::size_t transitions = 0;
+        std::size_t telemetryOutputs = 0;
+        bool directionRecorded = false;
+        reader->forEach([&](const FlightRecord &record) {
+            if (const auto recorded = FlightRecorder::decodeCommandFrame(record)) {
+                const auto &header = recorded->frame.header;
+                frames += header.sequence == 7U && header.targetSpeedMetersPerSecond == 1.5F ? 1 : 0;
+            } else if (FlightRecorder::decodeMotorCommand(record)) {
+                ++motorCommands;
+            } else if (const auto transition = FlightRecorder::decodeStateTransition(record)) {
+                ++transitions;
+                directionRecorded = directionRecorded || transition->direction == Direction::Forward;
+            } else if (record.type == FlightRecordType::TelemetryOutput) {
+                const auto telemetry = FlightRecorder::decodeTelemetry(record);
+                telemetryOutputs += telemetry && telemetry->batteryVoltage == 11.1F ? 1 : 0;
+            }
+        });
+        if (frames != 1 || motorCommands != 1 || transitions == 0 || !directionRecorded || telemetryOutputs != 1) {
+            std::cerr << "Flight recorder missed controller activity" << std::endl;
+            return 1;
+        }
+        if (reader->append(FlightRecordType::MotorCommand, origin, nullptr, 0)) {
+            std::cerr << "Read-only flight recorder accepted a write" << std::endl;
+            return 1;
+        }
+    }
+    std::filesystem::remove(path);
+
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,143 @@
+#include "minitrain/camera_streamer.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runFrameFanoutTests() {
+    using namespace std::chrono_literals;
+
+    std::vector<std::vector<std::uint8_t>> buffers(8, std::vector<std::uint8_t>(32));
+    std::vector<camera_fb_t> frames(8);
+    for (std::size_t i = 0; i < frames.size(); ++i) {
+        frames[i].buf = buffers[i].data();
+        frames[i].len = buffers[i].size();
+    }
+    std::vector<int> returned(frames.size(), 0);
+    FrameFanout fanout([&](camera_fb_t *frame) { ++returned[static_cast<std::size_t>(frame - frames.data())]; });
+
+    auto live = fanout.subscribe(2, FrameDropPolicy::DropOldest);
+    auto recorder = fanout.subscribe(4, FrameDropPolicy::DropNewest);
+    for (std::size_t i = 1; i <= 7; ++i) {
+        fanout.publish(&frames[i]);
+    }
+    // live keeps 6 and 7, recorder keeps 1-4: only frame 5 is unreferenced.
+    if (live->droppedFrames() != 5U || recorder->droppedFrames() != 3U || live->pending() != 2U ||
+        recorder->pending() != 4U || returned[5] != 1 || returned[1] != 0 || returned[7] != 0) {
+        std::cerr << "Subscribers should apply their own drop policy" << std::endl;
+        return 1;
+    }
+
+    auto frame = live->tryAcquire(0ms);
+    if (!frame || frame->data() != buffers[6].data() || frame->size() != 32U || frame->useCount() != 1U ||
+        frame->sequence() != 5U) {
+        std::cerr << "Subscriber should receive the driver buffer without copying" << std::endl;
+        return 1;
+    }
+    {
+        const SharedFrame copy = *frame;
+        if (copy.raw() != &frames[6] || frame->useCount() != 2U) {
+            std::cerr << "Copied frame handles should share the buffer" << std::endl;
+            return 1;
+        }
+    }
+    frame.reset();
+    if (returned[6] != 1) {
+        std::cerr << "Frame should return to the driver with its last handle" << std::endl;
+        return 1;
+    }
+
+    fanout.unsubscribe(recorder);
+    fanout.flush();
+    for (std::size_t i = 1; i <= 7; ++i) {
+        if (returned[i] != 1) {
+            std::cerr << "Frame " << i << " returned " << returned[i] << " times" << std::endl;
+            return 1;
+        }
+    }
+    if (fanout.subscriberCount() != 1U || live->tryAcquire(1ms)) {
+        std::cerr << "Flushed subscription should be empty" << std::endl;
+        return 1;
+    }
+
+    // The subscriber table is fixed; a freed slot is reused.
+    std::vector<std::shared_ptr<FrameSubscription>> extra;
+    while (auto subscription = fanout.subscribe(1, FrameDropPolicy::DropOldest)) {
+        extra.push_back(std::move(subscription));
+    }
+    fanout.unsubscribe(extra.back());
+    extra.back() = fanout.subscribe(1, FrameDropPolicy::DropOldest);
+    if (extra.size() != FrameFanout::kMaxSubscribers - 1U || !extra.back() ||
+        fanout.subscriberCount() != FrameFanout::kMaxSubscribers) {
+        std::cerr << "Subscriber table should hold kMaxSubscribers and reuse freed slots" << std::endl;
+        return 1;
+    }
+    for (const auto &subscription : extra) {
+        fanout.unsubscribe(subscription);
+    }
+
+    // Latest-only keeps one frame; stats track delivery and capture latency.
+    auto latest = fanout.subscribe(8, FrameDropPolicy::LatestOnly);
+    const auto captured = std::chrono::steady_clock::now() - 40ms;
+    fanout.publish(&frames[1], captured);
+    fanout.publish(&frames[2], captured);
+    const auto newest = latest->tryAcquire(0ms);
+    const auto latestStats = latest->stats();
+    if (latest->depth() != 1U || !newest || newest->raw() != &frames[2] || newest->captureTime() != captured ||
+        latestStats.deliveredFrames != 1U || latestStats.droppedFrames != 1U || latestStats.pending != 0U ||
+        latestStats.averageLatency < 40ms || latestStats.maxLatency < latestStats.averageLatency) {
+        std::cerr << "Latest-only subscription or its stats are wrong" << std::endl;
+        return 1;
+    }
+    fanout.unsubscribe(latest);
+
+    // Concurrent consumer: every published frame goes back exactly once.
+    constexpr std::size_t kFrames = 20000;
+    std::vector<camera_fb_t> stream(kFrames);
+    std::vector<std::uint8_t> payload(16);
+    for (auto &entry : stream) {
+        entry.buf = payload.data();
+        entry.len = payload.size();
+    }
+    std::vector<std::atomic<int>> released(kFrames);
+    std::atomic<bool> done{false};
+    {
+        FrameFanout concurrent([&](camera_fb_t *entry) { released[static_cast<std::size_t>(entry - stream.data())]++; });
+        auto consumer = concurrent.subscribe(3, FrameDropPolicy::DropOldest);
+        std::size_t consumed = 0;
+        std::thread reader([&] {
+            while (!done.load(std::memory_order_acquire) || consumer->pending() > 0U) {
+                if (auto shared = consumer->tryAcquire(1ms)) {
+                    ++consumed;
+                }
+            }
+        });
+        for (auto &entry : stream) {
+            concurrent.publish(&entry);
+        }
+        done.store(true, std::memory_order_release);
+        reader.join();
+        concurrent.flush();
+        if (consumed + consumer->droppedFrames() != kFrames) {
+            std::cerr << "Concurrent subscriber lost frames" << std::endl;
+            return 1;
+        }
+    }
+    for (const auto &count : released) {
+        if (count.load() != 1) {
+            std::cerr << "Concurrent frames must be returned exactly once" << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,148 @@
+#include "minitrain/jpeg_validator.hpp"
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/synthetic_frame_source.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+// SOI, DQT, SOF0, SOS, scan data with a stuffed 0xFF and a restart marker,
+// EOI.
+std::vector<std::uint8_t> validJpeg() {
+    return {0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x04, 0x00, 0x01, 0xFF, 0xC0, 0x00, 0x0B, 0x08, 0x00, 0x10, 0x00,
+            0x10, 0x01, 0x01, 0x11, 0x00, 0xFF, 0xDA, 0x00, 0x08, 0x01, 0x01, 0x00, 0x00, 0x3F, 0x00, 0x12,
+            0xFF, 0x00, 0x34, 0xFF, 0xD0, 0x56, 0xFF, 0xFF, 0xD9};
+}
+
+// Cuts the EOI off every other frame, like a DMA overrun would.
+class TruncatingFrameSource final : public FrameSource {
+  public:
+    explicit TruncatingFrameSource(std::shared_ptr<FrameSource> inner) : inner_(std::move(inner)) {}
+
+    camera_fb_t *acquire() override {
+        camera_fb_t *frame = inner_->acquire();
+        if (frame != nullptr && (count_++ % 2U) == 1U) {
+            frame->len -= 2;
+        }
+        return frame;
+    }
+    void release(camera_fb_t *frame) override { inner_->release(frame); }
+
+  private:
+    std::shared_ptr<FrameSource> inner_;
+    std::size_t count_{0};
+};
+
+bool expectDefect(std::vector<std::uint8_t> jpeg, JpegDefect expected, const char *what) {
+    const auto defect = validateJpeg(jpeg.data(), jpeg.size());
+    if (defect != expected) {
+        std::cerr << what << ": expected " << toString(expected) << ", got " << toString(defect) << std::endl;
+        return false;
+    }
+    return true;
+}
+} // namespace
+
+int runJpegValidatorTests() {
+    using namespace std::chrono_literals;
+
+    auto padded = validJpeg();
+    padded.insert(padded.end(), 3, 0x00);
+    auto truncatedSegment = validJpeg();
+    truncatedSegment.resize(12);
+    auto badLength = validJpeg();
+    badLength[5] = 0x01;
+    auto oversizedSegment = validJpeg();
+    oversizedSegment[4] = 0x7F;
+    auto noEoi = validJpeg();
+    noEoi.resize(noEoi.size() - 2);
+    auto splicedSoi = validJpeg();
+    splicedSoi[36] = 0xD8;
+    auto strayByte = validJpeg();
+    strayByte[8] = 0x00;
+    auto noFrameHeader = validJpeg();
+    noFrameHeader.erase(noFrameHeader.begin() + 8, noFrameHeader.begin() + 21);
+    const std::vector<std::uint8_t> noScan = {0xFF, 0xD8, 0xFF, 0xD9};
+    auto trailing = validJpeg();
+    trailing.push_back(0x42);
+    auto noSoi = validJpeg();
+    noSoi[1] = 0xD9;
+    if (!expectDefect(validJpeg(), JpegDefect::None, "valid frame") ||
+        !expectDefect(padded, JpegDefect::None, "zero padding") ||
+        !expectDefect({0xFF, 0xD8}, JpegDefect::Truncated, "two bytes") ||
+        !expectDefect(noSoi, JpegDefect::MissingSoi, "missing SOI") ||
+        !expectDefect(truncatedSegment, JpegDefect::Truncated, "truncated segment") ||
+        !expectDefect(badLength, JpegDefect::BadSegmentLength, "segment length below two") ||
+        !expectDefect(oversizedSegment, JpegDefect::Truncated, "segment past the end") ||
+        !expectDefect(noEoi, JpegDefect::MissingEoi, "missing EOI") ||
+        !expectDefect(splicedSoi, JpegDefect::BadMarker, "SOI inside the scan") ||
+        !expectDefect(strayByte, JpegDefect::BadMarker, "stray byte between segments") ||
+        !expectDefect(noFrameHeader, JpegDefect::MissingFrameHeader, "SOS before SOF") ||
+        !expectDefect(noScan, JpegDefect::MissingScan, "no scan") ||
+        !expectDefect(trailing, JpegDefect::TrailingData, "data after EOI")) {
+        return 1;
+    }
+    if (validateJpeg(nullptr, 16) != JpegDefect::Truncated) {
+        std::cerr << "A null buffer should be rejected" << std::endl;
+        return 1;
+    }
+
+    // Every truncated frame is dropped by default and counted.
+    SyntheticFrameConfig cameraConfig{};
+    cameraConfig.period = 2ms;
+    cameraConfig.bufferCount = 3;
+    std::shared_ptr<FrameSource> source =
+        std::make_shared<TruncatingFrameSource>(std::shared_ptr<FrameSource>(SyntheticFrameSource::create(cameraConfig)));
+    CameraStreamer streamer;
+    streamer.setFrameSource(source);
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 8) || !streamer.start()) {
+        std::cerr << "Failed to start the truncating stream" << std::endl;
+        return 1;
+    }
+    std::size_t received = 0;
+    auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (received < 20 && std::chrono::steady_clock::now() < deadline) {
+        auto frame = streamer.tryAcquireFrame(100ms);
+        if (!frame) {
+            continue;
+        }
+        ++received;
+        if (frame->jpegDefect() != JpegDefect::None || validateJpeg(frame->data(), frame->size()) != JpegDefect::None) {
+            std::cerr << "A corrupt frame was published in drop mode" << std::endl;
+            return 1;
+        }
+    }
+    auto stats = streamer.stats();
+    if (received < 20 || stats.corruptFrames < 19U || stats.lastJpegDefect != JpegDefect::MissingEoi) {
+        std::cerr << "Truncated frames should be counted (" << stats.corruptFrames << " corrupt)" << std::endl;
+        return 1;
+    }
+
+    // Flag mode publishes them marked instead.
+    streamer.setJpegValidation(JpegValidation::Flag);
+    std::size_t flagged = 0;
+    deadline = std::chrono::steady_clock::now() + 1s;
+    while (flagged < 5 && std::chrono::steady_clock::now() < deadline) {
+        auto frame = streamer.tryAcquireFrame(100ms);
+        if (frame && frame->jpegDefect() == JpegDefect::MissingEoi) {
+            ++flagged;
+        }
+    }
+    streamer.stop();
+    if (flagged < 5) {
+        std::cerr << "Flag mode should publish corrupt frames with their defect" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -8,9 +8,29 @@ int main() {
     int failures = 0;
     failures += runPidControllerTests();
     failures += runTelemetryTests();
+    failures += runTelemetryHistoryTests();
+    failures += runTelemetryRollupTests();
+    failures += runTelemetryCompressionTests();
+    failures += runTelemetryExportTests();
+    failures += runQuantileSketchTests();
+    failures += runFlightRecorderTests();
+    failures += runEventIndexTests();
+    failures += runSessionReplayTests();
     failures += runCommandProcessorTests();
     failures += runTrainControllerTests();
     failures += runCommandChannelTests();
+    failures += runSpscRingTests();
+    failures += runFrameFanoutTests();
+    failures += runSyntheticFrameSourceTests();
+    failures += runSendSchedulerTests();
+    failures += runVideoFrameHeaderTests();
+    failures += runStaticFrameFilterTests();
+    failures += runVideoQualityControllerTests();
+    failures += runYuvKernelTests();
+    failures += runBufferPoolTests();
+    failures += runCabCameraRigTests();
+    failures += runJpegValidatorTests();
+    failures += runPosixWebSocketClientTests();
 
     if (failures == 0) {
         std::cout << "All firmware tests passed" << std::endl;
@@ -0,0 +1,458 @@
+#include "minitrain/posix_websocket_client.hpp"
+
+#include "minitrain/command_channel.hpp"
+#include "minitrain/command_processor.hpp"
+#include "minitrain/pid_controller.hpp"
+#include "minitrain/train_controller.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <unistd.h>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+
+struct ServerFrame {
+    bool fin{false};
+    std::uint8_t opcode{0};
+    std::vector<std::uint8_t> payload;
+};
+
+// Single-connection RFC 6455 server on 127.0.0.1 running a script against
+// the client under test. Blocking I/O with a receive timeout, so a client
+// bug fails the script instead of hanging the suite.
+class LoopbackServer {
+  public:
+    using Script = std::function<void(LoopbackServer &)>;
+
+    LoopbackServer() {
+        listener_ = ::socket(AF_INET, SOCK_STREAM, 0);
+        sockaddr_in address{};
+        address.sin_family = AF_INET;
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        socklen_t length = sizeof(address);
+        if (::bind(listener_, reinterpret_cast<sockaddr *>(&address), sizeof(address)) != 0 ||
+            ::listen(listener_, 1) != 0 ||
+            ::getsockname(listener_, reinterpret_cast<sockaddr *>(&address), &length) != 0) {
+            fail("listen failed");
+        }
+        port_ = ntohs(address.sin_port);
+    }
+
+    ~LoopbackServer() {
+        join();
+        if (client_ >= 0) {
+            ::close(client_);
+        }
+        ::close(listener_);
+    }
+
+    void run(Script script) {
+        thread_ = std::thread([this, script = std::move(script)] {
+            client_ = ::accept(listener_, nullptr, nullptr);
+            timeval timeout{2, 0};
+            (void)::setsockopt(client_, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+            if (client_ < 0 || !handshake()) {
+                fail("handshake failed");
+                return;
+            }
+            script(*this);
+        });
+    }
+
+    void join() {
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+    }
+
+    [[nodiscard]] std::string uri(const std::string &resource) const {
+        return "ws://127.0.0.1:" + std::to_string(port_) + resource;
+    }
+    [[nodiscard]] std::string requestLine() const { return requestLine_; }
+    [[nodiscard]] std::string error() const {
+        std::scoped_lock lock(mutex_);
+        return error_;
+    }
+
+    void fail(const std::string &message) {
+        std::scoped_lock lock(mutex_);
+        if (error_.empty()) {
+            error_ = message;
+        }
+    }
+
+    void write(bool fin, std::uint8_t opcode, const std::vector<std::uint8_t> &payload, bool masked = false) {
+        std::vector<std::uint8_t> frame{static_cast<std::uint8_t>((fin ? 0x80U : 0U) | opcode)};
+        const std::uint8_t maskBit = masked ? 0x80U : 0U;
+        if (payload.size() < 126U) {
+            frame.push_back(static_cast<std::uint8_t>(maskBit | payload.size()));
+        } else {
+            frame.push_back(maskBit | 126U);
+            frame.push_back(static_cast<std::uint8_t>(payload.size() >> 8U));
+            frame.push_back(static_cast<std::uint8_t>(payload.size()));
+        }
+        if (masked) {
+            frame.insert(frame.end(), 4, 0x00U);
+        }
+        frame.insert(frame.end(), payload.begin(), payload.end());
+        (void)::send(client_, frame.data(), frame.size(), MSG_NOSIGNAL);
+    }
+
+    // Next client frame, unmasked; opcode 0xFF when the connection ended.
+    ServerFrame read() {
+        ServerFrame frame{};
+        std::uint8_t header[2];
+        if (!readExact(header, 2)) {
+            frame.opcode = 0xFFU;
+            return frame;
+        }
+        frame.fin = (header[0] & 0x80U) != 0U;
+        frame.opcode = header[0] & 0x0FU;
+        if ((header[1] & 0x80U) == 0U) {
+            fail("client frame was not masked");
+        }
+        std::uint64_t length = header[1] & 0x7FU;
+        std::uint8_t extended[8];
+        if (length == 126U && readExact(extended, 2)) {
+            length = (static_cast<std::uint64_t>(extended[0]) << 8U) | extended[1];
+        } else if (length == 127U && readExact(extended, 8)) {
+            length = 0;
+            for (const auto byte : extended) {
+                length = (length << 8U) | byte;
+            }
+        }
+        std::uint8_t key[4];
+        frame.payload.resize(static_cast<std::size_t>(length));
+        if (!readExact(key, 4) || !readExact(frame.payload.data(), frame.payload.size())) {
+            frame.opcode = 0xFFU;
+            return frame;
+        }
+        for (std::size_t i = 0; i < frame.payload.size(); ++i) {
+            frame.payload[i] ^= key[i % 4U];
+        }
+        return frame;
+    }
+
+    ServerFrame expect(std::uint8_t opcode, const char *what) {
+        auto frame = read();
+        if (frame.opcode != opcode) {
+            fail(std::string("expected ") + what);
+        }
+        return frame;
+    }
+
+  private:
+    bool readExact(std::uint8_t *data, std::size_t size) {
+        std::size_t done = 0;
+        while (done < size) {
+            const ssize_t result = ::recv(client_, data + done, size - done, 0);
+            if (result <= 0) {
+                return false;
+            }
+            done += static_cast<std::size_t>(result);
+        }
+        return true;
+    }
+
+    bool handshake() {
+        std::string request;
+        char byte = 0;
+        while (request.find("\r\n\r\n") == std::string::npos && ::recv(client_, &byte, 1, 0) == 1) {
+            request.push_back(byte);
+        }
+        requestLine_ = request.substr(0, request.find("\r\n"));
+        const auto keyStart = request.find("Sec-WebSocket-Key: ");
+        if (keyStart == std::string::npos) {
+            return false;
+        }
+        const auto valueStart = keyStart + std::strlen("Sec-WebSocket-Key: ");
+        const auto key = request.substr(valueStart, request.find("\r\n", valueStart) - valueStart);
+        const std::string response = "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+                                     "Sec-WebSocket-Accept: " +
+                                     webSocketAcceptKey(key) + "\r\n\r\n";
+        return ::send(client_, response.data(), response.size(), MSG_NOSIGNAL) ==
+               static_cast<ssize_t>(response.size());
+    }
+
+    int listener_{-1};
+    int client_{-1};
+    std::uint16_t port_{0};
+    std::thread thread_;
+    std::string requestLine_;
+    mutable std::mutex mutex_;
+    std::string error_;
+};
+
+std::vector<std::uint8_t> bytes(const std::string &text) { return {text.begin(), text.end()}; }
+
+bool waitFor(const std::function<bool()> &condition) {
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds{2};
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) {
+            return false;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds{2});
+    }
+    return true;
+}
+
+} // namespace
+
+int runPosixWebSocketClientTests() {
+    using namespace std::chrono_literals;
+
+    if (webSocketAcceptKey("dGhlIHNhbXBsZSBub25jZQ==") != "s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") {
+        std::cerr << "Accept key does not match the RFC 6455 example" << std::endl;
+        return 1;
+    }
+    const auto secure = parseWebSocketUri("wss://[::1]:8443/ws?train=7");
+    const auto plain = parseWebSocketUri("ws://gateway.local");
+    if (!secure || !secure->secure || secure->host != "::1" || secure->port != 8443 ||
+        secure->resource != "/ws?train=7" || !plain || plain->port != 80 || plain->resource != "/" ||
+        parseWebSocketUri("http://gateway.local") || parseWebSocketUri("ws://:80/") ||
+        parseWebSocketUri("ws://host:70000/")) {
+        std::cerr << "WebSocket URI parsing is wrong" << std::endl;
+        return 1;
+    }
+    PosixWebSocketClient noTls;
+    if (noTls.open("wss://127.0.0.1:1/") || noTls.lastError().empty()) {
+        std::cerr << "wss:// without a secure transport should be refused" << std::endl;
+        return 1;
+    }
+
+    // Full session: ping, text echo, fragmented binary both ways with a ping
+    // between fragments, 16- and 64-bit lengths, then a clean close.
+    std::vector<std::uint8_t> large(70000);
+    for (std::size_t i = 0; i < large.size(); ++i) {
+        large[i] = static_cast<std::uint8_t>(i * 7U);
+    }
+    {
+        LoopbackServer server;
+        server.run([&large](LoopbackServer &peer) {
+            const auto text = peer.expect(0x1U, "text");
+            // The pong is queued before the echo reaches the handler, so it
+            // precedes anything the client sends in response.
+            peer.write(true, 0x9U, bytes("hb"));
+            peer.write(true, 0x1U, text.payload);
+            if (peer.expect(0xAU, "pong").payload != bytes("hb")) {
+                peer.fail("pong should echo the ping payload");
+            }
+            const auto first = peer.expect(0x2U, "binary fragment");
+            const auto middle = peer.expect(0x0U, "continuation");
+            const auto last = peer.expect(0x0U, "final continuation");
+            if (first.fin || middle.fin || !last.fin || first.payload != bytes("abc") || middle.payload != bytes("de") ||
+                last.payload != bytes("f")) {
+                peer.fail("segments should arrive as one fragmented message");
+            }
+            peer.write(false, 0x2U, bytes("abc"));
+            peer.write(true, 0x9U, bytes("x"));
+            peer.write(true, 0x0U, bytes("def"));
+            (void)peer.expect(0xAU, "pong between fragments");
+            if (peer.expect(0x2U, "large binary").payload != large) {
+                peer.fail("64-bit length payload was corrupted");
+            }
+            peer.write(true, 0x2U, std::vector<std::uint8_t>(300, 0x5AU));
+            const auto close = peer.expect(0x8U, "close");
+            if (close.payload != std::vector<std::uint8_t>{0x03U, 0xE8U}) {
+                peer.fail("close should carry status 1000");
+            }
+            peer.write(true, 0x8U, close.payload);
+        });
+
+        PosixWebSocketClient client;
+        std::mutex textMutex;
+        std::vector<std::string> texts;
+        std::atomic<int> connects{0};
+        std::atomic<int> disconnects{0};
+        client.setMessageHandler([&](const std::string &text) {
+            std::scoped_lock lock(textMutex);
+            texts.push_back(text);
+        });
+        client.setOnConnected([&connects] { ++connects; });
+        client.setOnDisconnected([&disconnects] { ++disconnects; });
+        if (!client.open(server.uri("/train?id=1")) || !client.isConnected() || connects != 1 ||
+            server.requestLine() != "GET /train?id=1 HTTP/1.1") {
+            std::cerr << "Loopback connection failed: " << client.lastError() << std::endl;
+            return 1;
+        }
+        const std::uint8_t abc[] = {'a', 'b', 'c'};
+        const std::uint8_t de[] = {'d', 'e'};
+        const std::uint8_t f[] = {'f'};
+        const ByteSegment segments[] = {{abc, 3}, {de, 2}, {f, 1}};
+        const bool textSent = client.sendText("hello");
+        const bool echoed = waitFor([&] {
+            std::scoped_lock lock(textMutex);
+            return !texts.empty();
+        });
+        if (!textSent || !echoed || texts.front() != "hello") {
+            std::cerr << "Text message did not round-trip" << std::endl;
+            return 1;
+        }
+        const bool fragmentsSent = client.sendBinary(segments, 3);
+        const auto reassembled = client.receiveBinary(1s);
+        if (!fragmentsSent || !reassembled || *reassembled != bytes("abcdef")) {
+            std::cerr << "Fragmented binary message was not reassembled" << std::endl;
+            return 1;
+        }
+        const bool largeSent = client.sendBinary(large.data(), large.size());
+        const auto medium = client.receiveBinary(1s);
+        if (!largeSent || !medium || medium->size() != 300U) {
+            std::cerr << "Extended payload lengths failed" << std::endl;
+            return 1;
+        }
+        client.close();
+        server.join();
+        if (!server.error().empty() || client.isConnected() || disconnects != 1 || client.sendText("late")) {
+            std::cerr << "Session script failed: " << server.error() << std::endl;
+            return 1;
+        }
+    }
+
+    // Keepalive: a silent server gets a ping and is dropped after pongTimeout.
+    {
+        LoopbackServer server;
+        server.run([](LoopbackServer &peer) {
+            (void)peer.expect(0x9U, "keepalive ping");
+            (void)peer.read();
+        });
+        PosixWebSocketConfig config{};
+        config.pingInterval = 30ms;
+        config.pongTimeout = 30ms;
+        PosixWebSocketClient client(config);
+        std::atomic<bool> dropped{false};
+        client.setOnDisconnected([&dropped] { dropped = true; });
+        if (!client.open(server.uri("/")) || !waitFor([&dropped] { return dropped.load(); }) ||
+            client.lastError() != "Keepalive timed out") {
+            std::cerr << "Unanswered keepalive should drop the connection" << std::endl;
+            return 1;
+        }
+        client.close();
+        server.join();
+        if (!server.error().empty()) {
+            std::cerr << "Keepalive script failed: " << server.error() << std::endl;
+            return 1;
+        }
+    }
+
+    // A masked server frame is a protocol error: close with status 1002.
+    {
+        LoopbackServer server;
+        server.run([](LoopbackServer &peer) {
+            peer.write(true, 0x2U, bytes("bad"), true);
+            if (peer.expect(0x8U, "protocol error close").payload != std::vector<std::uint8_t>{0x03U, 0xEAU}) {
+                peer.fail("protocol errors should close with 1002");
+            }
+        });
+        PosixWebSocketClient client;
+        if (!client.open(server.uri("/")) || !waitFor([&client] { return !client.isConnected(); }) ||
+            client.receiveBinary(0ms)) {
+            std::cerr << "Masked server frame should fail the connection" << std::endl;
+            return 1;
+        }
+        client.close();
+        server.join();
+        if (!server.error().empty()) {
+            std::cerr << "Protocol error script failed: " << server.error() << std::endl;
+            return 1;
+        }
+    }
+
+    // As a WebSocketClient behind CommandChannel.
+    {
+        CommandFrame command;
+        command.header.sequence = 1;
+        command.header.targetSpeedMetersPerSecond = 1.25F;
+        command.header.direction = Direction::Forward;
+        command.payload.push_back(0x00U);
+        command.header.auxPayloadLength = 1;
+        const auto encoded = CommandChannel::encodeFrame(command);
+        LoopbackServer server;
+        server.run([&encoded](LoopbackServer &peer) {
+            peer.write(true, 0x2U, encoded);
+            (void)peer.expect(0x2U, "telemetry");
+            const auto close = peer.expect(0x8U, "close");
+            peer.write(true, 0x8U, close.payload);
+        });
+        TrainController controller(
+            PidController{0.8F, 0.1F, 0.0F, 0.0F, 1.0F}, [](float) {}, [](const TelemetrySample &) {});
+        CommandProcessor processor(controller);
+        CommandChannel::Config config;
+        config.uri = server.uri("/control");
+        config.receiveTimeout = 500ms;
+        CommandChannel channel(config, std::make_unique<PosixWebSocketClient>(), processor);
+        channel.start();
+        channel.poll();
+        channel.publishTelemetry(TelemetrySample{}, 1);
+        channel.stop();
+        server.join();
+        if (!server.error().empty() || controller.state().targetSpeed != 1.25F) {
+            std::cerr << "CommandChannel over the loopback client failed: " << server.error() << std::endl;
+            return 1;
+        }
+    }
+
+    // A binary handler gets reassembled messages instead of the queue.
+    {
+        CommandFrame command;
+        command.header.sequence = 2;
+        command.header.targetSpeedMetersPerSecond = 0.75F;
+        command.header.direction = Direction::Forward;
+        command.payload.push_back(0x00U);
+        command.header.auxPayloadLength = 1;
+        const auto encoded = CommandChannel::encodeFrame(command);
+        LoopbackServer server;
+        server.run([&encoded](LoopbackServer &peer) {
+            const auto split = encoded.begin() + 10;
+            peer.write(false, 0x2U, std::vector<std::uint8_t>(encoded.begin(), split));
+            peer.write(true, 0x9U, bytes("x"));
+            peer.write(true, 0x0U, std::vector<std::uint8_t>(split, encoded.end()));
+            (void)peer.expect(0xAU, "pong between fragments");
+            peer.write(true, 0x2U, bytes("short"));
+            const auto close = peer.expect(0x8U, "close");
+            peer.write(true, 0x8U, close.payload);
+        });
+        TrainController controller(
+            PidController{0.8F, 0.1F, 0.0F, 0.0F, 1.0F}, [](float) {}, [](const TelemetrySample &) {});
+        CommandProcessor processor(controller);
+        PosixWebSocketClient client;
+        std::atomic<int> processed{0};
+        std::atomic<int> rejected{0};
+        client.setBinaryHandler([&](const std::uint8_t *data, std::size_t size) {
+            try {
+                (void)processor.processFrame(CommandChannel::decodeFrame(data, size), std::chrono::steady_clock::now());
+                ++processed;
+            } catch (const std::invalid_argument &) {
+                ++rejected;
+            }
+        });
+        const bool opened = client.open(server.uri("/"));
+        const bool delivered = waitFor([&] { return processed + rejected == 2; });
+        client.close();
+        server.join();
+        if (!opened || !delivered || processed != 1 || rejected != 1 || client.receiveBinary(0ms) ||
+            controller.state().targetSpeed != 0.75F || !server.error().empty()) {
+            std::cerr << "Binary handler did not receive the reassembled command frame: " << server.error() << std::endl;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,109 @@
+#include "minitrain/quantile_sketch.hpp"
+#include "minitrain/train_controller.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runQuantileSketchTests() {
+    QuantileSketch sketch;
+    if (sketch.quantile(0.5)) {
+        std::cerr << "Empty sketch should not report quantiles" << std::endl;
+        return 1;
+    }
+
+    // Nominal current around 0.5 A with a 1 % tail of surges up to 6 A.
+    std::vector<float> values;
+    std::uint32_t state = 12345U;
+    for (std::uint32_t i = 0; i < 200000U; ++i) {
+        state = state * 1664525U + 1013904223U;
+        const float noise = static_cast<float>(state >> 8U) / static_cast<float>(1U << 24U);
+        const float value = (i % 100U) == 0U ? 4.0F + 2.0F * noise : 0.4F + 0.2F * noise;
+        values.push_back(value);
+        sketch.add(value);
+    }
+
+    if (sketch.retainedValues() > 3U * QuantileSketch::kDefaultK + 64U) {
+        std::cerr << "Sketch should stay bounded (" << sketch.retainedValues() << " values)" << std::endl;
+        return 1;
+    }
+    if (sketch.count() != values.size() || sketch.max() != *std::max_element(values.begin(), values.end())) {
+        std::cerr << "Sketch should track count and extremes exactly" << std::endl;
+        return 1;
+    }
+
+    std::vector<float> sorted = values;
+    std::sort(sorted.begin(), sorted.end());
+    auto exactRank = [&sorted](float value) {
+        return static_cast<double>(std::lower_bound(sorted.begin(), sorted.end(), value) - sorted.begin()) /
+               static_cast<double>(sorted.size());
+    };
+    for (const double q : {0.01, 0.25, 0.5, 0.9, 0.99, 0.995}) {
+        const auto estimate = sketch.quantile(q);
+        if (!estimate || std::fabs(exactRank(*estimate) - q) > 0.02) {
+            std::cerr << "Quantile " << q << " outside rank error bound" << std::endl;
+            return 1;
+        }
+    }
+    if (*sketch.quantile(0.995) < 4.0F) {
+        std::cerr << "High percentiles should expose current surges" << std::endl;
+        return 1;
+    }
+
+    QuantileSketch first;
+    QuantileSketch second;
+    for (std::size_t i = 0; i < values.size(); ++i) {
+        (i < values.size() / 3 ? first : second).add(values[i]);
+    }
+    first.merge(second);
+    if (first.count() != values.size()) {
+        std::cerr << "Merged sketch should account for all observations" << std::endl;
+        return 1;
+    }
+    const auto mergedMedian = first.quantile(0.5);
+    if (!mergedMedian || std::fabs(exactRank(*mergedMedian) - 0.5) > 0.02) {
+        std::cerr << "Merged sketch median outside rank error bound" << std::endl;
+        return 1;
+    }
+
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point now{};
+    TrainController controller(
+        PidController{0.5F, 0.0F, 0.0F, 0.0F, 1.0F}, [](float) {}, [](const TelemetrySample &) {},
+        std::chrono::milliseconds{150}, std::chrono::milliseconds{5000}, std::chrono::milliseconds{1000},
+        [&now]() { return now; });
+    controller.registerCommandTimestamp(now);
+    controller.setTargetSpeed(1.0F);
+    for (int i = 0; i < 50; ++i) {
+        now += std::chrono::milliseconds{20};
+        controller.onSpeedMeasurement(0.75F, std::chrono::milliseconds{20});
+        TelemetrySample sample{};
+        sample.motorCurrentAmps = i == 49 ? 3.0F : 0.5F;
+        controller.onTelemetrySample(sample);
+    }
+    auto fleet = controller.quantiles();
+    const auto speedError = fleet.speedErrorMetersPerSecond.quantile(0.5);
+    if (!speedError || std::fabs(*speedError - 0.25F) > 1e-4F) {
+        std::cerr << "Controller should record speed-tracking error" << std::endl;
+        return 1;
+    }
+    if (fleet.motorCurrentAmps.max() != 3.0F || fleet.commandAgeMillis.max() < 999.0F) {
+        std::cerr << "Controller should record current surges and command age" << std::endl;
+        return 1;
+    }
+    fleet.merge(controller.quantiles());
+    if (fleet.motorCurrentAmps.count() != 100U) {
+        std::cerr << "Controller quantiles should merge across trains" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace minitrain::tests
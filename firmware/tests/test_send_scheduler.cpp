@@ -0,0 +1,160 @@
+#include "minitrain/send_scheduler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+struct SentMessage {
+    bool binary{true};
+    std::vector<std::uint8_t> bytes;
+};
+
+std::uint32_t readLittle32(const std::vector<std::uint8_t> &bytes, std::size_t offset) {
+    return static_cast<std::uint32_t>(bytes[offset]) | (static_cast<std::uint32_t>(bytes[offset + 1]) << 8U) |
+           (static_cast<std::uint32_t>(bytes[offset + 2]) << 16U) | (static_cast<std::uint32_t>(bytes[offset + 3]) << 24U);
+}
+} // namespace
+
+int runSendSchedulerTests() {
+    using namespace std::chrono_literals;
+
+    std::vector<SentMessage> sent;
+    bool transportUp = true;
+    SendSchedulerConfig config{};
+    config.classes[static_cast<std::size_t>(TrafficClass::Video)] = TrafficClassConfig{2, 1000};
+    SendScheduler scheduler(
+        [&](bool binary, const ByteSegment *segments, std::size_t count) {
+            SentMessage message{binary, {}};
+            for (std::size_t i = 0; i < count; ++i) {
+                message.bytes.insert(message.bytes.end(), segments[i].data, segments[i].data + segments[i].size);
+            }
+            sent.push_back(std::move(message));
+            return transportUp;
+        },
+        config);
+
+    if (scheduler.enqueue(TrafficClass::Control, OutboundMessage{}) || scheduler.sendNext()) {
+        std::cerr << "Empty messages should not be scheduled" << std::endl;
+        return 1;
+    }
+
+    // A 2500 byte frame split across two segments goes out as three chunks,
+    // with control and telemetry overtaking it between chunks.
+    std::vector<std::uint8_t> header(100);
+    std::vector<std::uint8_t> body(2400);
+    for (std::size_t i = 0; i < body.size(); ++i) {
+        body[i] = static_cast<std::uint8_t>(i * 7U);
+    }
+    OutboundMessage frame;
+    frame.addSegment({header.data(), header.size()});
+    frame.addSegment({body.data(), body.size()});
+    OutboundMessage full = frame;
+    full.addSegment({header.data(), 1});
+    full.addSegment({header.data(), 1});
+    if (full.addSegment({header.data(), 1}) || full.segmentCount != kMaxMessageSegments) {
+        std::cerr << "Segments beyond the inline capacity should be refused" << std::endl;
+        return 1;
+    }
+    scheduler.enqueue(TrafficClass::Video, std::move(frame));
+    scheduler.sendNext();
+    scheduler.enqueue(TrafficClass::Telemetry, OutboundMessage::text("speed=1.0"));
+    scheduler.enqueue(TrafficClass::Control, OutboundMessage::bytes({0x01, 0x02}));
+    while (scheduler.sendNext()) {
+    }
+    if (sent.size() != 5U || sent[1].bytes != std::vector<std::uint8_t>{0x01, 0x02} || sent[2].binary ||
+        std::string(sent[2].bytes.begin(), sent[2].bytes.end()) != "speed=1.0") {
+        std::cerr << "Control and telemetry should preempt a chunked video frame" << std::endl;
+        return 1;
+    }
+    std::vector<std::uint8_t> reassembled;
+    for (const std::size_t index : {std::size_t{0}, std::size_t{3}, std::size_t{4}}) {
+        const auto &chunk = sent[index].bytes;
+        if (chunk.size() < kChunkHeaderBytes || !std::equal(kChunkMagic.begin(), kChunkMagic.end(), chunk.begin()) ||
+            readLittle32(chunk, 4) != 0U || readLittle32(chunk, 8) != reassembled.size() ||
+            readLittle32(chunk, 12) != 2500U) {
+            std::cerr << "Chunk header is wrong" << std::endl;
+            return 1;
+        }
+        reassembled.insert(reassembled.end(), chunk.begin() + kChunkHeaderBytes, chunk.end());
+    }
+    std::vector<std::uint8_t> expected = header;
+    expected.insert(expected.end(), body.begin(), body.end());
+    if (reassembled != expected || sent[4].bytes.size() != kChunkHeaderBytes + 500U) {
+        std::cerr << "Chunks should reassemble into the original frame" << std::endl;
+        return 1;
+    }
+
+    const auto video = scheduler.stats(TrafficClass::Video);
+    const auto control = scheduler.stats(TrafficClass::Control);
+    const auto telemetry = scheduler.stats(TrafficClass::Telemetry);
+    if (video.sentMessages != 1U || video.sentChunks != 3U || video.sentBytes != 2500U || video.preemptions != 0U ||
+        control.sentBytes != 2U || control.preemptions != 1U || telemetry.preemptions != 1U ||
+        video.averageLatency.count() <= 0 || video.maxLatency < video.averageLatency || scheduler.pending() != 0U) {
+        std::cerr << "Per-class accounting is wrong" << std::endl;
+        return 1;
+    }
+
+    // The video queue keeps the newest frames; a failed chunk abandons the
+    // rest of its frame.
+    // Every message completes exactly once, after its memory is released.
+    sent.clear();
+    std::string outcomes;
+    for (std::uint8_t i = 0; i < 4; ++i) {
+        auto message = OutboundMessage::bytes(std::vector<std::uint8_t>(1500, i));
+        std::weak_ptr<const void> memory = message.owner;
+        message.onComplete = [&outcomes, memory, i](bool ok) {
+            outcomes += static_cast<char>('0' + i);
+            outcomes += memory.expired() ? (ok ? "s" : "d") : "!";
+        };
+        scheduler.enqueue(TrafficClass::Video, std::move(message));
+    }
+    transportUp = false;
+    scheduler.sendNext();
+    transportUp = true;
+    while (scheduler.sendNext()) {
+    }
+    const auto lossy = scheduler.stats(TrafficClass::Video);
+    if (lossy.droppedMessages != 2U || lossy.failedMessages != 1U || lossy.sentMessages != 2U || sent.size() != 3U ||
+        sent[0].bytes[kChunkHeaderBytes] != 2U || sent[1].bytes[kChunkHeaderBytes] != 3U ||
+        readLittle32(sent[1].bytes, 4) != 2U || outcomes != "0d1d2d3s") {
+        std::cerr << "Video queue overflow or send failure was handled wrongly " << outcomes << std::endl;
+        return 1;
+    }
+
+    // Background sender drains everything and clear() discards a backlog.
+    sent.clear();
+    scheduler.start();
+    for (int i = 0; i < 10; ++i) {
+        scheduler.enqueue(TrafficClass::Telemetry, OutboundMessage::text("t"));
+    }
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (scheduler.pending() > 0U && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(1ms);
+    }
+    scheduler.stop();
+    if (scheduler.isRunning() || scheduler.stats(TrafficClass::Telemetry).sentMessages != 11U) {
+        std::cerr << "Background sender should drain the queues" << std::endl;
+        return 1;
+    }
+    scheduler.enqueue(TrafficClass::Video, OutboundMessage::bytes(std::vector<std::uint8_t>(3000, 1)));
+    scheduler.sendNext();
+    scheduler.clear();
+    if (scheduler.pending() != 0U || scheduler.sendNext() ||
+        scheduler.stats(TrafficClass::Video).droppedMessages != 3U) {
+        std::cerr << "clear() should drop queued and partial messages" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,125 @@
+#include "minitrain/command_processor.hpp"
+#include "minitrain/flight_recorder.hpp"
+#include "minitrain/session_replay.hpp"
+#include "minitrain/train_controller.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+namespace {
+
+// Drives a controller for a few seconds, including a command gap long enough
+// to engage the fail-safe ramp, with every input and output logged.
+void recordSession(FlightRecorder &recorder, float speed) {
+    using namespace std::chrono_literals;
+    const ReplayConfig config{};
+    const auto origin = std::chrono::steady_clock::time_point{} + 2h;
+    const auto systemOrigin = std::chrono::system_clock::time_point{} + std::chrono::hours{24 * 365 * 50};
+    auto now = origin;
+    auto systemNow = systemOrigin;
+
+    TrainController controller(config.pid, [](float) {}, [](const TelemetrySample &) {}, config.staleCommandThreshold,
+                               config.pilotReleaseDuration, config.failSafeRampDuration, [&now] { return now; });
+    CommandProcessor processor(controller, std::nullopt, [&systemNow] { return systemNow; });
+    controller.attachFlightRecorder(&recorder);
+    processor.attachFlightRecorder(&recorder);
+
+    float measured = 0.0F;
+    for (std::uint32_t tick = 0; tick < 250U; ++tick) {
+        now = origin + tick * 20ms;
+        systemNow = systemOrigin + tick * 20ms;
+        const bool gap = tick >= 120U && tick < 160U;
+        if (!gap) {
+            CommandFrame frame{};
+            frame.header.sequence = tick;
+            frame.header.timestampMicros = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::microseconds>((systemNow - 4ms).time_since_epoch()).count());
+            frame.header.targetSpeedMetersPerSecond = speed;
+            frame.header.direction = Direction::Forward;
+            frame.payload = {static_cast<std::uint8_t>(tick % 50U < 25U ? 0x01U : 0x00U)};
+            frame.header.auxPayloadLength = 1;
+            processor.processFrame(frame, now);
+        }
+        controller.onSpeedMeasurement(measured, 20ms);
+        measured += (controller.state().appliedSpeed + 0.1F - measured) * 0.2F;
+        if (tick % 5U == 0U) {
+            TelemetrySample sample{};
+            sample.speedMetersPerSecond = measured;
+            sample.motorCurrentAmps = 0.4F + measured * 0.1F;
+            sample.batteryVoltage = 11.4F;
+            sample.temperatureCelsius = 31.0F;
+            sample.sequence = tick;
+            controller.onTelemetrySample(sample);
+        }
+    }
+}
+
+} // namespace
+
+int runSessionReplayTests() {
+    std::vector<std::uint8_t> region(256 * 1024);
+    FlightRecorder recorder{region.data(), region.size()};
+    recordSession(recorder, 1.2F);
+
+    const auto report = replaySession(recorder);
+    if (!report.matches() || report.motorCommands < 250U || report.telemetrySamples < 50U) {
+        std::cerr << "Replay diverged from the recorded session";
+        if (report.firstMismatch) {
+            std::cerr << ": " << report.firstMismatch->detail;
+        }
+        std::cerr << std::endl;
+        return 1;
+    }
+    if (report.recordedSpan < std::chrono::seconds{4}) {
+        std::cerr << "Replay should report the recorded time span" << std::endl;
+        return 1;
+    }
+
+    ReplayConfig retuned{};
+    retuned.pid = PidController{1.6F, 0.2F, 0.05F, 0.0F, 1.0F};
+    const auto diverged = replaySession(recorder, retuned);
+    if (diverged.matches() || diverged.motorMismatches == 0 || !diverged.firstMismatch ||
+        diverged.firstMismatch->type != FlightRecordType::MotorCommand) {
+        std::cerr << "Replay with different gains should flag motor command differences" << std::endl;
+        return 1;
+    }
+
+    const auto directory =
+        std::filesystem::temp_directory_path() / ("minitrain_replay_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    std::vector<std::string> paths;
+    for (int i = 0; i < 3; ++i) {
+        const auto path = (directory / ("session_" + std::to_string(i) + ".bin")).string();
+        auto file = FlightRecorder::open(path, 256 * 1024);
+        if (!file) {
+            std::cerr << "Unable to create replay recording" << std::endl;
+            std::filesystem::remove_all(directory);
+            return 1;
+        }
+        recordSession(*file, 0.5F + static_cast<float>(i) * 0.3F);
+        paths.push_back(path);
+    }
+    paths.push_back((directory / "missing.bin").string());
+
+    const auto summary = replaySessions(paths, ReplayConfig{}, 2);
+    std::filesystem::remove_all(directory);
+    if (summary.sessions.size() != 4U || summary.failures() != 1U || summary.sessions[3].loaded ||
+        !summary.sessions[0].matches() || !summary.sessions[2].matches() ||
+        summary.inputRecords != 3U * report.inputRecords || summary.speedup() <= 1.0) {
+        std::cerr << "Parallel replay summary is wrong" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,101 @@
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/spsc_ring.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <thread>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runSpscRingTests() {
+    using namespace std::chrono_literals;
+
+    SpscRing<std::uint32_t> ring{3};
+    std::uint32_t value = 0;
+    if (!ring.tryPush(1U) || !ring.tryPush(2U) || !ring.tryPush(3U) || ring.tryPush(4U) || ring.size() != 3U) {
+        std::cerr << "SPSC ring should hold exactly its capacity" << std::endl;
+        return 1;
+    }
+    if (!ring.tryPop(value) || value != 1U || !ring.tryPush(4U) || !ring.tryPop(value) || value != 2U) {
+        std::cerr << "SPSC ring should be FIFO across the wrap" << std::endl;
+        return 1;
+    }
+    while (ring.tryPop(value)) {
+    }
+    if (value != 4U || !ring.empty()) {
+        std::cerr << "SPSC ring did not drain" << std::endl;
+        return 1;
+    }
+
+    EventCount event;
+    const auto key = event.prepareWait();
+    if (event.wait(key, std::chrono::steady_clock::now() + 1ms)) {
+        std::cerr << "Event count wait should time out without a notification" << std::endl;
+        return 1;
+    }
+
+    // Producer evicting the oldest entry while the consumer sleeps on the
+    // event count: order is preserved and every entry is accounted for once.
+    constexpr std::uint32_t kCount = 200000;
+    SpscRing<std::uint32_t> frames{4};
+    std::atomic<bool> done{false};
+    std::uint32_t received = 0;
+    bool ordered = true;
+    std::thread consumer([&] {
+        std::uint32_t last = 0;
+        while (true) {
+            std::uint32_t item = 0;
+            const auto wait = event.prepareWait();
+            if (frames.tryPop(item)) {
+                event.cancelWait();
+                ordered = ordered && item > last;
+                last = item;
+                ++received;
+                continue;
+            }
+            if (done.load(std::memory_order_acquire)) {
+                event.cancelWait();
+                break;
+            }
+            event.wait(wait, std::chrono::steady_clock::now() + 10ms);
+        }
+    });
+    std::uint32_t evicted = 0;
+    for (std::uint32_t item = 1; item <= kCount; ++item) {
+        std::uint32_t oldest = 0;
+        while (!frames.tryPush(item)) {
+            evicted += frames.tryPop(oldest) ? 1U : 0U;
+        }
+        event.notifyAll();
+    }
+    done.store(true, std::memory_order_release);
+    event.notifyAll();
+    consumer.join();
+    if (!ordered || received + evicted != kCount || received == 0U) {
+        std::cerr << "SPSC ring lost or reordered entries: " << received << " received, " << evicted << " evicted"
+                  << std::endl;
+        return 1;
+    }
+
+    // Without a camera driver every capture fails and the stream stops itself.
+    CameraStreamer streamer;
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 2, 3) || !streamer.start()) {
+        std::cerr << "Camera streamer failed to start" << std::endl;
+        return 1;
+    }
+    for (int i = 0; i < 100 && streamer.isRunning(); ++i) {
+        (void)streamer.tryAcquireFrame(10ms);
+    }
+    if (streamer.isRunning() || streamer.tryAcquireFrame(0ms)) {
+        std::cerr << "Camera streamer should stop after repeated capture failures" << std::endl;
+        return 1;
+    }
+    streamer.stop();
+    return 0;
+}
+
+} // namespace minitrain::tests
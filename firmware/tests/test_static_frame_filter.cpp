@@ -0,0 +1,170 @@
+#include "minitrain/static_frame_filter.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+// SOI, a DQT segment holding `table`, SOS, entropy bytes, EOI.
+std::vector<std::uint8_t> makeJpeg(std::uint8_t table, std::size_t entropyBytes, std::uint8_t seed) {
+    std::vector<std::uint8_t> jpeg{0xFF, 0xD8, 0xFF, 0xDB, 0x00, 0x03, table, 0xFF, 0xDA, 0x00, 0x04, 0x01, 0x02};
+    for (std::size_t i = 0; i < entropyBytes; ++i) {
+        jpeg.push_back(static_cast<std::uint8_t>((i * 13U + seed) % 0xFFU));
+    }
+    jpeg.push_back(0xFF);
+    jpeg.push_back(0xD9);
+    return jpeg;
+}
+
+camera_fb_t describe(std::vector<std::uint8_t> &bytes, pixformat_t format, std::size_t width = 0,
+                     std::size_t height = 0) {
+    camera_fb_t frame{};
+    frame.buf = bytes.data();
+    frame.len = bytes.size();
+    frame.format = format;
+    frame.width = width;
+    frame.height = height;
+    return frame;
+}
+
+std::vector<std::uint8_t> makeYuv(std::size_t width, std::size_t height, int offset) {
+    std::vector<std::uint8_t> yuv(width * height * 2U, 128U);
+    for (std::size_t y = 0; y < height; ++y) {
+        for (std::size_t x = 0; x < width; ++x) {
+            yuv[(y * width + x) * 2U] = static_cast<std::uint8_t>(std::min(255, static_cast<int>(x + y) + offset));
+        }
+    }
+    return yuv;
+}
+std::vector<std::uint8_t> readFixture(const std::string &relative) {
+    const auto base = std::filesystem::path(__FILE__).parent_path() / ".." / ".." / relative;
+    std::ifstream file(base, std::ios::binary);
+    if (!file) {
+        throw std::runtime_error("Unable to open fixture: " + base.string());
+    }
+    return std::vector<std::uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+} // namespace
+
+int runStaticFrameFilterTests() {
+    using namespace std::chrono_literals;
+
+    // Two captures of a still scene with independent sensor noise (+-6) and
+    // the same scene panned by 8 px, encoded by libjpeg at quality 80 with
+    // 4:2:2 sampling like the OV2640. The stills differ in length, so none
+    // of their entropy-coded bytes line up.
+    auto stillA = readFixture("fixtures/video/still_a.jpg");
+    auto stillB = readFixture("fixtures/video/still_b.jpg");
+    auto panned = readFixture("fixtures/video/panned.jpg");
+    const auto stillAFingerprint = fingerprintFrame(describe(stillA, PIXFORMAT_JPEG));
+    const auto stillBFingerprint = fingerprintFrame(describe(stillB, PIXFORMAT_JPEG));
+    const auto pannedFingerprint = fingerprintFrame(describe(panned, PIXFORMAT_JPEG));
+    // Cell means as libjpeg decodes them: 88 top left, 133 on the building.
+    if (stillA.size() == stillB.size() || !stillAFingerprint.hasLuma ||
+        std::abs(stillAFingerprint.samples[0] - 88) > 2 || std::abs(stillAFingerprint.samples[19] - 133) > 2 ||
+        stillAFingerprint.hash == stillBFingerprint.hash || !nearlyIdentical(stillAFingerprint, stillBFingerprint) ||
+        nearlyIdentical(stillAFingerprint, pannedFingerprint)) {
+        std::cerr << "Re-encoded JPEGs of a still scene should match, a panned one should not" << std::endl;
+        return 1;
+    }
+    // 4:2:0 with a restart marker every 7 MCUs: 63, 95, 126, 158 across the
+    // top row.
+    auto restarts = readFixture("fixtures/video/restart_420.jpg");
+    const auto restartFingerprint = fingerprintFrame(describe(restarts, PIXFORMAT_JPEG));
+    if (!restartFingerprint.hasLuma || std::abs(restartFingerprint.samples[0] - 63) > 2 ||
+        std::abs(restartFingerprint.samples[3] - 158) > 2) {
+        std::cerr << "JPEG DC grid should survive restart markers and 4:2:0 sampling" << std::endl;
+        return 1;
+    }
+
+    // Streams the grid cannot be taken from (no tables here) are compared on
+    // their entropy-coded data only: the same scan behind other tables is
+    // a repeat, anything else is not.
+    auto base = makeJpeg(1, 4000, 0);
+    auto retabled = makeJpeg(2, 4000, 0);
+    // A moving scene that happens to compress to the same size.
+    auto moving = makeJpeg(1, 4000, 5);
+    const auto baseFingerprint = fingerprintFrame(describe(base, PIXFORMAT_JPEG));
+    const auto retabledFingerprint = fingerprintFrame(describe(retabled, PIXFORMAT_JPEG));
+    const auto movingFingerprint = fingerprintFrame(describe(moving, PIXFORMAT_JPEG));
+    if (baseFingerprint.payloadBytes != 4000U || baseFingerprint.hasLuma ||
+        !nearlyIdentical(baseFingerprint, retabledFingerprint) || nearlyIdentical(baseFingerprint, movingFingerprint) ||
+        nearlyIdentical(FrameFingerprint{}, baseFingerprint)) {
+        std::cerr << "JPEG fingerprints should compare entropy data" << std::endl;
+        return 1;
+    }
+
+    // YUV422 frames compare their luma grid.
+    auto still = makeYuv(64, 48, 0);
+    auto flicker = makeYuv(64, 48, 2);
+    auto brighter = makeYuv(64, 48, 40);
+    const auto stillFingerprint = fingerprintFrame(describe(still, PIXFORMAT_YUV422, 64, 48));
+    if (!stillFingerprint.hasLuma || stillFingerprint.samples[0] > stillFingerprint.samples.back() ||
+        !nearlyIdentical(stillFingerprint, fingerprintFrame(describe(flicker, PIXFORMAT_YUV422, 64, 48))) ||
+        nearlyIdentical(stillFingerprint, fingerprintFrame(describe(brighter, PIXFORMAT_YUV422, 64, 48)))) {
+        std::cerr << "YUV422 fingerprints should compare the luma grid" << std::endl;
+        return 1;
+    }
+
+    // Unchanged frames are held back until the keep-alive interval passes.
+    std::vector<camera_fb_t> frames{describe(stillA, PIXFORMAT_JPEG), describe(stillB, PIXFORMAT_JPEG),
+                                    describe(stillA, PIXFORMAT_JPEG), describe(panned, PIXFORMAT_JPEG)};
+    FrameFanout fanout([](camera_fb_t *) {});
+    auto subscription = fanout.subscribe(1, FrameDropPolicy::DropOldest);
+    StaticFrameFilterConfig config{};
+    config.keepAliveInterval = 500ms;
+    StaticFrameFilter filter(config);
+    const auto start = std::chrono::steady_clock::now();
+    const std::vector<std::pair<std::size_t, std::chrono::milliseconds>> schedule{
+        {0, 0ms}, {1, 100ms}, {2, 200ms}, {1, 600ms}, {3, 700ms}, {3, 800ms}};
+    std::vector<bool> decisions;
+    for (const auto &[index, offset] : schedule) {
+        fanout.publish(&frames[index], start + offset, fingerprintFrame(frames[index]));
+        const auto frame = subscription->tryAcquire(0ms);
+        decisions.push_back(frame && filter.shouldSend(*frame, start + offset));
+    }
+    if (decisions != std::vector<bool>{true, false, false, true, true, false} || filter.sentFrames() != 3U ||
+        filter.suppressedFrames() != 3U) {
+        std::cerr << "Static frame filter made the wrong decisions" << std::endl;
+        return 1;
+    }
+    // Equal-sized frames with different content are both sent.
+    StaticFrameFilter motion(config);
+    auto movingFrame = describe(moving, PIXFORMAT_JPEG);
+    bool motionSent = true;
+    auto baseFrame = describe(base, PIXFORMAT_JPEG);
+    for (auto *raw : {&baseFrame, &movingFrame}) {
+        fanout.publish(raw, start, fingerprintFrame(*raw));
+        const auto frame = subscription->tryAcquire(0ms);
+        motionSent = motionSent && frame && motion.shouldSend(*frame, start + 100ms);
+    }
+    if (!motionSent || motion.suppressedFrames() != 0U) {
+        std::cerr << "Different JPEGs of equal size should both be sent" << std::endl;
+        return 1;
+    }
+
+    filter.reset();
+    fanout.publish(&frames[3], start + 900ms, fingerprintFrame(frames[3]));
+    fanout.publish(&frames[0], start + 900ms);
+    const auto unfingerprinted = subscription->tryAcquire(0ms);
+    if (!unfingerprinted || !filter.shouldSend(*unfingerprinted, start + 900ms)) {
+        std::cerr << "Frames without a fingerprint should always be sent" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
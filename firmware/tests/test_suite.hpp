@@ -4,8 +4,28 @@ namespace minitrain::tests {
 
 int runPidControllerTests();
 int runTelemetryTests();
+int runTelemetryHistoryTests();
+int runTelemetryRollupTests();
+int runTelemetryCompressionTests();
+int runTelemetryExportTests();
+int runQuantileSketchTests();
+int runFlightRecorderTests();
+int runEventIndexTests();
+int runSessionReplayTests();
 int runCommandProcessorTests();
 int runTrainControllerTests();
 int runCommandChannelTests();
+int runSpscRingTests();
+int runFrameFanoutTests();
+int runSyntheticFrameSourceTests();
+int runSendSchedulerTests();
+int runVideoFrameHeaderTests();
+int runStaticFrameFilterTests();
+int runVideoQualityControllerTests();
+int runYuvKernelTests();
+int runBufferPoolTests();
+int runCabCameraRigTests();
+int runJpegValidatorTests();
+int runPosixWebSocketClientTests();
 
 } // namespace minitrain::tests
@@ -0,0 +1,258 @@
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/synthetic_frame_source.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+namespace {
+bool isJpeg(const std::uint8_t *data, std::size_t size) {
+    return size >= 4 && data[0] == 0xFFU && data[1] == 0xD8U && data[size - 2] == 0xFFU && data[size - 1] == 0xD9U;
+}
+
+// Spends a fixed time in the driver call, like a sensor readout.
+class SlowFrameSource final : public FrameSource {
+  public:
+    SlowFrameSource(std::shared_ptr<FrameSource> inner, std::chrono::milliseconds delay)
+        : inner_(std::move(inner)), delay_(delay) {}
+
+    camera_fb_t *acquire() override {
+        std::this_thread::sleep_for(delay_);
+        return inner_->acquire();
+    }
+    void release(camera_fb_t *frame) override { inner_->release(frame); }
+
+  private:
+    std::shared_ptr<FrameSource> inner_;
+    std::chrono::milliseconds delay_;
+};
+
+void writeFile(const std::filesystem::path &path, const std::vector<std::uint8_t> &bytes) {
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char *>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+} // namespace
+
+int runSyntheticFrameSourceTests() {
+    using namespace std::chrono_literals;
+
+    SyntheticFrameConfig config{};
+    config.bufferCount = 0;
+    if (SyntheticFrameSource::create(config)) {
+        std::cerr << "Synthetic source without buffers should be rejected" << std::endl;
+        return 1;
+    }
+    config.bufferCount = 2;
+    config.jpegDirectory = "/nonexistent/minitrain";
+    if (SyntheticFrameSource::create(config)) {
+        std::cerr << "Synthetic source without JPEGs to replay should be rejected" << std::endl;
+        return 1;
+    }
+
+    // Generated JPEGs from a pool limited like fb_count.
+    config.jpegDirectory.clear();
+    config.jpegBytes = 2048;
+    config.period = 2ms;
+    config.bufferTimeout = 5ms;
+    auto source = SyntheticFrameSource::create(config);
+    auto *first = source ? source->acquire() : nullptr;
+    auto *second = source ? source->acquire() : nullptr;
+    if (first == nullptr || second == nullptr || first == second || !isJpeg(first->buf, first->len) ||
+        first->len != 2048U || first->width != 320U) {
+        std::cerr << "Synthetic source should produce JPEG frames from its pool" << std::endl;
+        return 1;
+    }
+    if (source->acquire() != nullptr || source->buffersInUse() != 2U) {
+        std::cerr << "Synthetic source should run dry once every buffer is held" << std::endl;
+        return 1;
+    }
+    source->release(first);
+    source->release(second);
+    const auto paced = std::chrono::steady_clock::now();
+    for (int i = 0; i < 20; ++i) {
+        source->release(source->acquire());
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - paced;
+    if (elapsed < 36ms || source->framesProduced() != 22U || source->buffersInUse() != 0U) {
+        std::cerr << "Synthetic source should pace frames at its period" << std::endl;
+        return 1;
+    }
+
+    config.format = PIXFORMAT_YUV422;
+    config.width = 64;
+    config.height = 48;
+    config.jitter = 500us;
+    auto yuv = SyntheticFrameSource::create(config);
+    auto *raw = yuv ? yuv->acquire() : nullptr;
+    if (raw == nullptr || raw->len != 64U * 48U * 2U || raw->format != PIXFORMAT_YUV422) {
+        std::cerr << "Synthetic YUV422 frame has the wrong size" << std::endl;
+        return 1;
+    }
+    yuv->release(raw);
+
+    // Replay from a directory, in name order, ignoring other files.
+    const auto directory =
+        std::filesystem::temp_directory_path() / ("minitrain_frames_" + std::to_string(::getpid()));
+    std::filesystem::create_directories(directory);
+    writeFile(directory / "a.jpg", {0xFF, 0xD8, 0x01, 0xFF, 0xD9});
+    writeFile(directory / "b.JPEG", {0xFF, 0xD8, 0x02, 0x02, 0xFF, 0xD9});
+    writeFile(directory / "notes.txt", {0x00});
+    config = SyntheticFrameConfig{};
+    config.period = 1ms;
+    config.jpegDirectory = directory.string();
+    auto replay = SyntheticFrameSource::create(config);
+    std::filesystem::remove_all(directory);
+    std::vector<std::size_t> sizes;
+    for (int i = 0; replay && i < 3; ++i) {
+        auto *frame = replay->acquire();
+        sizes.push_back(frame != nullptr ? frame->len : 0U);
+        replay->release(frame);
+    }
+    if (sizes != std::vector<std::size_t>{5U, 6U, 5U}) {
+        std::cerr << "Synthetic source should replay JPEG files in order" << std::endl;
+        return 1;
+    }
+
+    // End to end through CameraStreamer.
+    config = SyntheticFrameConfig{};
+    config.period = 1ms;
+    config.bufferCount = 4;
+    config.jpegBytes = 1024;
+    std::shared_ptr<SyntheticFrameSource> shared = SyntheticFrameSource::create(config);
+    CameraStreamer streamer;
+    streamer.setFrameSource(shared);
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 2) || !streamer.start()) {
+        std::cerr << "Camera streamer failed to start on a synthetic source" << std::endl;
+        return 1;
+    }
+    std::size_t received = 0;
+    for (int i = 0; i < 20; ++i) {
+        const auto frame = streamer.tryAcquireFrame(100ms);
+        received += frame && isJpeg(frame->data(), frame->size()) && frame->fingerprint().valid() ? 1U : 0U;
+    }
+    const auto stats = streamer.stats();
+    streamer.stop();
+    if (received != 20U || stats.deliveredFrames != 20U || stats.capturedFrames < 20U || stats.captureFps <= 0.0 ||
+        shared->buffersInUse() != 0U) {
+        std::cerr << "Camera streamer should deliver synthetic frames" << std::endl;
+        return 1;
+    }
+
+    // Capture runs on absolute 10 ms ticks: the 3 ms the driver takes per
+    // frame must not add up into the period.
+    streamer.setFrameSource(std::make_shared<SlowFrameSource>(shared, 3ms));
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 10ms, 2) || !streamer.start()) {
+        std::cerr << "Camera streamer failed to restart" << std::endl;
+        return 1;
+    }
+    std::vector<std::uint64_t> sequences;
+    std::vector<std::chrono::steady_clock::time_point> captureTimes;
+    for (int i = 0; i < 16; ++i) {
+        const auto frame = streamer.tryAcquireFrame(100ms);
+        if (!frame) {
+            break;
+        }
+        sequences.push_back(frame->sequence());
+        captureTimes.push_back(frame->captureTime());
+    }
+    const auto missedTicks = streamer.stats().missedTicks;
+    streamer.stop();
+    streamer.setFrameSource(shared);
+    // A tick lost to scheduling noise shifts the grid by a whole period.
+    const auto span = captureTimes.size() == 16U ? captureTimes.back() - captureTimes.front() : 0ms;
+    const auto expected = 150ms + 10ms * static_cast<int>(missedTicks);
+    if (sequences.size() != 16U || sequences.back() - sequences.front() != 15U || span < expected - 5ms ||
+        span > expected + 7ms) {
+        std::cerr << "Paced capture should keep a 10 ms cadence, took "
+                  << std::chrono::duration_cast<std::chrono::microseconds>(span).count() << " us for 15 frames"
+                  << std::endl;
+        return 1;
+    }
+
+    // A subscriber that never reads makes the adaptive policy slow capture
+    // down instead of stopping the stream.
+    CameraBackpressureConfig adaptive{};
+    adaptive.policy = CameraBackpressure::AdaptiveInterval;
+    adaptive.maxCaptureInterval = 20ms;
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 2, 5, nullptr, adaptive) ||
+        !streamer.start()) {
+        std::cerr << "Camera streamer failed to restart" << std::endl;
+        return 1;
+    }
+    // Consumers come and go while the capture thread publishes and sums
+    // their drop counters every frame.
+    const auto churnUntil = std::chrono::steady_clock::now() + 50ms;
+    std::size_t churned = 0;
+    while (std::chrono::steady_clock::now() < churnUntil) {
+        auto transient = streamer.subscribe(1, FrameDropPolicy::DropOldest);
+        (void)transient->tryAcquire(0ms);
+        streamer.unsubscribe(transient);
+        ++churned;
+    }
+    if (churned == 0U || !streamer.isRunning()) {
+        std::cerr << "Subscribing while capturing should not disturb the stream" << std::endl;
+        return 1;
+    }
+    auto stalled = streamer.subscribe(1, FrameDropPolicy::DropNewest);
+    std::this_thread::sleep_for(150ms);
+    const auto congested = streamer.stats();
+    const bool running = streamer.isRunning();
+    // A new base interval, e.g. from the quality controller, moves the floor
+    // without discarding the backoff.
+    streamer.setCaptureInterval(5ms);
+    const auto retuned = streamer.stats().captureInterval;
+    streamer.unsubscribe(stalled);
+    streamer.stop();
+    if (!running || congested.captureInterval != 20ms || congested.droppedFrames == 0U) {
+        std::cerr << "Adaptive backpressure should stretch the capture interval, got "
+                  << congested.captureInterval.count() << " us" << std::endl;
+        return 1;
+    }
+    if (retuned != 20ms) {
+        std::cerr << "Raising the capture floor should keep the backoff, got " << retuned.count() << " us"
+                  << std::endl;
+        return 1;
+    }
+
+    // A monitor polls stats() while the default queue is torn down by
+    // initialize() and created again by the first tryAcquireFrame().
+    std::atomic<bool> polling{true};
+    std::uint64_t observed = 0;
+    std::thread monitor([&] {
+        while (polling.load()) {
+            observed += streamer.stats().deliveredFrames;
+        }
+    });
+    std::size_t restarted = 0;
+    for (int i = 0; i < 50; ++i) {
+        if (streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 1) && streamer.start() &&
+            streamer.tryAcquireFrame(100ms)) {
+            ++restarted;
+        }
+    }
+    polling.store(false);
+    monitor.join();
+    streamer.stop();
+    if (restarted != 50U || shared->buffersInUse() != 0U) {
+        std::cerr << "Restarting under a stats() poller should keep delivering frames (" << restarted << ", "
+                  << observed << ")" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -1,6 +1,8 @@
 #include "minitrain/telemetry.hpp"
 
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 #include "test_suite.hpp"
 
@@ -79,6 +81,35 @@ int runTelemetryTests() {
         return 1;
     }
 
+    TelemetryAggregator longWindow{250};
+    std::vector<float> speeds;
+    for (std::uint32_t i = 0; i < 100000U; ++i) {
+        const float speed = 2.0F + static_cast<float>(i % 97U) * 0.013F + (i % 2U == 0U ? 1000.0F : 0.0F);
+        speeds.push_back(speed);
+        auto sample = makeSample(speed, 0.5F, 11.0F, 30.0F, i == 99990U, LightsState::BothRed,
+                                 LightsSource::Automatic, ActiveCab::None, 0x00U, false, i, i, Direction::Forward);
+        longWindow.addSample(sample);
+    }
+    double expected = 0.0;
+    for (std::size_t i = speeds.size() - longWindow.windowSize(); i < speeds.size(); ++i) {
+        expected += speeds[i];
+    }
+    expected /= static_cast<double>(longWindow.windowSize());
+    auto longAvg = longWindow.average();
+    if (!longAvg || std::fabs(longAvg->speedMetersPerSecond - static_cast<float>(expected)) > 1e-3F) {
+        std::cerr << "Running sums should not drift over long sessions" << std::endl;
+        return 1;
+    }
+    if (!longAvg->failSafeActive || longWindow.size() != 250U) {
+        std::cerr << "Fail-safe flag should stay set while inside the window" << std::endl;
+        return 1;
+    }
+    auto longHistory = longWindow.history();
+    if (longHistory.front().sequence != 100000U - 250U || longHistory.back().sequence != 99999U) {
+        std::cerr << "History should be ordered oldest to newest" << std::endl;
+        return 1;
+    }
+
     return 0;
 }
 
@@ -0,0 +1,104 @@
+#include "minitrain/telemetry_compression.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+namespace {
+
+bool sameBits(float a, float b) { return std::memcmp(&a, &b, sizeof(float)) == 0; }
+
+bool identical(const TelemetrySample &a, const TelemetrySample &b) {
+    return sameBits(a.speedMetersPerSecond, b.speedMetersPerSecond) &&
+           sameBits(a.motorCurrentAmps, b.motorCurrentAmps) && sameBits(a.batteryVoltage, b.batteryVoltage) &&
+           sameBits(a.temperatureCelsius, b.temperatureCelsius) &&
+           sameBits(a.appliedSpeedMetersPerSecond, b.appliedSpeedMetersPerSecond) &&
+           sameBits(a.failSafeProgress, b.failSafeProgress) && a.failSafeActive == b.failSafeActive &&
+           a.failSafeElapsedMillis == b.failSafeElapsedMillis && a.lightsState == b.lightsState &&
+           a.lightsSource == b.lightsSource && a.activeCab == b.activeCab &&
+           a.lightsOverrideMask == b.lightsOverrideMask && a.lightsTelemetryOnly == b.lightsTelemetryOnly &&
+           a.sessionId == b.sessionId && a.sequence == b.sequence && a.commandTimestamp == b.commandTimestamp &&
+           a.appliedDirection == b.appliedDirection && a.source == b.source;
+}
+
+} // namespace
+
+int runTelemetryCompressionTests() {
+    std::vector<TimedTelemetrySample> trace;
+    for (std::uint32_t i = 0; i < 3000U; ++i) {
+        TimedTelemetrySample entry{};
+        // 50 Hz with occasional scheduling jitter.
+        entry.timestampMillis = 1'700'000'000'000ULL + i * 20ULL + (i % 97U == 0U ? 3U : 0U);
+        auto &sample = entry.sample;
+        sample.speedMetersPerSecond = std::round(1000.0F * (1.0F + 0.5F * std::sin(static_cast<float>(i) / 200.0F))) / 1000.0F;
+        sample.appliedSpeedMetersPerSecond = sample.speedMetersPerSecond;
+        sample.motorCurrentAmps = static_cast<float>(400U + (i / 25U) % 8U) / 1000.0F;
+        sample.batteryVoltage = 11.5F;
+        sample.temperatureCelsius = 30.0F + static_cast<float>(i / 600U) * 0.25F;
+        sample.failSafeActive = i >= 2000U && i < 2050U;
+        sample.failSafeElapsedMillis = sample.failSafeActive ? (i - 2000U) * 20U : 0U;
+        sample.failSafeProgress = sample.failSafeActive ? static_cast<float>(i - 2000U) / 50.0F : 0.0F;
+        sample.sequence = i + 1U;
+        sample.commandTimestamp = 5'000'000ULL + i * 20'000ULL;
+        sample.appliedDirection = i < 1500U ? Direction::Forward : Direction::Reverse;
+        sample.activeCab = i < 1500U ? ActiveCab::Front : ActiveCab::Rear;
+        sample.lightsState = i < 1500U ? LightsState::FrontWhiteRearRed : LightsState::FrontRedRearWhite;
+        sample.sessionId[0] = i < 2500U ? 0x11U : 0x22U;
+        trace.push_back(entry);
+    }
+    trace[1234].sample.batteryVoltage = std::nanf("");
+
+    TelemetryCompressor compressor;
+    for (const auto &entry : trace) {
+        compressor.append(entry.sample, entry.timestampMillis);
+    }
+    if (compressor.sampleCount() != trace.size()) {
+        std::cerr << "Compressor lost track of the sample count" << std::endl;
+        return 1;
+    }
+    const auto block = compressor.finish();
+    if (compressor.sampleCount() != 0U) {
+        std::cerr << "finish() should start a new block" << std::endl;
+        return 1;
+    }
+
+    const auto decoded = TelemetryDecompressor::decodeAll(block);
+    if (decoded.size() != trace.size()) {
+        std::cerr << "Decompressor returned " << decoded.size() << " samples" << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < trace.size(); ++i) {
+        if (decoded[i].timestampMillis != trace[i].timestampMillis || !identical(decoded[i].sample, trace[i].sample)) {
+            std::cerr << "Compressed telemetry round trip mismatch at sample " << i << std::endl;
+            return 1;
+        }
+    }
+
+    // 36-byte wire payload plus an 8-byte timestamp per sample.
+    const double raw = static_cast<double>(trace.size()) * 44.0;
+    if (raw / static_cast<double>(block.size()) < 5.0) {
+        std::cerr << "Slowly varying telemetry should compress well, got " << block.size() << " bytes" << std::endl;
+        return 1;
+    }
+
+    bool threw = false;
+    try {
+        std::vector<std::uint8_t> truncated(block.begin(), block.begin() + static_cast<std::ptrdiff_t>(block.size() / 2));
+        TelemetryDecompressor::decodeAll(truncated);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    if (!threw) {
+        std::cerr << "Truncated compressed block should be rejected" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace minitrain::tests
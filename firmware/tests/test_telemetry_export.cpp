@@ -0,0 +1,131 @@
+#include "minitrain/telemetry_export.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include <unistd.h>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runTelemetryExportTests() {
+    const auto path =
+        (std::filesystem::temp_directory_path() / ("minitrain_export_" + std::to_string(::getpid()) + ".mtcx"))
+            .string();
+    const auto inFault = [](std::uint32_t row) { return (row >= 5000U && row < 5200U) || (row >= 9990U && row < 10010U); };
+    {
+        auto writer = TelemetryExportWriter::create(path, 1000);
+        if (!writer) {
+            std::cerr << "Unable to create telemetry export" << std::endl;
+            return 1;
+        }
+        for (std::uint32_t row = 0; row < 20000U; ++row) {
+            TelemetrySample sample{};
+            sample.speedMetersPerSecond = static_cast<float>(row % 1500U) / 1000.0F;
+            sample.motorCurrentAmps = inFault(row) || row == 15000U ? 2.5F : 0.6F;
+            sample.failSafeActive = inFault(row) || (row >= 17000U && row < 17100U);
+            sample.batteryVoltage = 11.8F;
+            sample.sequence = row;
+            sample.sessionId[15] = 0x42U;
+            writer->append(sample, 1'000'000ULL + row * 20ULL);
+        }
+        if (!writer->close() || writer->rowCount() != 20000U) {
+            std::cerr << "Telemetry export failed to close" << std::endl;
+            return 1;
+        }
+    }
+
+    auto reader = TelemetryExportReader::open(path);
+    if (!reader || reader->rowCount() != 20000U || reader->blockCount() != 20U) {
+        std::cerr << "Unable to reopen telemetry export" << std::endl;
+        std::filesystem::remove(path);
+        return 1;
+    }
+
+    const auto speeds = reader->readColumn(ExportColumn::Speed, 4);
+    const auto sessions = reader->readColumn(ExportColumn::SessionIdLow, 4);
+    bool roundTrip = speeds.size() == 20000U && sessions.size() == 20000U;
+    for (std::uint32_t row = 0; roundTrip && row < 20000U; row += 7U) {
+        roundTrip = speeds[row] == static_cast<double>(static_cast<float>(row % 1500U) / 1000.0F) && sessions[row] == 0x42;
+    }
+    if (!roundTrip) {
+        std::cerr << "Exported columns did not round trip" << std::endl;
+        std::filesystem::remove(path);
+        return 1;
+    }
+
+    // failSafeActive && current > 2 A
+    const auto result = reader->scan({{ExportColumn::FailSafeActive, 1.0, 1.0},
+                                      {ExportColumn::MotorCurrent, 2.0, std::numeric_limits<double>::infinity()}},
+                                     4);
+    std::ifstream exported(path, std::ios::binary);
+    std::vector<std::uint8_t> bytes((std::istreambuf_iterator<char>(exported)), std::istreambuf_iterator<char>());
+    exported.close();
+    std::filesystem::remove(path);
+    if (result.matchedRows != 220U || result.intervals.size() != 2U) {
+        std::cerr << "Export scan returned " << result.matchedRows << " rows in " << result.intervals.size()
+                  << " intervals" << std::endl;
+        return 1;
+    }
+    if (result.intervals[0].startMillis != 1'000'000ULL + 5000ULL * 20ULL ||
+        result.intervals[0].endMillis != 1'000'000ULL + 5199ULL * 20ULL ||
+        result.intervals[1].startMillis != 1'000'000ULL + 9990ULL * 20ULL ||
+        result.intervals[1].endMillis != 1'000'000ULL + 10009ULL * 20ULL) {
+        std::cerr << "Export scan intervals should merge across block boundaries" << std::endl;
+        return 1;
+    }
+    // Blocks 15 (current only) and 17 (fail-safe only) each match one predicate
+    // and are skipped on statistics alone, like every block but 5, 9 and 10.
+    if (result.blocksScanned != 3U || result.blocksSkipped != 17U) {
+        std::cerr << "Export scan should skip blocks using min/max statistics" << std::endl;
+        return 1;
+    }
+
+    // A chunk offset near UINT64_MAX must not wrap past the bounds check.
+    {
+        auto little64 = [&bytes](std::size_t at) {
+            std::uint64_t value = 0;
+            for (std::size_t i = 0; i < 8; ++i) {
+                value |= static_cast<std::uint64_t>(bytes[at + i]) << (8U * i);
+            }
+            return value;
+        };
+        // Footer: column count and padding, block count, row count, column names, then
+        // per block a row count followed by one entry per column.
+        std::size_t at = static_cast<std::size_t>(little64(bytes.size() - 16));
+        const std::size_t columns = bytes[at] | (bytes[at + 1] << 8U);
+        at += 2 + 2 + 4 + 8;
+        for (std::size_t column = 0; column < columns; ++column) {
+            at += 2U + bytes[at + 1];
+        }
+        at += 4;
+        const std::uint64_t wrapping = std::numeric_limits<std::uint64_t>::max() - 7U;
+        for (std::size_t i = 0; i < 8; ++i) {
+            bytes[at + i] = static_cast<std::uint8_t>(wrapping >> (8U * i));
+        }
+        const auto corruptPath = path + ".corrupt";
+        std::ofstream(corruptPath, std::ios::binary).write(reinterpret_cast<const char *>(bytes.data()),
+                                                           static_cast<std::streamsize>(bytes.size()));
+        const bool opened = TelemetryExportReader::open(corruptPath) != nullptr;
+        std::filesystem::remove(corruptPath);
+        if (opened) {
+            std::cerr << "Export with a wrapping chunk offset should be rejected" << std::endl;
+            return 1;
+        }
+    }
+
+    if (TelemetryExportReader::open(path + ".missing")) {
+        std::cerr << "Opening a missing export should fail" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
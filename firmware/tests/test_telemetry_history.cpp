@@ -0,0 +1,98 @@
+#include "minitrain/telemetry.hpp"
+#include "minitrain/telemetry_history.hpp"
+
+#include <cmath>
+#include <iostream>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runTelemetryHistoryTests() {
+    TelemetryHistory history{500};
+
+    auto makeSample = [](std::uint32_t index) {
+        TelemetrySample sample{};
+        sample.speedMetersPerSecond = 1.234F + static_cast<float>(index % 10U) * 0.1F;
+        sample.appliedSpeedMetersPerSecond = -0.5F;
+        sample.motorCurrentAmps = 0.75F;
+        sample.batteryVoltage = 11.987F;
+        sample.temperatureCelsius = -4.25F;
+        sample.failSafeActive = (index % 7U) == 0U;
+        sample.failSafeProgress = 0.5F;
+        sample.failSafeElapsedMillis = index * 3U;
+        sample.sequence = index;
+        sample.commandTimestamp = 1'000'000'000ULL + index * 20'000ULL;
+        sample.appliedDirection = (index % 2U) == 0U ? Direction::Forward : Direction::Reverse;
+        sample.sessionId[0] = static_cast<std::uint8_t>(index / 100U);
+        sample.lightsState = index < 250U ? LightsState::FrontWhiteRearRed : LightsState::BothRed;
+        sample.activeCab = ActiveCab::Front;
+        sample.lightsOverrideMask = 0x01U;
+        return sample;
+    };
+
+    for (std::uint32_t i = 0; i < 1200U; ++i) {
+        history.append(makeSample(i));
+    }
+
+    if (history.size() != 500U) {
+        std::cerr << "History should be bounded by its capacity" << std::endl;
+        return 1;
+    }
+    if (history.runCount() > 6U) {
+        std::cerr << "Session and lights metadata should be run-length encoded" << std::endl;
+        return 1;
+    }
+
+    std::uint32_t expectedSequence = 700U;
+    for (const auto sample : history.view()) {
+        const auto expected = makeSample(expectedSequence);
+        if (sample.sequence != expected.sequence || sample.commandTimestamp != expected.commandTimestamp ||
+            sample.sessionId != expected.sessionId || sample.lightsState != expected.lightsState ||
+            sample.appliedDirection != expected.appliedDirection ||
+            sample.failSafeActive != expected.failSafeActive ||
+            sample.failSafeElapsedMillis != expected.failSafeElapsedMillis) {
+            std::cerr << "History metadata mismatch at sequence " << expectedSequence << std::endl;
+            return 1;
+        }
+        if (std::fabs(sample.speedMetersPerSecond - expected.speedMetersPerSecond) > 0.0005F ||
+            std::fabs(sample.batteryVoltage - expected.batteryVoltage) > 0.0005F ||
+            std::fabs(sample.motorCurrentAmps - expected.motorCurrentAmps) > 0.0005F ||
+            std::fabs(sample.temperatureCelsius - expected.temperatureCelsius) > 0.005F ||
+            std::fabs(sample.appliedSpeedMetersPerSecond - expected.appliedSpeedMetersPerSecond) > 0.0005F) {
+            std::cerr << "History quantisation error too large at sequence " << expectedSequence << std::endl;
+            return 1;
+        }
+        ++expectedSequence;
+    }
+    if (expectedSequence != 1200U) {
+        std::cerr << "History view should iterate every retained sample" << std::endl;
+        return 1;
+    }
+
+    // Metadata changing on every sample exhausts run slots before sample slots.
+    TelemetryHistory churn{64, 8};
+    for (std::uint32_t i = 0; i < 100U; ++i) {
+        auto sample = makeSample(i);
+        sample.lightsOverrideMask = static_cast<std::uint8_t>(i);
+        churn.append(sample);
+    }
+    if (churn.size() != 8U || churn.view().front().sequence != 92U || churn.view().back().lightsOverrideMask != 99U) {
+        std::cerr << "Run exhaustion should evict the oldest samples" << std::endl;
+        return 1;
+    }
+
+    TelemetryAggregator aggregator{10, 200};
+    for (std::uint32_t i = 0; i < 300U; ++i) {
+        aggregator.addSample(makeSample(i));
+    }
+    const auto view = aggregator.history();
+    if (view.size() != 200U || view.front().sequence != 100U || aggregator.size() != 10U) {
+        std::cerr << "Aggregator history may be longer than its averaging window" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,98 @@
+#include "minitrain/telemetry_rollup.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <iostream>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runTelemetryRollupTests() {
+    TelemetryRollup rollup;
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point start{};
+
+    // 90 minutes at 50 Hz with a linearly decaying battery and a current spike each minute.
+    const std::uint32_t totalSamples = 90U * 60U * 50U;
+    for (std::uint32_t i = 0; i < totalSamples; ++i) {
+        TelemetrySample sample{};
+        sample.speedMetersPerSecond = 1.0F;
+        sample.batteryVoltage = 12.6F - static_cast<float>(i) * 1e-5F;
+        sample.motorCurrentAmps = (i % 3000U) == 1500U ? 4.0F : 0.5F;
+        sample.failSafeActive = (i % 3000U) < 10U;
+        rollup.addSample(sample, start + std::chrono::milliseconds{20} * i);
+    }
+
+    const auto seconds = rollup.buckets(RollupResolution::OneSecond);
+    const auto minutes = rollup.buckets(RollupResolution::OneMinute);
+    if (seconds.size() != TelemetryRollup::kBucketsPerTier || minutes.size() != TelemetryRollup::kBucketsPerTier) {
+        std::cerr << "Rollup tiers should be bounded" << std::endl;
+        return 1;
+    }
+    if (seconds.back().count != 50U || seconds.front().count != 50U) {
+        std::cerr << "One-second buckets should hold 50 samples at 50 Hz" << std::endl;
+        return 1;
+    }
+    const auto &lastMinute = minutes.back();
+    if (lastMinute.count != 3000U || lastMinute.failSafeSamples != 10U) {
+        std::cerr << "Minute buckets should include samples still held by finer tiers" << std::endl;
+        return 1;
+    }
+    if (lastMinute.field(RollupField::MotorCurrent).max != 4.0F ||
+        lastMinute.field(RollupField::MotorCurrent).min != 0.5F) {
+        std::cerr << "Minute buckets should keep current extremes" << std::endl;
+        return 1;
+    }
+    const float expectedMinVoltage = 12.6F - static_cast<float>(totalSamples - 1U) * 1e-5F;
+    if (std::fabs(lastMinute.field(RollupField::BatteryVoltage).min - expectedMinVoltage) > 1e-4F) {
+        std::cerr << "Minute bucket minimum voltage mismatch" << std::endl;
+        return 1;
+    }
+    if (minutes.back().startMillis - minutes.front().startMillis != 59U * 60000U) {
+        std::cerr << "Minute tier should span one hour" << std::endl;
+        return 1;
+    }
+
+    const auto tens = rollup.buckets(RollupResolution::TenSeconds);
+    std::uint64_t tenCount = 0;
+    for (std::size_t i = tens.size() - 6; i < tens.size(); ++i) {
+        tenCount += tens[i].count;
+    }
+    if (tenCount != 3000U) {
+        std::cerr << "Ten-second tier should cascade from the one-second tier" << std::endl;
+        return 1;
+    }
+
+    const auto wire = rollup.encode(RollupResolution::OneMinute);
+    if (wire.size() > 4096U) {
+        std::cerr << "An hour of rollups should fit in a few KB (" << wire.size() << " bytes)" << std::endl;
+        return 1;
+    }
+    const auto decoded = TelemetryRollup::decode(wire);
+    if (decoded.resolution != RollupResolution::OneMinute || decoded.buckets.size() != minutes.size()) {
+        std::cerr << "Rollup decode should preserve resolution and bucket count" << std::endl;
+        return 1;
+    }
+    for (std::size_t i = 0; i < minutes.size(); ++i) {
+        const auto &expected = minutes[i];
+        const auto &actual = decoded.buckets[i];
+        const float expectedMean = expected.field(RollupField::BatteryVoltage).mean(expected.count);
+        const float actualMean = actual.field(RollupField::BatteryVoltage).mean(actual.count);
+        if (actual.startMillis != expected.startMillis || actual.count != expected.count ||
+            std::fabs(actualMean - expectedMean) > 1e-4F) {
+            std::cerr << "Rollup decode mismatch at bucket " << i << std::endl;
+            return 1;
+        }
+    }
+
+    rollup.clear();
+    if (!rollup.buckets(RollupResolution::OneSecond).empty()) {
+        std::cerr << "Rollup should be empty after clear" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,180 @@
+#include "minitrain/video_frame_header.hpp"
+
+#include "minitrain/synthetic_frame_source.hpp"
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runVideoFrameHeaderTests() {
+    VideoFrameHeader header{};
+    header.flags = VideoFrameHeader::kFlagCommandApplied;
+    header.sessionId[0] = 0x11U;
+    header.sessionId[15] = 0xEEU;
+    header.frameSequence = 0x01020304U;
+    header.captureMicros = 0x1122334455667788ULL;
+    header.commandSequence = 77;
+    header.payloadLength = 4096;
+    header.captureUnixMicros = 1'760'000'000'000'000ULL;
+    std::array<std::uint8_t, kVideoFrameHeaderSize + 4> encoded{};
+    encodeVideoFrameHeader(header, encoded.data());
+    const auto decoded = decodeVideoFrameHeader(encoded.data(), kVideoFrameHeaderSize);
+    if (encoded[0] != VideoFrameHeader::kVersion || encoded[2] != kVideoFrameHeaderSize ||
+        decoded.flags != header.flags || decoded.sessionId != header.sessionId ||
+        decoded.frameSequence != header.frameSequence || decoded.captureMicros != header.captureMicros ||
+        decoded.commandSequence != 77U || decoded.payloadLength != 4096U ||
+        decoded.captureUnixMicros != header.captureUnixMicros) {
+        std::cerr << "Video frame header did not round-trip" << std::endl;
+        return 1;
+    }
+
+    // A longer header from a newer sender is accepted; a short buffer or an
+    // unknown version is not.
+    encoded[2] = static_cast<std::uint8_t>(kVideoFrameHeaderSize + 4);
+    if (decodeVideoFrameHeader(encoded.data(), encoded.size()).commandSequence != 77U) {
+        std::cerr << "Extended video frame header should decode" << std::endl;
+        return 1;
+    }
+    bool threw = false;
+    try {
+        decodeVideoFrameHeader(encoded.data(), kVideoFrameHeaderSize);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    encoded[0] = 9;
+    try {
+        decodeVideoFrameHeader(encoded.data(), encoded.size());
+        threw = false;
+    } catch (const std::invalid_argument &) {
+    }
+    if (!threw) {
+        std::cerr << "Malformed video frame headers should be rejected" << std::endl;
+        return 1;
+    }
+
+    // The JPEG is referenced from the driver buffer and released once sent.
+    std::vector<std::uint8_t> jpeg(3000);
+    for (std::size_t i = 0; i < jpeg.size(); ++i) {
+        jpeg[i] = static_cast<std::uint8_t>(i);
+    }
+    camera_fb_t driverFrame{};
+    driverFrame.buf = jpeg.data();
+    driverFrame.len = jpeg.size();
+    int returned = 0;
+    FrameFanout fanout([&](camera_fb_t *) { ++returned; });
+    auto subscription = fanout.subscribe(1, FrameDropPolicy::DropOldest);
+    const auto captured = std::chrono::steady_clock::time_point{std::chrono::microseconds{123456}};
+    fanout.publish(&driverFrame, captured);
+    fanout.publish(&driverFrame, captured);
+    auto frame = subscription->tryAcquire(std::chrono::milliseconds{0});
+    const std::array<std::uint8_t, 16> session{0x42U};
+    const auto capturedWallClock = std::chrono::system_clock::now() - (std::chrono::steady_clock::now() - captured);
+    const auto tagged = makeVideoFrameHeader(*frame, session, std::nullopt);
+    const auto expectedUnixMicros =
+        std::chrono::duration_cast<std::chrono::microseconds>(capturedWallClock.time_since_epoch()).count();
+    if (tagged.frameSequence != 1U || tagged.captureMicros != 123456U || tagged.payloadLength != 3000U ||
+        tagged.flags != 0U || tagged.sessionId != session ||
+        std::llabs(static_cast<long long>(tagged.captureUnixMicros) - expectedUnixMicros) > 1'000'000) {
+        std::cerr << "Video frame header should describe the captured frame" << std::endl;
+        return 1;
+    }
+    auto message = makeVideoMessage(makeVideoFrameHeader(*frame, session, 9U), std::move(*frame));
+    frame.reset();
+    if (message.segmentCount != 2U || message.segments[1].data != jpeg.data() ||
+        message.size() != kVideoFrameHeaderSize + jpeg.size() || returned != 1) {
+        std::cerr << "Video message should reference the frame buffer" << std::endl;
+        return 1;
+    }
+
+    // Completion runs after the frame went back to the driver.
+    int returnedAtCompletion = -1;
+    message.onComplete = [&](bool sent) { returnedAtCompletion = sent ? returned : -2; };
+    std::vector<std::uint8_t> wire;
+    SendScheduler scheduler([&](bool, const ByteSegment *segments, std::size_t count) {
+        for (std::size_t i = 0; i < count; ++i) {
+            wire.insert(wire.end(), segments[i].data, segments[i].data + segments[i].size);
+        }
+        return true;
+    });
+    scheduler.enqueue(TrafficClass::Video, std::move(message));
+    while (scheduler.sendNext()) {
+    }
+    if (returned != 2 || returnedAtCompletion != 2 || fanout.heldFrames() != 0U) {
+        std::cerr << "Frame should go back to the driver once its message is sent" << std::endl;
+        return 1;
+    }
+    // Single 3048 byte message in one 4096 byte chunk.
+    const auto onWire = decodeVideoFrameHeader(wire.data() + kChunkHeaderBytes, wire.size() - kChunkHeaderBytes);
+    if (onWire.commandSequence != 9U || (onWire.flags & VideoFrameHeader::kFlagCommandApplied) == 0U ||
+        std::vector<std::uint8_t>(wire.begin() + kChunkHeaderBytes + kVideoFrameHeaderSize, wire.end()) != jpeg) {
+        std::cerr << "Video message should carry the header followed by the JPEG" << std::endl;
+        return 1;
+    }
+
+    // Capture keeps running while a slow uplink (60 ms per frame) sends: the
+    // queue and the video class hold one frame each, so with three driver
+    // buffers the camera always has one to capture into.
+    using namespace std::chrono_literals;
+    SyntheticFrameConfig cameraConfig{};
+    cameraConfig.period = 10ms;
+    cameraConfig.bufferCount = 3;
+    std::shared_ptr<SyntheticFrameSource> source = SyntheticFrameSource::create(cameraConfig);
+    CameraStreamer streamer;
+    streamer.setFrameSource(source);
+    std::atomic<int> completed{0};
+    std::atomic<std::size_t> maxHeld{0};
+    const auto noteHeld = [&] {
+        const auto held = streamer.stats().heldFrames;
+        auto seen = maxHeld.load();
+        while (held > seen && !maxHeld.compare_exchange_weak(seen, held)) {
+        }
+    };
+    SendScheduler uplink([&](bool, const ByteSegment *, std::size_t) {
+        std::this_thread::sleep_for(20ms);
+        noteHeld();
+        return true;
+    });
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 0ms, 1) || !streamer.start() || !uplink.start()) {
+        std::cerr << "Failed to start the slow uplink pipeline" << std::endl;
+        return 1;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + 500ms;
+    while (std::chrono::steady_clock::now() < deadline) {
+        // Polls like the main loop, so a frame sits in the queue meanwhile.
+        std::this_thread::sleep_for(20ms);
+        auto next = streamer.tryAcquireFrame(50ms);
+        if (!next) {
+            continue;
+        }
+        auto queued = makeVideoMessage(makeVideoFrameHeader(*next, {}, std::nullopt), std::move(*next),
+                                       streamer.bufferPool());
+        queued.onComplete = [&completed](bool sent) { completed += sent ? 1 : 0; };
+        uplink.enqueue(TrafficClass::Video, std::move(queued));
+        noteHeld();
+    }
+    const auto pipeline = streamer.stats();
+    uplink.stop();
+    uplink.clear();
+    streamer.stop();
+    if (pipeline.capturedFrames < 30U || completed.load() < 4 || maxHeld.load() >= cameraConfig.bufferCount ||
+        source->buffersInUse() != 0U) {
+        std::cerr << "Capture should overlap a slow send (captured " << pipeline.capturedFrames << ", sent "
+                  << completed.load() << ", held " << maxHeld.load() << ")" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
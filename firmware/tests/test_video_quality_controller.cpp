@@ -0,0 +1,144 @@
+#include "minitrain/video_quality_controller.hpp"
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/synthetic_frame_source.hpp"
+#include "minitrain/video_frame_header.hpp"
+
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runVideoQualityControllerTests() {
+    using namespace std::chrono_literals;
+
+    VideoQualityConfig config = VideoQualityConfig::defaults();
+    config.downgradeAfter = 3;
+    config.upgradeAfter = 5;
+    config.settleTime = 100ms;
+    VideoQualityController controller(config);
+    const auto start = std::chrono::steady_clock::now();
+    TrafficClassStats video{};
+    if (controller.evaluate(video, start) || controller.throughputBytesPerSecond() != 0.0) {
+        std::cerr << "Quality controller should hold without measurements" << std::endl;
+        return 1;
+    }
+
+    // 12 KB frames at 30 fps against a 100 KB/s uplink.
+    controller.recordSend(100000, 1s);
+    std::optional<VideoQualityLevel> changed;
+    for (int i = 0; i < 3; ++i) {
+        controller.recordFrame(12000);
+        changed = controller.evaluate(video, start + std::chrono::milliseconds{10 * i});
+    }
+    if (!changed || controller.levelIndex() != 1U || changed->jpegQuality != controller.level().jpegQuality ||
+        controller.throughputBytesPerSecond() < 99000.0 || controller.throughputBytesPerSecond() > 101000.0) {
+        std::cerr << "Quality controller should step down when video exceeds the uplink" << std::endl;
+        return 1;
+    }
+    // Nothing moves while the step settles, however congested.
+    for (int i = 0; i < 10; ++i) {
+        controller.recordFrame(12000);
+        if (controller.evaluate(video, start + 50ms)) {
+            std::cerr << "Quality controller should wait for a step to settle" << std::endl;
+            return 1;
+        }
+    }
+    // Queue drops alone are congestion too.
+    controller.recordSend(10000000, 1s);
+    for (int i = 0; i < 3; ++i) {
+        controller.recordFrame(1000);
+        video.droppedMessages += 1;
+        changed = controller.evaluate(video, start + 200ms);
+    }
+    if (!changed || controller.levelIndex() != 2U) {
+        std::cerr << "Quality controller should step down while frames are dropped" << std::endl;
+        return 1;
+    }
+    // Plenty of headroom for upgradeAfter evaluations steps back up once.
+    for (int i = 0; i < 5; ++i) {
+        controller.recordFrame(1000);
+        changed = controller.evaluate(video, start + 400ms);
+        if (i < 4 && changed) {
+            std::cerr << "Quality controller upgraded without hysteresis" << std::endl;
+            return 1;
+        }
+    }
+    if (!changed || controller.levelIndex() != 1U) {
+        std::cerr << "Quality controller should step up with headroom" << std::endl;
+        return 1;
+    }
+    video.queuedMessages = 1;
+    for (int i = 0; i < 10; ++i) {
+        controller.recordFrame(1000);
+        if (controller.evaluate(video, start + 600ms)) {
+            std::cerr << "Quality controller should not step up with a backlog" << std::endl;
+            return 1;
+        }
+    }
+
+    // End to end: synthetic VGA camera, 100 KB/s throttled loopback.
+    SyntheticFrameConfig cameraConfig{};
+    cameraConfig.width = 640;
+    cameraConfig.height = 480;
+    cameraConfig.period = 1ms;
+    cameraConfig.bufferCount = 4;
+    cameraConfig.jpegBytes = 12000;
+    std::shared_ptr<SyntheticFrameSource> source = SyntheticFrameSource::create(cameraConfig);
+    CameraStreamer streamer;
+    streamer.setFrameSource(source);
+    VideoQualityConfig adaptive = VideoQualityConfig::defaults();
+    adaptive.settleTime = 200ms;
+    VideoQualityController quality(adaptive);
+    SendScheduler scheduler([&quality](bool, const ByteSegment *segments, std::size_t count) {
+        std::size_t bytes = 0;
+        for (std::size_t i = 0; i < count; ++i) {
+            bytes += segments[i].size;
+        }
+        const auto elapsed = std::chrono::microseconds{bytes * 10};
+        std::this_thread::sleep_for(elapsed);
+        quality.recordSend(bytes, elapsed);
+        return true;
+    });
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig(), 33ms, 2) || !streamer.start() ||
+        !scheduler.start()) {
+        std::cerr << "Failed to start the throttled video pipeline" << std::endl;
+        return 1;
+    }
+    std::size_t firstFrame = 0;
+    std::size_t lastFrame = 0;
+    bool applied = true;
+    const auto deadline = std::chrono::steady_clock::now() + 1500ms;
+    while (std::chrono::steady_clock::now() < deadline) {
+        auto frame = streamer.tryAcquireFrame(100ms);
+        if (!frame) {
+            continue;
+        }
+        firstFrame = firstFrame == 0 ? frame->size() : firstFrame;
+        lastFrame = frame->size();
+        quality.recordFrame(frame->size());
+        scheduler.enqueue(TrafficClass::Video, makeVideoMessage(makeVideoFrameHeader(*frame, {}, std::nullopt),
+                                                                std::move(*frame)));
+        if (const auto level = quality.evaluate(scheduler.stats(TrafficClass::Video))) {
+            applied = applied && streamer.setVideoQuality(level->frameSize, level->jpegQuality);
+            streamer.setCaptureInterval(level->captureInterval);
+        }
+    }
+    streamer.stop();
+    scheduler.stop();
+    scheduler.clear();
+    if (!applied || quality.levelIndex() < 2U || lastFrame * 3U > firstFrame ||
+        streamer.stats().captureInterval != quality.level().captureInterval) {
+        std::cerr << "Video quality should drop to fit a throttled uplink (level " << quality.levelIndex()
+                  << ", frames " << firstFrame << " -> " << lastFrame << " bytes)" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,140 @@
+#include "minitrain/yuv_kernels.hpp"
+
+#include "minitrain/camera_streamer.hpp"
+#include "minitrain/synthetic_frame_source.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <optional>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "test_suite.hpp"
+
+namespace minitrain::tests {
+
+int runYuvKernelTests() {
+    using namespace std::chrono_literals;
+
+    // 4x4 YUYV frame whose luma is the pixel index; chroma bytes are noise
+    // that must never leak into the output.
+    std::vector<std::uint8_t> small(4 * 4 * 2);
+    for (std::size_t i = 0; i < 16; ++i) {
+        small[i * 2] = static_cast<std::uint8_t>(i * 10);
+        small[i * 2 + 1] = 0xA5U;
+    }
+    std::vector<std::uint8_t> out(16);
+    if (!yuv422ToLuma(small.data(), 4, 4, 2, LumaReduction::Average, out.data(), SimdIsa::Scalar) ||
+        out[0] != 25U || out[1] != 45U || out[2] != 105U || out[3] != 125U) {
+        std::cerr << "2x average should be the rounded block mean" << std::endl;
+        return 1;
+    }
+    if (!yuv422ToLuma(small.data(), 4, 4, 4, LumaReduction::Average, out.data(), SimdIsa::Scalar) || out[0] != 75U ||
+        !yuv422ToLuma(small.data(), 4, 4, 2, LumaReduction::Subsample, out.data(), SimdIsa::Scalar) ||
+        out[0] != 0U || out[1] != 20U || out[2] != 80U || out[3] != 100U) {
+        std::cerr << "4x average or 2x subsample produced the wrong luma" << std::endl;
+        return 1;
+    }
+    if (yuv422ToLuma(small.data(), 3, 4, 1, LumaReduction::Average, out.data()) ||
+        yuv422ToLuma(small.data(), 4, 4, 3, LumaReduction::Average, out.data()) ||
+        yuv422ToLuma(nullptr, 4, 4, 1, LumaReduction::Average, out.data())) {
+        std::cerr << "Odd widths, bad factors and null buffers should be rejected" << std::endl;
+        return 1;
+    }
+    const auto kernels = availableYuvKernels();
+    if (kernels.empty() || kernels.front() != SimdIsa::Scalar) {
+        std::cerr << "The scalar kernels should always be available" << std::endl;
+        return 1;
+    }
+
+    // Every kernel set must match the scalar reference bit for bit,
+    // including widths that leave a scalar tail and heights that drop rows.
+    std::mt19937 rng(3);
+    std::uniform_int_distribution<int> byte(0, 255);
+    const std::size_t sizes[][2] = {{320, 240}, {2, 2}, {66, 9}, {134, 17}, {206, 5}, {640, 8}};
+    for (const auto &size : sizes) {
+        std::vector<std::uint8_t> frame(size[0] * size[1] * 2U);
+        for (auto &value : frame) {
+            value = static_cast<std::uint8_t>(byte(rng));
+        }
+        for (const std::size_t factor : {1U, 2U, 4U}) {
+            for (const auto reduction : {LumaReduction::Average, LumaReduction::Subsample}) {
+                std::vector<std::uint8_t> reference(lumaOutputSize(size[0], size[1], factor));
+                (void)yuv422ToLuma(frame.data(), size[0], size[1], factor, reduction, reference.data(),
+                                   SimdIsa::Scalar);
+                for (const auto isa : kernels) {
+                    std::vector<std::uint8_t> result(reference.size() + 1, 0xEEU);
+                    if (!yuv422ToLuma(frame.data(), size[0], size[1], factor, reduction, result.data(), isa) ||
+                        !std::equal(reference.begin(), reference.end(), result.begin()) || result.back() != 0xEEU) {
+                        std::cerr << toString(isa) << " kernel differs from scalar at " << size[0] << "x" << size[1]
+                                  << " factor " << factor << std::endl;
+                        return 1;
+                    }
+                }
+            }
+        }
+    }
+
+    // Streamer stage on a synthetic YUV422 camera.
+    SyntheticFrameConfig cameraConfig{};
+    cameraConfig.format = PIXFORMAT_YUV422;
+    cameraConfig.period = 5ms;
+    cameraConfig.bufferCount = 4;
+    std::shared_ptr<SyntheticFrameSource> source = SyntheticFrameSource::create(cameraConfig);
+    CameraStreamer streamer;
+    streamer.setFrameSource(source);
+    if (streamer.setLumaStage(3) || !streamer.setLumaStage(4, LumaReduction::Average)) {
+        std::cerr << "Luma stage should only accept factors 0, 1, 2 and 4" << std::endl;
+        return 1;
+    }
+    if (!streamer.initialize(CameraStreamer::createDefaultConfig()) || !streamer.start()) {
+        std::cerr << "Failed to start the YUV422 stream" << std::endl;
+        return 1;
+    }
+    std::optional<SharedFrame> frame;
+    std::shared_ptr<const LumaFrame> luma;
+    const auto deadline = std::chrono::steady_clock::now() + 1s;
+    while (std::chrono::steady_clock::now() < deadline) {
+        frame = streamer.tryAcquireFrame(100ms);
+        luma = streamer.latestLumaFrame();
+        if (frame && luma && luma->sequence == frame->sequence()) {
+            break;
+        }
+    }
+    if (!frame || !luma || luma->sequence != frame->sequence() || luma->width != 80 || luma->height != 60 ||
+        luma->pixels.size() != 80U * 60U || luma->captureTime != frame->captureTime()) {
+        std::cerr << "Luma stage should mirror the published YUV422 frames" << std::endl;
+        return 1;
+    }
+    std::vector<std::uint8_t> expected(luma->pixels.size());
+    (void)yuv422ToLuma(frame->data(), 320, 240, 4, LumaReduction::Average, expected.data(), SimdIsa::Scalar);
+    if (expected != luma->pixels) {
+        std::cerr << "Luma stage output differs from the reference kernel" << std::endl;
+        return 1;
+    }
+    // Holding a luma frame must not let the stage overwrite it.
+    const auto held = luma->pixels;
+    const auto heldSequence = luma->sequence;
+    frame.reset();
+    std::this_thread::sleep_for(100ms);
+    if (luma->pixels != held || luma->sequence != heldSequence || streamer.latestLumaFrame() == luma ||
+        streamer.stats().lumaFrames < 10U) {
+        std::cerr << "Luma buffers held by a reader should not be recycled" << std::endl;
+        return 1;
+    }
+    (void)streamer.setLumaStage(0);
+    const auto converted = streamer.stats().lumaFrames;
+    std::this_thread::sleep_for(50ms);
+    streamer.stop();
+    if (streamer.stats().lumaFrames > converted + 1U) {
+        std::cerr << "Disabled luma stage kept converting frames" << std::endl;
+        return 1;
+    }
+    return 0;
+}
+
+} // namespace minitrain::tests
@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "minitrain/session_replay.hpp"
+
+namespace {
+
+void printUsage(const char *program) {
+    std::cerr << "Usage: " << program << " <recordings-dir> [--threads N] [--tolerance VALUE]" << '\n';
+}
+
+const char *recordTypeName(minitrain::FlightRecordType type) {
+    switch (type) {
+    case minitrain::FlightRecordType::MotorCommand:
+        return "motor";
+    case minitrain::FlightRecordType::TelemetryOutput:
+        return "telemetry";
+    default:
+        return "record";
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        printUsage(argv[0]);
+        return 2;
+    }
+
+    std::string directory;
+    unsigned threads = 0;
+    minitrain::ReplayConfig config{};
+    for (int i = 1; i < argc; ++i) {
+        const std::string argument = argv[i];
+        if (argument == "--threads" && i + 1 < argc) {
+            threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (argument == "--tolerance" && i + 1 < argc) {
+            config.motorTolerance = std::strtof(argv[++i], nullptr);
+            config.telemetryTolerance = config.motorTolerance;
+        } else if (directory.empty()) {
+            directory = argument;
+        } else {
+            printUsage(argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<std::string> paths;
+    std::error_code error;
+    for (const auto &entry : std::filesystem::directory_iterator(directory, error)) {
+        if (entry.is_regular_file()) {
+            paths.push_back(entry.path().string());
+        }
+    }
+    if (error) {
+        std::cerr << "ERR: cannot read " << directory << ": " << error.message() << '\n';
+        return 2;
+    }
+    std::sort(paths.begin(), paths.end());
+
+    const auto summary = minitrain::replaySessions(paths, config, threads);
+
+    for (const auto &report : summary.sessions) {
+        if (!report.loaded) {
+            std::cout << "SKIP " << report.session << ": not a flight recording" << '\n';
+            continue;
+        }
+        if (report.matches()) {
+            continue;
+        }
+        std::cout << "DIFF " << report.session << ": " << report.motorMismatches << " motor, "
+                  << report.telemetryMismatches << " telemetry, " << report.unmatchedOutputs << " unmatched";
+        if (report.firstMismatch) {
+            std::cout << " (first: " << recordTypeName(report.firstMismatch->type) << " #"
+                      << report.firstMismatch->recordedSequence << ", " << report.firstMismatch->detail << ")";
+        }
+        std::cout << '\n';
+    }
+
+    const auto wallSeconds = std::chrono::duration<double>(summary.wallTime).count();
+    const auto recordedHours = std::chrono::duration<double, std::ratio<3600>>(summary.recordedSpan).count();
+    std::cout << summary.sessions.size() << " sessions, " << summary.failures() << " diverged; " << recordedHours
+              << " h recorded replayed in " << wallSeconds << " s (" << summary.speedup() << "x real time, "
+              << (wallSeconds > 0.0 ? static_cast<double>(summary.inputRecords) / wallSeconds : 0.0)
+              << " inputs/s)" << '\n';
+
+    return summary.failures() == 0 ? 0 : 1;
+}